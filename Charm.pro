@@ -44,6 +44,10 @@ SOURCES += \
     Charm/HttpClient/UploadTimesheetJob.cpp \
     Charm/Idle/IdleDetector.cpp \
     Charm/Reports/MonthlyTimesheetXmlWriter.cpp \
+    Charm/Reports/ParallelReport.cpp \
+    Charm/Reports/ReportCache.cpp \
+    Charm/Reports/ReportGenerator.cpp \
+    Charm/Reports/ReportHtmlWriter.cpp \
     Charm/Reports/TimesheetInfo.cpp \
     Charm/Reports/WeeklyTimesheetXmlWriter.cpp \
     Charm/Widgets/ActivityReport.cpp \
@@ -96,6 +100,10 @@ HEADERS += \
     Charm/UndoCharmCommandWrapper.h \
     Charm/ViewFilter.h \
     Charm/Reports/MonthlyTimesheetXmlWriter.h \
+    Charm/Reports/ParallelReport.h \
+    Charm/Reports/ReportCache.h \
+    Charm/Reports/ReportGenerator.h \
+    Charm/Reports/ReportHtmlWriter.h \
     Charm/Reports/TimesheetInfo.h \
     Charm/Reports/WeeklyTimesheetXmlWriter.h \
     Charm/Widgets/TasksViewDelegate.h \
@@ -30,6 +30,7 @@
 #include "Core/CharmConstants.h"
 #include "Core/CharmExceptions.h"
 #include "Core/SqLiteStorage.h"
+#include "Core/StartupProfiler.h"
 
 #include "HttpClient/HttpJob.h"
 #include "Idle/IdleDetector.h"
@@ -281,6 +282,10 @@ ApplicationCore::ApplicationCore(TaskId startupTask, QObject* parent )
     m_cmdInterface = new CharmCommandInterface( this );
 #endif // CHARM_CI_SUPPORT
 
+    // the startup profile ends with the first paint of the main window:
+    if ( StartupProfiler::instance().isActive() )
+        m_timeTracker.installEventFilter( this );
+
     // Ladies and gentlemen, please raise upon your seats -
     // the show is about to begin:
     emit goToState(StartingUp);
@@ -405,6 +410,7 @@ void ApplicationCore::setState(State state)
     qDebug() << "ApplicationCore::setState: going from" << StateNames[m_state]
              << "to" << StateNames[state];
     State previous = m_state;
+    StartupPhase phase( StateNames[state] );
 
     try {
 
@@ -605,6 +611,21 @@ void ApplicationCore::enterConnectedState()
 #ifdef CHARM_CI_SUPPORT
     m_cmdInterface->start();
 #endif
+    // if Charm starts in the tray, there is no first paint to wait for:
+    if ( StartupProfiler::instance().isActive() && !m_timeTracker.isVisible() ) {
+        m_timeTracker.removeEventFilter( this );
+        StartupProfiler::instance().finish();
+    }
+}
+
+bool ApplicationCore::eventFilter( QObject* watched, QEvent* event )
+{
+    if ( watched == &m_timeTracker && event->type() == QEvent::Paint && m_state == Connected ) {
+        m_timeTracker.removeEventFilter( this );
+        StartupProfiler::instance().mark( "first paint" );
+        StartupProfiler::instance().finish();
+    }
+    return QObject::eventFilter( watched, event );
 }
 
 void ApplicationCore::leaveConnectedState()
@@ -670,7 +691,11 @@ bool ApplicationCore::configure()
     QSettings settings;
     settings.beginGroup(CONFIGURATION.configurationName);
 
-    bool configurationComplete = CONFIGURATION.readFrom(settings);
+    bool configurationComplete;
+    {
+        StartupPhase phase( "read configuration" );
+        configurationComplete = CONFIGURATION.readFrom(settings);
+    }
 
     if (!configurationComplete || CONFIGURATION.failure)
     {
@@ -825,13 +850,10 @@ TrayIcon& ApplicationCore::trayIcon()
 void ApplicationCore::updateTaskList()
 {
 #ifdef Q_OS_WIN
-    const auto recentData = DATAMODEL->mostRecentlyUsedTasks();
+    const auto recentData = DATAMODEL->mostRecentlyUsedTasks( 6 );
     auto recentJumpList = m_windowsJumpList->recent();
     recentJumpList->clear();
-    int count = 0;
     Q_FOREACH (const auto &id, recentData) {
-        if (count++ > 5)
-            break;
         recentJumpList->addLink( Data::goIcon(), DATAMODEL->getTask( id ).name(), qApp->applicationFilePath(),
         { QLatin1String( "--start-task" ), QString::number( id ) } );
     }
@@ -124,6 +124,8 @@ signals:
     void goToState( State state );
 
 protected:
+    bool eventFilter( QObject* watched, QEvent* event ) override;
+
     QAction m_actionStopAllTasks;
     TimeTrackingWindow m_timeTracker;
     QAction m_actionQuit;
@@ -27,10 +27,12 @@
 #define CHARM_CI_VERSION                    0x0001
 
 #define CHARM_CI_COMMAND_DISCONNECT         "BYE"
+#define CHARM_CI_COMMAND_QUERYSTATS         "QUERYSTATS"
 #define CHARM_CI_COMMAND_RECENT             "RECENT"
 #define CHARM_CI_COMMAND_START              "START"
 #define CHARM_CI_COMMAND_STATUS             "STATUS"
 #define CHARM_CI_COMMAND_STOP               "STOP"
+#define CHARM_CI_COMMAND_STREAM             "STREAM"
 #define CHARM_CI_COMMAND_TASK               "TASK"
 #define CHARM_CI_EVENT_TASK_ACTIVATED       "TASK ACTIVATED"
 #define CHARM_CI_EVENT_TASK_ADDED           "TASK ADDED"
@@ -42,6 +44,7 @@
 #define CHARM_CI_SERVER_ACK                 "ACK"
 #define CHARM_CI_SERVER_COMMENT             "*"
 #define CHARM_CI_SERVER_NAK                 "NAK"
+#define CHARM_CI_STREAM_VERSION             1
 
 #endif // CHARM_CI_CHARMCOMMANDPROTOCOL_H
 
@@ -25,6 +25,8 @@
 
 #include "CharmCommandSession.h"
 
+#include "ViewHelpers.h"
+
 #include "CharmCMake.h"
 
 #ifndef CHARM_CI_SUPPORT
@@ -42,7 +44,7 @@ CharmCommandServer::~CharmCommandServer()
 
 void CharmCommandServer::spawnSession(QIODevice* device)
 {
-    CharmCommandSession *session = new CharmCommandSession(this);
+    CharmCommandSession *session = new CharmCommandSession(DATAMODEL, this);
     session->setDevice(device);
     connect(device, SIGNAL(disconnected()), session, SLOT(deleteLater()));
 }
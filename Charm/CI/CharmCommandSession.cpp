@@ -23,34 +23,39 @@
 
 #include "CharmCommandSession.h"
 
-#include <QBuffer>
 #include <QIODevice>
 #include <QStringList>
 
 #include "Core/CharmDataModel.h"
-
-#include "ViewHelpers.h"
+#include "Core/SqlQueryStatistics.h"
 
 #include "CharmCommandProtocol.h"
+#include "CharmEventStream.h"
 #include "CharmCMake.h"
 
 #ifndef CHARM_CI_SUPPORT
 #error Build system error: CHARM_CI_SUPPORT should be defined
 #endif
 
-CharmCommandSession::CharmCommandSession(QObject* parent)
+/* the longest command line accepted, longer lines are discarded */
+static const int sMaximumLineLength(4096);
+
+CharmCommandSession::CharmCommandSession(CharmDataModel* model, QObject* parent)
     : QObject(parent)
+    , m_model(model)
     , m_device(nullptr)
     , m_state(InvalidState)
+    , m_discardingLine(false)
+    , m_stream(nullptr)
 {
     qDebug("Command interface created.");
 
-    DATAMODEL->registerAdapter(this);
+    m_model->registerAdapter(this);
 }
 
 CharmCommandSession::~CharmCommandSession()
 {
-    DATAMODEL->unregisterAdapter(this);
+    m_model->unregisterAdapter(this);
 
     qDebug("Command interface destroyed.");
 }
@@ -62,10 +67,14 @@ QIODevice* CharmCommandSession::device() const
 
 void CharmCommandSession::setDevice(QIODevice* device)
 {
+    stopStream();
+
     if (m_device)
         disconnect(m_device, SIGNAL(readyRead()), this, SLOT(onReadyRead()));
 
     m_device = device;
+    m_buffer.clear();
+    m_discardingLine = false;
 
     if (m_device)
         connect(m_device, SIGNAL(readyRead()), this, SLOT(onReadyRead()));
@@ -75,7 +84,7 @@ void CharmCommandSession::setDevice(QIODevice* device)
 
 void CharmCommandSession::resetTasks()
 {
-    if (!m_device)
+    if (!m_device || streaming())
         return;
 
     m_device->write(CHARM_CI_EVENT_TASK_RESET);
@@ -84,50 +93,89 @@ void CharmCommandSession::resetTasks()
 
 void CharmCommandSession::taskAdded( TaskId id )
 {
-    if (!m_device)
+    if (!m_device || streaming())
         return;
 
     m_device->write(QString("%1 %2\n")
         .arg(CHARM_CI_EVENT_TASK_ADDED)
-        .arg(DATAMODEL->taskIdAndSmartNameString(id))
+        .arg(m_model->taskIdAndSmartNameString(id))
         .toLatin1());
 }
 
 void CharmCommandSession::taskModified( TaskId id )
 {
-    if (!m_device)
+    if (!m_device || streaming())
         return;
 
     m_device->write(QString("%1 %2\n")
         .arg(CHARM_CI_EVENT_TASK_MODIFIED)
-        .arg(DATAMODEL->taskIdAndSmartNameString(id))
+        .arg(m_model->taskIdAndSmartNameString(id))
         .toLatin1());
 }
 
+void CharmCommandSession::taskParentChanged( TaskId, TaskId, TaskId )
+{
+    streaming();
+}
+
+void CharmCommandSession::taskDeleted( TaskId )
+{
+    streaming();
+}
+
+void CharmCommandSession::resetEvents()
+{
+    streaming();
+}
+
+void CharmCommandSession::eventAdded( EventId )
+{
+    streaming();
+}
+
+void CharmCommandSession::eventModified( EventId, Event )
+{
+    streaming();
+}
+
+void CharmCommandSession::eventDeleted( EventId )
+{
+    streaming();
+}
+
 void CharmCommandSession::eventActivated( EventId id )
 {
-    if (!m_device)
+    if (!m_device || streaming())
         return;
 
-    const Event &event = DATAMODEL->eventForId(id);
+    const Event &event = m_model->eventForId(id);
     m_device->write(QString("%1 %2\n")
         .arg(CHARM_CI_EVENT_TASK_ACTIVATED)
-        .arg(DATAMODEL->taskIdAndSmartNameString(event.taskId()))
+        .arg(m_model->taskIdAndSmartNameString(event.taskId()))
         .toLatin1());
 }
 
 void CharmCommandSession::eventDeactivated( EventId id )
 {
-    if (!m_device)
+    if (!m_device || streaming())
         return;
 
-    const Event &event = DATAMODEL->eventForId(id);
+    const Event &event = m_model->eventForId(id);
     m_device->write(QString("%1 %2\n")
         .arg(CHARM_CI_EVENT_TASK_DEACTIVATED)
-        .arg(DATAMODEL->taskIdAndSmartNameString(event.taskId()))
+        .arg(m_model->taskIdAndSmartNameString(event.taskId()))
         .toLatin1());
 }
 
+bool CharmCommandSession::streaming()
+{
+    if (!m_stream)
+        return false;
+
+    m_stream->modelChanged();
+    return true;
+}
+
 void CharmCommandSession::reset()
 {
     m_state = InvalidState;
@@ -136,14 +184,65 @@ void CharmCommandSession::reset()
 
 void CharmCommandSession::onReadyRead()
 {
-    QByteArray payload = m_device->readAll();
+    /*
+     * Data arrives in arbitrary chunks: a chunk may hold several commands,
+     * or only a part of one. Complete lines are handled in the order they
+     * were sent, the rest is kept until more data arrives. Clients may send
+     * many commands without waiting for the replies.
+     */
+    m_buffer += m_device->readAll();
+
+    int start = 0;
+    int end;
+    while ((end = m_buffer.indexOf('\n', start)) != -1) {
+        const QByteArray line = m_buffer.mid(start, end - start);
+        start = end + 1;
+
+        if (m_discardingLine) {
+            /* the rest of an overlong line */
+            m_discardingLine = false;
+            continue;
+        }
 
+        if (line.size() > sMaximumLineLength) {
+            discardLongLine();
+            continue;
+        }
+
+        handleLine(line);
+
+        if (!m_device || !m_device->isOpen()) {
+            /* BYE: ignore whatever follows */
+            m_buffer.clear();
+            return;
+        }
+    }
+    m_buffer.remove(0, start);
+
+    if (m_buffer.size() > sMaximumLineLength) {
+        m_buffer.clear();
+        if (!m_discardingLine) {
+            discardLongLine();
+            m_discardingLine = true;
+        }
+    }
+}
+
+void CharmCommandSession::discardLongLine()
+{
+    qDebug("Received a line longer than %d bytes. Discarding.", sMaximumLineLength);
+    if (m_state == CommandState)
+        sendNak("LINE TOO LONG");
+}
+
+void CharmCommandSession::handleLine(const QByteArray &line)
+{
     switch (m_state) {
     case HandshakeState:
-        handleHandshare(payload);
+        handleHandshake(QString::fromLatin1(line).trimmed());
         break;
     case CommandState:
-        handleCommand(payload);
+        handleCommand(QString::fromLatin1(line).trimmed());
         break;
     case InvalidState:
         qDebug("Received data while in invalid state. Discarding.");
@@ -192,25 +291,15 @@ void CharmCommandSession::startCommand()
     /*
      * simulate event activated events
      */
-    EventIdList activeEvents = DATAMODEL->activeEvents();
+    EventIdList activeEvents = m_model->activeEvents();
     foreach (EventId id, activeEvents)
         eventActivated(id);
 
     m_state = CommandState;
 }
 
-void CharmCommandSession::handleHandshare(QByteArray payload)
+void CharmCommandSession::handleHandshake(const QString &reply)
 {
-    QBuffer buffer(&payload);
-    buffer.open(QIODevice::ReadOnly);
-
-    if (!buffer.canReadLine()) {
-        buffer.close();
-        return;
-    }
-
-    QString reply = buffer.readLine();
-
     if (reply.startsWith(CHARM_CI_HANDSHAKE_RECV, Qt::CaseInsensitive)) {
         sendAck("Entering Command Mode");
         startCommand();
@@ -221,18 +310,8 @@ void CharmCommandSession::handleHandshare(QByteArray payload)
     }
 }
 
-void CharmCommandSession::handleCommand(QByteArray payload)
+void CharmCommandSession::handleCommand(const QString &command)
 {
-    QBuffer buffer(&payload);
-    buffer.open(QIODevice::ReadOnly);
-
-    if (!buffer.canReadLine()) {
-        buffer.close();
-        return;
-    }
-
-    const QString command = buffer.readLine().trimmed();
-
     const QStringList segment =
         command.split(' ', QString::SkipEmptyParts);
 
@@ -248,15 +327,15 @@ void CharmCommandSession::handleCommand(QByteArray payload)
         if (segment.count() == 2)
             tid = segment[1].toInt(&tid_ok);
         else {
-            EventMap::const_reverse_iterator i = DATAMODEL->eventMap().rbegin();
-            tid_ok = (i != DATAMODEL->eventMap().rend());
+            EventMap::const_reverse_iterator i = m_model->eventMap().rbegin();
+            tid_ok = (i != m_model->eventMap().rend());
             tid = i->second.taskId();
         }
 
-        if (tid_ok && DATAMODEL->taskExists(tid)) {
-            if (!DATAMODEL->isTaskActive(tid)) {
+        if (tid_ok && m_model->taskExists(tid)) {
+            if (!m_model->isTaskActive(tid)) {
                 qDebug("START command received. Starting task %d", tid);
-                DATAMODEL->startEventRequested(DATAMODEL->getTask(tid));
+                m_model->startEventRequested(m_model->getTask(tid));
             }
         }
         else sendNak("UNKNOWN TASK");
@@ -269,14 +348,14 @@ void CharmCommandSession::handleCommand(QByteArray payload)
         if (segment.count() == 2)
             tid = segment[1].toInt(&tid_ok);
         else {
-            tid = DATAMODEL->activeEventCount() > 0 ?
-                DATAMODEL->eventForId(DATAMODEL->activeEvents().last()).taskId() : 0;
+            tid = m_model->activeEventCount() > 0 ?
+                m_model->eventForId(m_model->activeEvents().last()).taskId() : 0;
             tid_ok = (tid > 0);
         }
 
-        if (tid_ok && DATAMODEL->taskExists(tid) && DATAMODEL->isTaskActive(tid)) {
+        if (tid_ok && m_model->taskExists(tid) && m_model->isTaskActive(tid)) {
             qDebug("STOP command received. Stopping task %d", tid);
-            DATAMODEL->endEventRequested(DATAMODEL->getTask(tid));
+            m_model->endEventRequested(m_model->getTask(tid));
         }
         else sendNak("UNKNOWN TASK");
     }
@@ -289,9 +368,9 @@ void CharmCommandSession::handleCommand(QByteArray payload)
             tid = segment[1].toInt(&tid_ok);
         else tid_ok = false;
 
-        if (tid_ok && DATAMODEL->taskExists(tid)) {
+        if (tid_ok && m_model->taskExists(tid)) {
             qDebug("TASK command received. Task %d requested", tid);
-            m_device->write(DATAMODEL->taskIdAndSmartNameString(tid).toLatin1());
+            m_device->write(m_model->taskIdAndSmartNameString(tid).toLatin1());
             m_device->write("\n");
         }
         else sendNak("UNKNOWN TASK");
@@ -300,10 +379,10 @@ void CharmCommandSession::handleCommand(QByteArray payload)
     else if (segment[0].compare(CHARM_CI_COMMAND_STATUS, Qt::CaseInsensitive) == 0) {
         qDebug("STATUS command received.");
 
-        const EventIdList activeEvents = DATAMODEL->activeEvents();
+        const EventIdList activeEvents = m_model->activeEvents();
         if (!activeEvents.isEmpty()) {
             foreach (EventId id, activeEvents) {
-                const Event &event = DATAMODEL->eventForId(id);
+                const Event &event = m_model->eventForId(id);
                 m_device->write(QString("%0 %1\n")
                     .arg(event.taskId(), 4, 10, QChar('0'))
                     .arg(event.duration()).toLatin1());
@@ -317,7 +396,7 @@ void CharmCommandSession::handleCommand(QByteArray payload)
         bool count_ok;
         int offset;
         int count;
-        const EventIdList recent = DATAMODEL->mostRecentlyUsedTasks();
+        const EventIdList recent = m_model->mostRecentlyUsedTasks();
 
         /* default params */
 
@@ -340,13 +419,52 @@ void CharmCommandSession::handleCommand(QByteArray payload)
                 count = recent.size() - offset;
 
             for (int i = 0; i < count; ++i) {
-                m_device->write(DATAMODEL->taskIdAndSmartNameString(recent[offset + i]).toLatin1());
+                m_device->write(m_model->taskIdAndSmartNameString(recent[offset + i]).toLatin1());
                 m_device->write("\n");
             }
         }
         else sendNak("INVALID REQUEST");
     }
 
+    else if (segment[0].compare(CHARM_CI_COMMAND_QUERYSTATS, Qt::CaseInsensitive) == 0) {
+        SqlQueryStatistics &statistics = SqlQueryStatistics::instance();
+
+        if (segment.count() == 1) {
+            qDebug("QUERYSTATS command received.");
+            /* the report lines are sent as comments, the ACK ends it */
+            const QStringList lines = statistics.report().split('\n', QString::SkipEmptyParts);
+            foreach (const QString &line, lines)
+                sendComment(line);
+            sendAck("QUERYSTATS");
+        }
+        else if (segment.count() == 2 && segment[1].compare("RESET", Qt::CaseInsensitive) == 0) {
+            qDebug("QUERYSTATS RESET command received.");
+            statistics.reset();
+            sendAck("QUERYSTATS RESET");
+        }
+        else if (segment.count() == 3 && segment[1].compare("THRESHOLD", Qt::CaseInsensitive) == 0) {
+            bool threshold_ok;
+            const int threshold = segment[2].toInt(&threshold_ok);
+
+            if (threshold_ok && threshold >= 0) {
+                qDebug("QUERYSTATS THRESHOLD command received. Logging queries slower than %d ms", threshold);
+                statistics.setSlowQueryThreshold(threshold);
+                sendAck("QUERYSTATS THRESHOLD");
+            }
+            else sendNak("INVALID REQUEST");
+        }
+        else sendNak("INVALID REQUEST");
+    }
+
+    else if (segment[0].compare(CHARM_CI_COMMAND_STREAM, Qt::CaseInsensitive) == 0) {
+        if (segment.count() == 2 && segment[1].compare("STOP", Qt::CaseInsensitive) == 0) {
+            qDebug("STREAM STOP command received.");
+            stopStream();
+            sendAck("STREAM STOP");
+        }
+        else startStream(segment);
+    }
+
     else if (segment[0].compare(CHARM_CI_COMMAND_DISCONNECT, Qt::CaseInsensitive) == 0) {
         qDebug("BYE command received. Closing connection.");
         m_device->close();
@@ -356,3 +474,80 @@ void CharmCommandSession::handleCommand(QByteArray payload)
     else sendNak("UNKNOWN COMMAND");
 }
 
+
+void CharmCommandSession::startStream(const QStringList &segment)
+{
+    /*
+     * STREAM <version> [TASKS] [EVENTS] [ACTIVATIONS] [TASK <id>]... [FROM <epoch> <seq>]
+     *
+     * Without a subscription all changes are streamed, without TASK those
+     * of all tasks. FROM resumes a stream after the last epoch and sequence
+     * number the client received, otherwise the stream starts with the next
+     * change. The sequence numbers of an earlier run of Charm cannot be
+     * resumed, that stream starts with a "resync" line.
+     */
+    bool version_ok;
+    const int version = segment.value(1).toInt(&version_ok);
+
+    if (!version_ok || version != CHARM_CI_STREAM_VERSION) {
+        sendNak("UNSUPPORTED STREAM VERSION");
+        return;
+    }
+
+    int subscriptions = 0;
+    QSet<TaskId> tasks;
+    QByteArray epoch = CharmEventStream::epoch();
+    quint64 sequence = m_model->version();
+
+    for (int i = 2; i < segment.count(); ++i) {
+        const QString &option = segment[i];
+        bool value_ok = true;
+
+        if (option.compare("TASKS", Qt::CaseInsensitive) == 0)
+            subscriptions |= CharmEventStream::Tasks;
+        else if (option.compare("EVENTS", Qt::CaseInsensitive) == 0)
+            subscriptions |= CharmEventStream::Events;
+        else if (option.compare("ACTIVATIONS", Qt::CaseInsensitive) == 0)
+            subscriptions |= CharmEventStream::Activations;
+        else if (option.compare("TASK", Qt::CaseInsensitive) == 0 && i + 1 < segment.count())
+            tasks.insert(segment[++i].toInt(&value_ok));
+        else if (option.compare("FROM", Qt::CaseInsensitive) == 0 && i + 2 < segment.count()) {
+            epoch = segment[++i].toLatin1();
+            sequence = segment[++i].toULongLong(&value_ok);
+        }
+        else
+            value_ok = false;
+
+        if (!value_ok) {
+            sendNak("INVALID REQUEST");
+            return;
+        }
+    }
+
+    /* the sequence numbers of another run say nothing about this model */
+    const bool resync = (epoch != CharmEventStream::epoch());
+    if (resync)
+        sequence = m_model->version();
+    else if (sequence > m_model->version()) {
+        sendNak("INVALID SEQUENCE");
+        return;
+    }
+
+    if (subscriptions == 0)
+        subscriptions = CharmEventStream::AllChanges;
+
+    qDebug("STREAM command received. Streaming changes after %llu", static_cast<unsigned long long>(sequence));
+
+    stopStream();
+    sendAck(QString("STREAM %1 %2 %3")
+        .arg(version)
+        .arg(QString::fromLatin1(CharmEventStream::epoch()))
+        .arg(sequence));
+    m_stream = new CharmEventStream(m_model, m_device, subscriptions, tasks, sequence, resync, this);
+}
+
+void CharmCommandSession::stopStream()
+{
+    delete m_stream;
+    m_stream = nullptr;
+}
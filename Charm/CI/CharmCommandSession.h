@@ -24,11 +24,15 @@
 #ifndef CHARM_CI_CHARMCOMMANDSESSION_H
 #define CHARM_CI_CHARMCOMMANDSESSION_H
 
+#include <QByteArray>
 #include <QObject>
 
 #include "Core/CharmDataModelAdapterInterface.h"
 
 class QIODevice;
+class QStringList;
+class CharmDataModel;
+class CharmEventStream;
 
 class CharmCommandSession : public QObject,
                             public CharmDataModelAdapterInterface
@@ -42,7 +46,8 @@ class CharmCommandSession : public QObject,
 
     Q_OBJECT
 public:
-    explicit CharmCommandSession(QObject* parent = nullptr);
+    /* serve the commands of a client of @p model */
+    explicit CharmCommandSession(CharmDataModel* model, QObject* parent = nullptr);
     ~CharmCommandSession();
 
     QIODevice* device() const;
@@ -53,16 +58,16 @@ public: /* CharmDataModelAdapterInterface */
     void taskAboutToBeAdded( TaskId, int ) {};
     void taskAdded( TaskId );
     void taskModified( TaskId );
-    void taskParentChanged( TaskId, TaskId, TaskId ) {};
+    void taskParentChanged( TaskId, TaskId, TaskId );
     void taskAboutToBeDeleted( TaskId ) {};
-    void taskDeleted( TaskId ) {};
+    void taskDeleted( TaskId );
 
-    void resetEvents() {};
+    void resetEvents();
     void eventAboutToBeAdded( EventId id ) {};
-    void eventAdded( EventId id ) {};
-    void eventModified( EventId id, Event discardedEvent ) {};
+    void eventAdded( EventId id );
+    void eventModified( EventId id, Event discardedEvent );
     void eventAboutToBeDeleted( EventId id ) {};
-    void eventDeleted( EventId id ) {};
+    void eventDeleted( EventId id );
 
     void eventActivated( EventId id );
     void eventDeactivated( EventId id );
@@ -81,12 +86,26 @@ private:
 private:
     void startHandshake();
     void startCommand();
-    void handleHandshare(QByteArray payload);
-    void handleCommand(QByteArray payload);
+    void handleLine(const QByteArray &line);
+    void discardLongLine();
+    void handleHandshake(const QString &reply);
+    void handleCommand(const QString &command);
+
+    void startStream(const QStringList &segment);
+    void stopStream();
+    /* pass a model change to the event stream, true if one is running */
+    bool streaming();
 
 private:
+    CharmDataModel* m_model;
     QIODevice* m_device;
     State m_state;
+    /* received data after the last complete line */
+    QByteArray m_buffer;
+    /* true while the rest of an overlong line is skipped */
+    bool m_discardingLine;
+    /* replaces the text notifications after a STREAM command */
+    CharmEventStream* m_stream;
 };
 
 #endif // CHARM_CI_CHARMCOMMANDSESSION_H
@@ -0,0 +1,270 @@
+/*
+  CharmEventStream.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "CharmEventStream.h"
+
+#include <QDateTime>
+#include <QHash>
+#include <QIODevice>
+#include <QTimer>
+
+#include "Core/CharmDataModel.h"
+
+#include "CharmCommandProtocol.h"
+#include "CharmCMake.h"
+
+#ifndef CHARM_CI_SUPPORT
+#error Build system error: CHARM_CI_SUPPORT should be defined
+#endif
+
+/* stop streaming while more than this is waiting to be sent to the client */
+static const qint64 sMaximumPendingBytes(64 * 1024);
+
+static QByteArray jsonString(const QString &text)
+{
+    const QByteArray utf8 = text.toUtf8();
+    QByteArray result;
+    result.reserve(utf8.size() + 2);
+    result += '"';
+    for (int i = 0; i < utf8.size(); ++i) {
+        const char c = utf8[i];
+        switch (c) {
+        case '"':  result += "\\\""; break;
+        case '\\': result += "\\\\"; break;
+        case '\n': result += "\\n"; break;
+        case '\r': result += "\\r"; break;
+        case '\t': result += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+                result += "\\u00" + QByteArray::number(static_cast<int>(c), 16).rightJustified(2, '0');
+            else
+                result += c;
+        }
+    }
+    result += '"';
+    return result;
+}
+
+static QByteArray jsonTime(const QDateTime &time)
+{
+    return '"' + time.toUTC().toString("yyyy-MM-dd'T'HH:mm:ss'Z'").toLatin1() + '"';
+}
+
+static QByteArray jsonBool(bool value)
+{
+    return value ? "true" : "false";
+}
+
+CharmEventStream::CharmEventStream(CharmDataModel* model, QIODevice* device, int subscriptions,
+                                   const QSet<TaskId>& tasks, quint64 version, bool resync,
+                                   QObject* parent)
+    : QObject(parent)
+    , m_model(model)
+    , m_device(device)
+    , m_subscriptions(subscriptions)
+    , m_tasks(tasks)
+    , m_version(version)
+    , m_resync(resync)
+    , m_flushScheduled(false)
+{
+    /* the client took some data, continue where the stream stopped */
+    connect(m_device, SIGNAL(bytesWritten(qint64)), this, SLOT(flush()));
+
+    /* a resumed stream may have changes to catch up with */
+    modelChanged();
+}
+
+QByteArray CharmEventStream::epoch()
+{
+    static const QByteArray runEpoch = QByteArray::number(QDateTime::currentMSecsSinceEpoch(), 16);
+    return runEpoch;
+}
+
+quint64 CharmEventStream::version() const
+{
+    return m_version;
+}
+
+void CharmEventStream::modelChanged()
+{
+    if (m_flushScheduled)
+        return;
+
+    m_flushScheduled = true;
+    QTimer::singleShot(0, this, SLOT(flush()));
+}
+
+void CharmEventStream::flush()
+{
+    m_flushScheduled = false;
+
+    if (!m_device->isOpen())
+        return;
+
+    if (m_resync) {
+        m_resync = false;
+        writeLine(m_version, "resync");
+    }
+
+    const quint64 current = m_model->version();
+    if (m_version >= current)
+        return;
+
+    /* bytesWritten() resumes the stream */
+    if (m_device->bytesToWrite() > sMaximumPendingBytes)
+        return;
+
+    ModelChangeList changes;
+    if (!m_model->changesSince(m_version, &changes)) {
+        /* the client fell too far behind, it has to read the model again */
+        writeLine(current, "resync");
+        m_version = current;
+        return;
+    }
+
+    /* task and event lines show the current state, which is the state
+       after the last change of each task or event; changes before a reset
+       are superseded by it */
+    QHash<int, quint64> lastTaskChange;
+    QHash<int, quint64> lastEventChange;
+    quint64 lastTasksReset = 0;
+    quint64 lastEventsReset = 0;
+    foreach (const ModelChange &change, changes) {
+        if (change.type == ModelChange::TaskChanged)
+            lastTaskChange[change.id] = change.version;
+        else if (change.type == ModelChange::EventChanged)
+            lastEventChange[change.id] = change.version;
+        else if (change.type == ModelChange::TasksReset)
+            lastTasksReset = change.version;
+        else if (change.type == ModelChange::EventsReset)
+            lastEventsReset = change.version;
+    }
+
+    foreach (const ModelChange &change, changes) {
+        bool superseded = false;
+        if (change.type == ModelChange::TaskChanged)
+            superseded = change.version < lastTasksReset || lastTaskChange.value(change.id) != change.version;
+        else if (change.type == ModelChange::EventChanged)
+            superseded = change.version < lastEventsReset || lastEventChange.value(change.id) != change.version;
+
+        if (!superseded && accepts(change))
+            writeChange(change);
+        m_version = change.version;
+
+        if (m_device->bytesToWrite() > sMaximumPendingBytes)
+            return;
+    }
+}
+
+bool CharmEventStream::accepts(const ModelChange &change) const
+{
+    switch (change.type) {
+    case ModelChange::TasksReset:
+        return m_subscriptions & Tasks;
+    case ModelChange::TaskChanged:
+        return (m_subscriptions & Tasks) && (m_tasks.isEmpty() || m_tasks.contains(change.id));
+    case ModelChange::EventsReset:
+        return m_subscriptions & Events;
+    case ModelChange::EventChanged:
+    case ModelChange::EventActivated:
+    case ModelChange::EventDeactivated: {
+        if (!(m_subscriptions & (change.type == ModelChange::EventChanged ? Events : Activations)))
+            return false;
+        /* the task of a deleted event is not known any more */
+        const Event &event = m_model->eventForId(change.id);
+        return m_tasks.isEmpty() || !event.isValid() || m_tasks.contains(event.taskId());
+    }
+    }
+    return false;
+}
+
+void CharmEventStream::writeChange(const ModelChange &change)
+{
+    switch (change.type) {
+    case ModelChange::TasksReset:
+        writeLine(change.version, "tasks.reset");
+        break;
+
+    case ModelChange::TaskChanged: {
+        const QByteArray id = "\"id\":" + QByteArray::number(change.id);
+        if (!m_model->taskExists(change.id)) {
+            writeLine(change.version, "task.deleted", id);
+            break;
+        }
+        const Task &task = m_model->getTask(change.id);
+        QByteArray fields = id
+            + ",\"parent\":" + QByteArray::number(task.parent())
+            + ",\"name\":" + jsonString(task.name())
+            + ",\"trackable\":" + jsonBool(task.trackable());
+        if (task.validFrom().isValid())
+            fields += ",\"validFrom\":" + jsonTime(task.validFrom());
+        if (task.validUntil().isValid())
+            fields += ",\"validUntil\":" + jsonTime(task.validUntil());
+        writeLine(change.version, "task", fields);
+        break;
+    }
+
+    case ModelChange::EventsReset:
+        writeLine(change.version, "events.reset");
+        break;
+
+    case ModelChange::EventChanged: {
+        const QByteArray id = "\"id\":" + QByteArray::number(change.id);
+        const Event &event = m_model->eventForId(change.id);
+        if (!event.isValid()) {
+            writeLine(change.version, "event.deleted", id);
+            break;
+        }
+        QByteArray fields = id
+            + ",\"task\":" + QByteArray::number(event.taskId())
+            + ",\"start\":" + jsonTime(event.startDateTime());
+        /* the end of a running event is only the time it was last saved */
+        if (!event.isRunning())
+            fields += ",\"end\":" + jsonTime(event.endDateTime());
+        fields += ",\"running\":" + jsonBool(event.isRunning())
+            + ",\"comment\":" + jsonString(event.comment());
+        writeLine(change.version, "event", fields);
+        break;
+    }
+
+    case ModelChange::EventActivated:
+    case ModelChange::EventDeactivated: {
+        const Event &event = m_model->eventForId(change.id);
+        writeLine(change.version, "activation",
+                  "\"event\":" + QByteArray::number(change.id)
+                  + ",\"task\":" + QByteArray::number(event.isValid() ? event.taskId() : 0)
+                  + ",\"active\":" + jsonBool(change.type == ModelChange::EventActivated));
+        break;
+    }
+    }
+}
+
+void CharmEventStream::writeLine(quint64 sequence, const char* type, const QByteArray& fields)
+{
+    QByteArray line = "{\"v\":" + QByteArray::number(CHARM_CI_STREAM_VERSION)
+        + ",\"epoch\":\"" + epoch() + '"'
+        + ",\"seq\":" + QByteArray::number(sequence)
+        + ",\"type\":\"" + type + '"';
+    if (!fields.isEmpty())
+        line += ',' + fields;
+    line += "}\n";
+    m_device->write(line);
+}
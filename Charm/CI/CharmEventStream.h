@@ -0,0 +1,100 @@
+/*
+  CharmEventStream.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CHARM_CI_CHARMEVENTSTREAM_H
+#define CHARM_CI_CHARMEVENTSTREAM_H
+
+#include <QObject>
+#include <QSet>
+
+#include "Core/ModelChangeJournal.h"
+#include "Core/Task.h"
+
+class QIODevice;
+class CharmDataModel;
+
+/*
+ * CharmEventStream writes the changes of the data model to a command
+ * session as JSON lines, one object per change:
+ *
+ *   {"v":1,"epoch":"15f3a2c9e01","seq":42,"type":"event","id":7,...}
+ *
+ * The sequence numbers are the versions of the data model, which start
+ * again with every run of Charm, so every line also carries the epoch of
+ * the run. A client can resume a stream of the same epoch after the last
+ * sequence number it received.
+ *
+ * Task and event lines show the state after their sequence number: only
+ * the last change of a task or event is written, since the journal does
+ * not keep earlier states. Activation lines are written for every change.
+ *
+ * The changes are read from the model's change journal when the device can
+ * take more data, so a slow client never makes the write buffer grow
+ * beyond a limit: it falls behind, and gets a "resync" line if the journal
+ * no longer reaches back to its position.
+ */
+class CharmEventStream : public QObject
+{
+    Q_OBJECT
+public:
+    enum Subscription
+    {
+        Tasks       = 0x1,
+        Events      = 0x2,
+        Activations = 0x4,
+        AllChanges  = Tasks | Events | Activations
+    };
+
+    /* stream the subscribed changes of @p model after @p version, only
+       those of @p tasks unless it is empty; start with a "resync" line if
+       @p resync is set */
+    CharmEventStream(CharmDataModel* model, QIODevice* device, int subscriptions,
+                     const QSet<TaskId>& tasks, quint64 version, bool resync,
+                     QObject* parent = nullptr);
+
+    /* identifies the sequence numbers of this run of Charm */
+    static QByteArray epoch();
+
+    /* the sequence number of the last change that was streamed or skipped */
+    quint64 version() const;
+
+    /* the data model changed, stream the changes when the event loop runs */
+    void modelChanged();
+
+private slots:
+    void flush();
+
+private:
+    bool accepts(const ModelChange& change) const;
+    void writeChange(const ModelChange& change);
+    void writeLine(quint64 sequence, const char* type, const QByteArray& fields = QByteArray());
+
+private:
+    CharmDataModel* m_model;
+    QIODevice* m_device;
+    int m_subscriptions;
+    QSet<TaskId> m_tasks;
+    quint64 m_version;
+    bool m_resync;
+    bool m_flushScheduled;
+};
+
+#endif // CHARM_CI_CHARMEVENTSTREAM_H
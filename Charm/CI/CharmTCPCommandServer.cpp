@@ -112,6 +112,10 @@ void CharmTCPCommandServer::onNewConnection()
         QTcpSocket* conn = m_server->nextPendingConnection();
         Q_ASSERT(conn);
 
+        /* replies to pipelined commands are written together, do not
+           hold back the last one waiting for an acknowledgment */
+        conn->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+
         qDebug("New TCP connection, creating command session...");
         spawnSession(conn);
     }
@@ -31,10 +31,13 @@
 #include <QMessageBox>
 #include <QSettings>
 #include <QString>
+#include <QVector>
 
 #include "ApplicationCore.h"
 #include "MacApplicationCore.h"
 #include "Core/CharmExceptions.h"
+#include "Core/SqlQueryStatistics.h"
+#include "Core/StartupProfiler.h"
 #include "CharmCMake.h"
 
 static std::shared_ptr<ApplicationCore> createApplicationCore( TaskId startupTask )
@@ -52,19 +55,45 @@ void showCriticalError( const QString& msg ) {
     cerr << qPrintable( msg ) << endl;
 }
 
+// append the SQL query statistics to the file named by CHARM_QUERY_STATISTICS, for diagnostics:
+static void writeQueryStatistics()
+{
+    const QByteArray filename = qgetenv( "CHARM_QUERY_STATISTICS" );
+    if ( filename.isEmpty() )
+        return;
+    QFile file( QFile::decodeName( filename ) );
+    if ( file.open( QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text ) ) {
+        file.write( SqlQueryStatistics::instance().report().toUtf8() );
+    } else {
+        std::cerr << "Cannot write the query statistics to " << filename.constData() << std::endl;
+    }
+}
+
 int main ( int argc, char** argv )
 {
+    // --profile-startup[=filename] can be combined with the other options:
+    QVector<char*> arguments;
+    for ( int i = 0; i < argc; ++i ) {
+        if ( qstrcmp( argv[i], "--profile-startup" ) == 0 ) {
+            StartupProfiler::instance().start();
+        } else if ( qstrncmp( argv[i], "--profile-startup=", 18 ) == 0 ) {
+            StartupProfiler::instance().start( QFile::decodeName( argv[i] + 18 ) );
+        } else {
+            arguments.append( argv[i] );
+        }
+    }
+
     TaskId startupTask = -1;
-    if (argc >= 2) {
-        if ( qstrcmp(argv[1], "--version") == 0) {
+    if (arguments.size() >= 2) {
+        if ( qstrcmp(arguments[1], "--version") == 0) {
             using namespace std;
             cout << "Charm version " << CHARM_VERSION << endl;
             return 0;
-        } else if ( argc == 3 && qstrcmp(argv[1], "--start-task") == 0 ) {
+        } else if ( arguments.size() == 3 && qstrcmp(arguments[1], "--start-task") == 0 ) {
             bool ok = true;
-            startupTask = QString::fromLocal8Bit( argv[2] ).toInt( &ok );
+            startupTask = QString::fromLocal8Bit( arguments[2] ).toInt( &ok );
             if ( !ok || startupTask < 0 ) {
-                std::cerr << "Invalid task id passed: " << argv[2];
+                std::cerr << "Invalid task id passed: " << arguments[2];
                 return 1;
             }
         }
@@ -90,10 +119,19 @@ int main ( int argc, char** argv )
         QGuiApplication::setAttribute( Qt::AA_EnableHighDpiScaling );
 #endif
         QApplication app( argc, argv );
-        const std::shared_ptr<ApplicationCore> core( createApplicationCore( startupTask ) );
+        StartupProfiler::instance().mark( "QApplication created" );
+        std::shared_ptr<ApplicationCore> core;
+        {
+            StartupPhase phase( "create ApplicationCore" );
+            core = createApplicationCore( startupTask );
+        }
         QObject::connect( &app, SIGNAL(commitDataRequest(QSessionManager&)), core.get(), SLOT(commitData(QSessionManager&)) );
         QObject::connect( &app, SIGNAL(saveStateRequest(QSessionManager&)), core.get(), SLOT(saveState(QSessionManager&)) );
-        return app.exec();
+        const int result = app.exec();
+        // if Charm quit before the startup completed, write what was recorded:
+        StartupProfiler::instance().finish();
+        writeQueryStatistics();
+        return result;
     } catch( const AlreadyRunningException& ) {
         using namespace std;
         cout << "Charm already running, exiting..." << endl;
@@ -33,6 +33,8 @@ EventModelAdapter::EventModelAdapter( CharmDataModel* parent )
     , m_dataModel( parent )
 {
     m_dataModel->registerAdapter( this );
+    connect( m_dataModel, SIGNAL(activeEventDurationsChanged()),
+             SLOT(slotActiveEventDurationsChanged()) );
 }
 
 EventModelAdapter::~EventModelAdapter()
@@ -131,6 +133,16 @@ void EventModelAdapter::eventDeactivated( EventId id )
     emit eventDeactivationNotice( id );
 }
 
+void EventModelAdapter::slotActiveEventDurationsChanged()
+{
+    // repaint the rows of the running events, their durations grew:
+    Q_FOREACH( EventId id, m_dataModel->activeEvents() ) {
+        const int row = m_events.indexOf( id );
+        if ( row != -1 )
+            emit dataChanged( index( row ), index( row ) );
+    }
+}
+
 void EventModelAdapter::commitCommand( CharmCommand* command )
 {
     command->finalize();
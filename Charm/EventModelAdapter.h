@@ -80,6 +80,9 @@ signals:
     void eventActivationNotice( EventId id );
     void eventDeactivationNotice( EventId id );
 
+private slots:
+    void slotActiveEventDurationsChanged();
+
 private:
     // if this is slow, we may want to store pointers here:
     EventIdList m_events;
@@ -29,6 +29,7 @@
 #include <QNetworkRequest>
 #include <QRegExp> // Required for Qt 4
 #include <QSettings>
+#include <QTemporaryFile>
 
 UploadTimesheetJob::UploadTimesheetJob(QObject* parent)
     : HttpJob(parent), m_fileName("payload")
@@ -52,6 +53,13 @@ void UploadTimesheetJob::setPayload(const QByteArray &_payload)
     m_payload = _payload;
 }
 
+void UploadTimesheetJob::setPayload(QIODevice *payload)
+{
+    Q_ASSERT(payload);
+    payload->setParent(this);
+    m_payloadDevice = payload;
+}
+
 QString UploadTimesheetJob::fileName() const
 {
     return m_fileName;
@@ -72,12 +80,17 @@ void UploadTimesheetJob::setUploadUrl(const QUrl& url)
     m_uploadUrl = url;
 }
 
+/* false if not all of data could be written, like on a full disk */
+static bool writeAll(QIODevice *device, const QByteArray &data)
+{
+    return device->write(data) == data.size();
+}
+
 bool UploadTimesheetJob::execute(int state, QNetworkAccessManager *manager)
 {
     if (state != UploadTimesheet)
         return HttpJob::execute(state, manager);
 
-    QByteArray data;
     QByteArray uploadName;
 
     /* validate filename */
@@ -87,27 +100,53 @@ bool UploadTimesheetJob::execute(int state, QNetworkAccessManager *manager)
     }
     else uploadName = m_fileName.toUtf8();
 
+    /* the body is put together in a temporary file, so that the payload is
+       not copied in memory; the file is deleted together with the reply */
+    auto data = new QTemporaryFile(this);
+    if (!data->open()) {
+        setErrorAndEmitFinished(SomethingWentWrong, tr("Could not create the upload data: %1").arg(data->errorString()));
+        delete data;
+        return true;
+    }
+
     /* username */
-    data += "--KDAB\r\n"
-            "Content-Disposition: form-data; name=\"user\"\r\n\r\n";
-    data += username().toUtf8();
-    data += "\r\n";
+    bool written = writeAll(data, "--KDAB\r\n"
+                                  "Content-Disposition: form-data; name=\"user\"\r\n\r\n")
+        && writeAll(data, username().toUtf8())
+        && writeAll(data, "\r\n");
 
     /* payload */
-    data += "--KDAB\r\n"
-            "Content-Disposition: form-data; name=\"" + uploadName + "\"; filename=\"" +
-            uploadName + "\"\r\nContent-Type: application/octet-stream\r\n\r\n";
-    data += m_payload;
-    data += "\r\n";
+    written = written
+        && writeAll(data, "--KDAB\r\n"
+                          "Content-Disposition: form-data; name=\"" + uploadName + "\"; filename=\"" +
+                          uploadName + "\"\r\nContent-Type: application/octet-stream\r\n\r\n");
+    if (m_payloadDevice) {
+        m_payloadDevice->seek(0);
+        while (written && !m_payloadDevice->atEnd())
+            written = writeAll(data, m_payloadDevice->read(64 * 1024));
+    } else {
+        written = written && writeAll(data, m_payload);
+    }
+    written = written && writeAll(data, "\r\n");
 
     /* eot */
-    data += "--KDAB--\r\n";
+    written = written && writeAll(data, "--KDAB--\r\n") && data->flush();
+
+    /* a full disk would otherwise upload a truncated time sheet */
+    if (!written) {
+        setErrorAndEmitFinished(SomethingWentWrong, tr("Could not write the upload data: %1").arg(data->errorString()));
+        delete data;
+        return true;
+    }
+
+    data->seek(0);
 
     QNetworkRequest request(m_uploadUrl);
     request.setHeader(QNetworkRequest::ContentTypeHeader, "multipart/form-data; boundary=KDAB");
-    request.setHeader(QNetworkRequest::ContentLengthHeader, data.size());
+    request.setHeader(QNetworkRequest::ContentLengthHeader, data->size());
 
     QNetworkReply *reply = manager->post(request, data);
+    data->setParent(reply);
 
     if (reply->error() != QNetworkReply::NoError)
         setErrorFromReplyAndEmitFinished(reply);
@@ -26,8 +26,11 @@
 
 #include "HttpJob.h"
 
+#include <QPointer>
 #include <QUrl>
 
+class QIODevice;
+
 class UploadTimesheetJob : public HttpJob
 {
     Q_OBJECT
@@ -38,6 +41,9 @@ public:
 
     QByteArray payload() const;
     void setPayload(const QByteArray &payload);
+    /** Upload the contents of @p payload instead of a byte array, without
+     * loading them into memory. The job takes ownership of the device. */
+    void setPayload(QIODevice *payload);
     QString fileName() const;
     void setFileName(const QString &fileName);
     QUrl uploadUrl() const;
@@ -56,6 +62,7 @@ protected:
 
 private:
     QByteArray m_payload;
+    QPointer<QIODevice> m_payloadDevice;
     QString m_fileName;
     QUrl m_uploadUrl;
 };
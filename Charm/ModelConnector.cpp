@@ -38,6 +38,7 @@ ModelConnector::ModelConnector()
     , m_viewFilter( &m_dataModel )
     , m_eventModelFilter( &m_dataModel )
     , m_findEventModelFilter( &m_dataModel )
+    , m_reportCache( &m_dataModel )
 {
     connect( &m_dataModel, SIGNAL(makeAndActivateEvent(Task)),
              SLOT(slotMakeAndActivateEvent(Task)) );
@@ -67,6 +68,11 @@ EventModelFilter* ModelConnector::findEventModel()
     return &m_findEventModelFilter;
 }
 
+ReportCache* ModelConnector::reportCache()
+{
+    return &m_reportCache;
+}
+
 void ModelConnector::commitCommand( CharmCommand* command )
 {
     if ( ! command->finalize() ) {
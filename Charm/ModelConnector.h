@@ -29,6 +29,7 @@
 #include "ViewFilter.h"
 #include "Core/CharmDataModel.h"
 #include "EventModelFilter.h"
+#include "Reports/ReportCache.h"
 
 class ModelConnector : public QObject,
                        public CommandEmitterInterface
@@ -46,6 +47,8 @@ public:
     EventModelFilter* eventModel();
 
     EventModelFilter* findEventModel();
+    /** The recently generated reports. */
+    ReportCache* reportCache();
 
     // implement CommandEmitterInterface
     void commitCommand( CharmCommand* ) override;
@@ -63,6 +66,8 @@ private:
     EventModelFilter m_eventModelFilter; // owns the event model adapter
 
     EventModelFilter m_findEventModelFilter;
+
+    ReportCache m_reportCache;
 };
 
 #endif
@@ -29,7 +29,7 @@
 #include "Core/CharmDataModel.h"
 #include <Core/XmlSerialization.h>
 
-#include <QDomDocument>
+#include <QBuffer>
 
 MonthlyTimesheetXmlWriter::MonthlyTimesheetXmlWriter()
 {}
@@ -66,52 +66,46 @@ void MonthlyTimesheetXmlWriter::setRootTask( TaskId rootTask )
 
 QByteArray MonthlyTimesheetXmlWriter::saveToXml() const
 {
-    QDomDocument document = XmlSerialization::createXmlTemplate( "monthly-timesheet" );
-
-    // find metadata and report element:
-    QDomElement root = document.documentElement();
-    QDomElement metadata = XmlSerialization::metadataElement( document );
-    QDomElement charmVersion = document.createElement( "charmversion" );
-    QDomText charmVersionString = document.createTextNode( CHARM_VERSION );
-    charmVersion.appendChild( charmVersionString );
-    metadata.appendChild( charmVersion );
-    QDomElement report = XmlSerialization::reportElement( document );
-    Q_ASSERT( !root.isNull() && !metadata.isNull() && !report.isNull() );
+    QByteArray data;
+    QBuffer buffer( &data );
+    buffer.open( QIODevice::WriteOnly );
+    writeTo( &buffer );
+    return data;
+}
+
+void MonthlyTimesheetXmlWriter::writeTo( QIODevice* device ) const
+{
+    XmlReportWriter writer( device, "monthly-timesheet" );
+    writer.textElement( "charmversion", CHARM_VERSION );
 
     // extend metadata tag: add year, and serial (month) number:
-    {
-        QDomElement yearElement = document.createElement( "year" );
-        metadata.appendChild( yearElement );
-        QDomText text = document.createTextNode( QString::number( m_yearOfMonth ) );
-        yearElement.appendChild( text );
-        QDomElement monthElement = document.createElement( "serial-number" );
-        monthElement.setAttribute( "semantics", "month-number" );
-        metadata.appendChild( monthElement );
-        QDomText monthtext = document.createTextNode( QString::number( m_monthNumber ) );
-        monthElement.appendChild( monthtext );
-    }
+    writer.textElement( "year", QString::number( m_yearOfMonth ) );
+    writer.startElement( "serial-number" );
+    writer.attribute( "semantics", "month-number" );
+    writer.text( QString::number( m_monthNumber ) );
+    writer.endElement();
+    writer.startReport();
 
     typedef QMap< TaskId, QVector<int> > SecondsMap;
     SecondsMap secondsMap;
     TimeSheetInfoList timeSheetInfo = TimeSheetInfo::filteredTaskWithSubTasks(
-        TimeSheetInfo::taskWithSubTasks( m_dataModel, m_numberOfWeeks, m_rootTask, secondsMap ),
+        m_dataModel->taskTree(), m_numberOfWeeks, m_rootTask, secondsMap,
         false ); // here, we don't care about active or not, because we only report on the tasks
 
     // extend report tag: add tasks and effort structure
     {   // tasks
-        QDomElement tasks = document.createElement( "tasks" );
-        report.appendChild( tasks );
+        writer.startElement( "tasks" );
         Q_FOREACH ( TimeSheetInfo info, timeSheetInfo ) {
             if ( info.taskId == 0 ) // the root task
                 continue;
             const Task& modelTask = m_dataModel->getTask( info.taskId );
-            tasks.appendChild( modelTask.toXml( document ) );
+            modelTask.writeXml( &writer );
         }
+        writer.endElement();
     }
     {   // effort
         // make effort element:
-        QDomElement effort = document.createElement( "effort" );
-        report.appendChild( effort );
+        writer.startElement( "effort" );
 
         // aggregate (group by task and day):
         typedef QPair<TaskId, QDate> Key;
@@ -147,6 +141,7 @@ QByteArray MonthlyTimesheetXmlWriter::saveToXml() const
                 // add this event:
                 events[key] = event;
                 events[key].setId( -events[key].id() ); // "synthetic" :-)
+                events[key].setRunning( false ); // the end is set below
                 // move to start at midnight in UTC (for privacy reasons)
                 // never, never, never use setTime() here, it breaks on DST changes! (twice a year)
                 QDateTime start( event.startDateTime().date(), QTime(0, 0, 0, 0), Qt::UTC );
@@ -159,9 +154,10 @@ QByteArray MonthlyTimesheetXmlWriter::saveToXml() const
         }
         // create elements:
         Q_FOREACH ( const Event & event, events ) {
-            effort.appendChild( event.toXml( document ) );
+            event.writeXml( &writer );
         }
+        writer.endElement();
     }
 
-   return document.toByteArray( 4 );
+    writer.finish();
 }
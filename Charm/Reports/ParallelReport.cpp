@@ -0,0 +1,166 @@
+/*
+  ParallelReport.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ParallelReport.h"
+
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+
+#include <algorithm>
+
+namespace {
+    // more parts than threads, so that no thread waits for a slow one at the end:
+    static const int PartsPerThread = 4;
+}
+
+class ParallelReportPart : public QRunnable
+{
+public:
+    ParallelReportPart( const CharmDataSnapshot& data, const QDate& start, const QDate& end,
+                        const QVector<int>& dayBuckets, int bucketCount,
+                        int firstBlock, int lastBlock, TaskBucketSeconds* result )
+        : m_data( data )
+        , m_start( start )
+        , m_end( end )
+        , m_dayBuckets( dayBuckets )
+        , m_bucketCount( bucketCount )
+        , m_firstBlock( firstBlock )
+        , m_lastBlock( lastBlock )
+        , m_result( result )
+    {
+    }
+
+    void run() override
+    {
+        m_data.addSecondsByTask( m_start, m_end, m_dayBuckets, m_bucketCount,
+                                 m_firstBlock, m_lastBlock, m_result );
+    }
+
+private:
+    const CharmDataSnapshot m_data;
+    const QDate m_start;
+    const QDate m_end;
+    const QVector<int> m_dayBuckets;
+    const int m_bucketCount;
+    const int m_firstBlock;
+    const int m_lastBlock;
+    TaskBucketSeconds* m_result;
+};
+
+ParallelReport::PeriodList ParallelReport::periods( const QDate& start, const QDate& end, TimeSpanType type )
+{
+    PeriodList result;
+    QDate periodStart = start;
+    while ( periodStart < end ) {
+        QDate next;
+        switch ( type ) {
+        case Day:
+            next = periodStart.addDays( 1 );
+            break;
+        case Week:
+            next = periodStart.addDays( 8 - periodStart.dayOfWeek() );
+            break;
+        case Month:
+            next = QDate( periodStart.year(), periodStart.month(), 1 ).addMonths( 1 );
+            break;
+        case Year:
+            next = QDate( periodStart.year() + 1, 1, 1 );
+            break;
+        case Range:
+            next = end;
+            break;
+        }
+        Period period;
+        period.start = periodStart;
+        period.end = qMin( next, end );
+        result << period;
+        periodStart = period.end;
+    }
+    return result;
+}
+
+ParallelReport::ParallelReport( const CharmDataSnapshot& data, int threadCount )
+    : m_data( data )
+    , m_threadCount( threadCount > 0 ? threadCount : qMax( QThread::idealThreadCount(), 1 ) )
+{
+}
+
+int ParallelReport::threadCount() const
+{
+    return m_threadCount;
+}
+
+SecondsMap ParallelReport::secondsByPeriod( const PeriodList& periods ) const
+{
+    if ( periods.isEmpty() )
+        return SecondsMap();
+
+    // the period of every day of the time span:
+    const QDate start = periods.first().start;
+    const QDate end = periods.last().end;
+    QVector<int> dayBuckets( start.daysTo( end ) );
+    for ( int period = 0; period < periods.size(); ++period ) {
+        Q_ASSERT_X( period == 0 || periods[period].start == periods[period - 1].end,
+                    Q_FUNC_INFO, "periods have to be consecutive" );
+        std::fill( dayBuckets.begin() + start.daysTo( periods[period].start ),
+                   dayBuckets.begin() + start.daysTo( periods[period].end ), period );
+    }
+
+    const int blockCount = m_data.eventBlockCount();
+    const int partCount = qMin( blockCount, m_threadCount * PartsPerThread );
+    QVector<TaskBucketSeconds> parts( partCount );
+    if ( m_threadCount == 1 || partCount <= 1 ) {
+        if ( partCount > 0 )
+            m_data.addSecondsByTask( start, end, dayBuckets, periods.size(), 0, blockCount, &parts[0] );
+    } else {
+        QThreadPool pool;
+        pool.setMaxThreadCount( m_threadCount );
+        for ( int part = 0; part < partCount; ++part ) {
+            const int firstBlock = blockCount * part / partCount;
+            const int lastBlock = blockCount * ( part + 1 ) / partCount;
+            pool.start( new ParallelReportPart( m_data, start, end, dayBuckets, periods.size(),
+                                                firstBlock, lastBlock, &parts[part] ) );
+        }
+        pool.waitForDone();
+    }
+
+    // merge the partial sums, in the order of the parts:
+    SecondsMap seconds;
+    Q_FOREACH( const TaskBucketSeconds& part, parts ) {
+        for ( auto it = part.constBegin(); it != part.constEnd(); ++it ) {
+            QVector<int>& values = seconds[it.key()];
+            if ( values.isEmpty() ) {
+                values = it.value();
+            } else {
+                for ( int period = 0; period < values.size(); ++period )
+                    values[period] += it.value()[period];
+            }
+        }
+    }
+    return seconds;
+}
+
+TimeSheetInfoList ParallelReport::timeSheet( const PeriodList& periods, TaskId rootTask, bool activeTasksOnly ) const
+{
+    return TimeSheetInfo::filteredTaskWithSubTasks( m_data.taskTree(), periods.size(), rootTask,
+                                                    secondsByPeriod( periods ), activeTasksOnly );
+}
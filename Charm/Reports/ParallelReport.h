@@ -0,0 +1,76 @@
+/*
+  ParallelReport.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PARALLELREPORT_H
+#define PARALLELREPORT_H
+
+#include <QDate>
+#include <QVector>
+
+#include "Core/CharmDataSnapshot.h"
+#include "Core/TimeSpans.h"
+#include "TimesheetInfo.h"
+
+/**
+ * ParallelReport aggregates the events of a long time span on all cores.
+ *
+ * The time span is split into consecutive periods, which become the
+ * segments of the result. The event blocks of the snapshot are split into
+ * more parts than there are threads, and the threads take the parts one
+ * after the other, so that a thread that finishes early takes over the
+ * remaining work. Every part yields partial sums by task and period, which
+ * are merged in the order of the parts, so that the result does not depend
+ * on the scheduling of the threads.
+ */
+class ParallelReport
+{
+public:
+    /** A part of the time span, from start to before end. */
+    struct Period {
+        QDate start;
+        QDate end;
+    };
+    typedef QVector<Period> PeriodList;
+
+    /** Split [ start, end ) into the days, weeks, months or years it touches.
+     * The first and the last period can be shorter than the others, a Range
+     * is one period. */
+    static PeriodList periods( const QDate& start, const QDate& end, TimeSpanType type );
+
+    /** Aggregate the events of @p data on @p threadCount threads, or on as
+     * many as there are cores if it is zero. */
+    explicit ParallelReport( const CharmDataSnapshot& data, int threadCount = 0 );
+
+    int threadCount() const;
+
+    /** The seconds of every task with events in @p periods, with one segment per period.
+     * The periods have to be consecutive. */
+    SecondsMap secondsByPeriod( const PeriodList& periods ) const;
+
+    /** The time sheet of the subtree under @p rootTask, with one segment per period. */
+    TimeSheetInfoList timeSheet( const PeriodList& periods, TaskId rootTask, bool activeTasksOnly ) const;
+
+private:
+    CharmDataSnapshot m_data;
+    int m_threadCount;
+};
+
+#endif
@@ -0,0 +1,186 @@
+/*
+  ReportCache.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ReportCache.h"
+
+#include "Core/CharmDataModel.h"
+
+bool ReportCache::Key::operator==( const Key& other ) const
+{
+    return report == other.report
+        && start == other.start
+        && end == other.end
+        && rootTasks == other.rootTasks
+        && excludedTasks == other.excludedTasks
+        && activeTasksOnly == other.activeTasksOnly
+        && options == other.options;
+}
+
+ReportCache::ReportCache( CharmDataModel* model, int capacity )
+    : m_model( model )
+    , m_capacity( capacity )
+{
+    Q_ASSERT( m_capacity > 0 );
+    m_model->registerAdapter( this );
+}
+
+ReportCache::~ReportCache()
+{
+    m_model->unregisterAdapter( this );
+}
+
+ReportCache::Result ReportCache::find( const Key& key )
+{
+    for ( int i = 0; i < m_entries.size(); ++i ) {
+        if ( m_entries[i].first == key ) {
+            m_entries.move( i, 0 );
+            return m_entries.first().second;
+        }
+    }
+    return Result();
+}
+
+void ReportCache::insert( const Key& key, const Result& result )
+{
+    Q_ASSERT( result.document );
+    // the model changed while the report was generated:
+    if ( result.version != m_model->version() )
+        return;
+    // running durations grow without a model change, the report would freeze them:
+    if ( containsActiveEvent( key ) )
+        return;
+
+    for ( int i = 0; i < m_entries.size(); ++i ) {
+        if ( m_entries[i].first == key ) {
+            m_entries.removeAt( i );
+            break;
+        }
+    }
+    m_entries.prepend( qMakePair( key, result ) );
+    while ( m_entries.size() > m_capacity )
+        m_entries.removeLast();
+}
+
+int ReportCache::size() const
+{
+    return m_entries.size();
+}
+
+void ReportCache::clear()
+{
+    m_entries.clear();
+}
+
+void ReportCache::invalidate( const Event& event )
+{
+    const QDate date = event.startDateTime().date();
+    if ( !date.isValid() ) {
+        clear();
+        return;
+    }
+
+    for ( int i = m_entries.size() - 1; i >= 0; --i ) {
+        const Key& key = m_entries[i].first;
+        if ( key.start <= date && date <= key.end )
+            m_entries.removeAt( i );
+    }
+}
+
+bool ReportCache::containsActiveEvent( const Key& key ) const
+{
+    Q_FOREACH( EventId id, m_model->activeEvents() ) {
+        const QDate date = m_model->eventForId( id ).startDateTime().date();
+        if ( !date.isValid() || ( key.start <= date && date <= key.end ) )
+            return true;
+    }
+    return false;
+}
+
+void ReportCache::resetTasks()
+{
+    clear();
+}
+
+void ReportCache::taskAboutToBeAdded( TaskId, int )
+{
+}
+
+void ReportCache::taskAdded( TaskId )
+{
+    clear();
+}
+
+void ReportCache::taskModified( TaskId )
+{
+    clear();
+}
+
+void ReportCache::taskParentChanged( TaskId, TaskId, TaskId )
+{
+    clear();
+}
+
+void ReportCache::taskAboutToBeDeleted( TaskId )
+{
+}
+
+void ReportCache::taskDeleted( TaskId )
+{
+    clear();
+}
+
+void ReportCache::resetEvents()
+{
+    clear();
+}
+
+void ReportCache::eventAboutToBeAdded( EventId )
+{
+}
+
+void ReportCache::eventAdded( EventId id )
+{
+    invalidate( m_model->eventForId( id ) );
+}
+
+void ReportCache::eventModified( EventId id, Event discardedEvent )
+{
+    invalidate( discardedEvent );
+    invalidate( m_model->eventForId( id ) );
+}
+
+void ReportCache::eventAboutToBeDeleted( EventId id )
+{
+    invalidate( m_model->eventForId( id ) );
+}
+
+void ReportCache::eventDeleted( EventId )
+{
+}
+
+void ReportCache::eventActivated( EventId id )
+{
+    invalidate( m_model->eventForId( id ) );
+}
+
+void ReportCache::eventDeactivated( EventId )
+{
+}
@@ -0,0 +1,116 @@
+/*
+  ReportCache.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef REPORTCACHE_H
+#define REPORTCACHE_H
+
+#include <QDate>
+#include <QList>
+#include <QPair>
+#include <QSet>
+#include <QStringList>
+
+#include "Core/CharmDataModelAdapterInterface.h"
+#include "ReportGenerator.h"
+
+class CharmDataModel;
+
+/**
+ * ReportCache keeps the documents of the most recently generated reports,
+ * so that going back to a report that was already shown does not compute
+ * it again.
+ *
+ * The cache follows the changes of the data model. A modified, added or
+ * deleted event drops the reports whose time span contains it, changes to
+ * the tasks drop all of them. Reports that contain a running event are not
+ * cached, since its duration grows without a change of the model. The
+ * cache is only used on the GUI thread.
+ */
+class ReportCache : public CharmDataModelAdapterInterface
+{
+public:
+    /** Identifies a report by its type and everything it was generated from. */
+    struct Key {
+        QString report;
+        QDate start;
+        QDate end;
+        QSet<TaskId> rootTasks;
+        QSet<TaskId> excludedTasks;
+        bool activeTasksOnly = false;
+        /** Other settings that change the output, like the user name or style sheet. */
+        QStringList options;
+
+        bool operator==( const Key& other ) const;
+    };
+
+    struct Result {
+        /** The model version the report was generated from. */
+        quint64 version = 0;
+        /** The document. Show copies of it, the cached one is never modified. */
+        ReportGenerator::DocumentPointer document;
+        /** The events of the report, for reports that render them later. */
+        EventIdList events;
+    };
+
+    explicit ReportCache( CharmDataModel* model, int capacity = 32 );
+    ~ReportCache() override;
+
+    /** Returns the result cached for @p key, and marks it as recently used.
+     * The document of the returned result is null if there is none. */
+    Result find( const Key& key );
+    /** Cache @p result for @p key. If the least recently used report has to
+     * make room for it, it is dropped. Results generated from an older
+     * version of the model, or containing a running event, are not cached. */
+    void insert( const Key& key, const Result& result );
+    int size() const;
+    void clear();
+
+    // reimplement CharmDataModelAdapterInterface:
+    void resetTasks() override;
+    void taskAboutToBeAdded( TaskId parent, int pos ) override;
+    void taskAdded( TaskId id ) override;
+    void taskModified( TaskId id ) override;
+    void taskParentChanged( TaskId task, TaskId oldParent, TaskId newParent ) override;
+    void taskAboutToBeDeleted( TaskId ) override;
+    void taskDeleted( TaskId id ) override;
+
+    void resetEvents() override;
+    void eventAboutToBeAdded( EventId id ) override;
+    void eventAdded( EventId id ) override;
+    void eventModified( EventId id, Event discardedEvent ) override;
+    void eventAboutToBeDeleted( EventId id ) override;
+    void eventDeleted( EventId id ) override;
+
+    void eventActivated( EventId id ) override;
+    void eventDeactivated( EventId id ) override;
+
+private:
+    /** Drop the reports that contain @p event. */
+    void invalidate( const Event& event );
+    bool containsActiveEvent( const Key& key ) const;
+
+    CharmDataModel* m_model;
+    int m_capacity;
+    // the most recently used entry first:
+    QList<QPair<Key, Result> > m_entries;
+};
+
+#endif
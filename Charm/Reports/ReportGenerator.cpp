@@ -0,0 +1,80 @@
+/*
+  ReportGenerator.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ReportGenerator.h"
+
+#include <QCoreApplication>
+#include <QFutureInterface>
+#include <QRunnable>
+#include <QScopedPointer>
+#include <QThreadPool>
+
+class ReportGeneratorTask : public QRunnable
+{
+public:
+    explicit ReportGeneratorTask( ReportGenerator* generator )
+        : m_generator( generator )
+    {
+        m_generator->m_futureInterface = &m_futureInterface;
+    }
+
+    QFuture<ReportGenerator::DocumentPointer> start()
+    {
+        m_futureInterface.reportStarted();
+        QFuture<ReportGenerator::DocumentPointer> future = m_futureInterface.future();
+        QThreadPool::globalInstance()->start( this );
+        return future;
+    }
+
+    void run() override
+    {
+        if ( !m_futureInterface.isCanceled() ) {
+            QScopedPointer<QTextDocument> document( m_generator->generate() );
+            if ( document && !m_futureInterface.isCanceled() ) {
+                // hand the document over to the GUI thread, which also deletes it:
+                document->moveToThread( QCoreApplication::instance()->thread() );
+                const ReportGenerator::DocumentPointer result( document.take(), &QObject::deleteLater );
+                m_futureInterface.reportResult( result );
+            }
+        }
+        m_futureInterface.reportFinished();
+    }
+
+private:
+    QScopedPointer<ReportGenerator> m_generator;
+    QFutureInterface<ReportGenerator::DocumentPointer> m_futureInterface;
+};
+
+ReportGenerator::~ReportGenerator()
+{
+}
+
+QFuture<ReportGenerator::DocumentPointer> ReportGenerator::start( ReportGenerator* generator )
+{
+    Q_ASSERT( generator );
+    auto task = new ReportGeneratorTask( generator );
+    return task->start();
+}
+
+bool ReportGenerator::isCanceled() const
+{
+    return m_futureInterface != nullptr && m_futureInterface->isCanceled();
+}
@@ -0,0 +1,63 @@
+/*
+  ReportGenerator.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef REPORTGENERATOR_H
+#define REPORTGENERATOR_H
+
+#include <QFuture>
+#include <QSharedPointer>
+#include <QTextDocument>
+
+/**
+ * A report generator creates the document of a report on a worker thread.
+ *
+ * Everything a generator needs has to be copied into it on the GUI thread
+ * before it is started, usually a snapshot of the tasks and events of the
+ * data model. While running, it must not access DATAMODEL or any widget.
+ * Generators should check isCanceled() regularly, and return early once
+ * their result is no longer wanted.
+ */
+class ReportGenerator
+{
+public:
+    typedef QSharedPointer<QTextDocument> DocumentPointer;
+
+    virtual ~ReportGenerator();
+
+    /** Run @p generator on the global thread pool. The generator is
+     * deleted on the worker thread once it is done. The returned future
+     * holds the document, which belongs to the GUI thread, unless the
+     * generation was canceled. */
+    static QFuture<DocumentPointer> start( ReportGenerator* generator );
+
+    bool isCanceled() const;
+
+protected:
+    /** Create the report document, or return nullptr if canceled.
+     * Called on a worker thread. */
+    virtual QTextDocument* generate() = 0;
+
+private:
+    friend class ReportGeneratorTask;
+    const QFutureInterface<DocumentPointer>* m_futureInterface = nullptr;
+};
+
+#endif
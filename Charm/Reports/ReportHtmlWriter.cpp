@@ -0,0 +1,102 @@
+/*
+  ReportHtmlWriter.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ReportHtmlWriter.h"
+
+#include <QTextDocument>
+
+ReportHtmlWriter::ReportHtmlWriter()
+    : m_writer( &m_html )
+{
+    // create XHTML v1.0 structure:
+    // FIXME this is only a rudimentary subset of a valid xhtml 1 document
+    m_writer.writeDTD( QLatin1String( "<!DOCTYPE html>" ) );
+    m_writer.writeStartElement( QLatin1String( "html" ) );
+    m_writer.writeDefaultNamespace( QLatin1String( "http://www.w3.org/1999/xhtml" ) );
+    m_writer.writeEmptyElement( QLatin1String( "head" ) );
+    m_writer.writeStartElement( QLatin1String( "body" ) );
+}
+
+void ReportHtmlWriter::startElement( const QString& name )
+{
+    m_writer.writeStartElement( name );
+}
+
+void ReportHtmlWriter::attribute( const QString& name, const QString& value )
+{
+    m_writer.writeAttribute( name, value );
+}
+
+void ReportHtmlWriter::text( const QString& text )
+{
+    // also closes the start tag for empty texts, which keeps <td></td> from becoming <td/>:
+    m_writer.writeCharacters( text );
+}
+
+void ReportHtmlWriter::endElement()
+{
+    m_writer.writeEndElement();
+}
+
+void ReportHtmlWriter::textElement( const QString& name, const QString& text )
+{
+    startElement( name );
+    this->text( text );
+    endElement();
+}
+
+void ReportHtmlWriter::emptyElement( const QString& name )
+{
+    m_writer.writeEmptyElement( name );
+}
+
+void ReportHtmlWriter::link( const QString& href, const QString& text )
+{
+    startElement( QLatin1String( "a" ) );
+    attribute( QLatin1String( "href" ), href );
+    this->text( text );
+    endElement();
+}
+
+void ReportHtmlWriter::startTable()
+{
+    startElement( QLatin1String( "table" ) );
+    attribute( QLatin1String( "width" ), QLatin1String( "100%" ) );
+    attribute( QLatin1String( "align" ), QLatin1String( "left" ) );
+    attribute( QLatin1String( "cellpadding" ), QLatin1String( "3" ) );
+    attribute( QLatin1String( "cellspacing" ), QLatin1String( "0" ) );
+}
+
+QString ReportHtmlWriter::html()
+{
+    m_writer.writeEndDocument();
+    return m_html;
+}
+
+QTextDocument* ReportHtmlWriter::createDocument( const QString& styleSheet )
+{
+    auto document = new QTextDocument;
+    // NOTE: seems like the style sheet has to be set before the html
+    // code is pushed into the QTextDocument
+    document->setDefaultStyleSheet( styleSheet );
+    document->setHtml( html() );
+    return document;
+}
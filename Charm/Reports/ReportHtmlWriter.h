@@ -0,0 +1,68 @@
+/*
+  ReportHtmlWriter.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef REPORTHTMLWRITER_H
+#define REPORTHTMLWRITER_H
+
+#include <QString>
+#include <QXmlStreamWriter>
+
+class QTextDocument;
+
+/**
+ * ReportHtmlWriter writes the XHTML of a report in one pass.
+ *
+ * Reports used to assemble a QDomDocument and serialize it before the
+ * QTextDocument parsed the result. The writer produces the same markup
+ * directly into one string, without the intermediate tree.
+ * Elements are written in document order, startElement() and endElement()
+ * have to be balanced.
+ */
+class ReportHtmlWriter
+{
+public:
+    /** Start the document, and open its body. */
+    ReportHtmlWriter();
+
+    void startElement( const QString& name );
+    void attribute( const QString& name, const QString& value );
+    void text( const QString& text );
+    void endElement();
+
+    /** Write an element that only contains text. */
+    void textElement( const QString& name, const QString& text );
+    void emptyElement( const QString& name );
+    /** Write a link to @p href. */
+    void link( const QString& href, const QString& text );
+    /** Open a table with the layout shared by all reports. */
+    void startTable();
+
+    /** Close all open elements and return the XHTML. */
+    QString html();
+    /** Close all open elements and create the document, using the style sheet. */
+    QTextDocument* createDocument( const QString& styleSheet );
+
+private:
+    QString m_html;
+    QXmlStreamWriter m_writer;
+};
+
+#endif
@@ -25,6 +25,8 @@
 
 #include "Core/CharmDataModel.h"
 
+#include <algorithm>
+
 TimeSheetInfo::TimeSheetInfo(int segments)
     : seconds( segments )
 {
@@ -39,6 +41,15 @@ int TimeSheetInfo::total() const
     return value;
 }
 
+bool TimeSheetInfo::operator==( const TimeSheetInfo& other ) const
+{
+    return indentation == other.indentation
+            && taskName == other.taskName
+            && seconds == other.seconds
+            && taskId == other.taskId
+            && aggregated == other.aggregated;
+}
+
 void TimeSheetInfo::dump()
 {
     qDebug() << "TimeSheetInfo: (" << indentation << ")" << formattedTaskIdAndName( 6 ) << ":" << seconds << "-" << total() << "total";
@@ -121,3 +132,108 @@ TimeSheetInfoList TimeSheetInfo::filteredTaskWithSubTasks(
 
     return timeSheetInfo;
 }
+
+static bool higherTaskId( const TaskTreeItem* left, const TaskTreeItem* right )
+{
+    return left->task().id() > right->task().id();
+}
+
+TimeSheetInfoList TimeSheetInfo::filteredTaskWithSubTasks( const TaskTree& tasks, int segments, TaskId id,
+                                                           const SecondsMap& secondsMap, bool activeTasksOnly )
+{
+    const TaskTreeItem& rootItem = tasks.item( id );
+    // real task or virtual root item
+    Q_ASSERT( rootItem.task().isValid() || id == 0 );
+
+    const TaskSubtreeRange range = rootItem.subtreeRange();
+    const int sizeHint = range.isValid() ? range.last - range.first + 1 : tasks.size() + 1;
+
+    // lay out the subtree in pre-order, children sorted by task id, remembering every row's parent:
+    QVector<const TaskTreeItem*> items;
+    QVector<int> parentRows;
+    QVector<int> indentations;
+    items.reserve( sizeHint );
+    parentRows.reserve( sizeHint );
+    indentations.reserve( sizeHint );
+
+    QVector<QPair<const TaskTreeItem*, int> > pending; // item and parent row
+    QVector<const TaskTreeItem*> children;
+    pending.append( qMakePair( &rootItem, -1 ) );
+    while ( !pending.isEmpty() ) {
+        const QPair<const TaskTreeItem*, int> next = pending.last();
+        pending.removeLast();
+        const int row = items.size();
+        items.append( next.first );
+        parentRows.append( next.second );
+        if ( next.second == -1 ) {
+            indentations.append( id == 0 ? -1 : 0 );
+        } else {
+            indentations.append( indentations[next.second] + 1 );
+        }
+
+        // push the children in descending id order, so that the lowest id is processed first:
+        children.resize( next.first->childCount() );
+        for ( int i = 0; i < children.size(); ++i )
+            children[i] = &next.first->child( i );
+        std::sort( children.begin(), children.end(), higherTaskId );
+        Q_FOREACH( const TaskTreeItem* child, children ) {
+            pending.append( qMakePair( child, row ) );
+        }
+    }
+
+    // fill in the seconds of every task, then add every row to its parent, bottom-up
+    // (children always follow their parent in pre-order):
+    const int rowCount = items.size();
+    QVector<int> seconds( rowCount * segments, 0 );
+    QVector<bool> aggregated( rowCount, false );
+    for ( int row = 0; row < rowCount; ++row ) {
+        const TaskId taskId = row == 0 ? id : items[row]->task().id();
+        if ( taskId == 0 )
+            continue;
+        const SecondsMap::const_iterator it = secondsMap.constFind( taskId );
+        if ( it == secondsMap.constEnd() )
+            continue;
+        const int count = qMin( segments, it.value().size() );
+        std::copy( it.value().constBegin(), it.value().constBegin() + count, seconds.begin() + row * segments );
+    }
+    int* const values = seconds.data();
+    for ( int row = rowCount - 1; row > 0; --row ) {
+        const int parentRow = parentRows[row];
+        const int* source = values + row * segments;
+        int* target = values + parentRow * segments;
+        for ( int i = 0; i < segments; ++i )
+            target[i] += source[i];
+        aggregated[parentRow] = true;
+    }
+
+    // emit the rows:
+    TimeSheetInfoList result;
+    result.reserve( rowCount );
+    for ( int row = 0; row < rowCount; ++row ) {
+        const int* source = values + row * segments;
+        if ( activeTasksOnly ) {
+            int total = 0;
+            for ( int i = 0; i < segments; ++i )
+                total += source[i];
+            if ( total <= 0 )
+                continue;
+        }
+
+        TimeSheetInfo info( segments );
+        std::copy( source, source + segments, info.seconds.begin() );
+        info.indentation = indentations[row];
+        info.aggregated = aggregated[row];
+        if ( row == 0 ) {
+            if ( id != 0 ) {
+                info.taskId = id;
+                info.taskName = rootItem.task().name();
+            }
+        } else {
+            info.taskId = items[row]->task().id();
+            info.taskName = items[row]->task().name();
+        }
+        result.append( info );
+    }
+
+    return result;
+}
@@ -25,12 +25,14 @@
 #define TIMESHEETINFO_H
 
 #include <QList>
+#include <QMap>
 #include <QString>
 #include <QVector>
 
 #include "Core/Task.h"
 
 class CharmDataModel;
+class TaskTree;
 class TimeSheetInfo;
 typedef QList<TimeSheetInfo> TimeSheetInfoList;
 
@@ -43,7 +45,16 @@ public:
     int total() const;
     void dump();
 
+    bool operator==( const TimeSheetInfo& other ) const;
+
 public:
+    /** Aggregate the seconds of the subtree under id and list it in pre-order, children sorted by task id.
+     * This is done in a single pass: the seconds are accumulated bottom-up in one preallocated array
+     * and every row is created once. Rows without any time are skipped if activeTasksOnly is set. */
+    static TimeSheetInfoList filteredTaskWithSubTasks( const TaskTree& tasks, int segments, TaskId id,
+                                                       const SecondsMap& secondsMap, bool activeTasksOnly );
+
+    // the recursive implementation, kept as the reference for tests and benchmarks:
     static TimeSheetInfoList taskWithSubTasks( const CharmDataModel* dataModel, int segments, TaskId id, const SecondsMap& secondsMap, TimeSheetInfo* addTo = 0 );
     static TimeSheetInfoList filteredTaskWithSubTasks( TimeSheetInfoList timeSheetInfo, bool activeTasksOnly );
 
@@ -28,7 +28,7 @@
 #include "Core/CharmDataModel.h"
 #include <Core/XmlSerialization.h>
 
-#include <QDomDocument>
+#include <QBuffer>
 
 static const int DaysInWeek = 7;
 
@@ -62,49 +62,42 @@ void WeeklyTimesheetXmlWriter::setRootTask( TaskId rootTask )
 }
 
 QByteArray WeeklyTimesheetXmlWriter::saveToXml() const
+{
+    QByteArray data;
+    QBuffer buffer( &data );
+    buffer.open( QIODevice::WriteOnly );
+    writeTo( &buffer );
+    return data;
+}
+
+void WeeklyTimesheetXmlWriter::writeTo( QIODevice* device ) const
 {
     // now create the report:
-    QDomDocument document = XmlSerialization::createXmlTemplate( "weekly-timesheet" );
-
-    // find metadata and report element:
-    QDomElement root = document.documentElement();
-    QDomElement metadata = XmlSerialization::metadataElement( document );
-    QDomElement charmVersion = document.createElement( "charmversion" );
-    QDomText charmVersionString = document.createTextNode( CHARM_VERSION );
-    charmVersion.appendChild( charmVersionString );
-    metadata.appendChild( charmVersion );
-    QDomElement report = XmlSerialization::reportElement( document );
-    Q_ASSERT( !root.isNull() && !metadata.isNull() && !report.isNull() );
+    XmlReportWriter writer( device, "weekly-timesheet" );
+    writer.textElement( "charmversion", CHARM_VERSION );
 
     // extend metadata tag: add year, and serial (week) number:
-    {
-        QDomElement yearElement = document.createElement( "year" );
-        metadata.appendChild( yearElement );
-        QDomText text = document.createTextNode( QString::number( m_year ) );
-        yearElement.appendChild( text );
-        QDomElement weekElement = document.createElement( "serial-number" );
-        weekElement.setAttribute( "semantics", "week-number" );
-        metadata.appendChild( weekElement );
-        QDomText weektext = document.createTextNode( QString::number( m_weekNumber ) );
-        weekElement.appendChild( weektext );
-    }
-
+    writer.textElement( "year", QString::number( m_year ) );
+    writer.startElement( "serial-number" );
+    writer.attribute( "semantics", "week-number" );
+    writer.text( QString::number( m_weekNumber ) );
+    writer.endElement();
+    writer.startReport();
 
     typedef QMap< TaskId, QVector<int> > SecondsMap;
     SecondsMap secondsMap;
     TimeSheetInfoList timeSheetInfo = TimeSheetInfo::filteredTaskWithSubTasks(
-        TimeSheetInfo::taskWithSubTasks( m_dataModel, DaysInWeek, m_rootTask, secondsMap ),
+        m_dataModel->taskTree(), DaysInWeek, m_rootTask, secondsMap,
         false ); // here, we don't care about active or not, because we only report on the tasks
 
     // extend report tag: add tasks and effort structure
     {   // tasks
-        QDomElement tasks = document.createElement( "tasks" );
-        report.appendChild( tasks );
+        writer.startElement( "tasks" );
         Q_FOREACH ( const TimeSheetInfo& info, timeSheetInfo ) {
             if ( info.taskId == 0 ) // the root task
                 continue;
             const Task& modelTask = m_dataModel->getTask( info.taskId );
-            tasks.appendChild( modelTask.toXml( document ) );
+            modelTask.writeXml( &writer );
 //             TaskId parentTask = DATAMODEL->parentItem( modelTask ).task().id();
 //             QDomElement task = document.createElement( "task" );
 //             task.setAttribute( "taskid", QString::number( info.taskId ) );
@@ -115,11 +108,11 @@ QByteArray WeeklyTimesheetXmlWriter::saveToXml() const
 //             task.appendChild( name );
 //             tasks.appendChild( task );
         }
+        writer.endElement();
     }
     {   // effort
         // make effort element:
-        QDomElement effort = document.createElement( "effort" );
-        report.appendChild( effort );
+        writer.startElement( "effort" );
 
         // aggregate (group by task and day):
         typedef QPair<TaskId, QDate> Key;
@@ -155,6 +148,7 @@ QByteArray WeeklyTimesheetXmlWriter::saveToXml() const
                 // add this event:
                 events[key] = event;
                 events[key].setId( -events[key].id() ); // "synthetic" :-)
+                events[key].setRunning( false ); // the end is set below
                 // move to start at midnight in UTC (for privacy reasons)
                 // never, never, never use setTime() here, it breaks on DST changes! (twice a year)
                 QDateTime start( event.startDateTime().date(), QTime(0, 0, 0, 0), Qt::UTC );
@@ -167,9 +161,10 @@ QByteArray WeeklyTimesheetXmlWriter::saveToXml() const
         }
         // create elements:
         Q_FOREACH ( const Event & event, events ) {
-            effort.appendChild( event.toXml( document ) );
+            event.writeXml( &writer );
         }
+        writer.endElement();
     }
 
-    return document.toByteArray( 4 );
+    writer.finish();
 }
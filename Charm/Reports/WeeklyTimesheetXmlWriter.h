@@ -28,6 +28,7 @@
 #include "Core/Task.h"
 
 class QByteArray;
+class QIODevice;
 class CharmDataModel;
 
 class WeeklyTimesheetXmlWriter {
@@ -37,6 +38,11 @@ public:
      * @throws XmlSerializationException
      */
     QByteArray saveToXml() const;
+    /**
+     * Write the same document as saveToXml() to @p device, while it is produced.
+     * @throws XmlSerializationException
+     */
+    void writeTo( QIODevice* device ) const;
 
     void setDataModel( const CharmDataModel* model);
     void setYear( int year );
@@ -41,6 +41,8 @@ TaskModelAdapter::TaskModelAdapter( CharmDataModel* parent )
     , m_dataModel( parent )
 {
     m_dataModel->registerAdapter( this );
+    connect( m_dataModel, SIGNAL(activeEventDurationsChanged()),
+             SLOT(slotActiveEventDurationsChanged()) );
 }
 
 TaskModelAdapter::~TaskModelAdapter()
@@ -155,7 +157,7 @@ QModelIndex TaskModelAdapter::parent( const QModelIndex & index ) const
     if ( ! index.isValid() ) return QModelIndex();
 
     const TaskTreeItem* item = itemFor( index );
-    const TaskTreeItem& parent = m_dataModel->parentItem( item->task() );
+    const TaskTreeItem& parent = item->parent();
     if ( !parent.isValid() )
         return QModelIndex(); // top level item
 
@@ -259,7 +261,7 @@ void TaskModelAdapter::taskModified( TaskId id )
 void TaskModelAdapter::taskAboutToBeDeleted( TaskId id )
 {
     const TaskTreeItem& item = m_dataModel->taskTreeItem( id );
-    const TaskTreeItem& parent = m_dataModel->parentItem( item.task() );
+    const TaskTreeItem& parent = item.parent();
     int row = item.row();
     Q_ASSERT( row != -1 );
 
@@ -319,10 +321,23 @@ void TaskModelAdapter::eventDeactivated( EventId id )
     }
 }
 
+void TaskModelAdapter::slotActiveEventDurationsChanged()
+{
+    // only the rows of the active tasks show a running time:
+    Q_FOREACH( EventId id, m_dataModel->activeEvents() ) {
+        const Event& event = m_dataModel->eventForId( id );
+        const TaskTreeItem& item = m_dataModel->taskTreeItem( event.taskId() );
+        if ( item.isValid() ) {
+            const QModelIndex index = indexForTaskTreeItem( item, Column_TaskId );
+            emit dataChanged( index, index );
+        }
+    }
+}
+
 const TaskTreeItem* TaskModelAdapter::itemFor ( const QModelIndex& index ) const
 {
     if ( index.isValid() ) {
-        return static_cast<TaskTreeItem*>( index.internalPointer() );
+        return &m_dataModel->taskTree().itemAt( static_cast<int>( index.internalId() ) );
     } else {
         return &m_dataModel->taskTreeItem( 0 );
     }
@@ -332,11 +347,9 @@ QModelIndex TaskModelAdapter::indexForTaskTreeItem( const TaskTreeItem& item,
                                                     int column ) const
 {
     if ( item.isValid() ) {
-        // argl UUUUGGGLLYYYY
-        // DF: how about reinterpret_cast<void*>(&item) ?
-        const void* constVoidPointer = static_cast<const void*>( &item );
-        void* voidPointer = const_cast<void*>( constVoidPointer );
-        return createIndex( item.row(), column, voidPointer );
+        // the storage index is stable, while the item's address changes when tasks are added:
+        const int id = item.index();
+        return createIndex( item.row(), column, id );
     } else {
         return QModelIndex();
     }
@@ -51,8 +51,8 @@ typedef ViewColumns ViewColumn;
 /** TaskModelAdapter adapts the CharmDataModel to be used in the task view
     (in main view and "select task" dialog).
 
-    It is a QAbstractItemModel, and stores the TaskTreeItem pointer of
-    the respective address in the model indexes internal pointer.
+    It is a QAbstractItemModel, and stores the storage index of the
+    respective TaskTreeItem in the task tree as the model indexes internal id.
 */
 class TaskModelAdapter :  public QAbstractItemModel,
                           public TaskModelInterface,
@@ -109,6 +109,9 @@ signals:
     void eventActivationNotice( EventId id ) override;
     void eventDeactivationNotice( EventId id ) override;
 
+private slots:
+    void slotActiveEventDurationsChanged();
+
 private:
     const TaskTreeItem* itemFor ( const QModelIndex& ) const;
     QModelIndex indexForTaskTreeItem( const TaskTreeItem& item, int column = 0 ) const;
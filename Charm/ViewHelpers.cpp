@@ -25,6 +25,7 @@
 
 #include <QtAlgorithms>
 #include <QFile>
+#include <QVector>
 
 void Charm::connectControllerAndView( Controller* controller, CharmWindow* view )
 {
@@ -39,27 +40,40 @@ void Charm::connectControllerAndView( Controller* controller, CharmWindow* view
                       view, SLOT(commitCommand(CharmCommand*)) );
 }
 
+template <typename Data>
 struct StartsEarlier {
+    explicit StartsEarlier( const Data& data )
+        : m_data( data )
+    {}
+
     bool operator()( const EventId& leftId, const EventId& rightId ) const {
-        const Event& left = DATAMODEL->eventForId( leftId );
-        const Event& right = DATAMODEL->eventForId( rightId );
+        const Event& left = m_data.eventForId( leftId );
+        const Event& right = m_data.eventForId( rightId );
         return left.startDateTime() < right.startDateTime();
     }
+
+    const Data& m_data;
 };
 
 EventIdList Charm::eventIdsSortedByStartTime( EventIdList ids )
 {
-    qStableSort( ids.begin(), ids.end(), StartsEarlier() );
+    qStableSort( ids.begin(), ids.end(), StartsEarlier<CharmDataModel>( *DATAMODEL ) );
+    return ids;
+}
+
+EventIdList Charm::eventIdsSortedByStartTime( const CharmDataSnapshot& data, EventIdList ids )
+{
+    qStableSort( ids.begin(), ids.end(), StartsEarlier<CharmDataSnapshot>( data ) );
     return ids;
 }
 
 EventIdList Charm::filteredBySubtree( EventIdList ids, TaskId parent, bool exclude )
 {
     EventIdList result;
-    bool isParent = false;
+    const TaskSubtreeRange range = DATAMODEL->subtreeRange( parent );
     Q_FOREACH( EventId id, ids ) {
         const Event& event = DATAMODEL->eventForId( id );
-        isParent = ( parent == event.taskId() || DATAMODEL->isParentOf( parent, event.taskId() ) );
+        const bool isParent = range.contains( DATAMODEL->subtreeOrdinal( event.taskId() ) );
         if ( isParent != exclude ) {
             result << id;
         }
@@ -67,6 +81,59 @@ EventIdList Charm::filteredBySubtree( EventIdList ids, TaskId parent, bool exclu
     return result;
 }
 
+template <typename Data>
+static QVector<TaskSubtreeRange> subtreeRanges( const Data& data, const QSet<TaskId>& ids )
+{
+    QVector<TaskSubtreeRange> ranges;
+    ranges.reserve( ids.size() );
+    Q_FOREACH( TaskId id, ids ) {
+        const TaskSubtreeRange range = data.subtreeRange( id );
+        if ( range.isValid() )
+            ranges.append( range );
+    }
+    return ranges;
+}
+
+static bool anyRangeContains( const QVector<TaskSubtreeRange>& ranges, int ordinal )
+{
+    for ( int i = 0; i < ranges.size(); ++i ) {
+        if ( ranges[i].contains( ordinal ) )
+            return true;
+    }
+    return false;
+}
+
+template <typename Data>
+static EventIdList filteredBySubtrees( const Data& data, const EventIdList& ids,
+                                       const QSet<TaskId>& includes, const QSet<TaskId>& excludes )
+{
+    const QVector<TaskSubtreeRange> includeRanges = subtreeRanges( data, includes );
+    const QVector<TaskSubtreeRange> excludeRanges = subtreeRanges( data, excludes );
+    EventIdList result;
+    Q_FOREACH( EventId id, ids ) {
+        const Event& event = data.eventForId( id );
+        const int ordinal = data.subtreeOrdinal( event.taskId() );
+        if ( !includes.isEmpty() && !anyRangeContains( includeRanges, ordinal ) )
+            continue;
+        if ( anyRangeContains( excludeRanges, ordinal ) )
+            continue;
+        result << id;
+    }
+    return result;
+}
+
+EventIdList Charm::filteredBySubtrees( const EventIdList& ids, const QSet<TaskId>& includes,
+                                       const QSet<TaskId>& excludes )
+{
+    return ::filteredBySubtrees( *DATAMODEL, ids, includes, excludes );
+}
+
+EventIdList Charm::filteredBySubtrees( const CharmDataSnapshot& data, const EventIdList& ids,
+                                       const QSet<TaskId>& includes, const QSet<TaskId>& excludes )
+{
+    return ::filteredBySubtrees( data, ids, includes, excludes );
+}
+
 QString Charm::elidedTaskName( const QString& text, const QFont& font, int width )
 {
     QFontMetrics metrics( font );
@@ -24,6 +24,8 @@
 #ifndef VIEWHELPERS_H
 #define VIEWHELPERS_H
 
+#include <QSet>
+
 #include "Core/Event.h"
 #include "Core/CharmConstants.h"
 
@@ -38,9 +40,17 @@
 namespace Charm {
     void connectControllerAndView( Controller*, CharmWindow* );
     EventIdList eventIdsSortedByStartTime( EventIdList );
+    EventIdList eventIdsSortedByStartTime( const CharmDataSnapshot&, EventIdList );
     /** Return those ids in the input list that elements of the subtree
      * under the parent task, which includes the parent task. */
     EventIdList filteredBySubtree( EventIdList, TaskId parent, bool exclude=false );
+    /** Return those ids in the input list that are elements of at least one
+     * of the included subtrees (or all, if includes is empty), and of none of
+     * the excluded subtrees. The list is traversed only once. */
+    EventIdList filteredBySubtrees( const EventIdList&, const QSet<TaskId>& includes,
+                                    const QSet<TaskId>& excludes );
+    EventIdList filteredBySubtrees( const CharmDataSnapshot&, const EventIdList&,
+                                    const QSet<TaskId>& includes, const QSet<TaskId>& excludes );
     QString elidedTaskName( const QString& text, const QFont& font, int width );
     QString reportStylesheet( const QPalette& palette );
 }
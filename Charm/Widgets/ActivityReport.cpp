@@ -32,11 +32,14 @@
 #include "Core/Configuration.h"
 #include "Core/Dates.h"
 
+#include "Reports/ReportHtmlWriter.h"
+
 #include <QCalendarWidget>
-#include <QDomDocument>
-#include <QDomElement>
 #include <QFile>
 #include <QPushButton>
+#include <QScrollBar>
+#include <QTextBrowser>
+#include <QTextTable>
 #include <QTimer>
 #include <QtAlgorithms>
 #include <QUrl>
@@ -208,6 +211,45 @@ void ActivityReportConfigurationDialog::showReportPreviewDialog()
     report->show();
 }
 
+namespace {
+    // events rendered into the preview at once, more are added when scrolling down:
+    static const int EventsPerPage = 250;
+    // the table row of the first event, below the header:
+    static const int FirstEventRow = 1;
+    // the generated document carries all events of the report in this property:
+    static const char EventsProperty[] = "charmReportEvents";
+}
+
+// the events of a report, and how many of them are rendered into its document;
+// only used on the GUI thread:
+struct ActivityReport::EventRows
+{
+    CharmDataSnapshot data;
+    EventIdList events;
+    int taskPaddingLength = 0;
+    int shown = 0;
+};
+
+class ActivityReport::Generator : public ReportGenerator
+{
+public:
+    CharmDataSnapshot data;
+    QDate start;
+    QDate end;
+    QSet<TaskId> rootTasks;
+    QSet<TaskId> rootExcludeTasks;
+    QString timeSpanTypeName;
+    QString userName;
+    int taskPaddingLength = 0;
+    QString styleSheet;
+
+protected:
+    QTextDocument* generate() override
+    {
+        return createDocument( *this );
+    }
+};
+
 ActivityReport::ActivityReport( QWidget* parent )
     : ReportPreviewWindow( parent )
 {
@@ -215,6 +257,14 @@ ActivityReport::ActivityReport( QWidget* parent )
     saveToTextButton()->hide();
     uploadButton()->hide();
     connect( this, SIGNAL(anchorClicked(QUrl)), SLOT(slotLinkClicked(QUrl)) );
+    // more rows are needed when the end of the shown ones comes into view, by
+    // scrolling, by moving the cursor, or because the window is large enough:
+    connect( textBrowser()->verticalScrollBar(), SIGNAL(valueChanged(int)),
+             SLOT(slotShowMoreRows()) );
+    connect( textBrowser()->verticalScrollBar(), SIGNAL(rangeChanged(int,int)),
+             SLOT(slotShowMoreRows()), Qt::QueuedConnection );
+    connect( textBrowser(), SIGNAL(cursorPositionChanged()),
+             SLOT(slotShowMoreRows()) );
 }
 
 ActivityReport::~ActivityReport()
@@ -237,31 +287,6 @@ void ActivityReport::timeSpanSelection( NamedTimeSpan timeSpanSelection )
 
 void ActivityReport::slotUpdate()
 {
-    // retrieve matching events:
-    EventIdList matchingEvents = DATAMODEL->eventsThatStartInTimeFrame( m_start, m_end );
-    
-    if( !m_rootTasks.isEmpty() ) {
-        QSet<EventId> filteredEvents;
-        Q_FOREACH( TaskId include,  m_rootTasks ) {
-           filteredEvents |= Charm::filteredBySubtree( matchingEvents, include ).toSet();
-        }
-        matchingEvents = filteredEvents.toList();
-    }
-    matchingEvents = Charm::eventIdsSortedByStartTime( matchingEvents );
-
-    // filter unproductive events:
-    Q_FOREACH( TaskId exclude,  m_rootExcludeTasks ) {
-        matchingEvents = Charm::filteredBySubtree( matchingEvents, exclude, true );
-    }
-
-    // calculate total:
-    int totalSeconds = 0;
-    Q_FOREACH( EventId id, matchingEvents ) {
-        const Event& event = DATAMODEL->eventForId( id );
-        Q_ASSERT( event.isValid() );
-        totalSeconds += event.duration();
-    }
-
     // which TimeSpan type
     QString timeSpanTypeName;
     switch( m_timeSpanSelection.timeSpanType ) {
@@ -284,60 +309,91 @@ void ActivityReport::slotUpdate()
         Q_ASSERT( false ); // should not happen
     }
 
-    auto report = new QTextDocument( this );
-    QDomDocument doc = createReportTemplate();
-    QDomElement root = doc.documentElement();
-    QDomElement body = root.firstChildElement( "body" );
+    const QString userName = CONFIGURATION.user.name();
+    const int taskPaddingLength = Configuration::instance().taskPaddingLength;
+    const QString styleSheet = Charm::reportStylesheet( palette() );
+
+    ReportCache::Key key;
+    key.report = QLatin1String( "activity" );
+    key.start = m_start;
+    key.end = m_end;
+    key.rootTasks = m_rootTasks;
+    key.excludedTasks = m_rootExcludeTasks;
+    key.options << timeSpanTypeName << userName << QString::number( taskPaddingLength ) << styleSheet;
+
+    // the matching events are kept, to render the rows that are not shown yet:
+    m_pendingRows.reset( new EventRows );
+    m_pendingRows->data = DATAMODEL->snapshot();
+    m_pendingRows->taskPaddingLength = taskPaddingLength;
+
+    ReportCache::Result cached;
+    if ( showCachedDocument( key, &cached ) ) {
+        // cached reports are up to date, their events did not change since:
+        m_pendingRows->events = cached.events;
+        m_pendingRows->shown = qMin( cached.events.size(), EventsPerPage );
+        m_rows = m_pendingRows;
+        m_pendingRows.clear();
+        QTimer::singleShot( 0, this, SLOT(slotShowMoreRows()) );
+        return;
+    }
 
-    // create the caption:
-    {
-        QDomElement headline = doc.createElement( "h1" );
-        QDomText text = doc.createTextNode( tr( "Activity Report" ) );
-        headline.appendChild( text );
-        body.appendChild( headline );
+    // the document is created on a worker thread, from a snapshot of the data:
+    auto generator = new Generator;
+    generator->data = m_pendingRows->data;
+    generator->start = m_start;
+    generator->end = m_end;
+    generator->rootTasks = m_rootTasks;
+    generator->rootExcludeTasks = m_rootExcludeTasks;
+    generator->timeSpanTypeName = timeSpanTypeName;
+    generator->userName = userName;
+    generator->taskPaddingLength = taskPaddingLength;
+    generator->styleSheet = styleSheet;
+    generateDocument( generator, key );
+}
+
+QTextDocument* ActivityReport::createDocument( const Generator& input )
+{
+    const CharmDataSnapshot& data = input.data;
+    // retrieve matching events:
+    EventIdList matchingEvents = data.eventsThatStartInTimeFrame( input.start, input.end );
+
+    // keep events under the selected tasks, filter unproductive events:
+    matchingEvents = Charm::filteredBySubtrees( data, matchingEvents, input.rootTasks, input.rootExcludeTasks );
+    matchingEvents = Charm::eventIdsSortedByStartTime( data, matchingEvents );
+
+    // calculate total:
+    int totalSeconds = 0;
+    Q_FOREACH( EventId id, matchingEvents ) {
+        const Event& event = data.eventForId( id );
+        Q_ASSERT( event.isValid() );
+        totalSeconds += event.duration();
     }
+
+    ReportHtmlWriter writer;
+
+    // create the caption:
+    writer.textElement( "h1", tr( "Activity Report" ) );
     {
-        QDomElement headline = doc.createElement( "h3" );
         QString content = tr( "Report for %1, from %2 to %3" )
-                          .arg( CONFIGURATION.user.name() )
-                          .arg( m_start.toString( Qt::TextDate ) )
-                          .arg( m_end.toString( Qt::TextDate ) );
-        QDomText text = doc.createTextNode( content );
-        headline.appendChild( text );
-        body.appendChild( headline );
-        QDomElement previousLink = doc.createElement( "a" );
-        previousLink.setAttribute( "href" , "Previous" );
-        QDomText previousLinkText = doc.createTextNode( tr( "<Previous %1>" ).arg( timeSpanTypeName ) );
-        previousLink.appendChild( previousLinkText );
-        body.appendChild( previousLink );
-        QDomElement nextLink = doc.createElement( "a" );
-        nextLink.setAttribute( "href" , "Next" );
-        QDomText nextLinkText = doc.createTextNode( tr( "<Next %1>" ).arg( timeSpanTypeName ) );
-        nextLink.appendChild( nextLinkText );
-        body.appendChild( nextLink );
-        {
-            QDomElement paragraph = doc.createElement( "h4" );
-            QString totalsText = tr( "Total: %1" ).arg( hoursAndMinutes( totalSeconds ) );
-            QDomText totalsElement = doc.createTextNode( totalsText );
-            paragraph.appendChild( totalsElement );
-            body.appendChild( paragraph );
-        }
-        if ( !m_rootTasks.isEmpty() ) {
-            QDomElement paragraph = doc.createElement( "p" );
+                          .arg( input.userName )
+                          .arg( input.start.toString( Qt::TextDate ) )
+                          .arg( input.end.toString( Qt::TextDate ) );
+        writer.textElement( "h3", content );
+        writer.link( "Previous", tr( "<Previous %1>" ).arg( input.timeSpanTypeName ) );
+        writer.link( "Next", tr( "<Next %1>" ).arg( input.timeSpanTypeName ) );
+        writer.textElement( "h4", tr( "Total: %1" ).arg( hoursAndMinutes( totalSeconds ) ) );
+        if ( !input.rootTasks.isEmpty() ) {
             QString rootTaskText = tr( "Activity under tasks:" );
 
-            Q_FOREACH( TaskId taskId, m_rootTasks ) {
-                const Task& task = DATAMODEL->getTask( taskId );
-                rootTaskText.append( QString::fromLatin1( " ( %1 ),").arg( DATAMODEL->fullTaskName( task ) ) );
+            Q_FOREACH( TaskId taskId, input.rootTasks ) {
+                const Task& task = data.getTask( taskId );
+                rootTaskText.append( QString::fromLatin1( " ( %1 ),").arg( data.fullTaskName( task ) ) );
             }
             rootTaskText = rootTaskText.mid(0, rootTaskText.length() - 1 );
-            QDomText rootText = doc.createTextNode( rootTaskText );
-            paragraph.appendChild( rootText );
-            body.appendChild( paragraph );
+            writer.textElement( "p", rootTaskText );
         }
 
-        QDomElement paragraph = doc.createElement( "br" );
-        body.appendChild( paragraph );
+        writer.emptyElement( "br" );
     }
     {
         const QString Headlines[] = {
@@ -346,76 +402,153 @@ void ActivityReport::slotUpdate()
         const int NumberOfColumns = sizeof Headlines / sizeof Headlines[0];
 
         // now for a table
-        QDomElement table = doc.createElement( "table" );
-        table.setAttribute( "width", "100%" );
-        table.setAttribute( "align", "left" );
-        table.setAttribute( "cellpadding", "3" );
-        table.setAttribute( "cellspacing", "0" );
-        body.appendChild( table );
+        writer.startTable();
         // table header
-        QDomElement tableHead = doc.createElement( "thead" );
-        table.appendChild( tableHead );
-        QDomElement headerRow = doc.createElement( "tr" );
-        headerRow.setAttribute( "class", "header_row" );
-        tableHead.appendChild( headerRow );
+        writer.startElement( "thead" );
+        writer.startElement( "tr" );
+        writer.attribute( "class", "header_row" );
         // column headers
         for ( int i = 0; i < NumberOfColumns; ++i )
-        {
-            QDomElement header = doc.createElement( "th" );
-            QDomText text = doc.createTextNode( Headlines[i] );
-            header.appendChild( text );
-            headerRow.appendChild( header );
-        }
-        QDomElement tableBody = doc.createElement( "tbody" );
-        table.appendChild( tableBody );
-        // rows
-        Q_FOREACH( EventId id, matchingEvents ) {
-            const Event& event = DATAMODEL->eventForId( id );
+            writer.textElement( "th", Headlines[i] );
+        writer.endElement(); // tr
+        writer.endElement(); // thead
+        writer.startElement( "tbody" );
+        // rows, only the first page of them, the others are added when they are scrolled to:
+        const int shown = qMin( matchingEvents.size(), EventsPerPage );
+        for ( int i = 0; i < shown; ++i ) {
+            if ( input.isCanceled() )
+                return nullptr;
+
+            const Event& event = data.eventForId( matchingEvents[i] );
             Q_ASSERT( event.isValid() );
-            const TaskTreeItem& item = DATAMODEL->taskTreeItem( event.taskId() );
+            const TaskTreeItem& item = data.taskTreeItem( event.taskId() );
             const Task& task = item.task();
             Q_ASSERT( task.isValid() );
 
             const QString row1Texts[] = {
-                tr( "%1 %2-%3 (%4) -- [%5] %6" )
-                .arg( event.startDateTime().date().toString( Qt::SystemLocaleShortDate ).trimmed() )
-                .arg( event.startDateTime().time().toString( Qt::SystemLocaleShortDate ).trimmed() )
-                .arg( event.endDateTime().time().toString( Qt::SystemLocaleShortDate ).trimmed() )
-                .arg( hoursAndMinutes( event.duration() ) )
-                .arg( QString().setNum( task.id() ).trimmed(), Configuration::instance().taskPaddingLength, '0' )
-                .arg( task.name().trimmed() )
+                eventAttributes( event, task, input.taskPaddingLength )
             };
 
-            QDomElement row1 = doc.createElement( "tr" );
-            row1.setAttribute( "class", "event_attributes_row" );
-            QDomElement row2 = doc.createElement( "tr" );
+            writer.startElement( "tr" );
+            writer.attribute( "class", "event_attributes_row" );
             for ( int index = 0; index < NumberOfColumns; ++index ) {
-                QDomElement cell = doc.createElement( "td" );
-                cell.setAttribute( "class", "event_attributes" );
-                QDomText text = doc.createTextNode( row1Texts[index] );
-                cell.appendChild( text );
-                row1.appendChild( cell );
+                writer.startElement( "td" );
+                writer.attribute( "class", "event_attributes" );
+                writer.text( row1Texts[index] );
+                writer.endElement();
             }
-            QDomElement cell2 = doc.createElement( "td" );
-            cell2.setAttribute( "class", "event_description" );
-            cell2.setAttribute( "align", "left" );
-            QDomElement preElement = doc.createElement( "pre" );
-            QDomText preText = doc.createTextNode( event.comment() );
-            preElement.appendChild( preText );
-            cell2.appendChild( preElement );
-            row2.appendChild( cell2 );
-
-            tableBody.appendChild( row1 );
-            tableBody.appendChild( row2 );
+            writer.endElement(); // tr
+
+            writer.startElement( "tr" );
+            writer.startElement( "td" );
+            writer.attribute( "class", "event_description" );
+            writer.attribute( "align", "left" );
+            writer.textElement( "pre", event.comment() );
+            writer.endElement(); // td
+            writer.endElement(); // tr
         }
     }
 
-    // NOTE: seems like the style sheet has to be set before the html
-    // code is pushed into the QTextDocument
-    report->setDefaultStyleSheet(Charm::reportStylesheet(palette()));
+    QTextDocument* document = writer.createDocument( input.styleSheet );
+    // returned with the document, for adding the remaining rows on the GUI thread:
+    document->setProperty( EventsProperty, QVariant::fromValue( matchingEvents ) );
+    return document;
+}
+
+QString ActivityReport::eventAttributes( const Event& event, const Task& task, int taskPaddingLength )
+{
+    return tr( "%1 %2-%3 (%4) -- [%5] %6" )
+        .arg( event.startDateTime().date().toString( Qt::SystemLocaleShortDate ).trimmed() )
+        .arg( event.startDateTime().time().toString( Qt::SystemLocaleShortDate ).trimmed() )
+        .arg( event.endDateTime().time().toString( Qt::SystemLocaleShortDate ).trimmed() )
+        .arg( hoursAndMinutes( event.duration() ) )
+        .arg( QString().setNum( task.id() ).trimmed(), taskPaddingLength, '0' )
+        .arg( task.name().trimmed() );
+}
 
-    report->setHtml( doc.toString() );
-    setDocument( report );
+void ActivityReport::documentShown( ReportCache::Result& result )
+{
+    m_rows = m_pendingRows;
+    m_pendingRows.clear();
+    m_rows->events = textBrowser()->document()->property( EventsProperty ).value<EventIdList>();
+    m_rows->shown = qMin( m_rows->events.size(), EventsPerPage );
+    result.events = m_rows->events;
+    // once the first page was cached, and the document laid out:
+    QTimer::singleShot( 0, this, SLOT(slotShowMoreRows()) );
+}
+
+void ActivityReport::completeDocument()
+{
+    if ( m_rows )
+        appendEventRows( m_rows->events.size() - m_rows->shown );
+}
+
+void ActivityReport::slotShowMoreRows()
+{
+    if ( !m_rows || m_rows->shown >= m_rows->events.size() )
+        return;
+
+    // add the next page of events before the user reaches the end of the
+    // rendered ones; without a scroll bar, the maximum is 0 and all are visible:
+    const QScrollBar* scrollBar = textBrowser()->verticalScrollBar();
+    const bool endInView = scrollBar->value() >= scrollBar->maximum() - scrollBar->pageStep();
+    // each event has two rows of one block, the cursor is in the last page of them:
+    const QTextDocument* document = textBrowser()->document();
+    const bool cursorAtEnd = document->blockCount() - textBrowser()->textCursor().blockNumber() <= EventsPerPage;
+    if ( endInView || cursorAtEnd )
+        appendEventRows( EventsPerPage );
+}
+
+// fill the cell in row @p row with @p text, formatted like the one in @p templateRow:
+static void setCellText( QTextTable* table, int templateRow, int row, const QString& text )
+{
+    const QTextTableCell templateCell = table->cellAt( templateRow, 0 );
+    QTextTableCell cell = table->cellAt( row, 0 );
+    cell.setFormat( templateCell.format() );
+
+    QTextCursor templateCursor = templateCell.firstCursorPosition();
+    QTextCursor cursor = cell.firstCursorPosition();
+    cursor.setBlockFormat( templateCursor.blockFormat() );
+    cursor.setBlockCharFormat( templateCursor.blockCharFormat() );
+    QTextCharFormat format = templateCursor.blockCharFormat();
+    if ( templateCursor.block().length() > 1 ) {
+        templateCursor.movePosition( QTextCursor::NextCharacter );
+        format = templateCursor.charFormat();
+    }
+    cursor.insertText( text, format );
+}
+
+void ActivityReport::appendEventRows( int count )
+{
+    if ( !m_rows || m_rows->shown >= m_rows->events.size() || count <= 0 )
+        return;
+
+    QTextDocument* document = textBrowser()->document();
+    QTextTable* table = nullptr;
+    Q_FOREACH( QTextFrame* frame, document->rootFrame()->childFrames() ) {
+        if ( auto candidate = qobject_cast<QTextTable*>( frame ) )
+            table = candidate;
+    }
+    // the first page is never empty if there are more events:
+    Q_ASSERT( table && table->rows() >= FirstEventRow + 2 );
+    if ( !table )
+        return;
+
+    // the preview is read only, there is nothing to undo:
+    document->setUndoRedoEnabled( false );
+    QTextCursor cursor( document );
+    cursor.beginEditBlock();
+    const int end = qMin( m_rows->events.size(), m_rows->shown + count );
+    for ( int i = m_rows->shown; i < end; ++i ) {
+        const Event& event = m_rows->data.eventForId( m_rows->events[i] );
+        const Task& task = m_rows->data.getTask( event.taskId() );
+        const int row = table->rows();
+        table->appendRows( 2 );
+        setCellText( table, FirstEventRow, row, eventAttributes( event, task, m_rows->taskPaddingLength ) );
+        setCellText( table, FirstEventRow + 1, row + 1, event.comment() );
+    }
+    cursor.endEditBlock();
+    m_rows->shown = end;
 }
 
 void ActivityReport::slotLinkClicked( const QUrl& which )
@@ -31,11 +31,13 @@
 #include "ReportPreviewWindow.h"
 
 #include <QScopedPointer>
+#include <QSharedPointer>
 
 namespace Ui {
     class ActivityReportConfigurationDialog;
 }
 
+class Event;
 class QUrl;
 
 class ActivityReportConfigurationDialog : public ReportConfigurationDialog
@@ -83,11 +85,23 @@ public:
 
 private slots:
     void slotLinkClicked( const QUrl& which );
+    void slotShowMoreRows();
 
 private:
     void slotUpdate() override;
+    void documentShown( ReportCache::Result& result ) override;
+    void completeDocument() override;
+
+    class Generator;
+    struct EventRows;
+    static QTextDocument* createDocument( const Generator& input );
+    static QString eventAttributes( const Event& event, const Task& task, int taskPaddingLength );
+    /** Add the next @p count events to the table of the shown document. */
+    void appendEventRows( int count );
 
 private:
+    QSharedPointer<EventRows> m_rows;
+    QSharedPointer<EventRows> m_pendingRows;
     QDate m_start;
     QDate m_end;
     QSet<TaskId> m_rootTasks;
@@ -23,6 +23,8 @@
 
 #include "MonthlyTimesheet.h"
 #include "Reports/MonthlyTimesheetXmlWriter.h"
+#include "Reports/ParallelReport.h"
+#include "Reports/ReportHtmlWriter.h"
 
 #include <QFile>
 #include <QMessageBox>
@@ -41,6 +43,41 @@ namespace {
     static float SecondsInDay = 60. * 60. * 8. /* eight hour work day */;
 }
 
+// for every task, make a vector that includes a number of seconds
+// for every week of a month ( int seconds[numberOfWeeks]), and store those in
+// a map by their task id
+static SecondsMap secondsByWeek( const CharmDataSnapshot& data, const QDate& start, const QDate& end,
+                                 int numberOfWeeks )
+{
+    // the weeks of the month, aggregated on all cores:
+    const ParallelReport::PeriodList weeks = ParallelReport::periods( start, end, Week );
+    Q_ASSERT( weeks.size() == numberOfWeeks );
+    Q_UNUSED( numberOfWeeks );
+    return ParallelReport( data ).secondsByPeriod( weeks );
+}
+
+class MonthlyTimeSheetReport::Generator : public ReportGenerator
+{
+public:
+    CharmDataSnapshot data;
+    QDate start;
+    QDate end;
+    TaskId rootTask = {};
+    bool activeTasksOnly = false;
+    int numberOfWeeks = 0;
+    int monthNumber = 0;
+    float dailyHours = 0;
+    QString userName;
+    int taskPaddingLength = 0;
+    QString styleSheet;
+
+protected:
+    QTextDocument* generate() override
+    {
+        return createDocument( *this );
+    }
+};
+
 MonthlyTimeSheetReport::MonthlyTimeSheetReport( QWidget* parent )
     : TimeSheetReport( parent )
 {
@@ -90,9 +127,10 @@ QByteArray MonthlyTimeSheetReport::saveToText()
                       .arg( endDate().addDays( -1 ).toString( Qt::TextDate ) );
     stream << content << '\n';
     stream << '\n';
+    const CharmDataSnapshot data = DATAMODEL->snapshot();
     TimeSheetInfoList timeSheetInfo = TimeSheetInfo::filteredTaskWithSubTasks(
-        TimeSheetInfo::taskWithSubTasks( DATAMODEL, m_numberOfWeeks, rootTask(), secondsMap() ),
-        activeTasksOnly() );
+        data.taskTree(), m_numberOfWeeks, rootTask(),
+        secondsByWeek( data, startDate(), endDate(), m_numberOfWeeks ), activeTasksOnly() );
 
     TimeSheetInfo totalsLine( m_numberOfWeeks );
     if ( ! timeSheetInfo.isEmpty() ) {
@@ -112,7 +150,7 @@ QByteArray MonthlyTimeSheetReport::saveToText()
     return output;
 }
 
-QByteArray MonthlyTimeSheetReport::saveToXml()
+bool MonthlyTimeSheetReport::saveToXml( QIODevice* device )
 {
     try {
         MonthlyTimesheetXmlWriter timesheet;
@@ -128,180 +166,159 @@ QByteArray MonthlyTimeSheetReport::saveToXml()
             events.append( DATAMODEL->eventForId( eventId ) );
         }
         timesheet.setEvents( events );
-        return timesheet.saveToXml();
+        timesheet.writeTo( device );
+        return true;
     } catch ( const XmlSerializationException& e ) {
         QMessageBox::critical( this, tr( "Error exporting the report" ), e.what() );
     }
 
-    return QByteArray();
+    return false;
 }
 
-static QDomElement addTblHdr( QDomElement &toRow, const QString &text )
+static void addTblCell( ReportHtmlWriter& writer, const QString &text )
 {
-    QDomElement header = toRow.ownerDocument().createElement( "th" );
-    QDomText textNode = toRow.ownerDocument().createTextNode( text );
-    header.appendChild( textNode );
-    toRow.appendChild( header );
-    return header;
+    writer.startElement( "td" );
+    writer.attribute( "align", "center" );
+    writer.text( text );
+    writer.endElement();
 }
 
-static QDomElement addTblCell( QDomElement &toRow, const QString &text )
+void MonthlyTimeSheetReport::update()
 {
-    QDomElement cell = toRow.ownerDocument().createElement( "td" );
-    cell.setAttribute( "align", "center" );
-    QDomText textNode = toRow.ownerDocument().createTextNode( text );
-    cell.appendChild( textNode );
-    toRow.appendChild( cell );
-    return cell;
+    const QString userName = CONFIGURATION.user.name();
+    const int taskPaddingLength = CONFIGURATION.taskPaddingLength;
+    const QString styleSheet = Charm::reportStylesheet( palette() );
+
+    ReportCache::Key key;
+    key.report = QLatin1String( "monthly" );
+    key.start = startDate();
+    key.end = endDate();
+    key.rootTasks << rootTask();
+    key.activeTasksOnly = activeTasksOnly();
+    key.options << QString::number( m_dailyhours ) << userName
+                << QString::number( taskPaddingLength ) << styleSheet;
+
+    uploadButton()->setVisible(false);
+    uploadButton()->setEnabled(false);
+    if ( showCachedDocument( key ) )
+        return;
+
+    // the time sheet is created on a worker thread, from a snapshot of the data:
+    auto generator = new Generator;
+    generator->data = DATAMODEL->snapshot();
+    generator->start = startDate();
+    generator->end = endDate();
+    generator->rootTask = rootTask();
+    generator->activeTasksOnly = activeTasksOnly();
+    generator->numberOfWeeks = m_numberOfWeeks;
+    generator->monthNumber = m_monthNumber;
+    generator->dailyHours = m_dailyhours;
+    generator->userName = userName;
+    generator->taskPaddingLength = taskPaddingLength;
+    generator->styleSheet = styleSheet;
+    generateDocument( generator, key );
 }
 
-void MonthlyTimeSheetReport::update()
+QTextDocument* MonthlyTimeSheetReport::createDocument( const Generator& input )
 {
-    // this creates the time sheet
-    // retrieve matching events:
-    const EventIdList matchingEvents = DATAMODEL->eventsThatStartInTimeFrame( startDate(), endDate() );
-
-    m_secondsMap.clear();
-
-    // for every task, make a vector that includes a number of seconds
-    // for every week of a month ( int seconds[m_numberOfWeeks]), and store those in
-    // a map by their task id
-    Q_FOREACH( EventId id, matchingEvents ) {
-        const Event& event = DATAMODEL->eventForId( id );
-        QVector<int> seconds( m_numberOfWeeks );
-        if ( m_secondsMap.contains( event.taskId() ) ) {
-            seconds = m_secondsMap.value(event.taskId());
-        }
-        // what week of the month is the event (normalized to vector indexes):
-        const int weekOfMonth = Charm::weekDifference( startDate(), event.startDateTime().date() );
-        seconds[weekOfMonth] += event.duration();
-        // store in minute map:
-        m_secondsMap[event.taskId()] = seconds;
-    }
+    const SecondsMap secondsMap = secondsByWeek( input.data, input.start, input.end, input.numberOfWeeks );
+    if ( input.isCanceled() )
+        return nullptr;
+
     // now the reporting:
     // headline first:
-    QTextDocument report;
-    QDomDocument doc = createReportTemplate();
-    QDomElement root = doc.documentElement();
-    QDomElement body = root.firstChildElement( "body" );
+    ReportHtmlWriter writer;
 
-//     QTextCursor cursor( m_report );
     // create the caption:
+    writer.textElement( "h1", tr( "Monthly Time Sheet" ) );
     {
-        QDomElement headline = doc.createElement( "h1" );
-        QDomText text = doc.createTextNode( tr( "Monthly Time Sheet" ) );
-        headline.appendChild( text );
-        body.appendChild( headline );
-    }
-    {
-        QDomElement headline = doc.createElement( "h3" );
         QString content = tr( "Report for %1, %2 %3 (%4 to %5)" )
-                          .arg( CONFIGURATION.user.name() )
-                          .arg( QDate::longMonthName( m_monthNumber ) )
-                          .arg( startDate().year() )
-                          .arg( startDate().toString( Qt::TextDate ) )
-                          .arg( endDate().addDays( -1 ).toString( Qt::TextDate ) );
-        QDomText text = doc.createTextNode( content );
-        headline.appendChild( text );
-        body.appendChild( headline );
-        QDomElement previousLink = doc.createElement( "a" );
-        previousLink.setAttribute( "href" , "Previous" );
-        QDomText previousLinkText = doc.createTextNode( tr( "<Previous Month>" ) );
-        previousLink.appendChild( previousLinkText );
-        body.appendChild( previousLink );
-        QDomElement nextLink = doc.createElement( "a" );
-        nextLink.setAttribute( "href" , "Next" );
-        QDomText nextLinkText = doc.createTextNode( tr( "<Next Month>" ) );
-        nextLink.appendChild( nextLinkText );
-        body.appendChild( nextLink );
-        QDomElement paragraph = doc.createElement( "br" );
-        body.appendChild( paragraph );
+                          .arg( input.userName )
+                          .arg( QDate::longMonthName( input.monthNumber ) )
+                          .arg( input.start.year() )
+                          .arg( input.start.toString( Qt::TextDate ) )
+                          .arg( input.end.addDays( -1 ).toString( Qt::TextDate ) );
+        writer.textElement( "h3", content );
+        writer.link( "Previous", tr( "<Previous Month>" ) );
+        writer.link( "Next", tr( "<Next Month>" ) );
+        writer.emptyElement( "br" );
     }
     {
         // now for a table
         // retrieve the information for the report:
         // TimeSheetInfoList timeSheetInfo = taskWithSubTasks( m_rootTask, m_secondsMap );
         TimeSheetInfoList timeSheetInfo = TimeSheetInfo::filteredTaskWithSubTasks(
-            TimeSheetInfo::taskWithSubTasks( DATAMODEL, m_numberOfWeeks, rootTask(), secondsMap() ),
-            activeTasksOnly() );
+            input.data.taskTree(), input.numberOfWeeks, input.rootTask, secondsMap, input.activeTasksOnly );
 
-        QDomElement table = doc.createElement( "table" );
-        table.setAttribute( "width", "100%" );
-        table.setAttribute( "align", "left" );
-        table.setAttribute( "cellpadding", "3" );
-        table.setAttribute( "cellspacing", "0" );
-        body.appendChild( table );
+        writer.startTable();
 
-        TimeSheetInfo totalsLine( m_numberOfWeeks );
+        TimeSheetInfo totalsLine( input.numberOfWeeks );
         if ( ! timeSheetInfo.isEmpty() ) {
             totalsLine = timeSheetInfo.first();
-            if( rootTask() == 0 ) {
+            if( input.rootTask == 0 ) {
                 timeSheetInfo.removeAt( 0 ); // there is always one, because there is always the root item
             }
         }
 
         {   //Header Row
-            QDomElement headerRow = doc.createElement( "tr" );
-            headerRow.setAttribute( "class", "header_row" );
-            table.appendChild( headerRow );
-            addTblHdr( headerRow, tr( "Task" ) );
-            for ( int i = 0; i < m_numberOfWeeks; ++i )
-                addTblHdr( headerRow, tr( "Week" ) );
-            addTblHdr( headerRow, tr( "Total" ) );
-            addTblHdr( headerRow, tr( "Days" ) );
+            writer.startElement( "tr" );
+            writer.attribute( "class", "header_row" );
+            writer.textElement( "th", tr( "Task" ) );
+            for ( int i = 0; i < input.numberOfWeeks; ++i )
+                writer.textElement( "th", tr( "Week" ) );
+            writer.textElement( "th", tr( "Total" ) );
+            writer.textElement( "th", tr( "Days" ) );
+            writer.endElement();
         }
 
         {   //Header day row
-            QDomElement headerDayRow = doc.createElement( "tr" );
-            headerDayRow.setAttribute( "class", "header_row" );
-            table.appendChild( headerDayRow );
-            addTblHdr( headerDayRow, QString() );
-            for ( int i = 0; i < m_numberOfWeeks; ++i ) {
-                QString label = tr("%1").arg(startDate().addDays( i * 7 ).weekNumber(), 2, 10, QLatin1Char('0') );
-                addTblHdr( headerDayRow, label );
+            writer.startElement( "tr" );
+            writer.attribute( "class", "header_row" );
+            writer.textElement( "th", QString() );
+            for ( int i = 0; i < input.numberOfWeeks; ++i ) {
+                QString label = tr("%1").arg(input.start.addDays( i * 7 ).weekNumber(), 2, 10, QLatin1Char('0') );
+                writer.textElement( "th", label );
             }
-            addTblHdr( headerDayRow, QString() );
-            addTblHdr( headerDayRow, QString::number(m_dailyhours) + tr(" hours") );
+            writer.textElement( "th", QString() );
+            writer.textElement( "th", QString::number(input.dailyHours) + tr(" hours") );
+            writer.endElement();
         }
 
         for ( int i = 0; i < timeSheetInfo.size(); ++i )
         {
-            QDomElement row = doc.createElement( "tr" );
+            if ( input.isCanceled() )
+                return nullptr;
+
+            writer.startElement( "tr" );
             if (i % 2)
-                row.setAttribute( "class", "alternate_row" );
-            table.appendChild( row );
-
-            QDomElement taskCell = addTblCell( row, timeSheetInfo[i].formattedTaskIdAndName( CONFIGURATION.taskPaddingLength ) );
-            taskCell.setAttribute( "align", "left" );
-            taskCell.setAttribute( "style", QString( "text-indent: %1px;" )
-                                            .arg( 9 * timeSheetInfo[i].indentation ) );
-            for ( int week = 0; week < m_numberOfWeeks; ++week )
-                addTblCell( row, hoursAndMinutes( timeSheetInfo[i].seconds[week] ) );
-            addTblCell( row, hoursAndMinutes( timeSheetInfo[i].total() ) );
-            addTblCell( row, QString::number( timeSheetInfo[i].total() / SecondsInDay, 'f', 1) );
+                writer.attribute( "class", "alternate_row" );
+
+            writer.startElement( "td" );
+            writer.attribute( "align", "left" );
+            writer.attribute( "style", QString( "text-indent: %1px;" )
+                                       .arg( 9 * timeSheetInfo[i].indentation ) );
+            writer.text( timeSheetInfo[i].formattedTaskIdAndName( input.taskPaddingLength ) );
+            writer.endElement();
+            for ( int week = 0; week < input.numberOfWeeks; ++week )
+                addTblCell( writer, hoursAndMinutes( timeSheetInfo[i].seconds[week] ) );
+            addTblCell( writer, hoursAndMinutes( timeSheetInfo[i].total() ) );
+            addTblCell( writer, QString::number( timeSheetInfo[i].total() / SecondsInDay, 'f', 1) );
+            writer.endElement(); // tr
         }
 
         {   // Totals row
-            QDomElement totals = doc.createElement( "tr" );
-            totals.setAttribute( "class", "header_row" );
-            table.appendChild( totals );
-
-            addTblHdr( totals, tr( "Total:" ) );
-            for ( int i = 0; i < m_numberOfWeeks; ++i )
-                addTblHdr( totals, hoursAndMinutes( totalsLine.seconds[i] ) );
-            addTblHdr( totals, hoursAndMinutes( totalsLine.total() ) );
-            addTblHdr( totals, QString::number( totalsLine.total() / SecondsInDay, 'f', 1) );
+            writer.startElement( "tr" );
+            writer.attribute( "class", "header_row" );
+            writer.textElement( "th", tr( "Total:" ) );
+            for ( int i = 0; i < input.numberOfWeeks; ++i )
+                writer.textElement( "th", hoursAndMinutes( totalsLine.seconds[i] ) );
+            writer.textElement( "th", hoursAndMinutes( totalsLine.total() ) );
+            writer.textElement( "th", QString::number( totalsLine.total() / SecondsInDay, 'f', 1) );
+            writer.endElement();
         }
     }
 
-    // NOTE: seems like the style sheet has to be set before the html
-    // code is pushed into the QTextDocument
-    report.setDefaultStyleSheet(Charm::reportStylesheet(palette()));
-
-    report.setHtml( doc.toString() );
-    setDocument( &report );
-    uploadButton()->setVisible(false);
-    uploadButton()->setEnabled(false);
+    return writer.createDocument( input.styleSheet );
 }
 
 void MonthlyTimeSheetReport::slotLinkClicked( const QUrl& which )
@@ -50,7 +50,10 @@ private:
     QString suggestedFileName() const override;
     void update() override;
     QByteArray saveToText() override;
-    QByteArray saveToXml() override;
+    bool saveToXml( QIODevice* device ) override;
+
+    class Generator;
+    static QTextDocument* createDocument( const Generator& input );
 
 private:
     // properties of the report:
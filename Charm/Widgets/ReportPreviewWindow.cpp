@@ -58,45 +58,83 @@ ReportPreviewWindow::ReportPreviewWindow( QWidget* parent )
     m_updateTimer.start();
     connect( &m_updateTimer, SIGNAL(timeout()),
              SLOT(slotUpdate()) );
+    connect( &m_generatorWatcher, SIGNAL(finished()),
+             SLOT(slotDocumentGenerated()) );
 
     resize(850, 600);
 }
 
 ReportPreviewWindow::~ReportPreviewWindow()
 {
+    // the generator keeps running until it notices, but its result is dropped:
+    m_generatorWatcher.cancel();
 }
 
 void ReportPreviewWindow::setDocument( const QTextDocument* document )
 {
     if ( document != nullptr ) {
         // we keep a copy, to be able to show different versions of the same document
-        QScopedPointer<QTextDocument> docClone( document->clone() );
-        m_document.swap( docClone );
-        m_ui->textBrowser->setDocument( m_document.data() );
+        showDocument( ReportGenerator::DocumentPointer( document->clone() ) );
     } else {
-        m_ui->textBrowser->setDocument( nullptr );
-        m_document.reset();
+        showDocument( ReportGenerator::DocumentPointer() );
     }
 }
 
-QDomDocument ReportPreviewWindow::createReportTemplate() const
+void ReportPreviewWindow::showDocument( const ReportGenerator::DocumentPointer& document )
 {
-    // create XHTML v1.0 structure:
-    QDomDocument doc( "html" );
-    // FIXME this is only a rudimentary subset of a valid xhtml 1 document
+    m_ui->textBrowser->setDocument( document.data() );
+    m_document = document;
+}
+
+void ReportPreviewWindow::generateDocument( ReportGenerator* generator, const ReportCache::Key& key )
+{
+    m_generatorWatcher.cancel();
+    // generators work on a snapshot of the current version:
+    m_generatorKey = key;
+    m_generatorVersion = DATAMODEL->version();
+    m_generatorWatcher.setFuture( ReportGenerator::start( generator ) );
+    setCursor( Qt::BusyCursor );
+}
 
-    // html element
-    QDomElement html = doc.createElement( "html" );
-    html.setAttribute( "xmlns", "http://www.w3.org/1999/xhtml" );
-    doc.appendChild( html );
+bool ReportPreviewWindow::showCachedDocument( const ReportCache::Key& key, ReportCache::Result* result )
+{
+    const ReportCache::Result cached = MODEL.reportCache()->find( key );
+    if ( !cached.document )
+        return false;
+
+    // a document that is still being generated would replace it:
+    m_generatorWatcher.cancel();
+    setDocument( cached.document.data() );
+    if ( result )
+        *result = cached;
+    return true;
+}
+
+void ReportPreviewWindow::slotDocumentGenerated()
+{
+    unsetCursor();
+    const QFuture<ReportGenerator::DocumentPointer> future = m_generatorWatcher.future();
+    if ( future.isCanceled() || future.resultCount() == 0 )
+        return;
+    // generated documents are not shared, no need to copy them:
+    showDocument( future.result() );
+
+    ReportCache::Result result;
+    result.version = m_generatorVersion;
+    documentShown( result );
+    if ( !m_generatorKey.report.isEmpty() ) {
+        // the cache keeps a copy, reports may add to the shown document later:
+        result.document.reset( future.result()->clone() );
+        MODEL.reportCache()->insert( m_generatorKey, result );
+    }
+}
 
-    // head and body, children of html
-    QDomElement head = doc.createElement( "head" );
-    html.appendChild( head );
-    QDomElement body = doc.createElement( "body" );
-    html.appendChild( body );
+void ReportPreviewWindow::documentShown( ReportCache::Result& )
+{
+}
 
-    return doc;
+void ReportPreviewWindow::completeDocument()
+{
 }
 
 QPushButton* ReportPreviewWindow::saveToXmlButton() const
@@ -114,6 +152,11 @@ QPushButton* ReportPreviewWindow::uploadButton() const
     return m_ui->pushButtonUpload;
 }
 
+QTextBrowser* ReportPreviewWindow::textBrowser() const
+{
+    return m_ui->textBrowser;
+}
+
 void ReportPreviewWindow::slotSaveToXml()
 {
 }
@@ -128,7 +171,8 @@ void ReportPreviewWindow::slotPrint()
     QPrinter printer;
     QPrintDialog dialog( &printer, this );
 
-    if ( dialog.exec() ) {
+    if ( dialog.exec() && m_document ) {
+        completeDocument();
         m_document->print( &printer );
     }
 #endif
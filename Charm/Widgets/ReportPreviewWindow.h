@@ -25,16 +25,20 @@
 #define REPORTPREVIEWWINDOW_H
 
 #include <QDialog>
-#include <QDomDocument>
+#include <QFutureWatcher>
 #include <QScopedPointer>
 #include <QTextDocument>
 #include <QTimer>
 
+#include "Reports/ReportCache.h"
+#include "Reports/ReportGenerator.h"
+
 namespace Ui {
     class ReportPreviewWindow;
 }
 
 class QPushButton;
+class QTextBrowser;
 
 class ReportPreviewWindow : public QDialog
 {
@@ -49,10 +53,26 @@ signals:
 
 protected:
     void setDocument( const QTextDocument* document );
-    QDomDocument createReportTemplate() const;
+    /** Create the document with @p generator on a worker thread, and show
+     * it once it is ready. A generator that is still running is canceled
+     * and its result discarded. Takes ownership of the generator.
+     * Unless @p key is empty, the document is added to the report cache. */
+    void generateDocument( ReportGenerator* generator,
+                           const ReportCache::Key& key = ReportCache::Key() );
+    /** Show a copy of the document cached for @p key, and store its
+     * cache entry in @p result. Returns false if there is none. */
+    bool showCachedDocument( const ReportCache::Key& key, ReportCache::Result* result = nullptr );
     QPushButton* saveToXmlButton() const;
     QPushButton* saveToTextButton() const;
     QPushButton* uploadButton() const;
+    QTextBrowser* textBrowser() const;
+
+    /** Called when a generated document has been shown. Reports can add
+     * what they need to show it again to the @p result that is cached. */
+    virtual void documentShown( ReportCache::Result& result );
+    /** Called before the document is printed. Reports that only show part
+     * of their document in the preview complete it here. */
+    virtual void completeDocument();
 
     QTimer m_updateTimer;
 
@@ -62,10 +82,16 @@ private slots:
     virtual void slotPrint();
     virtual void slotUpdate();
     virtual void slotClose();
+    void slotDocumentGenerated();
 
 private:
+    void showDocument( const ReportGenerator::DocumentPointer& document );
+
     QScopedPointer<Ui::ReportPreviewWindow> m_ui;
-    QScopedPointer<QTextDocument> m_document;
+    ReportGenerator::DocumentPointer m_document;
+    QFutureWatcher<ReportGenerator::DocumentPointer> m_generatorWatcher;
+    ReportCache::Key m_generatorKey;
+    quint64 m_generatorVersion = 0;
 };
 
 #endif
@@ -48,6 +48,13 @@
 
 #define CUSTOM_TASK_PROPERTY_NAME "CUSTOM_TASK_PROPERTY"
 
+namespace {
+    // the number of recently and frequently used tasks offered in the menu
+    static const int InterestingTaskCount = 10;
+    // the number taken from each list, more than shown to leave room for expired tasks
+    static const int InterestingTaskCandidates = 2 * InterestingTaskCount;
+}
+
 TimeTrackingTaskSelector::TimeTrackingTaskSelector(QWidget *parent)
     : QWidget(parent)
     , m_stopGoButton( new QToolButton( this ) )
@@ -153,11 +160,11 @@ void TimeTrackingTaskSelector::populate( const QVector<WeeklySummary>& summaries
     m_menu->addAction( m_startOtherTaskAction );
 
     TaskIdList interestingTasks;
-    interestingTasks += DATAMODEL->mostRecentlyUsedTasks();
-    interestingTasks += DATAMODEL->mostFrequentlyUsedTasks();
+    interestingTasks += DATAMODEL->mostRecentlyUsedTasks( InterestingTaskCandidates );
+    interestingTasks += DATAMODEL->mostFrequentlyUsedTasks( InterestingTaskCandidates );
 
     TaskIdList interestingTasksToAdd;
-    while( interestingTasksToAdd.count() < 10 ) { // arbitrary hardcoded number warning
+    while( interestingTasksToAdd.count() < InterestingTaskCount ) {
         if( interestingTasks.isEmpty() )
             break;
 
@@ -139,19 +139,7 @@ void TimeTrackingView::paintEvent( QPaintEvent* e )
     for ( int row = 0; row < rowCount() - 1; ++row ) {
         for ( int column = 0; column < columnCount(); ++column ) {
             // get the rectangle of the field that will be drawn
-            QRect fieldRect;
-            const int y = row * FieldHeight;
-            if ( column == columnCount() - 1 ) { // totals column
-                fieldRect = QRect( width() - m_cachedTotalsFieldRect.width(), y,
-                                   m_cachedTotalsFieldRect.width(), FieldHeight );
-            } else if ( column == 0 ) { // task column
-                fieldRect = QRect( 0, y, taskColumnWidth(), FieldHeight );
-            } else if ( column > 0 ) { //  a task
-                fieldRect = QRect( width() - m_cachedTotalsFieldRect.width()
-                                   - 8 * m_cachedDayFieldRect.width()
-                                   + column * m_cachedDayFieldRect.width(), y,
-                                   m_cachedDayFieldRect.width(), FieldHeight );
-            }
+            const QRect fieldRect = this->fieldRect( column, row );
             // paint the field, if it is in the dirty region
             if( e->rect().contains( fieldRect ) ) {
                 DataField field = m_defaultField;
@@ -262,6 +250,23 @@ int TimeTrackingView::taskColumnWidth() const
     return width() - m_cachedTotalsFieldRect.width() - 7 * m_cachedDayFieldRect.width();
 }
 
+QRect TimeTrackingView::fieldRect( int column, int row ) const
+{
+    const int FieldHeight = m_cachedTotalsFieldRect.height();
+    const int y = row * FieldHeight;
+    if ( column == columnCount() - 1 ) { // totals column
+        return QRect( width() - m_cachedTotalsFieldRect.width(), y,
+                      m_cachedTotalsFieldRect.width(), FieldHeight );
+    } else if ( column == 0 ) { // task column
+        return QRect( 0, y, taskColumnWidth(), FieldHeight );
+    } else { //  a task
+        return QRect( width() - m_cachedTotalsFieldRect.width()
+                      - 8 * m_cachedDayFieldRect.width()
+                      + column * m_cachedDayFieldRect.width(), y,
+                      m_cachedDayFieldRect.width(), FieldHeight );
+    }
+}
+
 void TimeTrackingView::data( DataField& field, int column, int row ) const
 {
     const int HeaderRow = 0;
@@ -347,7 +352,9 @@ void TimeTrackingView::setSummaries( const QVector<WeeklySummary>& summaries )
     m_summaries = summaries;
     m_cachedMinimumSizeHint = QSize();
     m_cachedSizeHint = QSize();
-    m_dayOfWeek = QDate::currentDate().dayOfWeek();
+    m_durationsTime = QDateTime::currentDateTime();
+    m_dayOfWeek = m_durationsTime.date().dayOfWeek();
+    m_weekStart = m_durationsTime.date().addDays( 1 - m_dayOfWeek );
     m_elidedTexts.clear();
     updateGeometry();
     update();
@@ -402,6 +409,37 @@ void TimeTrackingView::handleActiveEvents()
     m_taskSelector->handleActiveEvents();
 }
 
+void TimeTrackingView::updateActiveDurations()
+{
+    if ( !m_durationsTime.isValid() )
+        return;
+    // whole seconds only, so that no time is lost between the updates:
+    const int seconds = m_durationsTime.secsTo( QDateTime::currentDateTime() );
+    if ( seconds <= 0 )
+        return;
+    m_durationsTime = m_durationsTime.addSecs( seconds );
+
+    const int TotalsRow = rowCount() - 2;
+    const int TotalsColumn = columnCount() - 1;
+    Q_FOREACH( EventId id, DATAMODEL->activeEvents() ) {
+        const Event& event = DATAMODEL->eventForId( id );
+        // the summaries count an event on the day it started:
+        const int day = m_weekStart.daysTo( event.startDateTime().date() );
+        if ( day < 0 || day >= 7 )
+            continue;
+        for ( int index = 0; index < m_summaries.size(); ++index ) {
+            if ( m_summaries[index].task != event.taskId() )
+                continue;
+            m_summaries[index].durations[day] += seconds;
+            update( fieldRect( day + 1, index + 1 ) );
+            update( fieldRect( TotalsColumn, index + 1 ) );
+            update( fieldRect( day + 1, TotalsRow ) );
+            update( fieldRect( TotalsColumn, TotalsRow ) );
+            break;
+        }
+    }
+}
+
 QString TimeTrackingView::elidedText( const QString& text, const QFont& font, int width )
 {
     if( ! m_elidedTexts.contains( text ) )
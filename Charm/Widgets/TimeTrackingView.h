@@ -24,6 +24,7 @@
 #ifndef TimeTrackingView_H
 #define TimeTrackingView_H
 
+#include <QDateTime>
 #include <QWidget>
 #include <QVector>
 #include <QMenu>
@@ -82,6 +83,11 @@ public:
 
     void configurationChanged();
 
+public slots:
+    /** Adds the time the active events ran since the summaries were set or last updated,
+     * and repaints only the fields that show it. */
+    void updateActiveDurations();
+
 signals:
     void maybeShrink();
     void startEvent( TaskId );
@@ -98,6 +104,7 @@ private:
     bool taskIsValidAndTrackable( int taskId );
 
     int taskColumnWidth() const;
+    QRect fieldRect( int column, int row ) const;
 
     QVector<WeeklySummary> m_summaries;
     mutable QSize m_cachedSizeHint;
@@ -112,6 +119,10 @@ private:
     DataField m_defaultField;
     /** Stored for performance reasons, QDate::currentDate() is expensive. */
     int m_dayOfWeek = 0;
+    /** The Monday of the summarized week. */
+    QDate m_weekStart;
+    /** Up to when the durations of the active events are included in the summaries. */
+    QDateTime m_durationsTime;
     /** Stored for performance reasons, QDate::shortDayName() is slow on Mac. */
     QString m_shortDayNames[7];
     /** Stored for performance reasons, QFontMetrics::elidedText is slow if called many times. */
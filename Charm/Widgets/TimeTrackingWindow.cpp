@@ -66,6 +66,7 @@
 #include <QMessageBox>
 #include <QScriptEngine>
 #include <QScriptValue>
+#include <QSet>
 #include <QSettings>
 #include <QToolBar>
 #include <QtAlgorithms>
@@ -144,6 +145,10 @@ void TimeTrackingWindow::stateChanged( State previous )
     case Connecting: {
         connect( ApplicationCore::instance().dateChangeWatcher(), SIGNAL(dateChanged()),
                  SLOT(slotSelectTasksToShow()) );
+        // the running time of the active events only changes their fields, the summaries
+        // are recomputed on model changes and when the date changes:
+        connect( DATAMODEL, SIGNAL(activeEventDurationsChanged()),
+                 m_summaryWidget, SLOT(updateActiveDurations()) );
         DATAMODEL->registerAdapter( this );
         m_summaryWidget->setSummaries( QVector<WeeklySummary>() );
         m_summaryWidget->handleActiveEvents();
@@ -685,7 +690,20 @@ void TimeTrackingWindow::importTasksFromDeviceOrFile( QIODevice* device, const Q
             exporter.readFrom( filename );
         merger.setOldTasks( DATAMODEL->getAllTasks() );
         merger.setNewTasks( exporter.tasks() );
-        if ( merger.modifiedTasks().isEmpty() && merger.addedTasks().isEmpty() ) {
+        TaskList tasks = merger.mergedTaskList();
+        // a delta lists the tasks deleted on the server, they expire here since events may use them:
+        int expiredTasks = 0;
+        if ( exporter.isDelta() ) {
+            const QDateTime expiry = exporter.exportTime().isValid() ? exporter.exportTime() : QDateTime::currentDateTime();
+            const QSet<TaskId> deleted = exporter.deletedTasks().toSet();
+            for ( TaskList::iterator it = tasks.begin(); it != tasks.end(); ++it ) {
+                if ( deleted.contains( it->id() ) && ( !it->validUntil().isValid() || it->validUntil() > expiry ) ) {
+                    it->setValidUntil( expiry );
+                    ++expiredTasks;
+                }
+            }
+        }
+        if ( merger.modifiedTasks().isEmpty() && merger.addedTasks().isEmpty() && expiredTasks == 0 ) {
             const QString title = tr( "Tasks Import" );
             const QString message = tr( "The selected task file does not contain any updates." );
             if ( verbose )
@@ -693,7 +711,7 @@ void TimeTrackingWindow::importTasksFromDeviceOrFile( QIODevice* device, const Q
             else
                 emit showNotification( title, message );
         } else {
-            auto cmd = new CommandSetAllTasks( merger.mergedTaskList(), this );
+            auto cmd = new CommandSetAllTasks( tasks, this );
             sendCommand( cmd );
             // At this point the command was finalized and we have a result.
             const bool success = cmd->finalize();
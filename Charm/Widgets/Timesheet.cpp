@@ -26,6 +26,11 @@
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QSettings>
+#if QT_VERSION >= QT_VERSION_CHECK(5,1,0)
+#include <QSaveFile>
+#else
+#include <QTemporaryFile>
+#endif
 
 #include "ViewHelpers.h"
 
@@ -68,14 +73,30 @@ void TimeSheetReport::slotSaveToXml()
         filename += QLatin1String( ".charmreport" );
     }
 
-    QByteArray payload = saveToXml();
-    if (payload.isEmpty())
-        return; // Error should have been already displayed by saveToXml()
-
-    QFile file( filename );
-    if ( file.open( QIODevice::WriteOnly ) ) {
-        file.write( payload );
-    } else {
+    // write next to the selected file, and only replace it once the report is complete:
+#if QT_VERSION >= QT_VERSION_CHECK(5,1,0)
+    QSaveFile file( filename );
+    const bool opened = file.open( QIODevice::WriteOnly );
+#else
+    QTemporaryFile file( filename + QLatin1String( ".XXXXXX" ) );
+    const bool opened = file.open();
+#endif
+    if ( !opened ) {
+        QMessageBox::critical( this, tr( "Error saving report" ),
+                               tr( "Cannot write to selected location:\n%1" ).arg( file.errorString() ) );
+        return;
+    }
+    if ( !saveToXml( &file ) )
+        return; // Error should have been already displayed by saveToXml(), the partial report is discarded
+
+#if QT_VERSION >= QT_VERSION_CHECK(5,1,0)
+    const bool saved = file.commit();
+#else
+    QFile::remove( filename );
+    const bool saved = file.rename( filename );
+    file.setAutoRemove( !saved );
+#endif
+    if ( !saved ) {
         QMessageBox::critical( this, tr( "Error saving report" ),
                                tr( "Cannot write to selected location:\n%1" ).arg( file.errorString() ) );
     }
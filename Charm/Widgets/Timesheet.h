@@ -29,6 +29,8 @@
 #include "ReportPreviewWindow.h"
 #include "Reports/TimesheetInfo.h"
 
+class QIODevice;
+
 class TimeSheetReport : public ReportPreviewWindow
 {
     Q_OBJECT
@@ -47,7 +49,8 @@ protected:
     virtual QString suggestedFileName() const = 0;
     virtual void update() = 0;
     virtual QByteArray saveToText() = 0;
-    virtual QByteArray saveToXml() = 0;
+    /** Write the timesheet to @p device. Returns false if it failed, after telling the user. */
+    virtual bool saveToXml( QIODevice* device ) = 0;
 
 protected:
 
@@ -63,18 +66,12 @@ protected:
     inline bool activeTasksOnly() const
         { return m_activeTasksOnly; }
 
-    inline const SecondsMap &secondsMap() const
-        { return m_secondsMap; }
-
     QString getFileName( const QString& filter );
 
     void slotUpdate() override;
     void slotSaveToText() override;
     void slotSaveToXml() override;
 
-protected:
-    SecondsMap m_secondsMap;
-
 private:
     // properties of the report:
     QDate m_start;
@@ -22,12 +22,14 @@
 */
 
 #include "WeeklyTimesheet.h"
+#include "Reports/ReportHtmlWriter.h"
 #include "Reports/WeeklyTimesheetXmlWriter.h"
 
 #include <QCalendarWidget>
 #include <QMessageBox>
 #include <QPushButton>
 #include <QSettings>
+#include <QTemporaryFile>
 #include <QUrl>
 
 #include <Core/Dates.h>
@@ -263,6 +265,36 @@ void WeeklyTimesheetConfigurationDialog::slotSelectTask()
 /*************************************************************** WeeklyTimeSheetReport */
 // here begins ... the actual report:
 
+// for every task, make a vector that includes a number of seconds
+// for every day of the week ( int seconds[7]), and store those in
+// a map by their task id
+static SecondsMap secondsByDay( const CharmDataSnapshot& data, const QDate& start, const QDate& end )
+{
+    // what day in the week is the event (normalized to vector indexes):
+    const QDate monday = start.addDays( 1 - start.dayOfWeek() );
+    return data.secondsByTask( start, end, monday, 1, DaysInWeek );
+}
+
+class WeeklyTimeSheetReport::Generator : public ReportGenerator
+{
+public:
+    CharmDataSnapshot data;
+    QDate start;
+    QDate end;
+    TaskId rootTask = {};
+    bool activeTasksOnly = false;
+    int weekNumber = 0;
+    QString userName;
+    int taskPaddingLength = 0;
+    QString styleSheet;
+
+protected:
+    QTextDocument* generate() override
+    {
+        return createDocument( *this );
+    }
+};
+
 WeeklyTimeSheetReport::WeeklyTimeSheetReport( QWidget* parent )
     : TimeSheetReport( parent )
 {
@@ -288,12 +320,21 @@ void WeeklyTimeSheetReport::setReportProperties(
 
 void WeeklyTimeSheetReport::slotUploadTimesheet()
 {
+    // the timesheet is written to a temporary file, which the upload reads from:
+    QScopedPointer<QTemporaryFile> payload( new QTemporaryFile );
+    if ( !payload->open() ) {
+        QMessageBox::critical( this, tr( "Error" ), tr( "Could not upload timesheet: %1" ).arg( payload->errorString() ) );
+        return;
+    }
+    if ( !saveToXml( payload.data() ) )
+        return;
+
     auto client = new UploadTimesheetJob( this );
     auto dialog = new HttpJobProgressDialog( client, this );
     dialog->setWindowTitle( tr("Uploading") );
     connect( client, SIGNAL(finished(HttpJob*)), this, SLOT(slotTimesheetUploaded(HttpJob*)) );
     client->setFileName( suggestedFileName() );
-    client->setPayload( saveToXml() );
+    client->setPayload( payload.take() );
     client->start();
     uploadButton()->setEnabled(false);
 }
@@ -321,95 +362,77 @@ QString WeeklyTimeSheetReport::suggestedFileName() const
 }
 
 void WeeklyTimeSheetReport::update()
-{   // this creates the time sheet
-    // retrieve matching events:
-    const EventIdList matchingEvents = DATAMODEL->eventsThatStartInTimeFrame( startDate(), endDate() );
-
-    m_secondsMap.clear();
-
-    // for every task, make a vector that includes a number of seconds
-    // for every day of the week ( int seconds[7]), and store those in
-    // a map by their task id
-    Q_FOREACH( EventId id, matchingEvents ) {
-        const Event& event = DATAMODEL->eventForId( id );
-        QVector<int> seconds( DaysInWeek );
-        if ( m_secondsMap.contains( event.taskId() ) ) {
-            seconds = m_secondsMap.value(event.taskId());
-        }
-        // what day in the week is the event (normalized to vector indexes):
-        int dayOfWeek = event.startDateTime().date().dayOfWeek() - 1;
-        Q_ASSERT( dayOfWeek >= 0 && dayOfWeek < DaysInWeek );
-        seconds[dayOfWeek] += event.duration();
-        // store in minute map:
-        m_secondsMap[event.taskId()] = seconds;
-    }
+{
+    const QString userName = CONFIGURATION.user.name();
+    const int taskPaddingLength = CONFIGURATION.taskPaddingLength;
+    const QString styleSheet = Charm::reportStylesheet( palette() );
+
+    ReportCache::Key key;
+    key.report = QLatin1String( "weekly" );
+    key.start = startDate();
+    key.end = endDate();
+    key.rootTasks << rootTask();
+    key.activeTasksOnly = activeTasksOnly();
+    key.options << userName << QString::number( taskPaddingLength ) << styleSheet;
+
+    uploadButton()->setEnabled(true);
+    if ( showCachedDocument( key ) )
+        return;
+
+    // the time sheet is created on a worker thread, from a snapshot of the data:
+    auto generator = new Generator;
+    generator->data = DATAMODEL->snapshot();
+    generator->start = startDate();
+    generator->end = endDate();
+    generator->rootTask = rootTask();
+    generator->activeTasksOnly = activeTasksOnly();
+    generator->weekNumber = m_weekNumber;
+    generator->userName = userName;
+    generator->taskPaddingLength = taskPaddingLength;
+    generator->styleSheet = styleSheet;
+    generateDocument( generator, key );
+}
+
+QTextDocument* WeeklyTimeSheetReport::createDocument( const Generator& input )
+{
+    const SecondsMap secondsMap = secondsByDay( input.data, input.start, input.end );
+    if ( input.isCanceled() )
+        return nullptr;
+
     // now the reporting:
     // headline first:
-    QTextDocument report;
-    QDomDocument doc = createReportTemplate();
-    QDomElement root = doc.documentElement();
-    QDomElement body = root.firstChildElement( "body" );
+    ReportHtmlWriter writer;
 
     // create the caption:
+    writer.textElement( "h1", tr( "Weekly Time Sheet" ) );
     {
-        QDomElement headline = doc.createElement( "h1" );
-        QDomText text = doc.createTextNode( tr( "Weekly Time Sheet" ) );
-        headline.appendChild( text );
-        body.appendChild( headline );
-    }
-    {
-        QDomElement headline = doc.createElement( "h3" );
         QString content = tr( "Report for %1, Week %2 (%3 to %4)" )
-                          .arg( CONFIGURATION.user.name() )
-                          .arg( m_weekNumber, 2, 10, QChar('0') )
-                          .arg( startDate().toString( Qt::TextDate ) )
-                          .arg( endDate().addDays( -1 ).toString( Qt::TextDate ) );
-        QDomText text = doc.createTextNode( content );
-        headline.appendChild( text );
-        body.appendChild( headline );
-        QDomElement previousLink = doc.createElement( "a" );
-        previousLink.setAttribute( "href" , "Previous" );
-        QDomText previousLinkText = doc.createTextNode( tr( "<Previous Week>" ) );
-        previousLink.appendChild( previousLinkText );
-        body.appendChild( previousLink );
-        QDomElement nextLink = doc.createElement( "a" );
-        nextLink.setAttribute( "href" , "Next" );
-        QDomText nextLinkText = doc.createTextNode( tr( "<Next Week>" ) );
-        nextLink.appendChild( nextLinkText );
-        body.appendChild( nextLink );
-        QDomElement paragraph = doc.createElement( "br" );
-        body.appendChild( paragraph );
+                          .arg( input.userName )
+                          .arg( input.weekNumber, 2, 10, QChar('0') )
+                          .arg( input.start.toString( Qt::TextDate ) )
+                          .arg( input.end.addDays( -1 ).toString( Qt::TextDate ) );
+        writer.textElement( "h3", content );
+        writer.link( "Previous", tr( "<Previous Week>" ) );
+        writer.link( "Next", tr( "<Next Week>" ) );
+        writer.emptyElement( "br" );
     }
     {
         // now for a table
         // retrieve the information for the report:
-        // TimeSheetInfoList timeSheetInfo = taskWithSubTasks( rootTask(), secondsMap() );
+        // TimeSheetInfoList timeSheetInfo = taskWithSubTasks( rootTask(), secondsMap );
         TimeSheetInfoList timeSheetInfo = TimeSheetInfo::filteredTaskWithSubTasks(
-            TimeSheetInfo::taskWithSubTasks( DATAMODEL, DaysInWeek, rootTask(), secondsMap() ),
-            activeTasksOnly() );
+            input.data.taskTree(), DaysInWeek, input.rootTask, secondsMap, input.activeTasksOnly );
 
-        QDomElement table = doc.createElement( "table" );
-        table.setAttribute( "width", "100%" );
-        table.setAttribute( "align", "left" );
-        table.setAttribute( "cellpadding", "3" );
-        table.setAttribute( "cellspacing", "0" );
-        body.appendChild( table );
+        writer.startTable();
 
         TimeSheetInfo totalsLine(DaysInWeek);
         if ( ! timeSheetInfo.isEmpty() ) {
             totalsLine = timeSheetInfo.first();
-            if( rootTask() == 0 ) {
+            if( input.rootTask == 0 ) {
                 timeSheetInfo.removeAt( 0 ); // there is always one, because there is always the root item
             }
         }
 
-        QDomElement headerRow = doc.createElement( "tr" );
-        headerRow.setAttribute( "class", "header_row" );
-        table.appendChild( headerRow );
-        QDomElement headerDayRow = doc.createElement( "tr" );
-        headerDayRow.setAttribute( "class", "header_row" );
-        table.appendChild( headerDayRow );
-
         const QString Headlines[NumberOfColumns] = {
             tr( "Task" ),
             QDate::shortDayName( 1 ),
@@ -423,37 +446,38 @@ void WeeklyTimeSheetReport::update()
         };
         const QString DayHeadlines[NumberOfColumns] = {
             QString(),
-            tr( "%1" ).arg( startDate().day(), 2, 10, QLatin1Char('0') ),
-            tr( "%1" ).arg( startDate().addDays( 1 ).day(), 2, 10, QLatin1Char('0') ),
-            tr( "%1" ).arg( startDate().addDays( 2 ).day(), 2, 10, QLatin1Char('0') ),
-            tr( "%1" ).arg( startDate().addDays( 3 ).day(), 2, 10, QLatin1Char('0') ),
-            tr( "%1" ).arg( startDate().addDays( 4 ).day(), 2, 10, QLatin1Char('0') ),
-            tr( "%1" ).arg( startDate().addDays( 5 ).day(), 2, 10, QLatin1Char('0') ),
-            tr( "%1" ).arg( startDate().addDays( 6 ).day(), 2, 10, QLatin1Char('0') ),
+            tr( "%1" ).arg( input.start.day(), 2, 10, QLatin1Char('0') ),
+            tr( "%1" ).arg( input.start.addDays( 1 ).day(), 2, 10, QLatin1Char('0') ),
+            tr( "%1" ).arg( input.start.addDays( 2 ).day(), 2, 10, QLatin1Char('0') ),
+            tr( "%1" ).arg( input.start.addDays( 3 ).day(), 2, 10, QLatin1Char('0') ),
+            tr( "%1" ).arg( input.start.addDays( 4 ).day(), 2, 10, QLatin1Char('0') ),
+            tr( "%1" ).arg( input.start.addDays( 5 ).day(), 2, 10, QLatin1Char('0') ),
+            tr( "%1" ).arg( input.start.addDays( 6 ).day(), 2, 10, QLatin1Char('0') ),
             QString()
         };
 
+        writer.startElement( "tr" );
+        writer.attribute( "class", "header_row" );
         for ( int i = 0; i < NumberOfColumns; ++i )
-        {
-            QDomElement header = doc.createElement( "th" );
-            QDomText text = doc.createTextNode( Headlines[i] );
-            header.appendChild( text );
-            headerRow.appendChild( header );
-            QDomElement dayHeader = doc.createElement( "th" );
-            QDomText dayText = doc.createTextNode( DayHeadlines[i] );
-            dayHeader.appendChild( dayText );
-            headerDayRow.appendChild( dayHeader );
-        }
+            writer.textElement( "th", Headlines[i] );
+        writer.endElement();
+        writer.startElement( "tr" );
+        writer.attribute( "class", "header_row" );
+        for ( int i = 0; i < NumberOfColumns; ++i )
+            writer.textElement( "th", DayHeadlines[i] );
+        writer.endElement();
 
         for ( int i = 0; i < timeSheetInfo.size(); ++i )
         {
-            QDomElement row = doc.createElement( "tr" );
+            if ( input.isCanceled() )
+                return nullptr;
+
+            writer.startElement( "tr" );
             if (i % 2)
-                row.setAttribute( "class", "alternate_row" );
-            table.appendChild( row );
+                writer.attribute( "class", "alternate_row" );
 
             QString texts[NumberOfColumns];
-            texts[Column_Task] = timeSheetInfo[i].formattedTaskIdAndName( CONFIGURATION.taskPaddingLength );
+            texts[Column_Task] = timeSheetInfo[i].formattedTaskIdAndName( input.taskPaddingLength );
             texts[Column_Monday] = hoursAndMinutes( timeSheetInfo[i].seconds[0] );
             texts[Column_Tuesday] = hoursAndMinutes( timeSheetInfo[i].seconds[1] );
             texts[Column_Wednesday] = hoursAndMinutes( timeSheetInfo[i].seconds[2] );
@@ -465,20 +489,19 @@ void WeeklyTimeSheetReport::update()
 
             for ( int column = 0; column < NumberOfColumns; ++column )
             {
-                QDomElement cell = doc.createElement( "td" );
-                cell.setAttribute( "align", column == Column_Task ? "left" : "center" );
+                writer.startElement( "td" );
+                writer.attribute( "align", column == Column_Task ? "left" : "center" );
 
                 if ( column == Column_Task ) {
                     QString style = QString( "text-indent: %1px;" )
                             .arg( 9 * timeSheetInfo[i].indentation );
-                    cell.setAttribute( "style", style );
+                    writer.attribute( "style", style );
                 }
 
-
-                QDomText text = doc.createTextNode( texts[column] );
-                cell.appendChild( text );
-                row.appendChild( cell );
+                writer.text( texts[column] );
+                writer.endElement();
             }
+            writer.endElement(); // tr
         }
         // put the totals:
         QString TotalsTexts[NumberOfColumns] = {
@@ -492,28 +515,17 @@ void WeeklyTimeSheetReport::update()
             hoursAndMinutes( totalsLine.seconds[6] ),
             hoursAndMinutes( totalsLine.total() )
         };
-        QDomElement totals = doc.createElement( "tr" );
-        totals.setAttribute( "class", "header_row" );
-        table.appendChild( totals );
+        writer.startElement( "tr" );
+        writer.attribute( "class", "header_row" );
         for ( int i = 0; i < NumberOfColumns; ++i )
-        {
-            QDomElement cell = doc.createElement( "th" );
-            QDomText text = doc.createTextNode( TotalsTexts[i] );
-            cell.appendChild( text );
-            totals.appendChild( cell );
-        }
+            writer.textElement( "th", TotalsTexts[i] );
+        writer.endElement();
     }
 
-    // NOTE: seems like the style sheet has to be set before the html
-    // code is pushed into the QTextDocument
-    report.setDefaultStyleSheet(Charm::reportStylesheet(palette()));
-
-    report.setHtml( doc.toString() );
-    setDocument( &report );
-    uploadButton()->setEnabled(true);
+    return writer.createDocument( input.styleSheet );
 }
 
-QByteArray WeeklyTimeSheetReport::saveToXml()
+bool WeeklyTimeSheetReport::saveToXml( QIODevice* device )
 {
     try {
         WeeklyTimesheetXmlWriter timesheet;
@@ -528,12 +540,13 @@ QByteArray WeeklyTimeSheetReport::saveToXml()
             events.append( DATAMODEL->eventForId( id ) );
         timesheet.setEvents( events );
 
-        return timesheet.saveToXml();
+        timesheet.writeTo( device );
+        return true;
     } catch ( const XmlSerializationException& e ) {
         QMessageBox::critical( this, tr( "Error exporting the report" ), e.what() );
     }
 
-    return QByteArray();
+    return false;
 }
 
 QByteArray WeeklyTimeSheetReport::saveToText()
@@ -547,8 +560,9 @@ QByteArray WeeklyTimeSheetReport::saveToText()
                       .arg( endDate().addDays( -1 ).toString( Qt::TextDate ) );
     stream << content << '\n';
     stream << '\n';
+    const CharmDataSnapshot data = DATAMODEL->snapshot();
     TimeSheetInfoList timeSheetInfo = TimeSheetInfo::filteredTaskWithSubTasks(
-        TimeSheetInfo::taskWithSubTasks( DATAMODEL, DaysInWeek, rootTask(), secondsMap() ),
+        data.taskTree(), DaysInWeek, rootTask(), secondsByDay( data, startDate(), endDate() ),
         activeTasksOnly() );
 
     TimeSheetInfo totalsLine( DaysInWeek );
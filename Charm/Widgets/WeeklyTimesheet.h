@@ -93,9 +93,12 @@ private slots:
 private:
     QString suggestedFileName() const override;
     void update() override;
-    QByteArray saveToXml() override;
+    bool saveToXml( QIODevice* device ) override;
     QByteArray saveToText() override;
 
+    class Generator;
+    static QTextDocument* createDocument( const Generator& input );
+
 private:
     // properties of the report:
     int m_weekNumber = 0;
@@ -38,18 +38,27 @@
 
 #include <algorithm>
 #include <functional>
-#include <queue>
+
+namespace {
+    // how often views are told that the running durations grew:
+    static const int DurationUpdateInterval = 10 * 1000;
+    // how often the end of running events is saved, in case Charm does not stop them:
+    static const int CheckpointInterval = 5 * 60 * 1000;
+}
 
 CharmDataModel::CharmDataModel()
     : QObject()
+    , m_journal( m_version )
 {
     connect( &m_timer, SIGNAL(timeout()), SLOT(eventUpdateTimerEvent()) );
+    connect( &m_checkpointTimer, SIGNAL(timeout()), SLOT(checkpointTimerEvent()) );
 }
 
 CharmDataModel::~CharmDataModel()
 {
+    // the tasks go with the model, setAllTasks() would reset the task
+    // padding length of the application:
     m_adapters.clear();
-    setAllTasks( TaskList() );
 }
 
 void CharmDataModel::stateChanged( State previous, State next )
@@ -79,31 +88,20 @@ void CharmDataModel::unregisterAdapter( CharmDataModelAdapterInterface* adapter
 
 void CharmDataModel::setAllTasks( const TaskList& tasks )
 {
-    clearTasks();
+    // one reset for the whole reload, not one for clearing and one for filling:
+    removeAllTasks();
 
     Q_ASSERT( Task::checkForTreeness( tasks ) );
     Q_ASSERT( Task::checkForUniqueTaskIds( tasks ) );
 
-    // fill the tasks into the map to TaskTreeItems
-    for ( int i = 0; i < tasks.size(); ++i )
-    {
-        const TaskTreeItem item( tasks[i], &m_rootItem );
-        Q_ASSERT( ! taskExists( tasks[i].id() ) ); // the tasks form a tree and have unique task ids
-        m_tasks[ tasks[i].id() ] = item;
-    }
-
-    // create parent-child-relationships:
-    for ( TaskTreeItem::Map::iterator it = m_tasks.begin(); it != m_tasks.end(); ++it )
-    {
-        const Task& task = it->second.task();
-        TaskTreeItem& parent = parentItem( task );
-        it->second.makeChildOf( parent );
-    }
+    // fill the tasks into the tree, creating the parent-child-relationships:
+    m_tasks.setAllTasks( tasks );
 
     // store task id length:
     determineTaskPaddingLength();
 
     m_nameCache.setAllTasks( tasks );
+    tasksChanged();
 
     // notify adapters of changes
     for_each( m_adapters.begin(), m_adapters.end(),
@@ -124,14 +122,10 @@ void CharmDataModel::addTask( const Task& task )
             adapter->taskAboutToBeAdded( parent.task().id(),
                                          parent.childCount() );
 
-        const TaskTreeItem item ( task );
-        m_tasks[ task.id() ] = item;
+        // note: this invalidates the parent reference
+        m_tasks.addTask( task );
         m_nameCache.addTask( task );
-
-        // the item in the map has a different address, let's find it:
-        Q_ASSERT( taskExists( task.id() ) ); // we just put it in
-        const auto it = m_tasks.find( task.id() );
-        it->second.makeChildOf( parentItem( task ) );
+        taskChanged( task.id() );
 
         determineTaskPaddingLength();
 //        regenerateSmartNames();
@@ -146,23 +140,22 @@ void CharmDataModel::addTask( const Task& task )
 
 void CharmDataModel::modifyTask( const Task& task )
 {
-    const auto it = m_tasks.find( task.id() );
-    Q_ASSERT_X( it != m_tasks.end(), Q_FUNC_INFO,
+    Q_ASSERT_X( taskExists( task.id() ), Q_FUNC_INFO,
               "Task to modify has to exist" );
 
-    if ( it == m_tasks.end() )
+    if ( !taskExists( task.id() ) )
         return;
-    const TaskId oldParentId = it->second.task().parent();
+    const TaskId oldParentId = taskTreeItem( task.id() ).task().parent();
     const bool parentChanged = task.parent() != oldParentId;
 
     if ( parentChanged ) {
         Q_FOREACH( auto adapter, m_adapters )
             adapter->taskParentChanged( task.id(), oldParentId, task.parent() );
-        m_tasks[ task.id() ].makeChildOf( parentItem( task ) );
     }
 
-    m_tasks[ task.id() ].task() = task;
+    m_tasks.modifyTask( task );
     m_nameCache.modifyTask( task );
+    taskChanged( task.id() );
 
     if( parentChanged ) {
         Q_FOREACH( auto adapter, m_adapters )
@@ -184,14 +177,11 @@ void CharmDataModel::deleteTask( const Task& task )
     Q_FOREACH( auto adapter, m_adapters )
         adapter->taskAboutToBeDeleted( task.id() );
 
-    const auto it = m_tasks.find( task.id() );
-    if ( it != m_tasks.end() ) {
-        TaskTreeItem tmpParent;
-        it->second.makeChildOf( tmpParent );
-        m_tasks.erase( it );
-    }
+    if ( taskExists( task.id() ) )
+        m_tasks.deleteTask( task.id() );
 
     m_nameCache.deleteTask( task );
+    taskChanged( task.id() );
 
     Q_FOREACH( auto adapter, m_adapters )
         adapter->taskDeleted( task.id() );
@@ -199,33 +189,37 @@ void CharmDataModel::deleteTask( const Task& task )
 
 void CharmDataModel::clearTasks()
 {
-    // to clear the task list, all tasks have first to be changed to be children of the root item:
-    for ( TaskTreeItem::Map::iterator it = m_tasks.begin(); it != m_tasks.end(); ++it )
-    {
-        it->second.makeChildOf( m_rootItem );
-    }
-
-    m_tasks.clear();
-    m_nameCache.clearTasks();
-    m_rootItem = TaskTreeItem();
+    removeAllTasks();
+    tasksChanged();
 
     Q_FOREACH( auto adapter, m_adapters )
         adapter->resetTasks();
 }
 
+void CharmDataModel::removeAllTasks()
+{
+    m_tasks.clear();
+    m_nameCache.clearTasks();
+}
+
 void CharmDataModel::setAllEvents( const EventList& events )
 {
     m_events.clear();
+    clearTaskUsage();
 
     for ( int i = 0; i < events.size(); ++i )
     {
         if ( ! eventExists( events[i].id() ) ) {
-            m_events[ events[i].id() ] = events[i];
+            Event& event = m_events[ events[i].id() ];
+            event = events[i];
+            event.setRunning( m_activeEventIdSet.contains( event.id() ) );
+            addTaskUsage( events[i] );
         } else {
-            qCritical() << "CharmDataModel::addTask: duplicate task id"
-                        << m_tasks[i].task().id() << "ignored. THIS IS A BUG";
+            qCritical() << "CharmDataModel::setAllEvents: duplicate event id"
+                        << events[i].id() << "ignored. THIS IS A BUG";
         }
     }
+    eventsChanged();
 
     Q_FOREACH( auto adapter, m_adapters )
         adapter->resetEvents();
@@ -240,6 +234,8 @@ void CharmDataModel::addEvent( const Event& event )
         adapter->eventAboutToBeAdded( event.id() );
 
     m_events[ event.id() ] = event;
+    addTaskUsage( event );
+    eventChanged( event.id() );
 
     Q_FOREACH( auto adapter, m_adapters )
         adapter->eventAdded( event.id() );
@@ -252,7 +248,19 @@ void CharmDataModel::modifyEvent( const Event& newEvent )
 
     const Event oldEvent = eventForId( newEvent.id() );
 
-    m_events[ newEvent.id() ] = newEvent;
+    Event& event = m_events[ newEvent.id() ];
+    event = newEvent;
+    event.setRunning( isEventActive( newEvent.id() ) );
+    eventChanged( newEvent.id() );
+    if ( oldEvent.taskId() != newEvent.taskId()
+         || oldEvent.startDateTime( Qt::UTC ) != newEvent.startDateTime( Qt::UTC ) ) {
+        removeTaskUsage( oldEvent );
+        addTaskUsage( newEvent );
+    }
+    if ( oldEvent.taskId() != newEvent.taskId() && isEventActive( newEvent.id() ) ) {
+        m_activeEventsByTask.remove( oldEvent.taskId() );
+        m_activeEventsByTask.insert( newEvent.taskId(), newEvent.id() );
+    }
 
     Q_FOREACH( auto adapter, m_adapters )
         adapter->eventModified( newEvent.id(), oldEvent );
@@ -262,15 +270,18 @@ void CharmDataModel::deleteEvent( const Event& event )
 {
     Q_ASSERT_X( eventExists( event.id() ), Q_FUNC_INFO,
                 "Event to delete has to exist" );
-    Q_ASSERT_X( !m_activeEventIds.contains( event.id() ), Q_FUNC_INFO,
+    Q_ASSERT_X( !isEventActive( event.id() ), Q_FUNC_INFO,
                 "Cannot delete an active event" );
 
     Q_FOREACH( auto adapter, m_adapters )
         adapter->eventAboutToBeDeleted( event.id() );
 
     const auto it = m_events.find( event.id() );
-    if ( it != m_events.end() )
+    if ( it != m_events.end() ) {
+        removeTaskUsage( it->second );
         m_events.erase( it );
+        eventChanged( event.id() );
+    }
 
     Q_FOREACH( auto adapter, m_adapters )
         adapter->eventDeleted( event.id() );
@@ -279,6 +290,8 @@ void CharmDataModel::deleteEvent( const Event& event )
 void CharmDataModel::clearEvents()
 {
     m_events.clear();
+    clearTaskUsage();
+    eventsChanged();
 
     Q_FOREACH( auto adapter, m_adapters )
         adapter->resetEvents();
@@ -286,14 +299,12 @@ void CharmDataModel::clearEvents()
 
 const TaskTreeItem& CharmDataModel::taskTreeItem( TaskId id ) const
 {
-    if ( id <= 0 ) return m_rootItem;
+    return m_tasks.item( id );
+}
 
-    const auto it = m_tasks.find( id );
-    if ( it == m_tasks.end() ) {
-        return m_rootItem;
-    } else {
-        return it->second;
-    }
+const TaskTree& CharmDataModel::taskTree() const
+{
+    return m_tasks;
 }
 
 const Task& CharmDataModel::getTask( TaskId id ) const
@@ -304,14 +315,13 @@ const Task& CharmDataModel::getTask( TaskId id ) const
 
 TaskList CharmDataModel::getAllTasks() const
 {
-    return m_rootItem.children();
+    return m_tasks.rootItem().children();
 }
 
-Task& CharmDataModel::findTask( TaskId id )
+const Task& CharmDataModel::findTask( TaskId id ) const
 {   // in this (private) method, the task has to exist
-    const TaskTreeItem::Map::iterator it = m_tasks.find( id );
-    Q_ASSERT( it != m_tasks.end() );
-    return it->second.task();
+    Q_ASSERT( m_tasks.contains( id ) );
+    return m_tasks.item( id ).task();
 }
 
 const Event& CharmDataModel::eventForId( EventId id ) const
@@ -337,60 +347,45 @@ bool CharmDataModel::activateEvent( const Event& activeEvent )
 {
     const bool DoSanityChecks = true;
     if ( DoSanityChecks ) {
-        TaskId taskId = activeEvent.taskId();
-
         // this check may become obsolete:
-        for ( int i = 0; i < m_activeEventIds.size(); ++i )
-        {
-            if ( m_activeEventIds[i] == activeEvent.id() ) {
-                Q_ASSERT( !"inconsistency (event already active)!" );
-                return false;
-            }
-
-            const Event& e = eventForId( m_activeEventIds[i] );
-            if ( e.taskId() == taskId ) {
-                Q_ASSERT( !"inconsistency (event already active for task)!" );
-                return false;
-            }
+        if ( isEventActive( activeEvent.id() ) ) {
+            Q_ASSERT( !"inconsistency (event already active)!" );
+            return false;
         }
 
+        if ( isTaskActive( activeEvent.taskId() ) ) {
+            Q_ASSERT( !"inconsistency (event already active for task)!" );
+            return false;
+        }
     }
 
-    m_activeEventIds << activeEvent.id();
+    insertActiveEvent( activeEvent );
     Q_FOREACH( auto adapter, m_adapters ) {
         adapter->eventActivated( activeEvent.id() );
     }
-    m_timer.start( 10000 );
+    m_timer.start( DurationUpdateInterval );
+    m_checkpointTimer.start( CheckpointInterval );
     return true;
 }
 
 void CharmDataModel::determineTaskPaddingLength()
 {
-    int maxTaskId = 0;
-
-    for ( TaskTreeItem::Map::iterator it = m_tasks.begin(); it != m_tasks.end(); ++it )
-    {
-        maxTaskId = qMax( maxTaskId, it->second.task().id() );
-    }
+    const TaskId maxTaskId = m_tasks.maxTaskId();
 
     QString temp;
     temp.setNum( maxTaskId );
     CONFIGURATION.taskPaddingLength = temp.length();
 }
 
-TaskTreeItem& CharmDataModel::parentItem( const Task& task )
+const TaskTreeItem& CharmDataModel::parentItem( const Task& task ) const
 {
-    TaskTreeItem& parent = m_tasks[ task.parent() ];
-    if ( parent.isValid() ) {
-        return parent;
-    } else {
-        return m_rootItem;
-    }
+    // the root item is returned for top level tasks and unknown parents:
+    return m_tasks.item( task.parent() );
 }
 
-bool CharmDataModel::taskExists( TaskId id )
+bool CharmDataModel::taskExists( TaskId id ) const
 {
-    return m_tasks.find( id ) != m_tasks.end();
+    return m_tasks.contains( id );
 }
 
 bool CharmDataModel::eventExists( EventId id )
@@ -398,33 +393,125 @@ bool CharmDataModel::eventExists( EventId id )
     return m_events.find( id ) != m_events.end();
 }
 
-bool CharmDataModel::isTaskActive( TaskId id ) const
+void CharmDataModel::addTaskUsage( const Event& event )
 {
-    for ( int i = 0; i < m_activeEventIds.size(); ++i )
-    {
-        const Event& e = eventForId( m_activeEventIds[i] );
-        Q_ASSERT( e.isValid() );
-        if ( e.taskId() == id ) {
-            return true;
-        }
+    // Note: for a relative order, the UTC time is sufficient and much faster
+    const qint64 start = event.startDateTime( Qt::UTC ).toMSecsSinceEpoch();
+    std::multiset<qint64>& starts = m_taskUsage[ event.taskId() ];
+    if ( !starts.empty() ) {
+        m_tasksByUseCount.erase( std::make_pair( static_cast<int>( starts.size() ), event.taskId() ) );
+        m_tasksByLastUse.erase( std::make_pair( *starts.rbegin(), event.taskId() ) );
     }
+    starts.insert( start );
+    m_tasksByUseCount.insert( std::make_pair( static_cast<int>( starts.size() ), event.taskId() ) );
+    m_tasksByLastUse.insert( std::make_pair( *starts.rbegin(), event.taskId() ) );
+}
 
-    return false;
+void CharmDataModel::removeTaskUsage( const Event& event )
+{
+    const auto it = m_taskUsage.find( event.taskId() );
+    if ( it == m_taskUsage.end() )
+        return;
+    std::multiset<qint64>& starts = it.value();
+    const auto start = starts.find( event.startDateTime( Qt::UTC ).toMSecsSinceEpoch() );
+    Q_ASSERT( start != starts.end() );
+    if ( start == starts.end() )
+        return;
+    m_tasksByUseCount.erase( std::make_pair( static_cast<int>( starts.size() ), event.taskId() ) );
+    m_tasksByLastUse.erase( std::make_pair( *starts.rbegin(), event.taskId() ) );
+    starts.erase( start );
+    if ( starts.empty() ) {
+        m_taskUsage.erase( it );
+    } else {
+        m_tasksByUseCount.insert( std::make_pair( static_cast<int>( starts.size() ), event.taskId() ) );
+        m_tasksByLastUse.insert( std::make_pair( *starts.rbegin(), event.taskId() ) );
+    }
+}
+
+void CharmDataModel::clearTaskUsage()
+{
+    m_taskUsage.clear();
+    m_tasksByUseCount.clear();
+    m_tasksByLastUse.clear();
+}
+
+void CharmDataModel::tasksChanged()
+{
+    ++m_version;
+    m_snapshotTasksChanged = true;
+    m_journal.record( m_version, ModelChange::TasksReset );
+}
+
+void CharmDataModel::taskChanged( TaskId id )
+{
+    ++m_version;
+    m_snapshotTasksChanged = true;
+    m_journal.record( m_version, ModelChange::TaskChanged, id );
+}
+
+void CharmDataModel::eventsChanged()
+{
+    ++m_version;
+    m_snapshotEventsReset = true;
+    m_snapshotChangedEventBlocks.clear();
+    m_journal.record( m_version, ModelChange::EventsReset );
+}
+
+void CharmDataModel::eventChanged( EventId id )
+{
+    ++m_version;
+    if ( !m_snapshotEventsReset )
+        m_snapshotChangedEventBlocks.insert( CharmDataSnapshot::eventBlock( id ) );
+    m_journal.record( m_version, ModelChange::EventChanged, id );
+}
+
+void CharmDataModel::activeEventsChanged( EventId id, bool active )
+{
+    ++m_version;
+    // the event started or stopped running:
+    if ( !m_snapshotEventsReset )
+        m_snapshotChangedEventBlocks.insert( CharmDataSnapshot::eventBlock( id ) );
+    m_journal.record( m_version, active ? ModelChange::EventActivated : ModelChange::EventDeactivated, id );
+}
+
+void CharmDataModel::insertActiveEvent( const Event& event )
+{
+    m_activeEventIds << event.id();
+    m_activeEventIdSet.insert( event.id() );
+    m_activeEventsByTask.insert( event.taskId(), event.id() );
+    const auto it = m_events.find( event.id() );
+    if ( it != m_events.end() )
+        it->second.setRunning( true );
+    activeEventsChanged( event.id(), true );
+}
+
+void CharmDataModel::removeActiveEvent( EventId id )
+{
+    m_activeEventIds.removeOne( id );
+    m_activeEventIdSet.remove( id );
+    m_activeEventsByTask.remove( eventForId( id ).taskId() );
+    const auto it = m_events.find( id );
+    if ( it != m_events.end() )
+        it->second.setRunning( false );
+    activeEventsChanged( id, false );
+}
+
+bool CharmDataModel::isTaskActive( TaskId id ) const
+{
+    return m_activeEventsByTask.contains( id );
 }
 
 const Event& CharmDataModel::activeEventFor ( TaskId id ) const
 {
     static Event InvalidEvent;
 
-    for ( int i = 0; i < m_activeEventIds.size(); ++i )
-    {
-        const Event& e = eventForId( m_activeEventIds[i] );
-        if ( e.taskId() == id ) {
-            return e;
-        }
-    }
+    const auto it = m_activeEventsByTask.constFind( id );
+    if ( it == m_activeEventsByTask.constEnd() )
+        return InvalidEvent;
 
-    return InvalidEvent;
+    const Event& e = eventForId( it.value() );
+    Q_ASSERT( e.isValid() );
+    return e;
 }
 
 void CharmDataModel::startEventRequested( const Task& task )
@@ -445,18 +532,12 @@ void CharmDataModel::startEventRequested( const Task& task )
 
 void CharmDataModel::endEventRequested( const Task& task )
 {
-    EventId eventId = 0;
-
     // find the event in the list of active events and remove it:
-    for ( int i = 0; i < m_activeEventIds.size(); ++i )
-    {
-        if ( eventForId( m_activeEventIds[i] ).taskId() == task.id() ) {
-            eventId = m_activeEventIds[i];
-            m_activeEventIds.removeAt( i );
-            Q_FOREACH( auto adapter, m_adapters ) {
-                adapter->eventDeactivated( eventId );
-            }
-            break;
+    const EventId eventId = m_activeEventsByTask.value( task.id() );
+    if ( eventId != 0 ) {
+        removeActiveEvent( eventId );
+        Q_FOREACH( auto adapter, m_adapters ) {
+            adapter->eventDeactivated( eventId );
         }
     }
 
@@ -464,10 +545,14 @@ void CharmDataModel::endEventRequested( const Task& task )
     Event& event = findEvent( eventId );
     Event old = event;
     event.setEndDateTime( QDateTime::currentDateTime() );
+    eventChanged( eventId );
 
     emit requestEventModification( event, old );
 
-    if ( m_activeEventIds.isEmpty() ) m_timer.stop();
+    if ( m_activeEventIds.isEmpty() ) {
+        m_timer.stop();
+        m_checkpointTimer.stop();
+    }
     updateToolTip();
 }
 
@@ -476,7 +561,7 @@ void CharmDataModel::endAllEventsRequested()
     QDateTime currentDateTime = QDateTime::currentDateTime();
     while ( ! m_activeEventIds.isEmpty() ) {
         EventId eventId = m_activeEventIds.first();
-        m_activeEventIds.pop_front();
+        removeActiveEvent( eventId );
         Q_FOREACH( auto adapter, m_adapters ) {
             adapter->eventDeactivated( eventId );
         }
@@ -485,15 +570,24 @@ void CharmDataModel::endAllEventsRequested()
         Event& event = findEvent( eventId );
         Event old = event;
         event.setEndDateTime( currentDateTime );
+        eventChanged( eventId );
 
         emit requestEventModification( event, old );
     }
 
     m_timer.stop();
+    m_checkpointTimer.stop();
     updateToolTip();
 }
 
 void CharmDataModel::eventUpdateTimerEvent()
+{
+    // the durations of running events follow the current time, nothing changes in the model:
+    emit activeEventDurationsChanged();
+    updateToolTip();
+}
+
+void CharmDataModel::checkpointTimerEvent()
 {
     Q_FOREACH( EventId id, m_activeEventIds ) {
         // Not a ref (Event &), since we want to diff "old event"
@@ -504,7 +598,6 @@ void CharmDataModel::eventUpdateTimerEvent()
 
         emit requestEventModification( event, old );
     }
-    updateToolTip();
 }
 
 QString CharmDataModel::fullTaskName( const Task& task ) const
@@ -615,7 +708,7 @@ const EventMap& CharmDataModel::eventMap() const
 
 bool CharmDataModel::isEventActive( EventId id ) const
 {
-    return m_activeEventIds.contains( id );
+    return m_activeEventIdSet.contains( id );
 }
 
 int CharmDataModel::activeEventCount() const
@@ -653,16 +746,22 @@ bool CharmDataModel::isParentOf( TaskId parent, TaskId id ) const
     Q_ASSERT_X( parent != 0, Q_FUNC_INFO, "parent is invalid (0)" );
 
     if ( id == parent ) return false; // a task is not it's own child
-    // get the item, make sure it is valid
-    const TaskTreeItem& item( taskTreeItem( id ) );
-    Q_ASSERT_X( item.isValid(), Q_FUNC_INFO, "No such task" );
-    if ( ! item.isValid() ) return false;
+    // get the task's number, make sure it is valid
+    const int ordinal = subtreeOrdinal( id );
+    Q_ASSERT_X( ordinal >= 0, Q_FUNC_INFO, "No such task" );
+    if ( ordinal < 0 ) return false;
+
+    return subtreeRange( parent ).containsBelow( ordinal );
+}
 
-    TaskId parentId = item.task().parent();
+TaskSubtreeRange CharmDataModel::subtreeRange( TaskId id ) const
+{
+    return m_tasks.subtreeRange( id );
+}
 
-    if ( parentId == parent ) return true; // found it on the path
-    if ( parentId == 0 ) return false; // the task has no parent
-    return isParentOf( parent, parentId );
+int CharmDataModel::subtreeOrdinal( TaskId id ) const
+{
+    return m_tasks.subtreeOrdinal( id );
 }
 
 EventIdList CharmDataModel::activeEvents() const
@@ -670,82 +769,58 @@ EventIdList CharmDataModel::activeEvents() const
     return m_activeEventIds;
 }
 
-struct TaskWithCount {
-    TaskId id;
-    unsigned int count;
-
-    bool operator<( const TaskWithCount& other ) const {
-        return count < other.count;
-    }
-};
-
-struct TaskWithLastUseDate {
-    TaskId id;
-    QDateTime lastUse;
-
-    bool operator<( const TaskWithLastUseDate& other ) const {
-        return lastUse < other.lastUse;
-    }
-};
-
-TaskIdList CharmDataModel::mostFrequentlyUsedTasks() const
+TaskIdList CharmDataModel::mostFrequentlyUsedTasks( int maxCount ) const
 {
-    QMap<TaskId, unsigned > mfuMap;
-    const EventMap& events = eventMap();
-    for( EventMap::const_iterator it = events.begin(); it != events.end(); ++it ) {
-        const TaskId id = it->second.taskId();
-        // process use count
-        const unsigned count  = mfuMap[id] + 1;
-        mfuMap[id] = count;
-    }
-    std::priority_queue<TaskWithCount> mfuTasks;
-    for( QMap<TaskId, unsigned >::const_iterator it = mfuMap.constBegin(); it != mfuMap.constEnd(); ++it ) {
-        TaskWithCount t;
-        t.id = it.key();
-        t.count = it.value();
-        mfuTasks.push( t );
-    }
     TaskIdList mfu;
-    while( ! mfuTasks.empty() ) {
-        const TaskWithCount t = mfuTasks.top();
-        mfuTasks.pop();
-        mfu.append( t.id );
+    for ( auto it = m_tasksByUseCount.rbegin(); it != m_tasksByUseCount.rend(); ++it ) {
+        if ( maxCount >= 0 && mfu.size() >= maxCount )
+            break;
+        mfu.append( it->second );
     }
     return mfu;
 }
 
-TaskIdList CharmDataModel::mostRecentlyUsedTasks() const
+TaskIdList CharmDataModel::mostRecentlyUsedTasks( int maxCount ) const
 {
-    QMap<TaskId, QDateTime> mruMap;
-    const EventMap& events = eventMap();
-    for( EventMap::const_iterator it = events.begin(); it != events.end(); ++it ) {
-        const TaskId id = it->second.taskId();
-        // process use date
-        // Note: for a relative order, the UTC time is sufficient and much faster
-        const QDateTime date = it->second.startDateTime(Qt::UTC);
-        mruMap[id]= qMax( mruMap[id], date );
-    }
-    std::priority_queue<TaskWithLastUseDate> mruTasks;
-    for( QMap<TaskId, QDateTime>::const_iterator it = mruMap.constBegin(); it != mruMap.constEnd(); ++it ) {
-        TaskWithLastUseDate t;
-        t.id = it.key();
-        t.lastUse = it.value();
-        if( t.id != 0 ) mruTasks.push( t );
-    }
     TaskIdList mru;
-    while( ! mruTasks.empty() ) {
-        const TaskWithLastUseDate t = mruTasks.top();
-        mruTasks.pop();
-        Q_ASSERT( t.id != 0 );
-        mru.append( t.id );
+    for ( auto it = m_tasksByLastUse.rbegin(); it != m_tasksByLastUse.rend(); ++it ) {
+        if ( maxCount >= 0 && mru.size() >= maxCount )
+            break;
+        if ( it->second != 0 )
+            mru.append( it->second );
     }
-
     return mru;
 }
 
+quint64 CharmDataModel::version() const
+{
+    return m_version;
+}
+
+CharmDataSnapshot CharmDataModel::snapshot() const
+{
+    if ( m_snapshot.version() != m_version ) {
+        const TaskList tasks = m_snapshotTasksChanged ? getAllTasks() : TaskList();
+        m_snapshot = CharmDataSnapshot( m_snapshot, m_version,
+                                        m_snapshotTasksChanged ? &tasks : nullptr,
+                                        m_events,
+                                        m_snapshotEventsReset ? nullptr : &m_snapshotChangedEventBlocks,
+                                        m_activeEventIds );
+        m_snapshotTasksChanged = false;
+        m_snapshotEventsReset = false;
+        m_snapshotChangedEventBlocks.clear();
+    }
+    return m_snapshot;
+}
+
+bool CharmDataModel::changesSince( quint64 version, ModelChangeList* changes ) const
+{
+    return m_journal.changesSince( version, changes );
+}
+
 bool CharmDataModel::operator==( const CharmDataModel& other ) const
 {
-    // not compared: m_timer, m_adapters
+    // not compared: m_timer, m_checkpointTimer, m_adapters
     if( &other == this ) {
         return true;
     }
@@ -759,7 +834,10 @@ CharmDataModel* CharmDataModel::clone() const
     auto c = new CharmDataModel();
     c->setAllTasks( getAllTasks() );
     c->m_events = m_events;
-    c->m_activeEventIds = m_activeEventIds;
+    for ( auto it = m_events.begin(); it != m_events.end(); ++it )
+        c->addTaskUsage( it->second );
+    Q_FOREACH( EventId id, m_activeEventIds )
+        c->insertActiveEvent( eventForId( id ) );
     return c;
 }
 
@@ -27,13 +27,21 @@
 #ifndef CHARMDATAMODEL_H
 #define CHARMDATAMODEL_H
 
+#include <QHash>
 #include <QObject>
+#include <QSet>
 #include <QTimer>
 
+#include <set>
+#include <utility>
+
 #include "Task.h"
 #include "State.h"
 #include "Event.h"
+#include "CharmDataSnapshot.h"
+#include "ModelChangeJournal.h"
 #include "TimeSpans.h"
+#include "TaskTree.h"
 #include "TaskTreeItem.h"
 #include "CharmDataModelAdapterInterface.h"
 #include "SmartNameCache.h"
@@ -68,6 +76,8 @@ public:
         imaginary root that has all top-levels as it's children.
     */
     const TaskTreeItem& taskTreeItem( TaskId id ) const;
+    /** Constant access to the task tree. */
+    const TaskTree& taskTree() const;
     /** Convenience method: retrieve the task directly. */
     const Task& getTask( TaskId id ) const;
     /** Get all tasks as a TaskList.
@@ -88,11 +98,16 @@ public:
     const Event& activeEventFor ( TaskId id ) const;
     EventIdList activeEvents() const;
     int activeEventCount() const;
-    TaskTreeItem& parentItem( const Task& task ); // FIXME const???
-    bool taskExists( TaskId id );
+    const TaskTreeItem& parentItem( const Task& task ) const;
+    bool taskExists( TaskId id ) const;
     /** True if task is in the subtree below parent.
      * parent is not element of the subtree, and thus not it's own child. */
     bool isParentOf( TaskId parent, TaskId task ) const;
+    /** The pre-order range of the subtree under the task with this id.
+     * Returns an invalid range for unknown tasks. */
+    TaskSubtreeRange subtreeRange( TaskId id ) const;
+    /** The pre-order number of the task with this id, or -1 for unknown tasks. */
+    int subtreeOrdinal( TaskId id ) const;
 
     // handling of active events:
     /** Is an event active for the task with this id? */
@@ -109,11 +124,15 @@ public:
     bool activateEvent( const Event& );
 
     /** Provide a list of the most frequently used tasks.
-      * Only tasks that have been used so far will be taken into account, so the list might be empty. */
-    TaskIdList mostFrequentlyUsedTasks() const;
+      * Only tasks that have been used so far will be taken into account, so the list might be empty.
+      * At most maxCount tasks are returned, all if maxCount is negative.
+      * The use counts are maintained incrementally, the event map is not scanned. */
+    TaskIdList mostFrequentlyUsedTasks( int maxCount = -1 ) const;
     /** Provide a list of the most recently used tasks.
-      * Only tasks that have been used so far will be taken into account, so the list might be empty. */
-    TaskIdList mostRecentlyUsedTasks() const;
+      * Only tasks that have been used so far will be taken into account, so the list might be empty.
+      * At most maxCount tasks are returned, all if maxCount is negative.
+      * The last use dates are maintained incrementally, the event map is not scanned. */
+    TaskIdList mostRecentlyUsedTasks( int maxCount = -1 ) const;
 
     /** Create a full task name from the specified TaskId. */
     QString fullTaskName( const Task& ) const;
@@ -130,6 +149,19 @@ public:
     /** Get the task id and smart name as a single string. */
     QString taskIdAndSmartNameString(TaskId id) const;
 
+    /** The version of the model. It changes whenever tasks, events or the
+     * set of active events change. */
+    quint64 version() const;
+    /** An immutable snapshot of the tasks and events at the current version.
+     * Snapshots are cheap to copy and may be passed to other threads, but
+     * this function must only be called on the thread that owns the model. */
+    CharmDataSnapshot snapshot() const;
+    /** Append the changes since @p version to @p changes, oldest first.
+     * The model only remembers its most recent changes. If they do not reach
+     * back to @p version, false is returned, and the caller has to read the
+     * whole model again. */
+    bool changesSince( quint64 version, ModelChangeList* changes ) const;
+
     bool operator==( const CharmDataModel& other ) const;
 
 signals:
@@ -137,6 +169,10 @@ signals:
     // be able to track time:
     void makeAndActivateEvent( const Task& );
     void requestEventModification( const Event&, const Event& );
+    /** The durations of the active events grow with the time. This is
+        emitted regularly while events are active, so that views can repaint
+        them; the model itself does not change. */
+    void activeEventDurationsChanged();
     void sysTrayUpdate( const QString&, bool );
     void resetGUIState();
 
@@ -155,9 +191,24 @@ public slots:
 
 private:
     void determineTaskPaddingLength();
+    // drops the tasks without recording a change or notifying the adapters:
+    void removeAllTasks();
     bool eventExists( EventId id );
 
-    Task& findTask( TaskId id );
+    void addTaskUsage( const Event& );
+    void removeTaskUsage( const Event& );
+    void clearTaskUsage();
+
+    void insertActiveEvent( const Event& );
+    void removeActiveEvent( EventId );
+
+    void tasksChanged();
+    void taskChanged( TaskId );
+    void eventsChanged();
+    void eventChanged( EventId );
+    void activeEventsChanged( EventId, bool active );
+
+    const Task& findTask( TaskId id ) const;
     Event& findEvent( EventId id );
 
     int totalDuration() const;
@@ -165,20 +216,38 @@ private:
     QString totalDurationString() const;
     void updateToolTip();
 
-    TaskTreeItem::Map m_tasks;
-    TaskTreeItem m_rootItem;
+    TaskTree m_tasks;
 
     EventMap m_events;
     EventIdList m_activeEventIds;
+    // index of the active events, kept in sync with m_activeEventIds:
+    QHash<TaskId, EventId> m_activeEventsByTask;
+    QSet<EventId> m_activeEventIdSet;
+    // start times (msecs since epoch, UTC) of the events of every used task,
+    // and the used tasks ordered by use count and by last use:
+    QHash<TaskId, std::multiset<qint64> > m_taskUsage;
+    std::set<std::pair<int, TaskId> > m_tasksByUseCount;
+    std::set<std::pair<qint64, TaskId> > m_tasksByLastUse;
+    // the model version, and the latest snapshot with what changed since:
+    quint64 m_version = 1;
+    mutable CharmDataSnapshot m_snapshot;
+    mutable bool m_snapshotTasksChanged = true;
+    mutable bool m_snapshotEventsReset = true;
+    mutable QSet<int> m_snapshotChangedEventBlocks;
+    // the recent changes, by version:
+    ModelChangeJournal m_journal;
     // adapters are notified when the model changes
     CharmDataModelAdapterList m_adapters;
 
     // event update timer:
     QTimer m_timer;
+    // saves the end of the active events every now and then:
+    QTimer m_checkpointTimer;
     SmartNameCache m_nameCache;
 
 private slots:
     void eventUpdateTimerEvent();
+    void checkpointTimerEvent();
 
 private:
     // functions only used for testing:
@@ -0,0 +1,224 @@
+/*
+  CharmDataSnapshot.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "CharmDataSnapshot.h"
+
+#include <QSet>
+
+namespace {
+    // the number of consecutive event ids that share one block:
+    const int EventBlockSize = 256;
+
+    const TaskTree& emptyTaskTree()
+    {
+        static const TaskTree tree;
+        return tree;
+    }
+}
+
+CharmDataSnapshot::CharmDataSnapshot()
+    : d( new Data )
+{
+}
+
+CharmDataSnapshot::CharmDataSnapshot( const CharmDataSnapshot& previous, quint64 version,
+                                      const TaskList* tasks, const EventMap& events,
+                                      const QSet<int>* changedEventBlocks,
+                                      const EventIdList& activeEventIds )
+{
+    QSharedPointer<Data> data( new Data( *previous.d ) );
+    data->version = version;
+    data->activeEventIds = activeEventIds;
+
+    if ( tasks != nullptr ) {
+        QSharedPointer<TaskTree> tree( new TaskTree );
+        tree->setAllTasks( *tasks );
+        data->tasks = tree;
+    }
+
+    QList<int> blocks;
+    if ( changedEventBlocks != nullptr ) {
+        blocks = changedEventBlocks->toList();
+    } else {
+        data->eventBlocks.clear();
+        data->eventColumns.clear();
+        QSet<int> allBlocks;
+        for ( auto it = events.begin(); it != events.end(); ++it )
+            allBlocks.insert( eventBlock( it->first ) );
+        blocks = allBlocks.toList();
+    }
+    Q_FOREACH( int block, blocks ) {
+        auto first = events.lower_bound( block * EventBlockSize );
+        const auto last = events.lower_bound( ( block + 1 ) * EventBlockSize );
+        if ( first == last ) {
+            data->eventBlocks.remove( block );
+            data->eventColumns.remove( block );
+        } else {
+            data->eventBlocks.insert( block, EventBlock( new EventMap( first, last ) ) );
+            data->eventColumns.insert( block, EventColumnBlock( new EventColumns( first, last ) ) );
+        }
+    }
+    data->eventCount = static_cast<int>( events.size() );
+
+    d = data;
+}
+
+quint64 CharmDataSnapshot::version() const
+{
+    return d->version;
+}
+
+const TaskTree& CharmDataSnapshot::taskTree() const
+{
+    return d->tasks ? *d->tasks : emptyTaskTree();
+}
+
+const TaskTreeItem& CharmDataSnapshot::taskTreeItem( TaskId id ) const
+{
+    return taskTree().item( id );
+}
+
+const Task& CharmDataSnapshot::getTask( TaskId id ) const
+{
+    return taskTreeItem( id ).task();
+}
+
+bool CharmDataSnapshot::taskExists( TaskId id ) const
+{
+    return taskTree().contains( id );
+}
+
+TaskList CharmDataSnapshot::getAllTasks() const
+{
+    return taskTree().rootItem().children();
+}
+
+TaskSubtreeRange CharmDataSnapshot::subtreeRange( TaskId id ) const
+{
+    return taskTree().subtreeRange( id );
+}
+
+int CharmDataSnapshot::subtreeOrdinal( TaskId id ) const
+{
+    return taskTree().subtreeOrdinal( id );
+}
+
+QString CharmDataSnapshot::fullTaskName( const Task& task ) const
+{
+    if ( !task.isValid() )
+        return QString();
+
+    QString name = task.name().simplified();
+    for ( TaskId parentId = task.parent(); parentId != 0; ) {
+        const Task& parent = getTask( parentId );
+        if ( !parent.isValid() )
+            break;
+        name = parent.name().simplified() + '/' + name;
+        parentId = parent.parent();
+    }
+    return name;
+}
+
+int CharmDataSnapshot::eventCount() const
+{
+    return d->eventCount;
+}
+
+const Event& CharmDataSnapshot::eventForId( EventId id ) const
+{
+    static const Event InvalidEvent;
+    const EventBlock block = d->eventBlocks.value( eventBlock( id ) );
+    if ( block ) {
+        const auto it = block->find( id );
+        if ( it != block->end() )
+            return it->second;
+    }
+    return InvalidEvent;
+}
+
+EventList CharmDataSnapshot::events() const
+{
+    EventList events;
+    events.reserve( d->eventCount );
+    Q_FOREACH( const EventBlock& block, d->eventBlocks ) {
+        for ( auto it = block->begin(); it != block->end(); ++it )
+            events.append( it->second );
+    }
+    return events;
+}
+
+EventIdList CharmDataSnapshot::eventsThatStartInTimeFrame( const QDate& start, const QDate& end ) const
+{
+    // see CharmDataModel::eventsThatStartInTimeFrame()
+    const QDateTime startUTC = QDateTime( start, QTime( 0, 0, 0 ) ).toUTC();
+    const QDateTime endUTC = QDateTime( end, QTime( 0, 0, 0 ) ).toUTC();
+    EventIdList events;
+    Q_FOREACH( const EventBlock& block, d->eventBlocks ) {
+        for ( auto it = block->begin(); it != block->end(); ++it ) {
+            const QDateTime eventStart = it->second.startDateTime( Qt::UTC );
+            if ( eventStart >= startUTC && eventStart < endUTC )
+                events << it->first;
+        }
+    }
+    return events;
+}
+
+EventIdList CharmDataSnapshot::activeEvents() const
+{
+    return d->activeEventIds;
+}
+
+TaskBucketSeconds CharmDataSnapshot::secondsByTask( const QDate& start, const QDate& end, const QDate& firstDay,
+                                                    int bucketDays, int bucketCount ) const
+{
+    const qint64 startSeconds = EventColumns::startOfDay( start );
+    const qint64 endSeconds = EventColumns::startOfDay( end );
+    const int firstDayNumber = EventColumns::dayNumber( firstDay );
+    TaskBucketSeconds seconds;
+    Q_FOREACH( const EventColumnBlock& columns, d->eventColumns )
+        columns->sumByTaskAndBucket( startSeconds, endSeconds, firstDayNumber, bucketDays, bucketCount, &seconds );
+    return seconds;
+}
+
+int CharmDataSnapshot::eventBlockCount() const
+{
+    return d->eventColumns.size();
+}
+
+void CharmDataSnapshot::addSecondsByTask( const QDate& start, const QDate& end, const QVector<int>& dayBuckets,
+                                          int bucketCount, int firstBlock, int lastBlock,
+                                          TaskBucketSeconds* result ) const
+{
+    Q_ASSERT( dayBuckets.size() == start.daysTo( end ) );
+    Q_ASSERT( firstBlock >= 0 && firstBlock <= lastBlock && lastBlock <= eventBlockCount() );
+    const qint64 startSeconds = EventColumns::startOfDay( start );
+    const qint64 endSeconds = EventColumns::startOfDay( end );
+    const int firstDayNumber = EventColumns::dayNumber( start );
+    auto it = d->eventColumns.constBegin() + firstBlock;
+    for ( int block = firstBlock; block < lastBlock; ++block, ++it )
+        ( *it )->sumByTaskAndDayBucket( startSeconds, endSeconds, firstDayNumber, dayBuckets, bucketCount, result );
+}
+
+int CharmDataSnapshot::eventBlock( EventId id )
+{
+    // round towards negative infinity, so that every block covers EventBlockSize ids:
+    return id >= 0 ? id / EventBlockSize : ( id + 1 ) / EventBlockSize - 1;
+}
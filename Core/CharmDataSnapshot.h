@@ -0,0 +1,115 @@
+/*
+  CharmDataSnapshot.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CHARMDATASNAPSHOT_H
+#define CHARMDATASNAPSHOT_H
+
+#include <QMap>
+#include <QSharedPointer>
+
+#include "Event.h"
+#include "EventColumns.h"
+#include "Task.h"
+#include "TaskTree.h"
+#include "TaskTreeItem.h"
+
+/** CharmDataSnapshot is an immutable view of the tasks and events of a
+    CharmDataModel at one model version.
+    Snapshots are implicitly shared, copying them is cheap. Since they are
+    never modified, they can be read from any thread while the model keeps
+    changing on the GUI thread.
+    Consecutive snapshots share their data structurally: the task tree is
+    only rebuilt if tasks changed, and the events are kept in blocks of
+    consecutive event ids, of which only those with changes are copied.
+*/
+class CharmDataSnapshot
+{
+public:
+    /** An empty snapshot, at version zero. */
+    CharmDataSnapshot();
+
+    /** The version of the model this snapshot was taken at. */
+    quint64 version() const;
+
+    /** The task tree. Children are ordered by task id. */
+    const TaskTree& taskTree() const;
+    const TaskTreeItem& taskTreeItem( TaskId id ) const;
+    const Task& getTask( TaskId id ) const;
+    bool taskExists( TaskId id ) const;
+    TaskList getAllTasks() const;
+    TaskSubtreeRange subtreeRange( TaskId id ) const;
+    int subtreeOrdinal( TaskId id ) const;
+    QString fullTaskName( const Task& task ) const;
+
+    int eventCount() const;
+    /** The event with this id, or an invalid event. */
+    const Event& eventForId( EventId id ) const;
+    /** All events, ordered by id. */
+    EventList events() const;
+    /** Same as CharmDataModel::eventsThatStartInTimeFrame(). */
+    EventIdList eventsThatStartInTimeFrame( const QDate& start, const QDate& end ) const;
+    EventIdList activeEvents() const;
+    /** The seconds of the events that start in [ start, end ), summed by task
+     * and by bucket. Bucket n holds the events that start between
+     * n * bucketDays and ( n + 1 ) * bucketDays days after @p firstDay. */
+    TaskBucketSeconds secondsByTask( const QDate& start, const QDate& end, const QDate& firstDay,
+                                     int bucketDays, int bucketCount ) const;
+    /** The number of event blocks, to split aggregations into parts. */
+    int eventBlockCount() const;
+    /** Add the seconds of the events in the event blocks [ firstBlock, lastBlock )
+     * that start in [ start, end ) to @p result, by task and by bucket. The bucket
+     * of an event that starts n days after @p start is @p dayBuckets[ n ].
+     * Parts of the blocks can be aggregated concurrently, into separate results. */
+    void addSecondsByTask( const QDate& start, const QDate& end, const QVector<int>& dayBuckets,
+                           int bucketCount, int firstBlock, int lastBlock,
+                           TaskBucketSeconds* result ) const;
+
+    /** The block of the event with this id. */
+    static int eventBlock( EventId id );
+
+private:
+    friend class CharmDataModel;
+
+    /** Create the snapshot that follows @p previous.
+     * The task tree is rebuilt from @p tasks unless it is null. Only the event
+     * blocks in @p changedEventBlocks are copied from @p events, all of them
+     * if it is null. */
+    CharmDataSnapshot( const CharmDataSnapshot& previous, quint64 version,
+                       const TaskList* tasks, const EventMap& events,
+                       const QSet<int>* changedEventBlocks,
+                       const EventIdList& activeEventIds );
+
+    typedef QSharedPointer<const EventMap> EventBlock;
+    typedef QSharedPointer<const EventColumns> EventColumnBlock;
+
+    struct Data {
+        quint64 version = 0;
+        QSharedPointer<const TaskTree> tasks;
+        QMap<int, EventBlock> eventBlocks;
+        // the same events, in columns for aggregation:
+        QMap<int, EventColumnBlock> eventColumns;
+        int eventCount = 0;
+        EventIdList activeEventIds;
+    };
+    QSharedPointer<const Data> d;
+};
+
+#endif
@@ -32,6 +32,7 @@
 #include "Event.h"
 #include "SqLiteStorage.h"
 #include "SqlRaiiTransactor.h"
+#include "StartupProfiler.h"
 #include "StorageInterface.h"
 #include "Task.h"
 
@@ -169,18 +170,33 @@ void Controller::stateChanged( State previous, State next )
     switch( next ) {
     case Connected:
     {   // yes, it is that simple:
-        TaskList tasks = m_storage->getAllTasks();
+        TaskList tasks;
+        {
+            StartupPhase phase( "getAllTasks" );
+            tasks = m_storage->getAllTasks();
+        }
         // tell the view about the existing tasks;
-        if ( ! Task::checkForUniqueTaskIds( tasks ) ) {
-            throw CharmException( tr( "The Charm database is corrupted, it contains duplicate task ids. "
-                                      "Please have it looked after by a professional." ) );
+        {
+            StartupPhase phase( "check task tree" );
+            if ( ! Task::checkForUniqueTaskIds( tasks ) ) {
+                throw CharmException( tr( "The Charm database is corrupted, it contains duplicate task ids. "
+                                          "Please have it looked after by a professional." ) );
+            }
+            if ( ! Task::checkForTreeness( tasks ) ) {
+                throw CharmException( tr( "The Charm database is corrupted, the tasks do not form a tree. "
+                                          "Please have it looked after by a professional." ) );
+            }
+        }
+        {
+            StartupPhase phase( "setAllTasks" );
+            emit definedTasks( tasks );
         }
-        if ( ! Task::checkForTreeness( tasks ) ) {
-            throw CharmException( tr( "The Charm database is corrupted, the tasks do not form a tree. "
-                                      "Please have it looked after by a professional." ) );
+        EventList events;
+        {
+            StartupPhase phase( "getAllEvents" );
+            events = m_storage->getAllEvents();
         }
-        emit definedTasks( tasks );
-        EventList events = m_storage->getAllEvents();
+        StartupPhase phase( "setAllEvents" );
         emit allEvents( events );
     }
     break;
@@ -291,6 +307,7 @@ bool Controller::initializeBackEnd( const QString& name )
 
 bool Controller::connectToBackend()
 {
+    StartupPhase phase( "connect to database" );
     bool result = m_storage->connect( CONFIGURATION );
 
     // the user id in the database, and the installation id, do not
@@ -23,6 +23,7 @@
 
 #include "Event.h"
 #include "CharmExceptions.h"
+#include "XmlSerialization.h"
 
 #include <QDomElement>
 #include <QDomText>
@@ -38,7 +39,7 @@ bool Event::operator == ( const Event& other ) const
              && other.taskId() == taskId()
              && other.comment() == comment()
              && other.startDateTime() ==  startDateTime()
-             && other.endDateTime() == endDateTime()
+             && other.m_end == m_end
              && other.userId() == userId()
              && other.reportId() == reportId() );
 }
@@ -122,9 +123,16 @@ void Event::setStartDateTime( const QDateTime& start )
     Q_ASSERT( m_start.time().msec() == 0 );
 }
 
+// the current time, with the precision of the stored times:
+static QDateTime now()
+{
+    const QDateTime now = QDateTime::currentDateTime().toUTC();
+    return now.addMSecs( -now.time().msec() );
+}
+
 QDateTime Event::endDateTime( Qt::TimeSpec timeSpec ) const
 {
-    return m_end.toTimeSpec( timeSpec );
+    return ( m_running ? now() : m_end ).toTimeSpec( timeSpec );
 }
 
 void Event::setEndDateTime( const QDateTime& end )
@@ -138,12 +146,24 @@ void Event::setEndDateTime( const QDateTime& end )
 
 int Event::duration() const
 {
-    if ( m_start.isValid() && m_end.isValid() )
+    if ( m_start.isValid() && m_running )
+        return m_start.secsTo( now() );
+    else if ( m_start.isValid() && m_end.isValid() )
         return m_start.secsTo( m_end );
     else
         return 0;
 }
 
+bool Event::isRunning() const
+{
+    return m_running;
+}
+
+void Event::setRunning( bool running )
+{
+    m_running = running;
+}
+
 void Event::dump() const
 {
     qDebug() << "[Event" << id() << "] - task "
@@ -180,8 +200,9 @@ QDomElement Event::toXml( QDomDocument document ) const
     if ( m_start.isValid() ) {
         element.setAttribute( EventStartAttribute, m_start.toString( Qt::ISODate ) );
     }
-    if ( m_end.isValid() ) {
-        element.setAttribute( EventEndAttribute, m_end.toString( Qt::ISODate ) );
+    const QDateTime end = endDateTime( Qt::UTC );
+    if ( end.isValid() ) {
+        element.setAttribute( EventEndAttribute, end.toString( Qt::ISODate ) );
     }
     if ( !comment().isEmpty() ) {
         QDomText commentText = document.createTextNode( comment() );
@@ -190,6 +211,27 @@ QDomElement Event::toXml( QDomDocument document ) const
     return element;
 }
 
+void Event::writeXml( XmlReportWriter* writer ) const
+{
+    writer->startElement( EventElement );
+    writer->attribute( EventIdAttribute, QString().setNum( id() ) );
+    writer->attribute( EventInstallationIdAttribute, QString().setNum( installationId() ) );
+    writer->attribute( EventTaskIdAttribute, QString().setNum( taskId() ) );
+    writer->attribute( EventUserIdAttribute, QString().setNum( userId() ) );
+    writer->attribute( EventReportIdAttribute, QString().setNum( reportId() ) );
+    if ( m_start.isValid() ) {
+        writer->attribute( EventStartAttribute, m_start.toString( Qt::ISODate ) );
+    }
+    const QDateTime end = endDateTime( Qt::UTC );
+    if ( end.isValid() ) {
+        writer->attribute( EventEndAttribute, end.toString( Qt::ISODate ) );
+    }
+    if ( !comment().isEmpty() ) {
+        writer->text( comment() );
+    }
+    writer->endElement();
+}
+
 QString Event::tagName()
 {
     static const QString tag( QString::fromLatin1( "event" ) );
@@ -85,9 +85,18 @@ public:
     /** Returns the duration of this event in seconds. */
     int duration () const;
 
+    /** A running event is being recorded. It lasts until now: its end and
+        duration follow the current time, and the end that was set is only
+        the time it was last saved. */
+    bool isRunning() const;
+
+    void setRunning( bool running );
+
     void dump() const;
 
     QDomElement toXml( QDomDocument ) const;
+    /** Write the same element as toXml() to a streamed report. */
+    void writeXml( XmlReportWriter* writer ) const;
 
     static Event fromXml( const QDomElement&,  int databaseSchemaVersion = 1 );
     static QString tagName();
@@ -111,6 +120,8 @@ private:
     QDateTime m_start;
     /** The end datetime of the event. */
     QDateTime m_end;
+    /** Whether the event is running, see isRunning(). */
+    bool m_running = false;
 };
 
 /** A list of events. */
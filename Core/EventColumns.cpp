@@ -0,0 +1,169 @@
+/*
+  EventColumns.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "EventColumns.h"
+
+#include <QDateTime>
+#include <QHash>
+#include <QVarLengthArray>
+
+#include <algorithm>
+#include <limits>
+
+EventColumns::EventColumns( EventMap::const_iterator first, EventMap::const_iterator last )
+{
+    const int count = static_cast<int>( std::distance( first, last ) );
+    m_startSeconds.reserve( count );
+    m_durations.reserve( count );
+    m_days.reserve( count );
+    m_taskIndexes.reserve( count );
+
+    QHash<TaskId, int> taskIndexes;
+    for ( auto it = first; it != last; ++it ) {
+        const Event& event = it->second;
+        const QDateTime start = event.startDateTime();
+        // events without a start never match a time span:
+        m_startSeconds.append( start.isValid() ? start.toMSecsSinceEpoch() / 1000
+                                               : std::numeric_limits<qint64>::min() );
+        m_durations.append( event.duration() );
+        if ( event.isRunning() )
+            m_runningIndexes.append( m_durations.size() - 1 );
+        m_days.append( start.isValid() ? dayNumber( start.date() ) : 0 );
+
+        auto task = taskIndexes.find( event.taskId() );
+        if ( task == taskIndexes.end() ) {
+            task = taskIndexes.insert( event.taskId(), m_tasks.size() );
+            m_tasks.append( event.taskId() );
+        }
+        m_taskIndexes.append( task.value() );
+    }
+}
+
+int EventColumns::size() const
+{
+    return m_startSeconds.size();
+}
+
+int EventColumns::dayNumber( const QDate& date )
+{
+    return static_cast<int>( date.toJulianDay() );
+}
+
+qint64 EventColumns::startOfDay( const QDate& date )
+{
+    return QDateTime( date, QTime( 0, 0, 0 ) ).toMSecsSinceEpoch() / 1000;
+}
+
+void EventColumns::sumByTaskAndBucket( qint64 startSeconds, qint64 endSeconds,
+                                       int firstDay, int bucketDays, int bucketCount,
+                                       TaskBucketSeconds* result ) const
+{
+    Q_ASSERT( result );
+    Q_ASSERT( bucketDays > 0 && bucketCount > 0 );
+    const int count = size();
+    const qint64* starts = m_startSeconds.constData();
+    const int* durations = m_durations.constData();
+    const int* days = m_days.constData();
+    const int* taskIndexes = m_taskIndexes.constData();
+
+    // first pass, without branches so that it vectorizes: the bucket of every
+    // event, and its duration if it is in the time span, or zero:
+    QVarLengthArray<int, 256> cells( count );
+    QVarLengthArray<int, 256> seconds( count );
+    QVarLengthArray<int, 256> matches( count );
+    // multiplying with the inverse vectorizes, integer division does not; the
+    // half day offset keeps the quotient away from the rounding boundaries:
+    const double inverseBucketDays = 1.0 / bucketDays;
+    const int lastBucket = bucketCount - 1;
+    for ( int i = 0; i < count; ++i ) {
+        const int match = ( starts[i] >= startSeconds ) & ( starts[i] < endSeconds );
+        const int bucket = static_cast<int>( ( days[i] - firstDay + 0.5 ) * inverseBucketDays );
+        cells[i] = taskIndexes[i] * bucketCount + std::min( std::max( bucket, 0 ), lastBucket );
+        seconds[i] = durations[i] & -match;
+        matches[i] = match;
+    }
+
+    addSums( cells.constData(), seconds.data(), matches.constData(), bucketCount, result );
+}
+
+void EventColumns::sumByTaskAndDayBucket( qint64 startSeconds, qint64 endSeconds, int firstDay,
+                                          const QVector<int>& dayBuckets, int bucketCount,
+                                          TaskBucketSeconds* result ) const
+{
+    Q_ASSERT( result );
+    Q_ASSERT( !dayBuckets.isEmpty() && bucketCount > 0 );
+    const int count = size();
+    const qint64* starts = m_startSeconds.constData();
+    const int* durations = m_durations.constData();
+    const int* days = m_days.constData();
+    const int* taskIndexes = m_taskIndexes.constData();
+    const int* buckets = dayBuckets.constData();
+
+    // the same first pass, with the bucket looked up by day; events outside of
+    // the time span are clamped to a valid day, and count zero seconds:
+    QVarLengthArray<int, 256> cells( count );
+    QVarLengthArray<int, 256> seconds( count );
+    QVarLengthArray<int, 256> matches( count );
+    const int lastDay = dayBuckets.size() - 1;
+    for ( int i = 0; i < count; ++i ) {
+        const int match = ( starts[i] >= startSeconds ) & ( starts[i] < endSeconds );
+        const int day = std::min( std::max( days[i] - firstDay, 0 ), lastDay );
+        cells[i] = taskIndexes[i] * bucketCount + buckets[day];
+        seconds[i] = durations[i] & -match;
+        matches[i] = match;
+    }
+
+    addSums( cells.constData(), seconds.data(), matches.constData(), bucketCount, result );
+}
+
+void EventColumns::addSums( const int* cells, int* seconds, const int* matches,
+                            int bucketCount, TaskBucketSeconds* result ) const
+{
+    // running events last until now, which is only known when aggregating:
+    if ( !m_runningIndexes.isEmpty() ) {
+        const qint64 now = QDateTime::currentMSecsSinceEpoch() / 1000;
+        Q_FOREACH( int i, m_runningIndexes )
+            seconds[i] = matches[i] ? static_cast<int>( now - m_startSeconds[i] ) : 0;
+    }
+
+    // second pass, scatter the values into the task and bucket slots:
+    const int count = size();
+    const int* taskIndexes = m_taskIndexes.constData();
+    QVarLengthArray<int, 256> sums( m_tasks.size() * bucketCount );
+    std::fill( sums.begin(), sums.end(), 0 );
+    QVarLengthArray<int, 64> taskMatches( m_tasks.size() );
+    std::fill( taskMatches.begin(), taskMatches.end(), 0 );
+    for ( int i = 0; i < count; ++i ) {
+        sums[cells[i]] += seconds[i];
+        taskMatches[taskIndexes[i]] += matches[i];
+    }
+
+    for ( int task = 0; task < m_tasks.size(); ++task ) {
+        if ( taskMatches[task] == 0 )
+            continue;
+        QVector<int>& values = ( *result )[m_tasks[task]];
+        if ( values.isEmpty() )
+            values.resize( bucketCount );
+        const int* taskSums = sums.constData() + task * bucketCount;
+        for ( int bucket = 0; bucket < bucketCount; ++bucket )
+            values[bucket] += taskSums[bucket];
+    }
+}
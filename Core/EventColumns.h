@@ -0,0 +1,86 @@
+/*
+  EventColumns.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef EVENTCOLUMNS_H
+#define EVENTCOLUMNS_H
+
+#include <QDate>
+#include <QMap>
+#include <QVector>
+
+#include "Event.h"
+#include "Task.h"
+
+/** Seconds per task, one value for every bucket of a time span. */
+typedef QMap<TaskId, QVector<int> > TaskBucketSeconds;
+
+/** EventColumns stores the fields of a set of events that reports
+    aggregate, with one array per field: the start in seconds since the
+    epoch, the duration, the local day number of the start, and the task.
+    Everything that needs time zone handling is computed once, when the
+    columns are built, so that aggregating them is plain integer arithmetic
+    over contiguous arrays, which the compiler can vectorize. Only the
+    durations of running events are computed when aggregating.
+*/
+class EventColumns
+{
+public:
+    /** Build the columns of the events in [ first, last ). */
+    EventColumns( EventMap::const_iterator first, EventMap::const_iterator last );
+
+    int size() const;
+
+    /** The local day number (Julian day) of @p date, as stored for event starts. */
+    static int dayNumber( const QDate& date );
+    /** The seconds since the epoch of local midnight at the beginning of @p date. */
+    static qint64 startOfDay( const QDate& date );
+
+    /** Add the durations of the events that start in [ startSeconds, endSeconds )
+     * to @p result, by task and bucket. The bucket of an event is the number of
+     * days between @p firstDay and its start day, divided by @p bucketDays.
+     * Tasks get an entry with @p bucketCount values if they have any matching event. */
+    void sumByTaskAndBucket( qint64 startSeconds, qint64 endSeconds,
+                             int firstDay, int bucketDays, int bucketCount,
+                             TaskBucketSeconds* result ) const;
+
+    /** Like sumByTaskAndBucket(), for buckets of different lengths: the bucket
+     * of an event that starts n days after @p firstDay is @p dayBuckets[ n ].
+     * @p dayBuckets has an entry for every day of the time span. */
+    void sumByTaskAndDayBucket( qint64 startSeconds, qint64 endSeconds, int firstDay,
+                                const QVector<int>& dayBuckets, int bucketCount,
+                                TaskBucketSeconds* result ) const;
+
+private:
+    void addSums( const int* cells, int* seconds, const int* matches,
+                  int bucketCount, TaskBucketSeconds* result ) const;
+
+    QVector<qint64> m_startSeconds;
+    QVector<int> m_durations;
+    QVector<int> m_days;
+    // index into m_tasks:
+    QVector<int> m_taskIndexes;
+    // the distinct tasks of the events:
+    QVector<TaskId> m_tasks;
+    // the running events, whose durations are computed when aggregating:
+    QVector<int> m_runningIndexes;
+};
+
+#endif
@@ -0,0 +1,71 @@
+/*
+  ModelChangeJournal.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ModelChangeJournal.h"
+
+ModelChangeJournal::ModelChangeJournal( quint64 version, int capacity )
+    : m_changes( capacity )
+    , m_firstVersion( version )
+    , m_lastVersion( version )
+{
+    Q_ASSERT( capacity > 0 );
+}
+
+void ModelChangeJournal::record( quint64 version, ModelChange::Type type, int id )
+{
+    Q_ASSERT_X( version == m_lastVersion + 1, Q_FUNC_INFO,
+                "Every change has to increase the version by one" );
+
+    const ModelChange change = { version, type, id };
+    if ( m_count < m_changes.size() ) {
+        m_changes[( m_first + m_count ) % m_changes.size()] = change;
+        ++m_count;
+    } else {
+        // overwrite the oldest change, the versions before it are lost:
+        m_firstVersion = m_changes[m_first].version;
+        m_changes[m_first] = change;
+        m_first = ( m_first + 1 ) % m_changes.size();
+    }
+    m_lastVersion = version;
+}
+
+bool ModelChangeJournal::changesSince( quint64 version, ModelChangeList* changes ) const
+{
+    Q_ASSERT( changes );
+    if ( version < m_firstVersion || version > m_lastVersion )
+        return false;
+
+    // the changes are consecutive, the one after version is at a known offset:
+    const int skipped = m_count - int( m_lastVersion - version );
+    for ( int i = skipped; i < m_count; ++i )
+        changes->append( m_changes[( m_first + i ) % m_changes.size()] );
+    return true;
+}
+
+quint64 ModelChangeJournal::firstVersion() const
+{
+    return m_firstVersion;
+}
+
+quint64 ModelChangeJournal::lastVersion() const
+{
+    return m_lastVersion;
+}
@@ -0,0 +1,89 @@
+/*
+  ModelChangeJournal.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MODELCHANGEJOURNAL_H
+#define MODELCHANGEJOURNAL_H
+
+#include <QVector>
+
+/** A change of the data model, recorded in its journal. */
+struct ModelChange
+{
+    enum Type {
+        /** All tasks were replaced. */
+        TasksReset,
+        /** A task was added, modified or deleted. */
+        TaskChanged,
+        /** All events were replaced. */
+        EventsReset,
+        /** An event was added, modified or deleted. */
+        EventChanged,
+        /** An event was activated. */
+        EventActivated,
+        /** An event was deactivated. */
+        EventDeactivated
+    };
+
+    /** The model version after the change. */
+    quint64 version;
+    Type type;
+    /** The task or event id, 0 for resets. */
+    int id;
+};
+
+typedef QVector<ModelChange> ModelChangeList;
+
+/**
+ * ModelChangeJournal records the most recent changes of a data model, to
+ * tell consumers what changed since the version they saw last.
+ *
+ * The journal holds a fixed number of changes in a ring buffer. Once the
+ * changes after a version were overwritten, consumers of that version have
+ * to read the whole model again.
+ */
+class ModelChangeJournal
+{
+public:
+    /** Start the journal at @p version, keeping up to @p capacity changes. */
+    explicit ModelChangeJournal( quint64 version = 0, int capacity = 1024 );
+
+    /** Record a change. Versions have to increase by one with every change. */
+    void record( quint64 version, ModelChange::Type type, int id = 0 );
+
+    /** Append the changes after @p version to @p changes, oldest first.
+     * Returns false if the journal does not reach back to @p version. */
+    bool changesSince( quint64 version, ModelChangeList* changes ) const;
+
+    /** The oldest version that changes can be retrieved for. */
+    quint64 firstVersion() const;
+    /** The version after the latest change. */
+    quint64 lastVersion() const;
+
+private:
+    QVector<ModelChange> m_changes;
+    // index of the oldest change, and the number of changes kept:
+    int m_first = 0;
+    int m_count = 0;
+    quint64 m_firstVersion;
+    quint64 m_lastVersion;
+};
+
+#endif
@@ -103,6 +103,12 @@ MySqlStorage::MySqlStorage() :
 {
 }
 
+MySqlStorage::MySqlStorage( const QString& connectionName )
+    : SqlStorage()
+    , m_database( QSqlDatabase::addDatabase( "QMYSQL", connectionName ) )
+{
+}
+
 MySqlStorage::~MySqlStorage()
 {
 }
@@ -41,6 +41,8 @@ public:
     };
 
     MySqlStorage();
+    /** Uses its own database connection, so that several storages can be open in different threads. */
+    explicit MySqlStorage( const QString& connectionName );
     virtual ~MySqlStorage();
 
     QSqlDatabase& database() override;
@@ -28,6 +28,7 @@
 #include "CharmExceptions.h"
 #include "Configuration.h"
 #include "Event.h"
+#include "StartupProfiler.h"
 
 #include <QDir>
 #include <QtDebug>
@@ -213,13 +214,23 @@ bool SqLiteStorage::connect( Configuration& configuration )
             "</body></html>");
     }
 
-    if ( !m_database.open() )
+    bool opened;
+    {
+        StartupPhase phase( "open SQLite database" );
+        opened = m_database.open();
+    }
+    if ( !opened )
     {
         configuration.failureMessage = QObject::tr("Could not open SQLite database %1").arg( databaseName );
         return false;
     }
 
-    if ( ! verifyDatabase() )
+    bool verified;
+    {
+        StartupPhase phase( "verifyDatabase" );
+        verified = verifyDatabase();
+    }
+    if ( ! verified )
     {
         if ( !createDatabase( configuration ) )
         {
@@ -0,0 +1,196 @@
+/*
+  SqlQueryStatistics.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SqlQueryStatistics.h"
+
+#include <QMutexLocker>
+#include <QStringList>
+#include <QtDebug>
+
+#include <algorithm>
+
+namespace {
+    static const int HistogramBuckets = 32;
+    static const int SlowQueryLogSize = 100;
+    static const int DefaultSlowQueryThreshold = 250; // milliseconds
+
+    int bucketOf( qint64 microseconds )
+    {
+        int bucket = 0;
+        while ( microseconds > 1 && bucket < HistogramBuckets - 1 ) {
+            microseconds >>= 1;
+            ++bucket;
+        }
+        return bucket;
+    }
+
+    bool moreExpensive( const SqlStatementStatistics& left, const SqlStatementStatistics& right )
+    {
+        return left.totalMicroseconds > right.totalMicroseconds;
+    }
+}
+
+SqlStatementStatistics::SqlStatementStatistics()
+    : count( 0 )
+    , failures( 0 )
+    , totalMicroseconds( 0 )
+    , maximumMicroseconds( 0 )
+    , rows( 0 )
+    , rowsReported( 0 )
+    , histogram( HistogramBuckets, 0 )
+{
+}
+
+qint64 SqlStatementStatistics::percentile( int percent ) const
+{
+    const quint64 rank = ( count * percent + 99 ) / 100;
+    quint64 seen = 0;
+    for ( int bucket = 0; bucket < histogram.size(); ++bucket ) {
+        seen += histogram[bucket];
+        if ( seen >= rank && seen > 0 )
+            return qMin( Q_INT64_C( 1 ) << ( bucket + 1 ), maximumMicroseconds );
+    }
+    return maximumMicroseconds;
+}
+
+SqlQueryStatistics& SqlQueryStatistics::instance()
+{
+    static SqlQueryStatistics statistics;
+    return statistics;
+}
+
+SqlQueryStatistics::SqlQueryStatistics()
+    : m_slowQueryThreshold( DefaultSlowQueryThreshold * 1000 )
+{
+    bool ok;
+    const int threshold = qgetenv( "CHARM_SLOW_QUERY_MS" ).toInt( &ok );
+    if ( ok && threshold >= 0 )
+        m_slowQueryThreshold = threshold * Q_INT64_C( 1000 );
+}
+
+void SqlQueryStatistics::record( const QString& statement, qint64 microseconds, int rows, bool success )
+{
+    QMutexLocker locker( &m_mutex );
+    SqlStatementStatistics& statistics = m_statements[statement];
+    if ( statistics.count == 0 )
+        statistics.statement = statement;
+    ++statistics.count;
+    if ( !success )
+        ++statistics.failures;
+    statistics.totalMicroseconds += microseconds;
+    statistics.maximumMicroseconds = qMax( statistics.maximumMicroseconds, microseconds );
+    if ( rows >= 0 ) {
+        statistics.rows += rows;
+        ++statistics.rowsReported;
+    }
+    ++statistics.histogram[bucketOf( microseconds )];
+
+    if ( microseconds >= m_slowQueryThreshold ) {
+        SlowSqlQuery slow;
+        slow.time = QDateTime::currentDateTime();
+        slow.statement = statement;
+        slow.microseconds = microseconds;
+        slow.rows = rows;
+        if ( m_slowQueryLog.size() == SlowQueryLogSize )
+            m_slowQueryLog.removeFirst();
+        m_slowQueryLog.append( slow );
+        locker.unlock();
+        qWarning() << "Slow SQL query:" << microseconds / 1000 << "ms," << rows << "rows:" << statement.simplified();
+    }
+}
+
+void SqlQueryStatistics::recordRows( const QString& statement, int rows )
+{
+    QMutexLocker locker( &m_mutex );
+    QHash<QString, SqlStatementStatistics>::iterator it = m_statements.find( statement );
+    if ( it == m_statements.end() )
+        return;
+    it->rows += rows;
+    ++it->rowsReported;
+}
+
+QList<SqlStatementStatistics> SqlQueryStatistics::statements() const
+{
+    QMutexLocker locker( &m_mutex );
+    QList<SqlStatementStatistics> statements = m_statements.values();
+    locker.unlock();
+    std::sort( statements.begin(), statements.end(), moreExpensive );
+    return statements;
+}
+
+QList<SlowSqlQuery> SqlQueryStatistics::slowQueries() const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_slowQueryLog;
+}
+
+int SqlQueryStatistics::slowQueryThreshold() const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_slowQueryThreshold / 1000;
+}
+
+void SqlQueryStatistics::setSlowQueryThreshold( int milliseconds )
+{
+    Q_ASSERT( milliseconds >= 0 );
+    QMutexLocker locker( &m_mutex );
+    m_slowQueryThreshold = milliseconds * Q_INT64_C( 1000 );
+}
+
+void SqlQueryStatistics::reset()
+{
+    QMutexLocker locker( &m_mutex );
+    m_statements.clear();
+    m_slowQueryLog.clear();
+}
+
+QString SqlQueryStatistics::report() const
+{
+    const QList<SqlStatementStatistics> statements = this->statements();
+    const QList<SlowSqlQuery> slowQueries = this->slowQueries();
+
+    QStringList lines;
+    lines << QString::fromLatin1( "SQL statements: %1, slow query threshold: %2 ms" )
+             .arg( statements.size() ).arg( slowQueryThreshold() );
+    lines << QString::fromLatin1( "count\tfailures\ttotal ms\tmean us\tp50 us\tp95 us\tp99 us\tmax us\trows\tstatement" );
+    Q_FOREACH( const SqlStatementStatistics& statistics, statements ) {
+        lines << QString::fromLatin1( "%1\t%2\t%3\t%4\t%5\t%6\t%7\t%8\t%9\t%10" )
+                 .arg( statistics.count )
+                 .arg( statistics.failures )
+                 .arg( statistics.totalMicroseconds / 1000 )
+                 .arg( statistics.totalMicroseconds / qint64( statistics.count ) )
+                 .arg( statistics.percentile( 50 ) )
+                 .arg( statistics.percentile( 95 ) )
+                 .arg( statistics.percentile( 99 ) )
+                 .arg( statistics.maximumMicroseconds )
+                 .arg( statistics.rowsReported > 0 ? QString::number( statistics.rows ) : QString::fromLatin1( "-" ) )
+                 .arg( statistics.statement.simplified() );
+    }
+    lines << QString::fromLatin1( "Slow queries: %1" ).arg( slowQueries.size() );
+    Q_FOREACH( const SlowSqlQuery& slow, slowQueries ) {
+        lines << QString::fromLatin1( "%1\t%2 ms\t%3 rows\t%4" )
+                 .arg( slow.time.toString( Qt::ISODate ) )
+                 .arg( slow.microseconds / 1000 )
+                 .arg( slow.rows )
+                 .arg( slow.statement.simplified() );
+    }
+    return lines.join( QLatin1String( "\n" ) ) + QLatin1Char( '\n' );
+}
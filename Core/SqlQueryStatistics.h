@@ -0,0 +1,106 @@
+/*
+  SqlQueryStatistics.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SQLQUERYSTATISTICS_H
+#define SQLQUERYSTATISTICS_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+/** The statistics of one SQL statement, over all its executions. */
+struct SqlStatementStatistics
+{
+    SqlStatementStatistics();
+
+    /** The latency in microseconds that @p percent of the executions
+     * took at most, rounded up to a power of two. */
+    qint64 percentile( int percent ) const;
+
+    QString statement;
+    quint64 count;
+    quint64 failures;
+    qint64 totalMicroseconds;
+    qint64 maximumMicroseconds;
+    /** The rows returned or changed, over the executions that reported them. */
+    qint64 rows;
+    quint64 rowsReported;
+    /** Executions by latency, bucket n holds the latencies
+     * in [ 2^n, 2^(n+1) ) microseconds. */
+    QVector<quint32> histogram;
+};
+
+/** An execution that took longer than the slow query threshold. */
+struct SlowSqlQuery
+{
+    QDateTime time;
+    QString statement;
+    qint64 microseconds;
+    int rows;
+};
+
+/**
+ * SqlQueryStatistics counts the statements that SqlStorage::runQuery()
+ * executes, with their latency and rows, and keeps a log of the slow
+ * ones. It is always on, the cost is one hash lookup per query.
+ *
+ * Statements are grouped by their prepared text, without the bound values.
+ * The slow query threshold defaults to the CHARM_SLOW_QUERY_MS environment
+ * variable, or 250 milliseconds. The instance may be used from all threads.
+ */
+class SqlQueryStatistics
+{
+public:
+    static SqlQueryStatistics& instance();
+
+    /** Record an execution. @p rows is -1 if the driver does not report it. */
+    void record( const QString& statement, qint64 microseconds, int rows, bool success );
+    /** Add the @p rows of an execution that record() got as -1, for drivers
+     * that only know the size of a result after it was read. */
+    void recordRows( const QString& statement, int rows );
+
+    /** The statistics of all statements, the most expensive in total first. */
+    QList<SqlStatementStatistics> statements() const;
+    /** The most recent slow queries, oldest first. */
+    QList<SlowSqlQuery> slowQueries() const;
+
+    int slowQueryThreshold() const;
+    void setSlowQueryThreshold( int milliseconds );
+
+    /** Forget all statistics and slow queries. */
+    void reset();
+
+    /** A plain text report of the statements and slow queries, for diagnostics. */
+    QString report() const;
+
+private:
+    SqlQueryStatistics();
+
+    mutable QMutex m_mutex;
+    QHash<QString, SqlStatementStatistics> m_statements;
+    QList<SlowSqlQuery> m_slowQueryLog;
+    qint64 m_slowQueryThreshold; // microseconds
+};
+
+#endif
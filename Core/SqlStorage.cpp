@@ -26,13 +26,16 @@
 #include "CharmConstants.h"
 #include "CharmExceptions.h"
 #include "Event.h"
+#include "SqlQueryStatistics.h"
 #include "SqlRaiiTransactor.h"
 #include "State.h"
 #include "Task.h"
 
 #include <QDateTime>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QSqlDatabase>
+#include <QSqlDriver>
 #include <QSqlError>
 #include <QSqlField>
 #include <QSqlQuery>
@@ -111,6 +114,7 @@ TaskList SqlStorage::getAllTasks()
             Task task = makeTaskFromRecord( query.record() );
             tasks.append(task);
         }
+        recordRows( query, tasks.size() );
     }
 
     return tasks;
@@ -177,8 +181,11 @@ Task SqlStorage::getTask( int taskid )
     if (runQuery(query) && query.next())
     {
         Task task = makeTaskFromRecord( query.record() );
+        recordRows( query, 1 );
         return task;
     } else {
+        if ( query.isActive() )
+            recordRows( query, 0 );
         return Task();
     }
 }
@@ -280,6 +287,7 @@ EventList SqlStorage::getAllEvents()
         {
             events.append(makeEventFromRecord(query.record()));
         }
+        recordRows( query, events.size() );
     }
     return events;
 }
@@ -438,7 +446,20 @@ bool SqlStorage::runQuery(QSqlQuery& query)
     if (DoChitChat)
         qDebug() << MARKER << endl << "SqlStorage::runQuery: executing query:"
                 << endl << query.executedQuery();
+    QElapsedTimer timer;
+    timer.start();
     bool result = query.exec();
+    const qint64 microseconds = timer.nsecsElapsed() / 1000;
+    // SQLite does not know the size of a result before it was read, the
+    // fetch loops report the rows of their SELECTs through recordRows():
+    int rows = -1;
+    if ( result ) {
+        if ( !query.isSelect() )
+            rows = query.numRowsAffected();
+        else if ( query.driver()->hasFeature( QSqlDriver::QuerySize ) )
+            rows = query.size();
+    }
+    SqlQueryStatistics::instance().record( query.lastQuery(), microseconds, rows, result );
     if ( DoChitChat )
     {
         if ( result )
@@ -457,6 +478,12 @@ bool SqlStorage::runQuery(QSqlQuery& query)
     return result;
 }
 
+void SqlStorage::recordRows( const QSqlQuery& query, int rows )
+{
+    if ( !query.driver()->hasFeature( QSqlDriver::QuerySize ) )
+        SqlQueryStatistics::instance().recordRows( query.lastQuery(), rows );
+}
+
 void SqlStorage::stateChanged(State previous)
 {
     Q_UNUSED(previous)
@@ -98,13 +98,17 @@ public:
 
     // run the query and process possible errors
     static bool runQuery( QSqlQuery& );
+    // report the rows a SELECT returned, once they were read, if the driver could not tell before
+    static void recordRows( const QSqlQuery&, int rows );
+
+    // make a task from a row of the Tasks table, optionally joined with Subscriptions
+    static Task makeTaskFromRecord( const QSqlRecord& );
 
 protected:
     virtual QString lastInsertRowFunction() const = 0;
 
 private:
     Event makeEventFromRecord( const QSqlRecord& );
-    Task makeTaskFromRecord( const QSqlRecord& );
 };
 
 #endif
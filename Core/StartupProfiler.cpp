@@ -0,0 +1,148 @@
+/*
+  StartupProfiler.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "StartupProfiler.h"
+
+#include <QFile>
+#include <QStringList>
+
+#include <iostream>
+
+#if defined( __GLIBC__ )
+#  include <malloc.h>
+#elif defined( Q_OS_OSX )
+#  include <malloc/malloc.h>
+#endif
+
+StartupProfiler& StartupProfiler::instance()
+{
+    static StartupProfiler profiler;
+    return profiler;
+}
+
+StartupProfiler::StartupProfiler()
+{
+}
+
+void StartupProfiler::start( const QString& filename )
+{
+    m_filename = filename;
+    m_phases.clear();
+    m_depth = 0;
+    m_active = true;
+    m_clock.start();
+}
+
+void StartupProfiler::finish()
+{
+    if ( !m_active )
+        return;
+    m_active = false;
+
+    const QByteArray text = report().toUtf8();
+    if ( m_filename.isEmpty() ) {
+        std::cerr << text.constData();
+        return;
+    }
+    QFile file( m_filename );
+    if ( file.open( QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text ) ) {
+        file.write( text );
+    } else {
+        std::cerr << "Cannot write the startup profile to " << qPrintable( m_filename )
+                  << ": " << qPrintable( file.errorString() ) << std::endl;
+    }
+}
+
+bool StartupProfiler::isActive() const
+{
+    return m_active;
+}
+
+void StartupProfiler::mark( const char* name )
+{
+    if ( !m_active )
+        return;
+    const Phase phase = { name, m_depth, m_clock.nsecsElapsed(), -1, heapSize(), 0 };
+    m_phases.append( phase );
+}
+
+int StartupProfiler::begin( const char* name )
+{
+    const Phase phase = { name, m_depth, m_clock.nsecsElapsed(), -1, heapSize(), 0 };
+    m_phases.append( phase );
+    ++m_depth;
+    return m_phases.size() - 1;
+}
+
+void StartupProfiler::end( int index )
+{
+    Q_ASSERT( index >= 0 && index < m_phases.size() );
+    --m_depth;
+    Phase& phase = m_phases[index];
+    phase.duration = m_clock.nsecsElapsed() - phase.start;
+    const qint64 heap = heapSize();
+    phase.heapChange = heap >= 0 && phase.heapAtStart >= 0 ? heap - phase.heapAtStart : 0;
+}
+
+QString StartupProfiler::report() const
+{
+    QStringList lines;
+    lines << QString::fromLatin1( "phase\tstart ms\tduration ms\theap KiB\theap change KiB" );
+    Q_FOREACH( const Phase& phase, m_phases ) {
+        const QString name = QString( phase.depth * 2, QLatin1Char( ' ' ) ) + QLatin1String( phase.name );
+        lines << QString::fromLatin1( "%1\t%2\t%3\t%4\t%5" )
+                 .arg( name )
+                 .arg( phase.start / 1000000.0, 0, 'f', 1 )
+                 .arg( phase.duration >= 0 ? QString::number( phase.duration / 1000000.0, 'f', 1 ) : QString::fromLatin1( "-" ) )
+                 .arg( phase.heapAtStart >= 0 ? QString::number( phase.heapAtStart / 1024 ) : QString::fromLatin1( "-" ) )
+                 .arg( phase.heapAtStart >= 0 && phase.duration >= 0 ? QString::number( phase.heapChange / 1024 ) : QString::fromLatin1( "-" ) );
+    }
+    return lines.join( QLatin1String( "\n" ) ) + QLatin1Char( '\n' );
+}
+
+qint64 StartupProfiler::heapSize()
+{
+#if defined( __GLIBC__ ) && ( __GLIBC__ > 2 || ( __GLIBC__ == 2 && __GLIBC_MINOR__ >= 33 ) )
+    const struct mallinfo2 info = mallinfo2();
+    return qint64( info.uordblks ) + qint64( info.hblkhd );
+#elif defined( __GLIBC__ )
+    const struct mallinfo info = mallinfo();
+    return qint64( unsigned( info.uordblks ) ) + qint64( unsigned( info.hblkhd ) );
+#elif defined( Q_OS_OSX )
+    malloc_statistics_t statistics;
+    malloc_zone_statistics( nullptr, &statistics );
+    return qint64( statistics.size_in_use );
+#else
+    return -1;
+#endif
+}
+
+StartupPhase::StartupPhase( const char* name )
+    : m_index( StartupProfiler::instance().isActive() ? StartupProfiler::instance().begin( name ) : -1 )
+{
+}
+
+StartupPhase::~StartupPhase()
+{
+    // the profiler may have finished while the phase ran:
+    if ( m_index >= 0 && StartupProfiler::instance().isActive() )
+        StartupProfiler::instance().end( m_index );
+}
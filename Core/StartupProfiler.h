@@ -0,0 +1,93 @@
+/*
+  StartupProfiler.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef STARTUPPROFILER_H
+#define STARTUPPROFILER_H
+
+#include <QElapsedTimer>
+#include <QString>
+#include <QVector>
+
+/**
+ * StartupProfiler records a timeline of the phases of the application
+ * startup, with the wall time and the change of the heap size of each.
+ *
+ * It is off unless start() is called, then StartupPhase objects record the
+ * phases they live for, nested phases are indented in the report. The
+ * profiler is only used from the GUI thread. The heap size is read from the
+ * C library where it reports it (glibc and macOS), elsewhere it is -1.
+ */
+class StartupProfiler
+{
+public:
+    static StartupProfiler& instance();
+
+    /** Start recording, the timeline begins now. finish() writes the
+     * report to @p filename, or to stderr if it is empty. */
+    void start( const QString& filename = QString() );
+    /** Stop recording after the last phase of the startup, and write the report. */
+    void finish();
+    bool isActive() const;
+
+    /** Record an instant, like the first paint of the main window. */
+    void mark( const char* name );
+
+    /** The timeline as tab separated lines, one per phase, with a header. */
+    QString report() const;
+
+    /** The heap in use in bytes, or -1 if it is not known. */
+    static qint64 heapSize();
+
+private:
+    friend class StartupPhase;
+    StartupProfiler();
+    int begin( const char* name );
+    void end( int index );
+
+    struct Phase {
+        const char* name;
+        int depth;
+        qint64 start; // nanoseconds since start()
+        qint64 duration; // nanoseconds, -1 for marks and unfinished phases
+        qint64 heapAtStart;
+        qint64 heapChange;
+    };
+
+    bool m_active = false;
+    QString m_filename;
+    QElapsedTimer m_clock;
+    QVector<Phase> m_phases;
+    int m_depth = 0;
+};
+
+/** Records a phase of the startup from its construction to its destruction,
+ * if the startup profiler is active. */
+class StartupPhase
+{
+public:
+    explicit StartupPhase( const char* name );
+    ~StartupPhase();
+
+private:
+    int m_index;
+};
+
+#endif
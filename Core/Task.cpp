@@ -26,6 +26,7 @@
 #include "Task.h"
 #include "CharmConstants.h"
 #include "CharmExceptions.h"
+#include "XmlSerialization.h"
 
 #include <QtDebug>
 
@@ -203,6 +204,22 @@ QDomElement Task::toXml(QDomDocument document) const
     return element;
 }
 
+void Task::writeXml( XmlReportWriter* writer ) const
+{
+    writer->startElement( tagName() );
+    writer->attribute( TaskIdElement, QString::number( id() ) );
+    writer->attribute( TaskParentId, QString::number( parent() ) );
+    writer->attribute( TaskSubscribed, QString::number( subscribed() ? 1 : 0 ) );
+    writer->attribute( TaskTrackable, QString::number( trackable() ? 1 : 0 ) );
+    if ( validFrom().isValid() )
+        writer->attribute( TaskValidFrom, validFrom().toString( Qt::ISODate ) );
+    if ( validUntil().isValid() )
+        writer->attribute( TaskValidUntil, validUntil().toString( Qt::ISODate ) );
+    if ( !name().isEmpty() )
+        writer->text( name() );
+    writer->endElement();
+}
+
 Task Task::fromXml(const QDomElement& element, int databaseSchemaVersion)
 {   // in case any task object creates trouble with
     // serialization/deserialization, add an object of it to
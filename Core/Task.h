@@ -38,6 +38,7 @@ typedef int TaskId;
 Q_DECLARE_METATYPE( TaskId )
 
 class Task;
+class XmlReportWriter;
 /** A task list is a list of tasks that belong together.
     Example: All tasks for one user. */
 typedef QList<Task> TaskList;
@@ -91,6 +92,8 @@ public:
     static QString taskListTagName();
 
     QDomElement toXml( QDomDocument ) const;
+    /** Write the same element as toXml() to a streamed report. */
+    void writeXml( XmlReportWriter* writer ) const;
 
     static Task fromXml( const QDomElement&, int databaseSchemaVersion = 1 );
 
@@ -0,0 +1,266 @@
+/*
+  TaskTree.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "TaskTree.h"
+
+#include <QtAlgorithms>
+
+TaskTree::TaskTree()
+{
+    clear();
+}
+
+void TaskTree::setAllTasks( const TaskList& tasks )
+{
+    clear();
+
+    TaskList sortedTasks( tasks );
+    qSort( sortedTasks.begin(), sortedTasks.end(), Task::lowerTaskId );
+
+    m_items.reserve( sortedTasks.size() + 1 );
+    m_indexById.reserve( sortedTasks.size() );
+
+    // allocate all items first, so that parents are found regardless of their position in the list:
+    QVector<int> nodes;
+    nodes.reserve( sortedTasks.size() );
+    Q_FOREACH( const Task& task, sortedTasks ) {
+        nodes.append( allocate( task ) );
+    }
+    for ( int i = 0; i < sortedTasks.size(); ++i )
+        link( nodes[i], sortedTasks[i].parent() );
+
+    updateIndexes();
+}
+
+void TaskTree::addTask( const Task& task )
+{
+    Q_ASSERT( !contains( task.id() ) );
+    const int node = allocate( task );
+    link( node, task.parent() );
+    updateIndexes();
+}
+
+void TaskTree::modifyTask( const Task& task )
+{
+    const int node = indexOf( task.id() );
+    Q_ASSERT_X( node != -1, Q_FUNC_INFO, "Task to modify has to exist" );
+    if ( node == -1 )
+        return;
+
+    const bool parentChanged = m_items[node].m_task.parent() != task.parent();
+    m_items[node].m_task = task;
+    if ( parentChanged ) {
+        unlink( node );
+        link( node, task.parent() );
+        updateIndexes();
+    }
+}
+
+void TaskTree::deleteTask( TaskId id )
+{
+    const int node = indexOf( id );
+    Q_ASSERT_X( node != -1, Q_FUNC_INFO, "Task to delete has to exist" );
+    if ( node == -1 )
+        return;
+
+    Q_ASSERT_X( m_items[node].m_firstChild == -1, Q_FUNC_INFO,
+                "Cannot delete a task that has children" );
+    // do not leave orphans pointing to a reused slot behind:
+    while ( m_items[node].m_firstChild != -1 ) {
+        const int child = m_items[node].m_firstChild;
+        unlink( child );
+        link( child, 0 );
+    }
+
+    unlink( node );
+    m_indexById.remove( id );
+    m_items[node] = TaskTreeItem();
+    m_freeSlots.append( node );
+    updateIndexes();
+}
+
+void TaskTree::clear()
+{
+    m_items.assign( 1, TaskTreeItem() );
+    m_items[0].m_tree = this;
+    m_items[0].m_index = 0;
+    m_indexById.clear();
+    m_freeSlots.clear();
+    m_childSlots.clear();
+}
+
+bool TaskTree::contains( TaskId id ) const
+{
+    return m_indexById.contains( id );
+}
+
+int TaskTree::size() const
+{
+    return m_indexById.size();
+}
+
+TaskId TaskTree::maxTaskId() const
+{
+    TaskId maxTaskId = 0;
+    for ( std::vector<TaskTreeItem>::const_iterator it = m_items.begin(); it != m_items.end(); ++it )
+        maxTaskId = qMax( maxTaskId, it->m_task.id() );
+    return maxTaskId;
+}
+
+const TaskTreeItem& TaskTree::rootItem() const
+{
+    return m_items[0];
+}
+
+const TaskTreeItem& TaskTree::item( TaskId id ) const
+{
+    const int node = indexOf( id );
+    return node == -1 ? m_items[0] : m_items[node];
+}
+
+const TaskTreeItem& TaskTree::itemAt( int index ) const
+{
+    static const TaskTreeItem InvalidItem;
+
+    if ( index >= 0 && index < static_cast<int>( m_items.size() ) ) {
+        return m_items[index];
+    } else {
+        Q_ASSERT_X( false, Q_FUNC_INFO, "Invalid item index" );
+        return InvalidItem;
+    }
+}
+
+TaskSubtreeRange TaskTree::subtreeRange( TaskId id ) const
+{
+    const int node = indexOf( id );
+    return node == -1 ? TaskSubtreeRange() : m_items[node].m_subtreeRange;
+}
+
+int TaskTree::subtreeOrdinal( TaskId id ) const
+{
+    const int node = indexOf( id );
+    return node == -1 ? -1 : m_items[node].m_subtreeRange.first;
+}
+
+int TaskTree::allocate( const Task& task )
+{
+    int node;
+    if ( !m_freeSlots.isEmpty() ) {
+        node = m_freeSlots.takeLast();
+    } else {
+        node = static_cast<int>( m_items.size() );
+        m_items.push_back( TaskTreeItem() );
+    }
+
+    TaskTreeItem& item = m_items[node];
+    item.m_tree = this;
+    item.m_index = node;
+    item.m_task = task;
+    m_indexById.insert( task.id(), node );
+    return node;
+}
+
+int TaskTree::indexOf( TaskId id ) const
+{
+    if ( id <= 0 ) return -1;
+    return m_indexById.value( id, -1 );
+}
+
+// append the item as the last child of the parent:
+void TaskTree::link( int node, TaskId parentId )
+{
+    int parent = indexOf( parentId );
+    if ( parent == -1 || parent == node )
+        parent = 0;
+
+    TaskTreeItem& item = m_items[node];
+    TaskTreeItem& parentItem = m_items[parent];
+    item.m_parent = parent;
+    item.m_nextSibling = -1;
+    item.m_previousSibling = parentItem.m_lastChild;
+    if ( parentItem.m_lastChild != -1 ) {
+        m_items[parentItem.m_lastChild].m_nextSibling = node;
+    } else {
+        parentItem.m_firstChild = node;
+    }
+    parentItem.m_lastChild = node;
+}
+
+void TaskTree::unlink( int node )
+{
+    TaskTreeItem& item = m_items[node];
+    if ( item.m_parent == -1 )
+        return;
+
+    TaskTreeItem& parentItem = m_items[item.m_parent];
+    if ( item.m_previousSibling != -1 ) {
+        m_items[item.m_previousSibling].m_nextSibling = item.m_nextSibling;
+    } else {
+        parentItem.m_firstChild = item.m_nextSibling;
+    }
+    if ( item.m_nextSibling != -1 ) {
+        m_items[item.m_nextSibling].m_previousSibling = item.m_previousSibling;
+    } else {
+        parentItem.m_lastChild = item.m_previousSibling;
+    }
+    item.m_parent = -1;
+    item.m_nextSibling = -1;
+    item.m_previousSibling = -1;
+    item.m_row = -1;
+}
+
+// One pre-order pass over the tree that assigns the rows, lays out the
+// positions of every item's children and numbers the subtrees:
+void TaskTree::updateIndexes()
+{
+    m_childSlots.resize( size() );
+    int slot = 0;
+    int ordinal = 0;
+    int node = 0;
+    while ( node != -1 ) {
+        TaskTreeItem& item = m_items[node];
+        if ( node != 0 )
+            item.m_subtreeRange.first = ordinal++;
+
+        item.m_firstChildSlot = slot;
+        int row = 0;
+        for ( int child = item.m_firstChild; child != -1; child = m_items[child].m_nextSibling ) {
+            m_childSlots[slot++] = child;
+            m_items[child].m_row = row++;
+        }
+        item.m_childCount = row;
+
+        if ( item.m_firstChild != -1 ) {
+            node = item.m_firstChild;
+            continue;
+        }
+        // the subtree is complete, close it and all ancestors that are complete as well:
+        while ( node != 0 ) {
+            m_items[node].m_subtreeRange.last = ordinal - 1;
+            if ( m_items[node].m_nextSibling != -1 )
+                break;
+            node = m_items[node].m_parent;
+        }
+        node = node == 0 ? -1 : m_items[node].m_nextSibling;
+    }
+    Q_ASSERT( slot == size() );
+}
@@ -0,0 +1,97 @@
+/*
+  TaskTree.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef TASKTREE_H
+#define TASKTREE_H
+
+#include <vector>
+
+#include <QHash>
+#include <QVector>
+
+#include "Task.h"
+#include "TaskTreeItem.h"
+
+/** TaskTree stores the task tree in one contiguous vector of TaskTreeItems.
+    The items are linked by storage indexes, and a hash maps task ids to
+    those indexes. Slot 0 holds the root item, the slots of deleted tasks
+    are reused for new ones, so the index of a task is stable for as long
+    as it exists.
+    After every structural change, the rows, the children's positions and
+    the pre-order numbering are recomputed in one pass over the tree, which
+    makes all per-item queries constant time.
+*/
+class TaskTree
+{
+public:
+    TaskTree();
+    TaskTree( const TaskTree& ) = delete;
+    TaskTree& operator=( const TaskTree& ) = delete;
+
+    /** Replace the content of the tree.
+     * Children are ordered by task id. */
+    void setAllTasks( const TaskList& tasks );
+    /** Add a task as the last child of its parent.
+     * Tasks with an unknown parent become top level tasks. */
+    void addTask( const Task& task );
+    /** Update a task. It is moved to the end of the new parent's children if the parent changed. */
+    void modifyTask( const Task& task );
+    /** Remove a task. The task must not have children. */
+    void deleteTask( TaskId id );
+    void clear();
+
+    bool contains( TaskId id ) const;
+    /** The number of tasks in the tree. */
+    int size() const;
+    /** The highest task id in the tree, or zero if it is empty. */
+    TaskId maxTaskId() const;
+
+    /** The imaginary root that has all top-levels as it's children. */
+    const TaskTreeItem& rootItem() const;
+    /** The item for the task, or the root item for unknown tasks and zero. */
+    const TaskTreeItem& item( TaskId id ) const;
+    /** The item at the given storage index, see TaskTreeItem::index(). */
+    const TaskTreeItem& itemAt( int index ) const;
+
+    /** The pre-order range of the subtree under the task with this id.
+     * Returns an invalid range for unknown tasks. */
+    TaskSubtreeRange subtreeRange( TaskId id ) const;
+    /** The pre-order number of the task with this id, or -1 for unknown tasks. */
+    int subtreeOrdinal( TaskId id ) const;
+
+private:
+    friend class TaskTreeItem;
+
+    int allocate( const Task& task );
+    int indexOf( TaskId id ) const;
+    void link( int node, TaskId parentId );
+    void unlink( int node );
+    void updateIndexes();
+
+    std::vector<TaskTreeItem> m_items;
+    QHash<TaskId, int> m_indexById;
+    QVector<int> m_freeSlots;
+    // the children of every item, in order, at [ m_firstChildSlot, m_firstChildSlot + m_childCount ):
+    QVector<int> m_childSlots;
+};
+
+#endif
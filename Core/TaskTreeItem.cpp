@@ -23,6 +23,7 @@
 */
 
 #include "TaskTreeItem.h"
+#include "TaskTree.h"
 
 #include <QtDebug>
 
@@ -30,84 +31,38 @@ TaskTreeItem::TaskTreeItem()
 {
 }
 
-TaskTreeItem::TaskTreeItem( const Task& task, TaskTreeItem* parent )
-    : m_parent( parent )
-    , m_task( task )
-{
-    if ( m_parent ) {
-        m_parent->m_children.append( this );
-    }
-}
-
-TaskTreeItem::TaskTreeItem( const TaskTreeItem& other )
+Task& TaskTreeItem::task()
 {
-    if( this != &other ) {
-        *this = other;
-    }
+    return m_task;
 }
 
-TaskTreeItem& TaskTreeItem::operator=( const TaskTreeItem& other )
+const Task& TaskTreeItem::task() const
 {
-    if( this != &other ) {
-        m_children = other.m_children;
-        m_parent = other.m_parent;
-        m_task = other.m_task;
-        if ( m_parent ) {
-            m_parent->m_children.append( this );
-        }
-    }
-    return *this;
+    return m_task;
 }
 
-TaskTreeItem::~TaskTreeItem()
+bool TaskTreeItem::isValid() const
 {
-    if ( m_parent ) {
-        m_parent->m_children.removeAt( row() );
-    }
+    return m_tree != nullptr && m_parent != -1 && m_task.isValid();
 }
 
-void TaskTreeItem::makeChildOf( TaskTreeItem& parent )
+const TaskTreeItem& TaskTreeItem::parent() const
 {
-    if ( m_parent != &parent ) {
-        Q_ASSERT( ! parent.m_children.contains( this ) ); // that would be wrong
-
-        // if there is an existing parent, unregister with it:
-        // parent can only be zero if there never was a parent so far
-        if ( m_parent != 0 ) {
-            m_parent->m_children.removeAt( row() );
-            m_parent = nullptr;
-        }
+    static TaskTreeItem InvalidItem;
 
-        // register with the new parent
-        m_parent = &parent;
-        parent.m_children.append( this );
+    if ( m_tree != nullptr && m_parent != -1 ) {
+        return m_tree->m_items[ m_parent ];
     } else {
-        // hm, should this be allowed?
-        // done
+        return InvalidItem;
     }
 }
 
-Task& TaskTreeItem::task()
-{
-    return m_task;
-}
-
-const Task& TaskTreeItem::task() const
-{
-    return m_task;
-}
-
-bool TaskTreeItem::isValid() const
-{
-    return m_parent != 0 && m_task.isValid();
-}
-
 const TaskTreeItem& TaskTreeItem::child( int row ) const
 {
     static TaskTreeItem InvalidItem;
 
-    if ( row >= 0 && row < m_children.size() ) {
-        return * m_children.at( row );
+    if ( row >= 0 && row < m_childCount ) {
+        return m_tree->m_items[ m_tree->m_childSlots[ m_firstChildSlot + row ] ];
     } else {
         Q_ASSERT_X( false, Q_FUNC_INFO, "Invalid item position" );
         return InvalidItem;
@@ -116,11 +71,10 @@ const TaskTreeItem& TaskTreeItem::child( int row ) const
 
 int TaskTreeItem::row() const
 {
-    if ( m_parent ) {
-        int row = m_parent->m_children.indexOf( this );
-        Q_ASSERT_X( row != -1, Q_FUNC_INFO,
+    if ( m_parent != -1 ) {
+        Q_ASSERT_X( m_row != -1, Q_FUNC_INFO,
                     "Internal error - cannot find myself in my parents family" );
-        return row;
+        return m_row;
     } else {
         Q_ASSERT_X( false, Q_FUNC_INFO,
                     "Calling row() on an invalid item" );
@@ -130,16 +84,38 @@ int TaskTreeItem::row() const
 
 int TaskTreeItem::childCount() const
 {
-    return m_children.size();
+    return m_childCount;
+}
+
+int TaskTreeItem::index() const
+{
+    return m_index;
+}
+
+TaskSubtreeRange TaskTreeItem::subtreeRange() const
+{
+    return m_subtreeRange;
 }
 
 TaskList TaskTreeItem::children() const
 {
     TaskList tasks;
-    for ( int i = 0; i < m_children.size(); ++i )
-    {
-        tasks << m_children[i]->task()
-              << m_children[i]->children();
+    if ( m_tree == nullptr )
+        return tasks;
+
+    // walk the subtree in pre-order, following the links instead of recursing:
+    const std::vector<TaskTreeItem>& items = m_tree->m_items;
+    int node = m_firstChild;
+    while ( node != -1 ) {
+        const TaskTreeItem& item = items[ node ];
+        tasks << item.m_task;
+        if ( item.m_firstChild != -1 ) {
+            node = item.m_firstChild;
+            continue;
+        }
+        while ( node != m_index && items[ node ].m_nextSibling == -1 )
+            node = items[ node ].m_parent;
+        node = node == m_index ? -1 : items[ node ].m_nextSibling;
     }
 
     return tasks;
@@ -148,9 +124,10 @@ TaskList TaskTreeItem::children() const
 TaskIdList TaskTreeItem::childIds() const
 {
     TaskIdList idList;
-    // get the list of children, and sort by task id:
-    Q_FOREACH( const TaskTreeItem* item, m_children ) {
-        idList.append( item->task().id() );
-    }
+    if ( m_tree == nullptr )
+        return idList;
+
+    for ( int child = m_firstChild; child != -1; child = m_tree->m_items[ child ].m_nextSibling )
+        idList.append( m_tree->m_items[ child ].m_task.id() );
     return idList;
 }
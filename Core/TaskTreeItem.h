@@ -25,61 +25,91 @@
 #ifndef TASKTREEITEM_H
 #define TASKTREEITEM_H
 
-#include <QList>
-
 #include "Task.h"
 
+class TaskTree;
+
+/** TaskSubtreeRange is the interval of pre-order (Euler tour) numbers
+    covered by a task's subtree.
+    The task itself has number first, all tasks below it have numbers
+    in (first, last]. Whether a task is in the subtree of another task
+    thus takes two integer comparisons.
+*/
+struct TaskSubtreeRange
+{
+    int first = -1;
+    int last = -1;
+
+    bool isValid() const { return first >= 0; }
+    /** True if the task with the given pre-order number is in this subtree.
+     * The subtree's root task is included. */
+    bool contains( int ordinal ) const { return ordinal >= first && ordinal <= last; }
+    /** True if the task with the given pre-order number is below the root of this subtree. */
+    bool containsBelow( int ordinal ) const { return ordinal > first && ordinal <= last; }
+};
+
 /** TaskTreeItem is a node in the task tree.
     The tasks form a tree, since tasks can belong to a parent task.
-    This structure is modeled by storing TaskTreeItems in a map that
-    associates them with the respective task id.
-    Every TaskTreeItem has a parent that represents the parent
-    task. If a task has no parent, it is a child of the root
-    TaskTreeItem stored in the model.
-    Every TaskTreeItem keeps a list of children.
+    This structure is modeled by storing TaskTreeItems contiguously in
+    a TaskTree, which links them by their storage indexes (parent,
+    first child, next sibling) instead of by pointers.
+    If a task has no parent, it is a child of the root TaskTreeItem
+    of the tree, which is not a valid item itself.
     Every TaskTreeItem also has a position in it's parents list of
     children. This integer position can be retrieved by calling row on
-    the item.
+    the item. Row, child access and the pre-order numbering are cached
+    by the tree, so all of them are constant time.
+    References to items are invalidated when tasks are added to the tree.
 */
 class TaskTreeItem
 {
 public:
-    typedef QList<const TaskTreeItem*> ConstPointerList;
-    typedef std::map<TaskId, TaskTreeItem> Map;
-
     TaskTreeItem();
 
-    explicit TaskTreeItem( const Task& task, TaskTreeItem* parent = nullptr );
-    TaskTreeItem( const TaskTreeItem& other );
-    TaskTreeItem& operator=( const TaskTreeItem& other );
-
-    ~TaskTreeItem();
-
-    void makeChildOf( TaskTreeItem& parent );
-
     bool isValid() const;
 
     Task& task();
 
     const Task& task() const;
 
+    /** The parent item. The root item is returned for top level tasks, an
+     * invalid item for the root item itself. */
+    const TaskTreeItem& parent() const;
+
     const TaskTreeItem& child( int row ) const;
 
     int row() const;
 
     int childCount() const;
 
-    // recursively find all children of this item
-    // warning: SLOW
+    /** The position of the item in the storage of its tree.
+     * It does not change as long as the task exists. */
+    int index() const;
+
+    /** The pre-order range of the subtree under this item. */
+    TaskSubtreeRange subtreeRange() const;
+
+    // find all children of this item, in pre-order
     TaskList children() const;
 
     TaskIdList childIds() const;
 
 private:
-    TaskTreeItem* m_parent = nullptr;
-    ConstPointerList m_children;
+    friend class TaskTree;
+
+    const TaskTree* m_tree = nullptr;
+    int m_index = -1;
+    int m_parent = -1;
+    int m_firstChild = -1;
+    int m_lastChild = -1;
+    int m_nextSibling = -1;
+    int m_previousSibling = -1;
+    // cached by TaskTree::updateIndexes():
+    int m_row = -1;
+    int m_childCount = 0;
+    int m_firstChildSlot = 0;
+    TaskSubtreeRange m_subtreeRange;
     Task m_task;
 };
 
-
 #endif
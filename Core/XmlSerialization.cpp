@@ -29,6 +29,38 @@
 
 #include <QDateTime>
 #include <QFile>
+#include <QIODevice>
+
+namespace {
+    // the indentation used by QDomDocument::toByteArray( 4 ):
+    static const int IndentSize = 4;
+    // the buffered output is written to the device when it grows beyond this:
+    static const int FlushSize = 16 * 1024;
+}
+
+// escape like QDomDocument does when it saves text and attribute values:
+static void appendEscaped( QString* output, const QString& text, bool isAttribute )
+{
+    const int start = output->size();
+    Q_FOREACH( const QChar c, text ) {
+        if ( c == QLatin1Char( '<' ) ) {
+            *output += QLatin1String( "&lt;" );
+        } else if ( c == QLatin1Char( '"' ) && isAttribute ) {
+            *output += QLatin1String( "&quot;" );
+        } else if ( c == QLatin1Char( '&' ) ) {
+            *output += QLatin1String( "&amp;" );
+        } else if ( c == QLatin1Char( '>' ) && output->size() - start >= 2
+                    && output->endsWith( QLatin1String( "]]" ) ) ) {
+            *output += QLatin1String( "&gt;" );
+        } else if ( isAttribute && ( c == QLatin1Char( '\n' ) || c == QLatin1Char( '\r' ) || c == QLatin1Char( '\t' ) ) ) {
+            *output += QLatin1String( "&#x" ) + QString::number( c.unicode(), 16 ) + QLatin1Char( ';' );
+        } else if ( c == QLatin1Char( '\r' ) ) {
+            *output += QLatin1String( "&#xd;" );
+        } else {
+            *output += c;
+        }
+    }
+}
 
 static QHash<QString,QString> readMetadata( const QDomElement& metadata ) {
     QHash<QString,QString> l;
@@ -114,30 +146,198 @@ namespace XmlSerialization {
 
 }
 
-QString TaskExport::reportType()
+XmlReportWriter::XmlReportWriter( QIODevice* device, const QString& docClass )
+    : m_device( device )
 {
-    return "taskdefinitions";
+    Q_ASSERT( m_device );
+    startDocument( XmlSerialization::reportTagName() );
+    attribute( XmlSerialization::reportTypeAttribute(), docClass );
+    startElement( QLatin1String( "metadata" ) );
+    textElement( QLatin1String( "username" ), Configuration::instance().user.name() );
+    textElement( QLatin1String( "creation-time" ),
+                 QDateTime::currentDateTime().toUTC().toString( Qt::ISODate ) );
 }
 
-void TaskExport::writeTo( const QString& filename, const TaskList& tasks )
+XmlReportWriter::XmlReportWriter( QIODevice* device )
+    : m_device( device )
 {
-    QDomDocument document = XmlSerialization::createXmlTemplate( reportType() );
-    QDomElement report = XmlSerialization::reportElement( document );
+    Q_ASSERT( m_device );
+}
 
-    // write tasks
-    {
-        QDomElement tasksElement = Task::makeTasksElement( document, tasks );
-        report.appendChild( tasksElement );
+XmlReportWriter::~XmlReportWriter()
+{
+}
+
+void XmlReportWriter::startDocument( const QString& rootName )
+{
+    Q_ASSERT( m_elements.isEmpty() );
+    m_buffer += QLatin1String( "<!DOCTYPE " ) + rootName + QLatin1String( ">\n" );
+    startElement( rootName );
+}
+
+void XmlReportWriter::startElement( const QString& name )
+{
+    closeStartTag( false );
+    if ( !m_elements.isEmpty() ) {
+        Q_ASSERT_X( !m_elements.top().lastChildIsText, Q_FUNC_INFO, "elements cannot follow text" );
+        m_elements.top().hasChildren = true;
     }
+    indent();
+    m_buffer += QLatin1Char( '<' ) + name;
+    const OpenElement element = { name, false, false };
+    m_elements.push( element );
+    m_startTagOpen = true;
+}
 
-    // all done, write to file:
-    QFile file( filename );
-    if ( file.open( QIODevice::WriteOnly ) ) {
-        QTextStream stream( &file );
-        document.save( stream, 4 );
+void XmlReportWriter::attribute( const QString& name, const QString& value )
+{
+    Q_ASSERT( m_startTagOpen );
+    m_buffer += QLatin1Char( ' ' ) + name + QLatin1String( "=\"" );
+    appendEscaped( &m_buffer, value, true );
+    m_buffer += QLatin1Char( '"' );
+}
+
+void XmlReportWriter::text( const QString& text )
+{
+    Q_ASSERT( !m_elements.isEmpty() );
+    Q_ASSERT_X( !m_elements.top().hasChildren || m_elements.top().lastChildIsText,
+                Q_FUNC_INFO, "text cannot follow elements" );
+    closeStartTag( true );
+    m_elements.top().hasChildren = true;
+    m_elements.top().lastChildIsText = true;
+    appendEscaped( &m_buffer, text, false );
+}
+
+void XmlReportWriter::endElement()
+{
+    Q_ASSERT( !m_elements.isEmpty() );
+    const OpenElement element = m_elements.pop();
+    if ( !element.hasChildren ) {
+        m_buffer += QLatin1String( "/>" );
     } else {
-        throw XmlSerializationException( QObject::tr( "Cannot write to file: %1" ).arg( file.errorString() ) );
+        if ( !element.lastChildIsText )
+            indent();
+        m_buffer += QLatin1String( "</" ) + element.name + QLatin1Char( '>' );
     }
+    m_buffer += QLatin1Char( '\n' );
+    m_startTagOpen = false;
+    if ( m_buffer.size() > FlushSize )
+        flush();
+}
+
+void XmlReportWriter::textElement( const QString& name, const QString& text )
+{
+    startElement( name );
+    this->text( text );
+    endElement();
+}
+
+void XmlReportWriter::startReport()
+{
+    Q_ASSERT( m_elements.size() == 2 );
+    endElement(); // metadata
+    startElement( QLatin1String( "report" ) );
+}
+
+void XmlReportWriter::finish()
+{
+    while ( !m_elements.isEmpty() )
+        endElement();
+    flush();
+}
+
+void XmlReportWriter::closeStartTag( bool textFollows )
+{
+    if ( !m_startTagOpen )
+        return;
+    m_buffer += QLatin1Char( '>' );
+    // the DOM starts a new line unless the first child is text:
+    if ( !textFollows )
+        m_buffer += QLatin1Char( '\n' );
+    m_startTagOpen = false;
+}
+
+void XmlReportWriter::indent()
+{
+    m_buffer += QString( m_elements.size() * IndentSize, QLatin1Char( ' ' ) );
+}
+
+void XmlReportWriter::flush()
+{
+    const QByteArray data = m_buffer.toUtf8();
+    m_buffer.clear();
+    if ( m_device->write( data ) != data.size() )
+        throw XmlSerializationException( QObject::tr( "Cannot write the report: %1" ).arg( m_device->errorString() ) );
+}
+
+TaskExportWriter::TaskExportWriter( QIODevice* device, const QDateTime& changedSince )
+    : m_writer( device, changedSince.isValid() ? TaskExport::deltaReportType() : TaskExport::reportType() )
+    , m_isDelta( changedSince.isValid() )
+{
+    if ( changedSince.isValid() )
+        m_writer.textElement( changedSinceTagName(), changedSince.toUTC().toString( Qt::ISODate ) );
+    m_writer.startReport();
+    m_writer.startElement( Task::taskListTagName() );
+}
+
+void TaskExportWriter::writeTask( const Task& task )
+{
+    Q_ASSERT_X( !m_writingDeletedTasks, Q_FUNC_INFO, "Tasks have to be written before the deleted tasks" );
+    task.writeXml( &m_writer );
+}
+
+void TaskExportWriter::writeDeletedTask( TaskId id )
+{
+    Q_ASSERT_X( m_isDelta, Q_FUNC_INFO, "Only a delta lists deleted tasks" );
+    if ( !m_writingDeletedTasks ) {
+        m_writer.endElement(); // the task list
+        m_writer.startElement( deletedTasksTagName() );
+        m_writingDeletedTasks = true;
+    }
+    m_writer.textElement( deletedTaskTagName(), QString::number( id ) );
+}
+
+void TaskExportWriter::finish()
+{
+    m_writer.finish();
+}
+
+QString TaskExportWriter::changedSinceTagName()
+{
+    return QLatin1String( "changed-since" );
+}
+
+QString TaskExportWriter::deletedTasksTagName()
+{
+    return QLatin1String( "deleted-tasks" );
+}
+
+QString TaskExportWriter::deletedTaskTagName()
+{
+    return QLatin1String( "deleted-task" );
+}
+
+QString TaskExport::reportType()
+{
+    return "taskdefinitions";
+}
+
+QString TaskExport::deltaReportType()
+{
+    // a different type, so that clients that only know complete catalogues reject deltas:
+    return "taskdefinitions-delta";
+}
+
+void TaskExport::writeTo( const QString& filename, const TaskList& tasks )
+{
+    QFile file( filename );
+    if ( !file.open( QIODevice::WriteOnly ) )
+        throw XmlSerializationException( QObject::tr( "Cannot write to file: %1" ).arg( file.errorString() ) );
+
+    TaskExportWriter writer( &file );
+    Q_FOREACH( const Task& task, tasks )
+        writer.writeTask( task );
+    writer.finish();
 }
 
 void TaskExport::readFrom( const QString& filename )
@@ -172,7 +372,8 @@ void TaskExport::readFrom( QIODevice* device )
     QDomElement rootElement = document.documentElement();
     const QString tagName = rootElement.tagName();
     const QString typeAttribute = rootElement.attribute( XmlSerialization::reportTypeAttribute() );
-    if( tagName != XmlSerialization::reportTagName() || typeAttribute != reportType() ) {
+    if( tagName != XmlSerialization::reportTagName()
+        || ( typeAttribute != reportType() && typeAttribute != deltaReportType() ) ) {
         throw XmlSerializationException( QObject::tr( "This file is not a Charm task definition file. Please double-check." ) );
     }
 
@@ -186,6 +387,19 @@ void TaskExport::readFrom( QIODevice* device )
     // from report, read tasks:
     QDomElement tasksElement = report.firstChildElement( Task::taskListTagName() );
     m_tasks = Task::readTasksElement( tasksElement, CHARM_DATABASE_VERSION );
+
+    // a delta also lists the tasks that were deleted:
+    m_isDelta = ( typeAttribute == deltaReportType() );
+    m_deletedTasks.clear();
+    QDomElement deletedElement = report.firstChildElement( TaskExportWriter::deletedTasksTagName() );
+    for ( QDomElement child = deletedElement.firstChildElement( TaskExportWriter::deletedTaskTagName() );
+          !child.isNull(); child = child.nextSiblingElement( TaskExportWriter::deletedTaskTagName() ) ) {
+        bool ok;
+        const TaskId id = child.text().toInt( &ok );
+        if ( !ok )
+            throw XmlSerializationException( QObject::tr( "Invalid deleted task id: %1" ).arg( child.text() ) );
+        m_deletedTasks << id;
+    }
 }
 
 TaskList TaskExport::tasks() const
@@ -198,6 +412,26 @@ QDateTime TaskExport::exportTime() const
     return m_exportTime;
 }
 
+bool TaskExport::isDelta() const
+{
+    return m_isDelta;
+}
+
+TaskIdList TaskExport::deletedTasks() const
+{
+    return m_deletedTasks;
+}
+
+QDateTime TaskExport::changedSince() const
+{
+    const QString changedSince = metadata( TaskExportWriter::changedSinceTagName() );
+    if ( changedSince.isEmpty() )
+        return QDateTime();
+    QDateTime result = QDateTime::fromString( changedSince, Qt::ISODate );
+    result.setTimeSpec( Qt::UTC );
+    return result;
+}
+
 QString TaskExport::metadata( const QString& key ) const
 {
     return m_metadata.value( key, QString() );
@@ -27,6 +27,7 @@
 
 #include <QDomDocument>
 #include <QHash>
+#include <QStack>
 #include <QString>
 
 #include "Task.h"
@@ -43,6 +44,84 @@ namespace XmlSerialization {
     QString userName( const QDomElement& metaDataElement );
 }
 
+class QIODevice;
+
+/** XmlReportWriter writes a charmreport document to a device while it is
+    produced, without building a QDomDocument first. The output has the same
+    bytes as the document from XmlSerialization::createXmlTemplate() saved
+    with QDomDocument::toByteArray( 4 ), except that the attributes of an
+    element follow the order in which they are added, while the DOM orders
+    them by hash. Text must not be followed by elements in the same parent.
+*/
+class XmlReportWriter {
+public:
+    /** Write the document type, the root element and the metadata of a
+     * report of type @p docClass. The metadata element stays open, so that
+     * the report can add to it before calling startReport(). */
+    XmlReportWriter( QIODevice* device, const QString& docClass );
+    /** Write a document that is not a report, like a database export. It
+     * starts with startDocument(). */
+    explicit XmlReportWriter( QIODevice* device );
+    ~XmlReportWriter();
+
+    /** Write the document type and open the root element @p rootName. */
+    void startDocument( const QString& rootName );
+
+    void startElement( const QString& name );
+    /** Only valid right after startElement(). */
+    void attribute( const QString& name, const QString& value );
+    void text( const QString& text );
+    void endElement();
+    void textElement( const QString& name, const QString& text );
+
+    /** Close the metadata and open the report element. */
+    void startReport();
+    /** Close all open elements and write the rest of the document to the device.
+     * @throws XmlSerializationException if the device cannot be written */
+    void finish();
+
+private:
+    void closeStartTag( bool textFollows );
+    void indent();
+    void flush();
+
+    struct OpenElement {
+        QString name;
+        bool hasChildren;
+        bool lastChildIsText;
+    };
+
+    QIODevice* m_device;
+    QString m_buffer;
+    QStack<OpenElement> m_elements;
+    bool m_startTagOpen = false;
+};
+
+/** TaskExportWriter writes a task definition file one task at a time, so
+    that large catalogues can be exported while they are read. */
+class TaskExportWriter {
+public:
+    /** A valid @p changedSince marks the file as a delta that only contains
+     * the tasks changed since then and their parents, and the tasks deleted
+     * since then. */
+    explicit TaskExportWriter( QIODevice* device, const QDateTime& changedSince = QDateTime() );
+
+    void writeTask( const Task& task );
+    /** Only for deltas, after all tasks were written. */
+    void writeDeletedTask( TaskId id );
+    /** @throws XmlSerializationException if the device cannot be written */
+    void finish();
+
+    static QString changedSinceTagName();
+    static QString deletedTasksTagName();
+    static QString deletedTaskTagName();
+
+private:
+    XmlReportWriter m_writer;
+    bool m_isDelta;
+    bool m_writingDeletedTasks = false;
+};
+
 class TaskExport {
 public:
     // the only method that deals with writing:
@@ -54,12 +133,22 @@ public:
     TaskList tasks() const;
     QString metadata( const QString& key ) const;
     static QString reportType();
+    static QString deltaReportType();
 
     QDateTime exportTime() const;
+    /** The time since which the tasks changed, if the file is a delta, invalid otherwise. */
+    QDateTime changedSince() const;
+    /** True if the file only lists the changes since changedSince(), the
+     * tasks it does not mention are unchanged. */
+    bool isDelta() const;
+    /** The ids of the tasks deleted since changedSince(), only in deltas. */
+    TaskIdList deletedTasks() const;
 
 private:
 
     TaskList m_tasks;
+    TaskIdList m_deletedTasks;
+    bool m_isDelta = false;
     QHash<QString,QString> m_metadata;
     QDateTime m_exportTime;
 };
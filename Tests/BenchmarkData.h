@@ -0,0 +1,101 @@
+/*
+  BenchmarkData.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BENCHMARKDATA_H
+#define BENCHMARKDATA_H
+
+#include "Tools/TimesheetGenerator/SyntheticData.h"
+
+#include <QtTest/QtTest>
+
+/* The data sets of the benchmarks. They are generated from a fixed seed,
+ * so results of different builds and machines can be compared. */
+namespace BenchmarkData {
+
+    enum Size {
+        Small, // one user, four weeks, about 80 tasks
+        Medium, // two users, one year, about 1500 tasks
+        Large, // eight users, two years, about 20000 tasks
+        Huge // 128 users, five years, about one million events
+    };
+
+    inline TimesheetGenerator::SyntheticData::Parameters parameters( Size size )
+    {
+        TimesheetGenerator::SyntheticData::Parameters parameters;
+        switch ( size ) {
+        case Small:
+            parameters.taskDepth = 3;
+            parameters.taskBreadth = 4;
+            parameters.users = 1;
+            parameters.days = 28;
+            break;
+        case Medium:
+            parameters.taskDepth = 4;
+            parameters.taskBreadth = 6;
+            parameters.users = 2;
+            parameters.days = 365;
+            break;
+        case Large:
+            parameters.taskDepth = 4;
+            parameters.taskBreadth = 12;
+            parameters.users = 8;
+            parameters.days = 2 * 365;
+            break;
+        case Huge:
+            parameters.taskDepth = 4;
+            parameters.taskBreadth = 12;
+            parameters.users = 128;
+            parameters.days = 5 * 365;
+            break;
+        }
+        // the running events end right after the generated period, not at the current time:
+        parameters.now = QDateTime( parameters.startDate.addDays( parameters.days ), QTime( 10, 0 ), Qt::UTC );
+        return parameters;
+    }
+
+    /** Add the "size" column and a row per data set, for the _data() functions. */
+    inline void addSizes()
+    {
+        QTest::addColumn<int>( "size" );
+        QTest::newRow( "small" ) << int( Small );
+        QTest::newRow( "medium" ) << int( Medium );
+        QTest::newRow( "large" ) << int( Large );
+    }
+
+    /** Add a row for the huge data set after addSizes(), for the benchmarks that
+     * show the time per million events. */
+    inline void addHugeSize()
+    {
+        QTest::newRow( "huge" ) << int( Huge );
+    }
+
+    /** The events of all users of @p data, their ids are unique. */
+    inline EventList allEvents( const TimesheetGenerator::SyntheticData& data )
+    {
+        EventList events;
+        for ( int userId = 1; userId <= data.parameters().users; ++userId )
+            events << data.events( userId );
+        return events;
+    }
+
+}
+
+#endif
@@ -0,0 +1,304 @@
+/*
+  CharmCommandSessionTests.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "CharmCommandSessionTests.h"
+
+#include "Core/CharmDataModel.h"
+#include "Core/Task.h"
+#include "Charm/CI/CharmCommandSession.h"
+#include "Charm/CI/CharmEventStream.h"
+
+#include <QIODevice>
+#include <QtTest/QtTest>
+
+#include <cstring>
+
+/**
+ * The client end of a connection. The test sends commands with send(),
+ * the replies of the session stay pending, as in the write buffer of a
+ * socket, until the test takes them with receive().
+ */
+class ClientDevice : public QIODevice
+{
+public:
+    ClientDevice()
+    {
+        open( QIODevice::ReadWrite | QIODevice::Unbuffered );
+    }
+
+    void send( const QByteArray& data )
+    {
+        m_input += data;
+        emit readyRead();
+    }
+
+    QByteArray receive()
+    {
+        const QByteArray data = m_output;
+        m_output.clear();
+        if ( !data.isEmpty() )
+            emit bytesWritten( data.size() );
+        return data;
+    }
+
+    bool isSequential() const override
+    {
+        return true;
+    }
+
+    qint64 bytesAvailable() const override
+    {
+        return m_input.size() + QIODevice::bytesAvailable();
+    }
+
+    qint64 bytesToWrite() const override
+    {
+        return m_output.size();
+    }
+
+protected:
+    qint64 readData( char* data, qint64 maxSize ) override
+    {
+        const qint64 size = qMin( maxSize, qint64( m_input.size() ) );
+        memcpy( data, m_input.constData(), size );
+        m_input.remove( 0, size );
+        return size;
+    }
+
+    qint64 writeData( const char* data, qint64 size ) override
+    {
+        m_output.append( data, size );
+        return size;
+    }
+
+private:
+    QByteArray m_input;
+    QByteArray m_output;
+};
+
+static QList<QByteArray> replyLines( const QByteArray& replies )
+{
+    QList<QByteArray> lines = replies.split( '\n' );
+    if ( !lines.isEmpty() && lines.last().isEmpty() )
+        lines.removeLast();
+    return lines;
+}
+
+CharmCommandSessionTests::CharmCommandSessionTests()
+    : QObject()
+{
+}
+
+void CharmCommandSessionTests::init()
+{
+    m_model = new CharmDataModel;
+    m_model->addTask( Task( 1, "Task 1" ) );
+    m_client = new ClientDevice;
+    m_session = new CharmCommandSession( m_model );
+    m_session->setDevice( m_client );
+
+    QList<QByteArray> expected;
+    expected << "* Charm Command Line Interface" << "HELLO CI 1";
+    QCOMPARE( replyLines( m_client->receive() ), expected );
+
+    m_client->send( "READY\n" );
+    expected.clear();
+    expected << "ACK Entering Command Mode";
+    QCOMPARE( replyLines( m_client->receive() ), expected );
+}
+
+void CharmCommandSessionTests::testSplitLines()
+{
+    // a command is only handled once its line is complete:
+    m_client->send( "TA" );
+    QVERIFY( m_client->receive().isEmpty() );
+    m_client->send( "SK 4" );
+    QVERIFY( m_client->receive().isEmpty() );
+    m_client->send( "2\r" );
+    QVERIFY( m_client->receive().isEmpty() );
+    m_client->send( "\nTASK" );
+
+    QList<QByteArray> expected;
+    expected << "NAK UNKNOWN TASK";
+    QCOMPARE( replyLines( m_client->receive() ), expected );
+
+    m_client->send( " 1\n" );
+    expected.clear();
+    expected << m_model->taskIdAndSmartNameString( 1 ).toLatin1();
+    QCOMPARE( replyLines( m_client->receive() ), expected );
+}
+
+void CharmCommandSessionTests::testPipelinedCommands()
+{
+    // all commands of a chunk are answered, in the order they were sent:
+    m_client->send( "TASK 1\nNONSENSE\n\nTASK 42\nSTATUS\n" );
+
+    QList<QByteArray> expected;
+    expected << m_model->taskIdAndSmartNameString( 1 ).toLatin1()
+             << "NAK UNKNOWN COMMAND"
+             << "NAK UNKNOWN TASK"
+             << "NAK WORK HARDER";
+    QCOMPARE( replyLines( m_client->receive() ), expected );
+}
+
+void CharmCommandSessionTests::testOverlongLine()
+{
+    m_client->send( QByteArray( 5000, 'x' ) + "\nTASK 1\n" );
+
+    QList<QByteArray> expected;
+    expected << "NAK LINE TOO LONG"
+             << m_model->taskIdAndSmartNameString( 1 ).toLatin1();
+    QCOMPARE( replyLines( m_client->receive() ), expected );
+}
+
+void CharmCommandSessionTests::testOverlongLineInChunks()
+{
+    // the line is refused as soon as it is too long, once, and the rest
+    // of it is skipped up to its end:
+    m_client->send( QByteArray( 3000, 'x' ) );
+    QVERIFY( m_client->receive().isEmpty() );
+    m_client->send( QByteArray( 3000, 'x' ) );
+
+    QList<QByteArray> expected;
+    expected << "NAK LINE TOO LONG";
+    QCOMPARE( replyLines( m_client->receive() ), expected );
+
+    m_client->send( QByteArray( 3000, 'x' ) );
+    m_client->send( QByteArray( 3000, 'x' ) );
+    QVERIFY( m_client->receive().isEmpty() );
+
+    m_client->send( "xxx\nTASK 1\n" );
+    expected.clear();
+    expected << m_model->taskIdAndSmartNameString( 1 ).toLatin1();
+    QCOMPARE( replyLines( m_client->receive() ), expected );
+}
+
+void CharmCommandSessionTests::testDataAfterBye()
+{
+    m_client->send( "TASK 1\nBYE\nTASK 1\nNONSENSE\n" );
+
+    QList<QByteArray> expected;
+    expected << m_model->taskIdAndSmartNameString( 1 ).toLatin1();
+    QCOMPARE( replyLines( m_client->receive() ), expected );
+    QVERIFY( !m_client->isOpen() );
+}
+
+void CharmCommandSessionTests::testStreamResume()
+{
+    const quint64 start = m_model->version();
+    m_model->addTask( Task( 2, "Task 2", 1 ) );
+    m_model->addTask( Task( 3, "Task 3", 1 ) );
+    m_client->receive(); // the TASK ADDED notifications
+
+    // the client received the change of task 2 before it disconnected:
+    const QByteArray epoch = CharmEventStream::epoch();
+    const QByteArray resumed = QByteArray::number( start + 1 );
+    m_client->send( "STREAM 1 TASKS FROM " + epoch + ' ' + resumed + '\n' );
+
+    QList<QByteArray> expected;
+    expected << "ACK STREAM 1 " + epoch + ' ' + resumed;
+    QCOMPARE( replyLines( m_client->receive() ), expected );
+
+    QCoreApplication::processEvents();
+    QList<QByteArray> lines = replyLines( m_client->receive() );
+    QCOMPARE( lines.size(), 1 );
+    QVERIFY( lines.first().contains( "\"seq\":" + QByteArray::number( start + 2 ) + ',' ) );
+    QVERIFY( lines.first().contains( "\"type\":\"task\",\"id\":3," ) );
+
+    // later changes follow:
+    m_model->addTask( Task( 4, "Task 4", 1 ) );
+    QCoreApplication::processEvents();
+    lines = replyLines( m_client->receive() );
+    QCOMPARE( lines.size(), 1 );
+    QVERIFY( lines.first().contains( "\"seq\":" + QByteArray::number( start + 3 ) + ',' ) );
+    QVERIFY( lines.first().contains( "\"type\":\"task\",\"id\":4," ) );
+}
+
+void CharmCommandSessionTests::testStreamResync()
+{
+    const QByteArray epoch = CharmEventStream::epoch();
+    const QByteArray version = QByteArray::number( m_model->version() );
+
+    // a sequence number this run did not reach yet:
+    m_client->send( "STREAM 1 FROM " + epoch + ' ' + QByteArray::number( m_model->version() + 1 ) + '\n' );
+    QList<QByteArray> expected;
+    expected << "NAK INVALID SEQUENCE";
+    QCOMPARE( replyLines( m_client->receive() ), expected );
+
+    // the sequence numbers of another run are not resumed:
+    m_client->send( "STREAM 1 FROM 0 0\n" );
+    expected.clear();
+    expected << "ACK STREAM 1 " + epoch + ' ' + version;
+    QCOMPARE( replyLines( m_client->receive() ), expected );
+
+    QCoreApplication::processEvents();
+    const QList<QByteArray> lines = replyLines( m_client->receive() );
+    QCOMPARE( lines.size(), 1 );
+    QVERIFY( lines.first().contains( "\"seq\":" + version + ',' ) );
+    QVERIFY( lines.first().contains( "\"type\":\"resync\"" ) );
+}
+
+void CharmCommandSessionTests::testStreamBackpressure()
+{
+    static const qint64 MaximumPendingBytes = 64 * 1024;
+    static const int TaskCount = 600;
+
+    m_client->send( "STREAM 1 TASKS\n" );
+    m_client->receive();
+
+    // about 300 bytes per line, more than twice the pending limit:
+    const quint64 start = m_model->version();
+    const QString padding( 200, QLatin1Char( 'x' ) );
+    for ( int i = 0; i < TaskCount; ++i )
+        m_model->addTask( Task( 2 + i, padding + QString::number( i ), 1 ) );
+
+    // the stream stops once the client does not take the data:
+    QCoreApplication::processEvents();
+    QVERIFY( m_client->bytesToWrite() > MaximumPendingBytes );
+    QVERIFY( m_client->bytesToWrite() < MaximumPendingBytes + 1024 );
+
+    // and continues every time it does, until it caught up:
+    QList<QByteArray> lines;
+    for ( ;; ) {
+        const QByteArray data = m_client->receive();
+        if ( data.isEmpty() )
+            break;
+        QVERIFY( data.size() < MaximumPendingBytes + 1024 );
+        lines += replyLines( data );
+    }
+    QCOMPARE( lines.size(), TaskCount );
+    for ( int i = 0; i < TaskCount; ++i ) {
+        QVERIFY( lines[i].contains( "\"seq\":" + QByteArray::number( start + 1 + i ) + ',' ) );
+        QVERIFY( lines[i].contains( "\"id\":" + QByteArray::number( 2 + i ) + ',' ) );
+    }
+}
+
+void CharmCommandSessionTests::cleanup()
+{
+    delete m_session;
+    m_session = nullptr;
+    delete m_client;
+    m_client = nullptr;
+    delete m_model;
+    m_model = nullptr;
+}
+
+QTEST_MAIN( CharmCommandSessionTests )
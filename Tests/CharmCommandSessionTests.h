@@ -0,0 +1,56 @@
+/*
+  CharmCommandSessionTests.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CHARMCOMMANDSESSIONTESTS_H
+#define CHARMCOMMANDSESSIONTESTS_H
+
+#include <QObject>
+
+class CharmDataModel;
+class CharmCommandSession;
+class ClientDevice;
+
+class CharmCommandSessionTests : public QObject
+{
+    Q_OBJECT
+
+public:
+    CharmCommandSessionTests();
+
+private slots:
+    void init();
+    void testSplitLines();
+    void testPipelinedCommands();
+    void testOverlongLine();
+    void testOverlongLineInChunks();
+    void testDataAfterBye();
+    void testStreamResume();
+    void testStreamResync();
+    void testStreamBackpressure();
+    void cleanup();
+
+private:
+    CharmDataModel* m_model = nullptr;
+    ClientDevice* m_client = nullptr;
+    CharmCommandSession* m_session = nullptr;
+};
+
+#endif
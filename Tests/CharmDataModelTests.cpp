@@ -23,14 +23,18 @@
 */
 
 #include "CharmDataModelTests.h"
+#include "TestHelpers.h"
 
 #include "Core/Task.h"
 #include "Core/TaskTreeItem.h"
 #include "Core/CharmDataModel.h"
+#include "Core/CharmDataSnapshot.h"
 
 #include <QtDebug>
 #include <QtTest/QtTest>
 
+using TestHelpers::makeEvent;
+
 CharmDataModelTests::CharmDataModelTests()
     : QObject()
 {
@@ -176,6 +180,297 @@ void CharmDataModelTests::modifyTaskTest()
     QVERIFY( model.taskTreeItem( 0 ).childCount() == 0 );
 }
 
+void CharmDataModelTests::subtreeRangeTest()
+{
+    CharmDataModel model;
+    Task task1( 1000, "Task 1" );
+    Task task1_1( 1001, "Task 1-1", task1.id() );
+    Task task1_1_1( 1011, "Task 1-1-1", task1_1.id() );
+    Task task1_2( 1002, "Task 1-2", task1.id() );
+    Task task2( 2000, "Task 2" );
+    TaskList tasks;
+    tasks << task1 << task1_1 << task1_1_1 << task1_2 << task2;
+    model.setAllTasks( tasks );
+
+    QVERIFY( model.isParentOf( task1.id(), task1_1.id() ) );
+    QVERIFY( model.isParentOf( task1.id(), task1_1_1.id() ) );
+    QVERIFY( model.isParentOf( task1.id(), task1_2.id() ) );
+    QVERIFY( model.isParentOf( task1_1.id(), task1_1_1.id() ) );
+    QVERIFY( !model.isParentOf( task1.id(), task1.id() ) );
+    QVERIFY( !model.isParentOf( task1.id(), task2.id() ) );
+    QVERIFY( !model.isParentOf( task1_2.id(), task1_1_1.id() ) );
+    QVERIFY( !model.isParentOf( task1_1_1.id(), task1.id() ) );
+
+    const TaskSubtreeRange range = model.subtreeRange( task1.id() );
+    QVERIFY( range.isValid() );
+    QCOMPARE( range.last - range.first, 3 );
+    QVERIFY( range.contains( model.subtreeOrdinal( task1.id() ) ) );
+    QVERIFY( !range.contains( model.subtreeOrdinal( task2.id() ) ) );
+    QVERIFY( !model.subtreeRange( 4711 ).isValid() );
+    QCOMPARE( model.subtreeOrdinal( 4711 ), -1 );
+
+    // the numbering follows moves, additions and deletions:
+    Task task1_1b( task1_1 );
+    task1_1b.setParent( task2.id() );
+    model.modifyTask( task1_1b );
+    QVERIFY( model.isParentOf( task2.id(), task1_1_1.id() ) );
+    QVERIFY( !model.isParentOf( task1.id(), task1_1_1.id() ) );
+    QCOMPARE( model.subtreeRange( task1.id() ).last - model.subtreeRange( task1.id() ).first, 1 );
+
+    Task task2_1( 2100, "Task 2-1", task2.id() );
+    model.addTask( task2_1 );
+    QVERIFY( model.isParentOf( task2.id(), task2_1.id() ) );
+    QCOMPARE( model.subtreeRange( task2.id() ).last - model.subtreeRange( task2.id() ).first, 3 );
+
+    model.deleteTask( task1_1_1 );
+    QCOMPARE( model.subtreeOrdinal( task1_1_1.id() ), -1 );
+    QCOMPARE( model.subtreeRange( task2.id() ).last - model.subtreeRange( task2.id() ).first, 2 );
+}
+
+// verify that rows, children and parents are consistent in the whole tree:
+static void verifyTreeStructure( const TaskTreeItem& item )
+{
+    for ( int row = 0; row < item.childCount(); ++row ) {
+        const TaskTreeItem& child = item.child( row );
+        QVERIFY( child.isValid() );
+        QCOMPARE( child.row(), row );
+        QCOMPARE( child.parent().index(), item.index() );
+        verifyTreeStructure( child );
+    }
+}
+
+void CharmDataModelTests::taskTreeStructureTest()
+{
+    CharmDataModel model;
+    Task task1( 1000, "Task 1" );
+    Task task1_1( 1001, "Task 1-1", task1.id() );
+    Task task1_2( 1002, "Task 1-2", task1.id() );
+    Task task2( 2000, "Task 2" );
+    Task task2_1( 2100, "Task 2-1", task2.id() );
+    TaskList tasks;
+    // children of tasks are sorted by task id, independent of the list order:
+    tasks << task2_1 << task1_2 << task2 << task1_1 << task1;
+    model.setAllTasks( tasks );
+    verifyTreeStructure( model.taskTreeItem( 0 ) );
+    QCOMPARE( model.taskTreeItem( 0 ).childIds(), TaskIdList() << task1.id() << task2.id() );
+    QCOMPARE( model.taskTreeItem( task1.id() ).childIds(), TaskIdList() << task1_1.id() << task1_2.id() );
+    QCOMPARE( model.taskTreeItem( task1_2.id() ).row(), 1 );
+    QVERIFY( !model.taskTreeItem( task1.id() ).parent().isValid() );
+    QCOMPARE( model.getAllTasks().size(), tasks.size() );
+    QCOMPARE( model.getAllTasks().first(), task1 );
+
+    const int index = model.taskTreeItem( task2_1.id() ).index();
+    QCOMPARE( &model.taskTree().itemAt( index ), &model.taskTreeItem( task2_1.id() ) );
+
+    // moved tasks are appended to their new parent, the storage index is stable:
+    Task task1_1b( task1_1 );
+    task1_1b.setParent( task2.id() );
+    model.modifyTask( task1_1b );
+    verifyTreeStructure( model.taskTreeItem( 0 ) );
+    QCOMPARE( model.taskTreeItem( task2.id() ).childIds(), TaskIdList() << task2_1.id() << task1_1.id() );
+    QCOMPARE( model.taskTreeItem( task1_2.id() ).row(), 0 );
+    QCOMPARE( model.taskTreeItem( task2_1.id() ).index(), index );
+
+    // deleted slots are reused:
+    model.deleteTask( task2_1 );
+    verifyTreeStructure( model.taskTreeItem( 0 ) );
+    QCOMPARE( model.taskTreeItem( task1_1.id() ).row(), 0 );
+    Task task3( 3000, "Task 3" );
+    model.addTask( task3 );
+    verifyTreeStructure( model.taskTreeItem( 0 ) );
+    QCOMPARE( model.taskTreeItem( task3.id() ).index(), index );
+    QCOMPARE( model.taskTreeItem( task3.id() ).row(), 2 );
+    QCOMPARE( model.taskTree().size(), 5 );
+}
+
+void CharmDataModelTests::mostUsedTasksTest()
+{
+    CharmDataModel model;
+    const QDateTime start( QDate( 2016, 1, 4 ), QTime( 8, 0 ) );
+    EventList events;
+    events << makeEvent( 1, 1000, start )
+           << makeEvent( 2, 1000, start.addDays( 1 ) )
+           << makeEvent( 3, 2000, start.addDays( 2 ) );
+    model.setAllEvents( events );
+
+    QCOMPARE( model.mostFrequentlyUsedTasks(), TaskIdList() << 1000 << 2000 );
+    QCOMPARE( model.mostRecentlyUsedTasks(), TaskIdList() << 2000 << 1000 );
+    QCOMPARE( model.mostRecentlyUsedTasks( 1 ), TaskIdList() << 2000 );
+
+    // adding and modifying events updates the statistics:
+    model.addEvent( makeEvent( 4, 3000, start.addDays( 3 ) ) );
+    model.addEvent( makeEvent( 5, 2000, start.addDays( -1 ) ) );
+    model.addEvent( makeEvent( 6, 2000, start.addDays( -2 ) ) );
+    QCOMPARE( model.mostFrequentlyUsedTasks( 2 ), TaskIdList() << 2000 << 1000 );
+    QCOMPARE( model.mostRecentlyUsedTasks(), TaskIdList() << 3000 << 2000 << 1000 );
+
+    model.modifyEvent( makeEvent( 4, 1000, start.addDays( 4 ) ) );
+    QCOMPARE( model.mostRecentlyUsedTasks(), TaskIdList() << 1000 << 2000 );
+    QCOMPARE( model.mostFrequentlyUsedTasks(), TaskIdList() << 2000 << 1000 );
+
+    // deleting the latest event of a task moves it back:
+    model.deleteEvent( model.eventForId( 3 ) );
+    model.deleteEvent( model.eventForId( 4 ) );
+    QCOMPARE( model.mostRecentlyUsedTasks(), TaskIdList() << 1000 << 2000 );
+    QCOMPARE( model.mostFrequentlyUsedTasks(), TaskIdList() << 2000 << 1000 );
+    model.deleteEvent( model.eventForId( 5 ) );
+    QCOMPARE( model.mostFrequentlyUsedTasks(), TaskIdList() << 1000 << 2000 );
+
+    model.clearEvents();
+    QVERIFY( model.mostFrequentlyUsedTasks().isEmpty() );
+    QVERIFY( model.mostRecentlyUsedTasks().isEmpty() );
+}
+
+void CharmDataModelTests::activeEventsTest()
+{
+    CharmDataModel model;
+    Task task1( 1000, "Task 1" );
+    Task task2( 2000, "Task 2" );
+    model.setAllTasks( TaskList() << task1 << task2 );
+    const QDateTime start( QDate( 2016, 1, 4 ), QTime( 8, 0 ) );
+    const Event event1 = makeEvent( 1, task1.id(), start );
+    const Event event2 = makeEvent( 2, task2.id(), start );
+    model.setAllEvents( EventList() << event1 << event2 );
+
+    QVERIFY( !model.isTaskActive( task1.id() ) );
+    QVERIFY( !model.activeEventFor( task1.id() ).isValid() );
+
+    QVERIFY( model.activateEvent( event1 ) );
+    QVERIFY( model.activateEvent( event2 ) );
+    QCOMPARE( model.activeEventCount(), 2 );
+    QVERIFY( model.isTaskActive( task1.id() ) );
+    QVERIFY( model.isEventActive( event2.id() ) );
+    QCOMPARE( model.activeEventFor( task2.id() ).id(), event2.id() );
+
+    // moving an active event to another task moves the index entry:
+    Task task3( 3000, "Task 3" );
+    model.addTask( task3 );
+    Event event2b( event2 );
+    event2b.setTaskId( task3.id() );
+    model.modifyEvent( event2b );
+    QVERIFY( !model.isTaskActive( task2.id() ) );
+    QCOMPARE( model.activeEventFor( task3.id() ).id(), event2.id() );
+
+    model.endEventRequested( task1 );
+    QVERIFY( !model.isTaskActive( task1.id() ) );
+    QVERIFY( !model.isEventActive( event1.id() ) );
+    QCOMPARE( model.activeEvents(), EventIdList() << event2.id() );
+
+    model.endAllEventsRequested();
+    QCOMPARE( model.activeEventCount(), 0 );
+    QVERIFY( !model.isTaskActive( task3.id() ) );
+    QVERIFY( !model.activeEventFor( task3.id() ).isValid() );
+}
+
+void CharmDataModelTests::runningEventTest()
+{
+    CharmDataModel model;
+    Task task( 1000, "Task" );
+    model.setAllTasks( TaskList() << task );
+    // started two hours ago, last saved an hour later:
+    const QDateTime start = QDateTime::currentDateTime().addSecs( -7200 );
+    const Event event = makeEvent( 1, task.id(), start );
+    model.addEvent( event );
+    QVERIFY( !model.eventForId( event.id() ).isRunning() );
+    QCOMPARE( model.eventForId( event.id() ).duration(), 3600 );
+
+    QVERIFY( model.activateEvent( event ) );
+    // the duration follows the current time, without changing the model:
+    const quint64 version = model.version();
+    const Event& running = model.eventForId( event.id() );
+    QVERIFY( running.isRunning() );
+    QVERIFY( qAbs( running.duration() - 7200 ) <= 1 );
+    QVERIFY( qAbs( running.endDateTime().secsTo( QDateTime::currentDateTime() ) ) <= 1 );
+    QCOMPARE( running, event ); // the saved end did not change
+    const TaskBucketSeconds seconds = model.snapshot().secondsByTask(
+        start.date(), QDate::currentDate().addDays( 1 ), start.date(), 2, 1 );
+    QVERIFY( qAbs( seconds.value( task.id() ).value( 0 ) - 7200 ) <= 1 );
+    QCOMPARE( model.version(), version );
+
+    // modifications, like a new comment, keep it running:
+    Event commented( event );
+    commented.setComment( "comment" );
+    model.modifyEvent( commented );
+    QVERIFY( model.eventForId( event.id() ).isRunning() );
+
+    // stopping sets the end:
+    model.endEventRequested( task );
+    const Event& stopped = model.eventForId( event.id() );
+    QVERIFY( !stopped.isRunning() );
+    QVERIFY( qAbs( stopped.duration() - 7200 ) <= 1 );
+}
+
+static QList<int> changeTypes( const ModelChangeList& changes )
+{
+    QList<int> types;
+    Q_FOREACH( const ModelChange& change, changes )
+        types << change.type;
+    return types;
+}
+
+void CharmDataModelTests::changeJournalTest()
+{
+    CharmDataModel model;
+    const quint64 start = model.version();
+    ModelChangeList changes;
+    QVERIFY( model.changesSince( start, &changes ) );
+    QVERIFY( changes.isEmpty() );
+    // versions the model never had:
+    QVERIFY( !model.changesSince( start + 1, &changes ) );
+    QVERIFY( !model.changesSince( start - 1, &changes ) );
+
+    Task task( 1000, "Task" );
+    model.setAllTasks( TaskList() << task );
+    model.addTask( Task( 2000, "Task 2" ) );
+    const quint64 tasksAdded = model.version();
+    const Event event = makeEvent( 1, task.id(), QDateTime( QDate( 2016, 1, 4 ), QTime( 8, 0 ) ) );
+    model.addEvent( event );
+    QVERIFY( model.activateEvent( event ) );
+
+    QVERIFY( model.changesSince( start, &changes ) );
+    QCOMPARE( changeTypes( changes ), QList<int>() << ModelChange::TasksReset << ModelChange::TaskChanged
+                                                   << ModelChange::EventChanged << ModelChange::EventActivated );
+    QCOMPARE( changes[1].id, 2000 );
+    QCOMPARE( changes[2].id, event.id() );
+    QCOMPARE( changes.last().version, model.version() );
+    for ( int i = 0; i < changes.size(); ++i )
+        QCOMPARE( changes[i].version, start + i + 1 );
+
+    // only what changed after the given version:
+    changes.clear();
+    QVERIFY( model.changesSince( tasksAdded, &changes ) );
+    QCOMPARE( changeTypes( changes ), QList<int>() << ModelChange::EventChanged << ModelChange::EventActivated );
+
+    // the change tells whether the event started or stopped:
+    const quint64 activated = model.version();
+    model.endEventRequested( task );
+    changes.clear();
+    QVERIFY( model.changesSince( activated, &changes ) );
+    QVERIFY( changeTypes( changes ).contains( ModelChange::EventDeactivated ) );
+    QVERIFY( !changeTypes( changes ).contains( ModelChange::EventActivated ) );
+}
+
+void CharmDataModelTests::changeJournalOverflowTest()
+{
+    ModelChangeJournal journal( 10, 4 );
+    for ( quint64 version = 11; version <= 16; ++version )
+        journal.record( version, ModelChange::EventChanged, int( version ) );
+
+    // the first two changes were overwritten:
+    QCOMPARE( journal.firstVersion(), quint64( 12 ) );
+    QCOMPARE( journal.lastVersion(), quint64( 16 ) );
+    ModelChangeList changes;
+    QVERIFY( !journal.changesSince( 10, &changes ) );
+    QVERIFY( !journal.changesSince( 11, &changes ) );
+    QVERIFY( journal.changesSince( 12, &changes ) );
+    QCOMPARE( changes.size(), 4 );
+    QCOMPARE( changes.first().id, 13 );
+    QCOMPARE( changes.last().id, 16 );
+    changes.clear();
+    QVERIFY( journal.changesSince( 16, &changes ) );
+    QVERIFY( changes.isEmpty() );
+}
+
 void CharmDataModelTests::cleanupTestCase ()
 {
     m_referenceModel->clearTasks();
@@ -40,6 +40,13 @@ private slots:
     void createAndDestroyTest();
     void addAndRemoveTasksTest();
     void modifyTaskTest();
+    void subtreeRangeTest();
+    void taskTreeStructureTest();
+    void mostUsedTasksTest();
+    void activeEventsTest();
+    void runningEventTest();
+    void changeJournalTest();
+    void changeJournalOverflowTest();
     void cleanupTestCase();
 
 private:
@@ -0,0 +1,232 @@
+/*
+  CharmDataSnapshotTests.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "CharmDataSnapshotTests.h"
+#include "TestHelpers.h"
+
+#include "Core/CharmDataModel.h"
+#include "Core/CharmDataSnapshot.h"
+
+#include <QAtomicInt>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QtTest/QtTest>
+
+using TestHelpers::makeEvent;
+
+static const QDate FirstDay( 2016, 1, 4 );
+
+static TaskList makeTasks()
+{
+    return TaskList() << Task( 1, "Project" )
+                      << Task( 2, "Development", 1 )
+                      << Task( 3, "Meetings", 1 )
+                      << Task( 4, "Vacation" );
+}
+
+// four weeks of events on the tasks above:
+static EventList makeEvents( int count )
+{
+    return TestHelpers::makeSpreadEvents( count, 4, FirstDay, 28 );
+}
+
+void CharmDataSnapshotTests::testEmptySnapshot()
+{
+    const CharmDataSnapshot snapshot;
+    QCOMPARE( snapshot.version(), quint64( 0 ) );
+    QCOMPARE( snapshot.eventCount(), 0 );
+    QVERIFY( !snapshot.eventForId( 1 ).isValid() );
+    QVERIFY( snapshot.getAllTasks().isEmpty() );
+    QVERIFY( !snapshot.taskExists( 1 ) );
+}
+
+void CharmDataSnapshotTests::testSnapshotIsImmutable()
+{
+    CharmDataModel model;
+    model.setAllTasks( makeTasks() );
+    model.setAllEvents( makeEvents( 10 ) );
+
+    const CharmDataSnapshot before = model.snapshot();
+    QCOMPARE( before.version(), model.version() );
+    QCOMPARE( model.snapshot().version(), before.version() );
+    QCOMPARE( before.eventCount(), 10 );
+    QCOMPARE( before.getAllTasks().size(), 4 );
+    QCOMPARE( before.fullTaskName( before.getTask( 2 ) ), QString( "Project/Development" ) );
+
+    Event modified = model.eventForId( 5 );
+    modified.setComment( "modified" );
+    model.modifyEvent( modified );
+    model.deleteEvent( model.eventForId( 6 ) );
+    model.addEvent( makeEvent( 11, 4, QDateTime::currentDateTime() ) );
+    model.modifyTask( Task( 2, "Coding", 1 ) );
+    QVERIFY( model.version() > before.version() );
+
+    // the old snapshot does not see any of it:
+    QCOMPARE( before.eventCount(), 10 );
+    QVERIFY( before.eventForId( 5 ).comment().isEmpty() );
+    QVERIFY( before.eventForId( 6 ).isValid() );
+    QVERIFY( !before.eventForId( 11 ).isValid() );
+    QCOMPARE( before.getTask( 2 ).name(), QString( "Development" ) );
+
+    const CharmDataSnapshot after = model.snapshot();
+    QCOMPARE( after.version(), model.version() );
+    QCOMPARE( after.eventCount(), 10 );
+    QCOMPARE( after.eventForId( 5 ).comment(), QString( "modified" ) );
+    QVERIFY( !after.eventForId( 6 ).isValid() );
+    QVERIFY( after.eventForId( 11 ).isValid() );
+    QCOMPARE( after.getTask( 2 ).name(), QString( "Coding" ) );
+    QCOMPARE( after.events().size(), 10 );
+}
+
+void CharmDataSnapshotTests::testStructuralSharing()
+{
+    CharmDataModel model;
+    model.setAllTasks( makeTasks() );
+    model.setAllEvents( makeEvents( 1000 ) );
+    const CharmDataSnapshot first = model.snapshot();
+
+    // change one event, in a different block than event 1:
+    const EventId changedId = 1000;
+    QVERIFY( CharmDataSnapshot::eventBlock( changedId ) != CharmDataSnapshot::eventBlock( 1 ) );
+    Event changed = model.eventForId( changedId );
+    changed.setComment( "changed" );
+    model.modifyEvent( changed );
+    const CharmDataSnapshot second = model.snapshot();
+
+    QCOMPARE( &second.taskTree(), &first.taskTree() );
+    QCOMPARE( &second.eventForId( 1 ), &first.eventForId( 1 ) );
+    QVERIFY( &second.eventForId( changedId ) != &first.eventForId( changedId ) );
+
+    // a task change rebuilds the tree, but keeps all events:
+    model.addTask( Task( 5, "Support", 1 ) );
+    const CharmDataSnapshot third = model.snapshot();
+    QVERIFY( &third.taskTree() != &second.taskTree() );
+    QCOMPARE( &third.eventForId( changedId ), &second.eventForId( changedId ) );
+    QVERIFY( third.taskExists( 5 ) );
+    QVERIFY( !second.taskExists( 5 ) );
+}
+
+void CharmDataSnapshotTests::testEventsThatStartInTimeFrame()
+{
+    CharmDataModel model;
+    model.setAllTasks( makeTasks() );
+    model.setAllEvents( makeEvents( 600 ) );
+    const CharmDataSnapshot snapshot = model.snapshot();
+
+    const QDate start( 2016, 1, 6 );
+    const QDate end( 2016, 1, 13 );
+    QCOMPARE( snapshot.eventsThatStartInTimeFrame( start, end ),
+              model.eventsThatStartInTimeFrame( start, end ) );
+}
+
+namespace {
+    struct Expectation {
+        CharmDataSnapshot snapshot;
+        int eventCount;
+        qint64 totalSeconds;
+        QString firstTaskName;
+    };
+
+    class SnapshotReader : public QRunnable
+    {
+    public:
+        SnapshotReader( const Expectation& expectation, QAtomicInt* failures )
+            : m_expectation( expectation )
+            , m_failures( failures )
+        {}
+
+        void run() override
+        {
+            const CharmDataSnapshot& snapshot = m_expectation.snapshot;
+            qint64 totalSeconds = 0;
+            int eventCount = 0;
+            Q_FOREACH( const Event& event, snapshot.events() ) {
+                totalSeconds += event.duration();
+                ++eventCount;
+                if ( !snapshot.taskExists( event.taskId() ) )
+                    m_failures->ref();
+            }
+            if ( eventCount != m_expectation.eventCount
+                 || snapshot.eventCount() != m_expectation.eventCount
+                 || totalSeconds != m_expectation.totalSeconds
+                 || snapshot.getTask( 1 ).name() != m_expectation.firstTaskName ) {
+                m_failures->ref();
+            }
+        }
+
+    private:
+        Expectation m_expectation;
+        QAtomicInt* m_failures;
+    };
+
+    qint64 totalSeconds( const CharmDataModel& model )
+    {
+        qint64 total = 0;
+        for ( auto it = model.eventMap().begin(); it != model.eventMap().end(); ++it )
+            total += it->second.duration();
+        return total;
+    }
+}
+
+void CharmDataSnapshotTests::testConcurrentReaders()
+{
+    // the model is modified on this thread, while other threads read snapshots of it.
+    // Build with CHARM_SANITIZE_THREAD to have ThreadSanitizer check this test.
+    CharmDataModel model;
+    model.setAllTasks( makeTasks() );
+    model.setAllEvents( makeEvents( 2000 ) );
+
+    QAtomicInt failures;
+    QThreadPool pool;
+    pool.setMaxThreadCount( 4 );
+    EventId nextId = 2001;
+    const QDateTime start( QDate( 2016, 2, 1 ), QTime( 8, 0 ) );
+
+    for ( int round = 0; round < 200; ++round ) {
+        const Expectation expectation = {
+            model.snapshot(), static_cast<int>( model.eventMap().size() ),
+            totalSeconds( model ), model.getTask( 1 ).name()
+        };
+        pool.start( new SnapshotReader( expectation, &failures ) );
+
+        // keep changing the model while the reader runs:
+        for ( int i = 0; i < 10; ++i ) {
+            const EventId changedId = 1 + ( round * 37 + i * 101 ) % 2000;
+            Event changed = model.eventForId( changedId );
+            if ( changed.isValid() ) {
+                changed.setEndDateTime( changed.endDateTime().addSecs( 60 ) );
+                changed.setComment( QString::number( round ) );
+                model.modifyEvent( changed );
+            }
+            model.addEvent( makeEvent( nextId, nextId % 4 + 1, start.addSecs( nextId * 60 ), 600 ) );
+            ++nextId;
+        }
+        model.deleteEvent( model.eventForId( nextId - 5 ) );
+        model.modifyTask( Task( 1, QString::fromLatin1( "Project %1" ).arg( round ) ) );
+    }
+    pool.waitForDone();
+
+    QCOMPARE( failures.load(), 0 );
+}
+
+QTEST_MAIN( CharmDataSnapshotTests )
+
+#include "moc_CharmDataSnapshotTests.cpp"
@@ -0,0 +1,250 @@
+/*
+  CoreBenchmarks.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "CoreBenchmarks.h"
+#include "BenchmarkData.h"
+
+#include "Core/CharmConstants.h"
+#include "Core/CharmDataModel.h"
+#include "Core/SmartNameCache.h"
+#include "Core/TaskListMerger.h"
+#include "Core/XmlSerialization.h"
+
+#include <QBuffer>
+#include <QDomDocument>
+#include <QtTest/QtTest>
+
+using namespace TimesheetGenerator;
+
+// the database export document, as Controller::exportDatabasetoXml() builds it:
+static QDomDocument makeExportDocument( const TaskList& tasks, const EventList& events )
+{
+    QDomDocument document( QLatin1String( "charmdatabase" ) );
+    QDomElement root = document.createElement( QLatin1String( "charmdatabase" ) );
+    root.setAttribute( QLatin1String( "version" ), CHARM_DATABASE_VERSION );
+    document.appendChild( root );
+    root.appendChild( document.createElement( QLatin1String( "metadata" ) ) );
+    root.appendChild( Task::makeTasksElement( document, tasks ) );
+    QDomElement eventsElement = document.createElement( QLatin1String( "events" ) );
+    Q_FOREACH( const Event& event, events )
+        eventsElement.appendChild( event.toXml( document ) );
+    root.appendChild( eventsElement );
+    return document;
+}
+
+void CoreBenchmarks::benchmarkSetAllTasks_data()
+{
+    BenchmarkData::addSizes();
+}
+
+void CoreBenchmarks::benchmarkSetAllTasks()
+{
+    QFETCH( int, size );
+    const SyntheticData data( BenchmarkData::parameters( BenchmarkData::Size( size ) ) );
+    const TaskList tasks = data.tasks();
+
+    CharmDataModel model;
+    QBENCHMARK {
+        model.setAllTasks( tasks );
+    }
+}
+
+void CoreBenchmarks::benchmarkSetAllEvents_data()
+{
+    BenchmarkData::addSizes();
+}
+
+void CoreBenchmarks::benchmarkSetAllEvents()
+{
+    QFETCH( int, size );
+    const SyntheticData data( BenchmarkData::parameters( BenchmarkData::Size( size ) ) );
+    const EventList events = BenchmarkData::allEvents( data );
+
+    CharmDataModel model;
+    model.setAllTasks( data.tasks() );
+    QBENCHMARK {
+        model.setAllEvents( events );
+    }
+}
+
+void CoreBenchmarks::benchmarkEventsThatStartInTimeFrame_data()
+{
+    BenchmarkData::addSizes();
+}
+
+void CoreBenchmarks::benchmarkEventsThatStartInTimeFrame()
+{
+    QFETCH( int, size );
+    const SyntheticData data( BenchmarkData::parameters( BenchmarkData::Size( size ) ) );
+
+    CharmDataModel model;
+    model.setAllTasks( data.tasks() );
+    model.setAllEvents( BenchmarkData::allEvents( data ) );
+    // the week in the middle of the generated period, as the weekly views ask for it:
+    const QDate middle = data.parameters().startDate.addDays( data.parameters().days / 2 );
+    const QDate monday = middle.addDays( 1 - middle.dayOfWeek() );
+    QBENCHMARK {
+        model.eventsThatStartInTimeFrame( monday, monday.addDays( 7 ) );
+    }
+}
+
+void CoreBenchmarks::benchmarkSmartNameCache_data()
+{
+    BenchmarkData::addSizes();
+}
+
+void CoreBenchmarks::benchmarkSmartNameCache()
+{
+    QFETCH( int, size );
+    const SyntheticData data( BenchmarkData::parameters( BenchmarkData::Size( size ) ) );
+    const TaskList tasks = data.tasks();
+
+    SmartNameCache cache;
+    QBENCHMARK {
+        cache.setAllTasks( tasks );
+    }
+}
+
+void CoreBenchmarks::benchmarkCheckForTreeness_data()
+{
+    BenchmarkData::addSizes();
+}
+
+void CoreBenchmarks::benchmarkCheckForTreeness()
+{
+    QFETCH( int, size );
+    const SyntheticData data( BenchmarkData::parameters( BenchmarkData::Size( size ) ) );
+    const TaskList tasks = data.tasks();
+
+    QBENCHMARK {
+        QVERIFY( Task::checkForTreeness( tasks ) );
+    }
+}
+
+void CoreBenchmarks::benchmarkTaskListMerger_data()
+{
+    BenchmarkData::addSizes();
+}
+
+void CoreBenchmarks::benchmarkTaskListMerger()
+{
+    QFETCH( int, size );
+    const SyntheticData data( BenchmarkData::parameters( BenchmarkData::Size( size ) ) );
+    const TaskList oldTasks = data.tasks();
+
+    // a new task list with every tenth task renamed, and one percent more leaves:
+    TaskList newTasks = oldTasks;
+    TaskId nextId = 0;
+    for ( int i = 0; i < newTasks.size(); ++i ) {
+        nextId = qMax( nextId, newTasks[i].id() + 1 );
+        if ( i % 10 == 0 )
+            newTasks[i].setName( newTasks[i].name() + QLatin1String( " (renamed)" ) );
+    }
+    for ( int i = 0; i < oldTasks.size(); i += 100 ) {
+        Task task( nextId++, QLatin1String( "Added" ), oldTasks[i].id() );
+        task.setTrackable( true );
+        newTasks << task;
+    }
+
+    QBENCHMARK {
+        TaskListMerger merger;
+        merger.setOldTasks( oldTasks );
+        merger.setNewTasks( newTasks );
+        merger.mergedTaskList();
+    }
+}
+
+void CoreBenchmarks::benchmarkXmlExport_data()
+{
+    BenchmarkData::addSizes();
+}
+
+void CoreBenchmarks::benchmarkXmlExport()
+{
+    QFETCH( int, size );
+    const SyntheticData data( BenchmarkData::parameters( BenchmarkData::Size( size ) ) );
+    const TaskList tasks = data.tasks();
+    const EventList events = BenchmarkData::allEvents( data );
+
+    QBENCHMARK {
+        makeExportDocument( tasks, events ).toByteArray( 4 );
+    }
+}
+
+void CoreBenchmarks::benchmarkXmlStreamingExport_data()
+{
+    BenchmarkData::addSizes();
+}
+
+void CoreBenchmarks::benchmarkXmlStreamingExport()
+{
+    QFETCH( int, size );
+    const SyntheticData data( BenchmarkData::parameters( BenchmarkData::Size( size ) ) );
+    const TaskList tasks = data.tasks();
+    const EventList events = BenchmarkData::allEvents( data );
+
+    QBENCHMARK {
+        QBuffer buffer;
+        buffer.open( QIODevice::WriteOnly );
+        XmlReportWriter writer( &buffer );
+        writer.startDocument( QLatin1String( "charmdatabase" ) );
+        writer.attribute( QLatin1String( "version" ), QString::number( CHARM_DATABASE_VERSION ) );
+        writer.startElement( QLatin1String( "metadata" ) );
+        writer.endElement();
+        writer.startElement( Task::taskListTagName() );
+        Q_FOREACH( const Task& task, tasks )
+            task.writeXml( &writer );
+        writer.endElement();
+        writer.startElement( QLatin1String( "events" ) );
+        Q_FOREACH( const Event& event, events )
+            event.writeXml( &writer );
+        writer.finish();
+    }
+}
+
+void CoreBenchmarks::benchmarkXmlImport_data()
+{
+    BenchmarkData::addSizes();
+}
+
+void CoreBenchmarks::benchmarkXmlImport()
+{
+    QFETCH( int, size );
+    const SyntheticData data( BenchmarkData::parameters( BenchmarkData::Size( size ) ) );
+    const QByteArray content = makeExportDocument( data.tasks(), BenchmarkData::allEvents( data ) ).toByteArray( 4 );
+
+    QBENCHMARK {
+        QDomDocument document;
+        QVERIFY( document.setContent( content ) );
+        const QDomElement root = document.documentElement();
+        const TaskList tasks = Task::readTasksElement( root.firstChildElement( Task::taskListTagName() ), CHARM_DATABASE_VERSION );
+        EventList events;
+        const QDomElement eventsElement = root.firstChildElement( QLatin1String( "events" ) );
+        for ( QDomElement element = eventsElement.firstChildElement( Event::tagName() );
+              !element.isNull(); element = element.nextSiblingElement( Event::tagName() ) )
+            events << Event::fromXml( element, CHARM_DATABASE_VERSION );
+        QVERIFY( !tasks.isEmpty() && !events.isEmpty() );
+    }
+}
+
+QTEST_MAIN( CoreBenchmarks )
+
+#include "moc_CoreBenchmarks.cpp"
@@ -0,0 +1,70 @@
+/*
+  EventColumnsTests.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "EventColumnsTests.h"
+#include "TestHelpers.h"
+
+#include "Core/CharmDataModel.h"
+#include "Core/CharmDataSnapshot.h"
+
+#include <QtTest/QtTest>
+
+static const QDate FirstDay( 2016, 1, 4 );
+
+void EventColumnsTests::testSecondsByTask_data()
+{
+    QTest::addColumn<QDate>( "start" );
+    QTest::addColumn<int>( "days" );
+    QTest::addColumn<int>( "bucketDays" );
+    QTest::newRow( "week, by day" ) << FirstDay.addDays( 14 ) << 7 << 1;
+    QTest::newRow( "month, by week" ) << QDate( 2016, 3, 1 ) << 31 << 7;
+    QTest::newRow( "year, by week" ) << FirstDay << 364 << 7;
+    QTest::newRow( "no events" ) << QDate( 2020, 1, 6 ) << 7 << 1;
+}
+
+void EventColumnsTests::testSecondsByTask()
+{
+    QFETCH( QDate, start );
+    QFETCH( int, days );
+    QFETCH( int, bucketDays );
+
+    CharmDataModel model;
+    model.setAllEvents( TestHelpers::makeSpreadEvents( 5000, 40, FirstDay, 365 ) );
+    // a few changes, so that not all blocks are built at once:
+    Event event = model.eventForId( 10 );
+    event.setStartDateTime( QDateTime( start, QTime( 23, 30 ) ) );
+    model.modifyEvent( event );
+    model.deleteEvent( model.eventForId( 300 ) );
+
+    const CharmDataSnapshot snapshot = model.snapshot();
+    const QDate end = start.addDays( days );
+    const QDate monday = start.addDays( 1 - start.dayOfWeek() );
+    const int bucketCount = ( monday.daysTo( end ) + bucketDays - 1 ) / bucketDays;
+    const TaskBucketSeconds expected = TestHelpers::sumPerEvent( snapshot, start, end, bucketDays, bucketCount );
+    const TaskBucketSeconds actual = snapshot.secondsByTask( start, end, monday, bucketDays, bucketCount );
+    QCOMPARE( actual.keys(), expected.keys() );
+    Q_FOREACH( TaskId task, expected.keys() )
+        QCOMPARE( actual.value( task ), expected.value( task ) );
+}
+
+QTEST_MAIN( EventColumnsTests )
+
+#include "moc_EventColumnsTests.cpp"
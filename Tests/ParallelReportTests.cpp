@@ -0,0 +1,142 @@
+/*
+  ParallelReportTests.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ParallelReportTests.h"
+#include "TestHelpers.h"
+
+#include "Charm/Reports/ParallelReport.h"
+#include "Core/CharmDataModel.h"
+
+#include <QtTest/QtTest>
+
+static const QDate FirstDay( 2012, 1, 1 );
+static const int TaskCount = 60;
+
+// ten top level tasks with five subtasks each:
+static TaskList makeTasks()
+{
+    return TestHelpers::makeTaskTree( TaskCount );
+}
+
+static EventList makeEvents( int count, int days )
+{
+    return TestHelpers::makeSpreadEvents( count, TaskCount, FirstDay, days );
+}
+
+// the sequential way, one period after the other:
+static SecondsMap sumPeriodByPeriod( const CharmDataSnapshot& data, const ParallelReport::PeriodList& periods )
+{
+    SecondsMap seconds;
+    for ( int period = 0; period < periods.size(); ++period ) {
+        const TaskBucketSeconds periodSeconds = data.secondsByTask(
+            periods[period].start, periods[period].end, periods[period].start, 1, 1 );
+        for ( auto it = periodSeconds.constBegin(); it != periodSeconds.constEnd(); ++it ) {
+            QVector<int>& values = seconds[it.key()];
+            if ( values.isEmpty() )
+                values.resize( periods.size() );
+            values[period] = it.value().first();
+        }
+    }
+    return seconds;
+}
+
+void ParallelReportTests::testPeriods_data()
+{
+    QTest::addColumn<QDate>( "start" );
+    QTest::addColumn<QDate>( "end" );
+    QTest::addColumn<int>( "type" );
+    QTest::addColumn<int>( "count" );
+    QTest::addColumn<QDate>( "secondStart" );
+    QTest::newRow( "days" ) << QDate( 2016, 2, 27 ) << QDate( 2016, 3, 2 ) << int( Day ) << 4 << QDate( 2016, 2, 28 );
+    QTest::newRow( "weeks of a month" ) << QDate( 2016, 5, 1 ) << QDate( 2016, 6, 1 ) << int( Week ) << 6 << QDate( 2016, 5, 2 );
+    QTest::newRow( "months" ) << QDate( 2016, 1, 15 ) << QDate( 2016, 4, 1 ) << int( Month ) << 3 << QDate( 2016, 2, 1 );
+    QTest::newRow( "years" ) << QDate( 2012, 1, 1 ) << QDate( 2017, 1, 1 ) << int( Year ) << 5 << QDate( 2013, 1, 1 );
+    QTest::newRow( "range" ) << QDate( 2012, 1, 1 ) << QDate( 2017, 1, 1 ) << int( Range ) << 1 << QDate();
+    QTest::newRow( "empty" ) << QDate( 2016, 1, 1 ) << QDate( 2016, 1, 1 ) << int( Month ) << 0 << QDate();
+}
+
+void ParallelReportTests::testPeriods()
+{
+    QFETCH( QDate, start );
+    QFETCH( QDate, end );
+    QFETCH( int, type );
+    QFETCH( int, count );
+    QFETCH( QDate, secondStart );
+
+    const ParallelReport::PeriodList periods = ParallelReport::periods( start, end, static_cast<TimeSpanType>( type ) );
+    QCOMPARE( periods.size(), count );
+    if ( count == 0 )
+        return;
+    QCOMPARE( periods.first().start, start );
+    QCOMPARE( periods.last().end, end );
+    if ( count > 1 )
+        QCOMPARE( periods[1].start, secondStart );
+    for ( int period = 1; period < periods.size(); ++period )
+        QCOMPARE( periods[period].start, periods[period - 1].end );
+}
+
+void ParallelReportTests::testSecondsByPeriod_data()
+{
+    QTest::addColumn<int>( "type" );
+    QTest::addColumn<int>( "threadCount" );
+    QTest::newRow( "weeks, one thread" ) << int( Week ) << 1;
+    QTest::newRow( "weeks, four threads" ) << int( Week ) << 4;
+    QTest::newRow( "months, three threads" ) << int( Month ) << 3;
+    QTest::newRow( "years, all cores" ) << int( Year ) << 0;
+}
+
+void ParallelReportTests::testSecondsByPeriod()
+{
+    QFETCH( int, type );
+    QFETCH( int, threadCount );
+
+    CharmDataModel model;
+    model.setAllTasks( makeTasks() );
+    model.setAllEvents( makeEvents( 20000, 3 * 365 ) );
+    const CharmDataSnapshot snapshot = model.snapshot();
+
+    const ParallelReport::PeriodList periods = ParallelReport::periods(
+        FirstDay.addDays( 10 ), FirstDay.addDays( 3 * 365 - 20 ), static_cast<TimeSpanType>( type ) );
+    const SecondsMap expected = sumPeriodByPeriod( snapshot, periods );
+    const SecondsMap actual = ParallelReport( snapshot, threadCount ).secondsByPeriod( periods );
+    QCOMPARE( actual.keys(), expected.keys() );
+    Q_FOREACH( TaskId task, expected.keys() )
+        QCOMPARE( actual.value( task ), expected.value( task ) );
+}
+
+void ParallelReportTests::testTimeSheet()
+{
+    CharmDataModel model;
+    model.setAllTasks( makeTasks() );
+    model.setAllEvents( makeEvents( 20000, 2 * 365 ) );
+    const CharmDataSnapshot snapshot = model.snapshot();
+
+    const ParallelReport::PeriodList periods = ParallelReport::periods( FirstDay, FirstDay.addYears( 2 ), Month );
+    const TimeSheetInfoList expected = TimeSheetInfo::filteredTaskWithSubTasks(
+        snapshot.taskTree(), periods.size(), 0, sumPeriodByPeriod( snapshot, periods ), true );
+    // the same result on any number of threads:
+    for ( int threadCount = 1; threadCount <= 8; threadCount *= 2 )
+        QCOMPARE( ParallelReport( snapshot, threadCount ).timeSheet( periods, 0, true ), expected );
+}
+
+QTEST_MAIN( ParallelReportTests )
+
+#include "moc_ParallelReportTests.cpp"
@@ -0,0 +1,236 @@
+/*
+  ReportBenchmarks.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ReportBenchmarks.h"
+#include "BenchmarkData.h"
+#include "ReportHtmlData.h"
+#include "TestHelpers.h"
+
+#include "Core/CharmDataModel.h"
+#include "Charm/WeeklySummary.h"
+#include "Charm/Reports/ParallelReport.h"
+#include "Charm/Reports/TimesheetInfo.h"
+
+#include <QtTest/QtTest>
+
+using namespace TimesheetGenerator;
+
+static void fillModel( CharmDataModel* model, const SyntheticData& data )
+{
+    model->setAllTasks( data.tasks() );
+    model->setAllEvents( BenchmarkData::allEvents( data ) );
+}
+
+// the Monday of the week in the middle of the generated period:
+static QDate middleMonday( const SyntheticData& data )
+{
+    const QDate middle = data.parameters().startDate.addDays( data.parameters().days / 2 );
+    return middle.addDays( 1 - middle.dayOfWeek() );
+}
+
+void ReportBenchmarks::benchmarkWeeklySummary_data()
+{
+    BenchmarkData::addSizes();
+}
+
+void ReportBenchmarks::benchmarkWeeklySummary()
+{
+    QFETCH( int, size );
+    const SyntheticData data( BenchmarkData::parameters( BenchmarkData::Size( size ) ) );
+    CharmDataModel model;
+    fillModel( &model, data );
+    const QDate monday = middleMonday( data );
+
+    QBENCHMARK {
+        WeeklySummary::summariesForTimespan( &model, TimeSpan( monday, monday.addDays( 7 ) ) );
+    }
+}
+
+void ReportBenchmarks::benchmarkSecondsByTask_data()
+{
+    BenchmarkData::addSizes();
+    BenchmarkData::addHugeSize();
+}
+
+void ReportBenchmarks::benchmarkSecondsByTask()
+{
+    QFETCH( int, size );
+    const SyntheticData data( BenchmarkData::parameters( BenchmarkData::Size( size ) ) );
+    CharmDataModel model;
+    fillModel( &model, data );
+    const QDate start = data.parameters().startDate;
+    const int weeks = data.parameters().days / 7;
+
+    // the whole period by week, as a report over all the data would aggregate it:
+    QBENCHMARK {
+        model.snapshot().secondsByTask( start, start.addDays( 7 * weeks ), start, 7, weeks );
+    }
+}
+
+void ReportBenchmarks::benchmarkSumPerEvent_data()
+{
+    BenchmarkData::addSizes();
+    BenchmarkData::addHugeSize();
+}
+
+void ReportBenchmarks::benchmarkSumPerEvent()
+{
+    QFETCH( int, size );
+    const SyntheticData data( BenchmarkData::parameters( BenchmarkData::Size( size ) ) );
+    CharmDataModel model;
+    fillModel( &model, data );
+    const QDate start = data.parameters().startDate;
+    const int weeks = data.parameters().days / 7;
+
+    // the same aggregation as benchmarkSecondsByTask, one event at a time:
+    QBENCHMARK {
+        TestHelpers::sumPerEvent( model.snapshot(), start, start.addDays( 7 * weeks ), 7, weeks );
+    }
+}
+
+void ReportBenchmarks::benchmarkTimeSheetInfo_data()
+{
+    BenchmarkData::addSizes();
+}
+
+void ReportBenchmarks::benchmarkTimeSheetInfo()
+{
+    QFETCH( int, size );
+    const SyntheticData data( BenchmarkData::parameters( BenchmarkData::Size( size ) ) );
+    CharmDataModel model;
+    fillModel( &model, data );
+    const QDate monday = middleMonday( data );
+    const SecondsMap secondsMap = model.snapshot().secondsByTask( monday, monday.addDays( 7 ), monday, 1, 7 );
+
+    QBENCHMARK {
+        TimeSheetInfo::filteredTaskWithSubTasks( model.taskTree(), 7, 0, secondsMap, true );
+    }
+}
+
+// task trees of different shapes, for the aggregation of the time sheet rows:
+void ReportBenchmarks::benchmarkRecursiveAggregation_data()
+{
+    QTest::addColumn<int>( "breadth" );
+    QTest::addColumn<int>( "depth" );
+    QTest::newRow( "1k tasks, flat" ) << 1000 << 1;
+    QTest::newRow( "1k tasks, deep" ) << 3 << 6;
+    QTest::newRow( "30k tasks, deep" ) << 4 << 7;
+}
+
+void ReportBenchmarks::benchmarkRecursiveAggregation()
+{
+    QFETCH( int, breadth );
+    QFETCH( int, depth );
+
+    CharmDataModel model;
+    const TaskList tasks = TestHelpers::makeBalancedTaskTree( breadth, depth );
+    model.setAllTasks( tasks );
+    const SecondsMap secondsMap = TestHelpers::makeBucketSeconds( tasks, 7 );
+
+    QBENCHMARK {
+        TimeSheetInfo::filteredTaskWithSubTasks(
+            TimeSheetInfo::taskWithSubTasks( &model, 7, 0, secondsMap ), true );
+    }
+}
+
+void ReportBenchmarks::benchmarkSinglePassAggregation_data()
+{
+    benchmarkRecursiveAggregation_data();
+}
+
+void ReportBenchmarks::benchmarkSinglePassAggregation()
+{
+    QFETCH( int, breadth );
+    QFETCH( int, depth );
+
+    CharmDataModel model;
+    const TaskList tasks = TestHelpers::makeBalancedTaskTree( breadth, depth );
+    model.setAllTasks( tasks );
+    const SecondsMap secondsMap = TestHelpers::makeBucketSeconds( tasks, 7 );
+
+    QBENCHMARK {
+        TimeSheetInfo::filteredTaskWithSubTasks( model.taskTree(), 7, 0, secondsMap, true );
+    }
+}
+
+void ReportBenchmarks::benchmarkSequentialTimeSheet_data()
+{
+    BenchmarkData::addSizes();
+}
+
+void ReportBenchmarks::benchmarkSequentialTimeSheet()
+{
+    QFETCH( int, size );
+    const SyntheticData data( BenchmarkData::parameters( BenchmarkData::Size( size ) ) );
+    CharmDataModel model;
+    fillModel( &model, data );
+    const CharmDataSnapshot snapshot = model.snapshot();
+    const QDate start = data.parameters().startDate;
+    const ParallelReport::PeriodList periods =
+        ParallelReport::periods( start, start.addDays( data.parameters().days ), Week );
+
+    QBENCHMARK {
+        ParallelReport( snapshot, 1 ).timeSheet( periods, 0, false );
+    }
+}
+
+void ReportBenchmarks::benchmarkParallelTimeSheet_data()
+{
+    BenchmarkData::addSizes();
+}
+
+void ReportBenchmarks::benchmarkParallelTimeSheet()
+{
+    QFETCH( int, size );
+    const SyntheticData data( BenchmarkData::parameters( BenchmarkData::Size( size ) ) );
+    CharmDataModel model;
+    fillModel( &model, data );
+    const CharmDataSnapshot snapshot = model.snapshot();
+    const QDate start = data.parameters().startDate;
+    const ParallelReport::PeriodList periods =
+        ParallelReport::periods( start, start.addDays( data.parameters().days ), Week );
+
+    // the same summary as benchmarkSequentialTimeSheet, on all cores:
+    QBENCHMARK {
+        ParallelReport( snapshot ).timeSheet( periods, 0, false );
+    }
+}
+
+// an activity report of ten thousand events, assembled with QDom and with ReportHtmlWriter:
+void ReportBenchmarks::benchmarkDomReport()
+{
+    const QVector<QPair<QString, QString> > rows = ReportHtmlData::makeRows( 10000 );
+    QBENCHMARK {
+        delete ReportHtmlData::createDomReport( rows );
+    }
+}
+
+void ReportBenchmarks::benchmarkWriterReport()
+{
+    const QVector<QPair<QString, QString> > rows = ReportHtmlData::makeRows( 10000 );
+    QBENCHMARK {
+        delete ReportHtmlData::createWriterReport( rows );
+    }
+}
+
+QTEST_MAIN( ReportBenchmarks )
+
+#include "moc_ReportBenchmarks.cpp"
@@ -0,0 +1,167 @@
+/*
+  ReportCacheTests.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ReportCacheTests.h"
+#include "TestHelpers.h"
+
+#include "Core/CharmDataModel.h"
+#include "Charm/Reports/ReportCache.h"
+
+#include <QtTest/QtTest>
+
+using TestHelpers::makeEvent;
+
+// the key of a weekly report for the week starting at @p monday:
+static ReportCache::Key makeKey( const QDate& monday )
+{
+    ReportCache::Key key;
+    key.report = "weekly";
+    key.start = monday;
+    key.end = monday.addDays( 7 );
+    key.rootTasks << 0;
+    return key;
+}
+
+static ReportCache::Result makeResult( const CharmDataModel& model, const QString& text )
+{
+    ReportCache::Result result;
+    result.version = model.version();
+    result.document.reset( new QTextDocument( text ) );
+    return result;
+}
+
+static const QDate Week1( 2016, 1, 4 );
+static const QDate Week2( 2016, 1, 18 );
+
+void ReportCacheTests::testFind()
+{
+    CharmDataModel model;
+    ReportCache cache( &model );
+    const ReportCache::Key key = makeKey( Week1 );
+    QVERIFY( !cache.find( key ).document );
+
+    cache.insert( key, makeResult( model, "week 1" ) );
+    QCOMPARE( cache.size(), 1 );
+    const ReportCache::Result result = cache.find( key );
+    QVERIFY( result.document );
+    QCOMPARE( result.document->toPlainText(), QString( "week 1" ) );
+
+    ReportCache::Key other = key;
+    other.activeTasksOnly = true;
+    QVERIFY( !cache.find( other ).document );
+    other = key;
+    other.options << "someone else";
+    QVERIFY( !cache.find( other ).document );
+}
+
+void ReportCacheTests::testLeastRecentlyUsedIsDropped()
+{
+    CharmDataModel model;
+    ReportCache cache( &model, 2 );
+    cache.insert( makeKey( Week1 ), makeResult( model, "week 1" ) );
+    cache.insert( makeKey( Week2 ), makeResult( model, "week 2" ) );
+    // use week 1, so that week 2 is the least recently used:
+    QVERIFY( cache.find( makeKey( Week1 ) ).document );
+    cache.insert( makeKey( Week2.addDays( 7 ) ), makeResult( model, "week 3" ) );
+
+    QCOMPARE( cache.size(), 2 );
+    QVERIFY( cache.find( makeKey( Week1 ) ).document );
+    QVERIFY( !cache.find( makeKey( Week2 ) ).document );
+    QVERIFY( cache.find( makeKey( Week2.addDays( 7 ) ) ).document );
+}
+
+void ReportCacheTests::testEventChangesInvalidateTheirTimeSpan()
+{
+    CharmDataModel model;
+    model.setAllTasks( TaskList() << Task( 1, "Project" ) );
+    ReportCache cache( &model );
+    cache.insert( makeKey( Week1 ), makeResult( model, "week 1" ) );
+    cache.insert( makeKey( Week2 ), makeResult( model, "week 2" ) );
+
+    // an event in week 1 does not change the report of week 2:
+    Event event = makeEvent( 1, 1, QDateTime( Week1.addDays( 2 ), QTime( 9, 0 ) ) );
+    model.addEvent( event );
+    QVERIFY( !cache.find( makeKey( Week1 ) ).document );
+    QVERIFY( cache.find( makeKey( Week2 ) ).document );
+
+    // moving it to week 2 changes both weeks:
+    cache.insert( makeKey( Week1 ), makeResult( model, "week 1" ) );
+    event.setStartDateTime( QDateTime( Week2.addDays( 1 ), QTime( 9, 0 ) ) );
+    event.setEndDateTime( event.startDateTime().addSecs( 3600 ) );
+    model.modifyEvent( event );
+    QCOMPARE( cache.size(), 0 );
+
+    cache.insert( makeKey( Week1 ), makeResult( model, "week 1" ) );
+    cache.insert( makeKey( Week2 ), makeResult( model, "week 2" ) );
+    model.deleteEvent( event );
+    QVERIFY( cache.find( makeKey( Week1 ) ).document );
+    QVERIFY( !cache.find( makeKey( Week2 ) ).document );
+}
+
+void ReportCacheTests::testTaskChangesInvalidateAll()
+{
+    CharmDataModel model;
+    model.setAllTasks( TaskList() << Task( 1, "Project" ) );
+    ReportCache cache( &model );
+    cache.insert( makeKey( Week1 ), makeResult( model, "week 1" ) );
+    cache.insert( makeKey( Week2 ), makeResult( model, "week 2" ) );
+
+    model.modifyTask( Task( 1, "Renamed Project" ) );
+    QCOMPARE( cache.size(), 0 );
+}
+
+void ReportCacheTests::testOutdatedResultsAreNotCached()
+{
+    CharmDataModel model;
+    model.setAllTasks( TaskList() << Task( 1, "Project" ) );
+    ReportCache cache( &model );
+
+    // the model changes while the report is generated:
+    const ReportCache::Result result = makeResult( model, "week 1" );
+    model.addEvent( makeEvent( 1, 1, QDateTime( Week2, QTime( 9, 0 ) ) ) );
+    cache.insert( makeKey( Week1 ), result );
+    QCOMPARE( cache.size(), 0 );
+}
+
+void ReportCacheTests::testRunningEventsAreNotCached()
+{
+    CharmDataModel model;
+    model.setAllTasks( TaskList() << Task( 1, "Project" ) );
+    ReportCache cache( &model );
+    const Event event = makeEvent( 1, 1, QDateTime( Week1.addDays( 1 ), QTime( 9, 0 ) ) );
+    model.addEvent( event );
+    cache.insert( makeKey( Week1 ), makeResult( model, "week 1" ) );
+    QCOMPARE( cache.size(), 1 );
+
+    // starting the event drops the report that contains it:
+    QVERIFY( model.activateEvent( event ) );
+    QVERIFY( !cache.find( makeKey( Week1 ) ).document );
+
+    // while it runs, its duration grows without a model change:
+    cache.insert( makeKey( Week1 ), makeResult( model, "week 1" ) );
+    QCOMPARE( cache.size(), 0 );
+    cache.insert( makeKey( Week2 ), makeResult( model, "week 2" ) );
+    QCOMPARE( cache.size(), 1 );
+}
+
+QTEST_MAIN( ReportCacheTests )
+
+#include "moc_ReportCacheTests.cpp"
@@ -0,0 +1,87 @@
+/*
+  ReportGeneratorTests.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ReportGeneratorTests.h"
+
+#include "Charm/Reports/ReportGenerator.h"
+
+#include <QSemaphore>
+#include <QtTest/QtTest>
+
+namespace {
+    class TestGenerator : public ReportGenerator
+    {
+    public:
+        TestGenerator( QSemaphore* started, QSemaphore* proceed )
+            : m_started( started )
+            , m_proceed( proceed )
+        {}
+
+    protected:
+        QTextDocument* generate() override
+        {
+            m_started->release();
+            m_proceed->acquire();
+            if ( isCanceled() )
+                return nullptr;
+            auto document = new QTextDocument;
+            document->setPlainText( QLatin1String( "Report" ) );
+            return document;
+        }
+
+    private:
+        QSemaphore* m_started;
+        QSemaphore* m_proceed;
+    };
+}
+
+void ReportGeneratorTests::testDocumentIsHandedToGuiThread()
+{
+    QSemaphore started;
+    QSemaphore proceed( 1 );
+    QFuture<ReportGenerator::DocumentPointer> future =
+        ReportGenerator::start( new TestGenerator( &started, &proceed ) );
+    future.waitForFinished();
+    QVERIFY( !future.isCanceled() );
+    QCOMPARE( future.resultCount(), 1 );
+    const ReportGenerator::DocumentPointer document = future.result();
+    QVERIFY( document );
+    QCOMPARE( document->thread(), QThread::currentThread() );
+    QCOMPARE( document->toPlainText(), QLatin1String( "Report" ) );
+}
+
+void ReportGeneratorTests::testCancel()
+{
+    QSemaphore started;
+    QSemaphore proceed;
+    QFuture<ReportGenerator::DocumentPointer> future =
+        ReportGenerator::start( new TestGenerator( &started, &proceed ) );
+    started.acquire();
+    future.cancel();
+    proceed.release();
+    future.waitForFinished();
+    QVERIFY( future.isCanceled() );
+    QCOMPARE( future.resultCount(), 0 );
+}
+
+QTEST_MAIN( ReportGeneratorTests )
+
+#include "moc_ReportGeneratorTests.cpp"
@@ -0,0 +1,159 @@
+/*
+  ReportHtmlData.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef REPORTHTMLDATA_H
+#define REPORTHTMLDATA_H
+
+#include "Charm/Reports/ReportHtmlWriter.h"
+
+#include <QDomDocument>
+#include <QPair>
+#include <QTextDocument>
+#include <QVector>
+
+/* An activity report built with QDom and with ReportHtmlWriter, for the
+ * tests that compare them and for the benchmarks. */
+namespace ReportHtmlData {
+
+    static const char StyleSheet[] =
+        "tr.header_row { background-color: #444444; color: white; }\n"
+        "td.event_attributes { font-weight: bold; }\n"
+        "td.event_description { padding-left: 20px; }\n";
+
+    // rows of an activity report: the event attributes, and the comment
+    inline QVector<QPair<QString, QString> > makeRows( int count )
+    {
+        QVector<QPair<QString, QString> > rows;
+        rows.reserve( count );
+        for ( int i = 0; i < count; ++i ) {
+            const QString attributes = QString::fromLatin1( "2016-03-%1 09:00-10:30 (01:30) -- [%2] Task <%2> & more" )
+                                       .arg( i % 28 + 1, 2, 10, QLatin1Char( '0' ) )
+                                       .arg( i % 500, 4, 10, QLatin1Char( '0' ) );
+            const QString comment = i % 3 ? QString::fromLatin1( "Comment %1\n  second line" ).arg( i ) : QString();
+            rows.append( qMakePair( attributes, comment ) );
+        }
+        return rows;
+    }
+
+    // the way the reports assembled their documents before ReportHtmlWriter:
+    inline QTextDocument* createDomReport( const QVector<QPair<QString, QString> >& rows )
+    {
+        QDomDocument doc( "html" );
+        QDomElement html = doc.createElement( "html" );
+        html.setAttribute( "xmlns", "http://www.w3.org/1999/xhtml" );
+        doc.appendChild( html );
+        QDomElement head = doc.createElement( "head" );
+        html.appendChild( head );
+        QDomElement body = doc.createElement( "body" );
+        html.appendChild( body );
+
+        QDomElement headline = doc.createElement( "h1" );
+        headline.appendChild( doc.createTextNode( "Activity Report" ) );
+        body.appendChild( headline );
+        QDomElement previousLink = doc.createElement( "a" );
+        previousLink.setAttribute( "href", "Previous" );
+        previousLink.appendChild( doc.createTextNode( "<Previous Week>" ) );
+        body.appendChild( previousLink );
+        body.appendChild( doc.createElement( "br" ) );
+
+        QDomElement table = doc.createElement( "table" );
+        table.setAttribute( "width", "100%" );
+        table.setAttribute( "align", "left" );
+        table.setAttribute( "cellpadding", "3" );
+        table.setAttribute( "cellspacing", "0" );
+        body.appendChild( table );
+        QDomElement tableHead = doc.createElement( "thead" );
+        table.appendChild( tableHead );
+        QDomElement headerRow = doc.createElement( "tr" );
+        headerRow.setAttribute( "class", "header_row" );
+        tableHead.appendChild( headerRow );
+        QDomElement header = doc.createElement( "th" );
+        header.appendChild( doc.createTextNode( "Date and Time, Task, Description" ) );
+        headerRow.appendChild( header );
+        QDomElement emptyHeader = doc.createElement( "th" );
+        emptyHeader.appendChild( doc.createTextNode( QString() ) );
+        headerRow.appendChild( emptyHeader );
+        QDomElement tableBody = doc.createElement( "tbody" );
+        table.appendChild( tableBody );
+        for ( int i = 0; i < rows.size(); ++i ) {
+            QDomElement row1 = doc.createElement( "tr" );
+            row1.setAttribute( "class", "event_attributes_row" );
+            QDomElement cell = doc.createElement( "td" );
+            cell.setAttribute( "class", "event_attributes" );
+            cell.appendChild( doc.createTextNode( rows[i].first ) );
+            row1.appendChild( cell );
+            QDomElement row2 = doc.createElement( "tr" );
+            QDomElement cell2 = doc.createElement( "td" );
+            cell2.setAttribute( "class", "event_description" );
+            cell2.setAttribute( "align", "left" );
+            QDomElement preElement = doc.createElement( "pre" );
+            preElement.appendChild( doc.createTextNode( rows[i].second ) );
+            cell2.appendChild( preElement );
+            row2.appendChild( cell2 );
+            tableBody.appendChild( row1 );
+            tableBody.appendChild( row2 );
+        }
+
+        auto report = new QTextDocument;
+        report->setDefaultStyleSheet( StyleSheet );
+        report->setHtml( doc.toString() );
+        return report;
+    }
+
+    inline QTextDocument* createWriterReport( const QVector<QPair<QString, QString> >& rows )
+    {
+        ReportHtmlWriter writer;
+        writer.textElement( "h1", "Activity Report" );
+        writer.link( "Previous", "<Previous Week>" );
+        writer.emptyElement( "br" );
+
+        writer.startTable();
+        writer.startElement( "thead" );
+        writer.startElement( "tr" );
+        writer.attribute( "class", "header_row" );
+        writer.textElement( "th", "Date and Time, Task, Description" );
+        writer.textElement( "th", QString() );
+        writer.endElement();
+        writer.endElement();
+        writer.startElement( "tbody" );
+        for ( int i = 0; i < rows.size(); ++i ) {
+            writer.startElement( "tr" );
+            writer.attribute( "class", "event_attributes_row" );
+            writer.startElement( "td" );
+            writer.attribute( "class", "event_attributes" );
+            writer.text( rows[i].first );
+            writer.endElement();
+            writer.endElement();
+            writer.startElement( "tr" );
+            writer.startElement( "td" );
+            writer.attribute( "class", "event_description" );
+            writer.attribute( "align", "left" );
+            writer.textElement( "pre", rows[i].second );
+            writer.endElement();
+            writer.endElement();
+        }
+
+        return writer.createDocument( StyleSheet );
+    }
+
+}
+
+#endif
@@ -0,0 +1,52 @@
+/*
+  ReportHtmlWriterTests.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ReportHtmlWriterTests.h"
+#include "ReportHtmlData.h"
+
+#include <QScopedPointer>
+#include <QtTest/QtTest>
+
+using namespace ReportHtmlData;
+
+void ReportHtmlWriterTests::testMatchesDomReport_data()
+{
+    QTest::addColumn<int>( "rowCount" );
+    QTest::newRow( "no rows" ) << 0;
+    QTest::newRow( "some rows" ) << 10;
+}
+
+void ReportHtmlWriterTests::testMatchesDomReport()
+{
+    QFETCH( int, rowCount );
+    const QVector<QPair<QString, QString> > rows = makeRows( rowCount );
+
+    QScopedPointer<QTextDocument> expected( createDomReport( rows ) );
+    QScopedPointer<QTextDocument> actual( createWriterReport( rows ) );
+    QCOMPARE( actual->toPlainText(), expected->toPlainText() );
+    QCOMPARE( actual->blockCount(), expected->blockCount() );
+    // the formatting the text document derived from both is the same, too:
+    QCOMPARE( actual->toHtml(), expected->toHtml() );
+}
+
+QTEST_MAIN( ReportHtmlWriterTests )
+
+#include "moc_ReportHtmlWriterTests.cpp"
@@ -27,6 +27,7 @@
 #include "Core/CharmConstants.h"
 #include "Core/Installation.h"
 #include "Core/SqLiteStorage.h"
+#include "Core/SqlQueryStatistics.h"
 
 #include <QDir>
 #include <QFileInfo>
@@ -344,6 +345,42 @@ void SqLiteStorageTests::setGetMetaDataTest()
     QVERIFY( m_storage->getMetaData( Key2 ) == Value2 );
 }
 
+void SqLiteStorageTests::queryStatisticsTest()
+{
+    SqlQueryStatistics& statistics = SqlQueryStatistics::instance();
+    const int threshold = statistics.slowQueryThreshold();
+
+    // percentiles are the upper bounds of power of two buckets:
+    statistics.reset();
+    for ( int microseconds = 1; microseconds <= 100; ++microseconds )
+        statistics.record( QLatin1String( "statement" ), microseconds, 1, microseconds != 100 );
+    QList<SqlStatementStatistics> statements = statistics.statements();
+    QCOMPARE( statements.size(), 1 );
+    QCOMPARE( statements.first().count, quint64( 100 ) );
+    QCOMPARE( statements.first().failures, quint64( 1 ) );
+    QCOMPARE( statements.first().rows, qint64( 100 ) );
+    QCOMPARE( statements.first().percentile( 50 ), qint64( 64 ) );
+    QCOMPARE( statements.first().percentile( 99 ), qint64( 100 ) );
+
+    // queries run by the storage are recorded, and logged if they are slow:
+    statistics.reset();
+    statistics.setSlowQueryThreshold( 0 );
+    const int eventCount = m_storage->getAllEvents().size();
+    m_storage->getAllEvents();
+    statements = statistics.statements();
+    QCOMPARE( statements.size(), 1 );
+    QCOMPARE( statements.first().count, quint64( 2 ) );
+    QCOMPARE( statements.first().failures, quint64( 0 ) );
+    // SQLite cannot size a result, the rows are counted while they are read:
+    QCOMPARE( statements.first().rowsReported, quint64( 2 ) );
+    QCOMPARE( statements.first().rows, qint64( 2 * eventCount ) );
+    QCOMPARE( statistics.slowQueries().size(), 2 );
+    QVERIFY( statistics.report().contains( statements.first().statement ) );
+
+    statistics.setSlowQueryThreshold( threshold );
+    statistics.reset();
+}
+
 void SqLiteStorageTests::cleanupTestCase ()
 {
     m_storage->disconnect();
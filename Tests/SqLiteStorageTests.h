@@ -60,6 +60,8 @@ private slots:
 
     void deleteTaskWithEventsTest();
 
+    void queryStatisticsTest();
+
     void cleanupTestCase();
 };
 
@@ -0,0 +1,163 @@
+/*
+  StorageBenchmarks.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "StorageBenchmarks.h"
+#include "BenchmarkData.h"
+
+#include "Core/CharmConstants.h"
+#include "Core/SqLiteStorage.h"
+#include "Core/SqlRaiiTransactor.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QtTest/QtTest>
+
+using namespace TimesheetGenerator;
+
+// the number of events modified one by one, each in its own transaction, like the UI does:
+static const int SingleModifications = 100;
+
+StorageBenchmarks::StorageBenchmarks()
+    : QObject()
+    , m_storage( new SqLiteStorage )
+    , m_localPath( "./StorageBenchmarksDatabase.db" )
+{
+}
+
+StorageBenchmarks::~StorageBenchmarks()
+{
+    delete m_storage;
+}
+
+void StorageBenchmarks::initTestCase()
+{
+    QFileInfo file( m_localPath );
+    if ( file.exists() ) {
+        QDir dir( file.absoluteDir() );
+        QVERIFY( dir.remove( file.fileName() ) );
+    }
+
+    m_configuration.installationId = 1;
+    m_configuration.user.setId( 1 );
+    m_configuration.localStorageType = CHARM_SQLITE_BACKEND_DESCRIPTOR;
+    m_configuration.localStorageDatabase = m_localPath;
+    m_configuration.newDatabase = true;
+    QVERIFY( m_storage->connect( m_configuration ) );
+}
+
+void StorageBenchmarks::cleanupTestCase()
+{
+    QVERIFY( m_storage->disconnect() );
+    QFileInfo file( m_localPath );
+    QDir dir( file.absoluteDir() );
+    QVERIFY( dir.remove( file.fileName() ) );
+}
+
+void StorageBenchmarks::benchmarkSetAllTasksAndEvents_data()
+{
+    BenchmarkData::addSizes();
+}
+
+void StorageBenchmarks::benchmarkSetAllTasksAndEvents()
+{
+    QFETCH( int, size );
+    const SyntheticData data( BenchmarkData::parameters( BenchmarkData::Size( size ) ) );
+    const TaskList tasks = data.tasks();
+    const EventList events = BenchmarkData::allEvents( data );
+
+    QBENCHMARK {
+        QCOMPARE( m_storage->setAllTasksAndEvents( m_configuration.user, tasks, events ), QString() );
+    }
+}
+
+void StorageBenchmarks::benchmarkGetAllEvents_data()
+{
+    BenchmarkData::addSizes();
+}
+
+void StorageBenchmarks::benchmarkGetAllEvents()
+{
+    QFETCH( int, size );
+    const SyntheticData data( BenchmarkData::parameters( BenchmarkData::Size( size ) ) );
+    const EventList events = BenchmarkData::allEvents( data );
+    QCOMPARE( m_storage->setAllTasksAndEvents( m_configuration.user, data.tasks(), events ), QString() );
+
+    QBENCHMARK {
+        QCOMPARE( m_storage->getAllEvents().size(), events.size() );
+    }
+}
+
+void StorageBenchmarks::benchmarkMakeModifyDeleteEvents_data()
+{
+    BenchmarkData::addSizes();
+}
+
+void StorageBenchmarks::benchmarkMakeModifyDeleteEvents()
+{
+    QFETCH( int, size );
+    const SyntheticData data( BenchmarkData::parameters( BenchmarkData::Size( size ) ) );
+    QCOMPARE( m_storage->setAllTasksAndEvents( m_configuration.user, data.tasks(), EventList() ), QString() );
+    const EventList events = data.events( 1 );
+
+    // add the events of one user as an import does, then delete them again:
+    QBENCHMARK {
+        SqlRaiiTransactor transactor( m_storage->database() );
+        EventList added;
+        Q_FOREACH( const Event& event, events ) {
+            Event newEvent = m_storage->makeEvent( transactor );
+            const EventId id = newEvent.id();
+            newEvent = event;
+            newEvent.setId( id );
+            QVERIFY( m_storage->modifyEvent( newEvent, transactor ) );
+            added << newEvent;
+        }
+        Q_FOREACH( const Event& event, added )
+            QVERIFY( m_storage->deleteEvent( event ) );
+        QVERIFY( transactor.commit() );
+    }
+}
+
+void StorageBenchmarks::benchmarkModifyEvents_data()
+{
+    BenchmarkData::addSizes();
+}
+
+void StorageBenchmarks::benchmarkModifyEvents()
+{
+    QFETCH( int, size );
+    const SyntheticData data( BenchmarkData::parameters( BenchmarkData::Size( size ) ) );
+    QCOMPARE( m_storage->setAllTasksAndEvents( m_configuration.user, data.tasks(), BenchmarkData::allEvents( data ) ), QString() );
+    EventList events = m_storage->getAllEvents();
+    events = events.mid( 0, SingleModifications );
+
+    int round = 0;
+    QBENCHMARK {
+        ++round;
+        for ( int i = 0; i < events.size(); ++i ) {
+            events[i].setComment( QString::fromLatin1( "Modified %1" ).arg( round ) );
+            QVERIFY( m_storage->modifyEvent( events[i] ) );
+        }
+    }
+}
+
+QTEST_MAIN( StorageBenchmarks )
+
+#include "moc_StorageBenchmarks.cpp"
@@ -0,0 +1,173 @@
+/*
+  SyntheticDataTests.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SyntheticDataTests.h"
+
+#include "Core/Configuration.h"
+#include "Core/SqLiteStorage.h"
+#include "Tools/TimesheetGenerator/SyntheticData.h"
+#include "Tools/TimesheetGenerator/SyntheticOutput.h"
+
+#include <QDir>
+#include <QDomDocument>
+#include <QFile>
+#include <QtTest/QtTest>
+
+using namespace TimesheetGenerator;
+
+// three users over four weeks, two of them are tracking time at a fixed "now" in the third week:
+static SyntheticData::Parameters makeParameters()
+{
+    SyntheticData::Parameters parameters;
+    parameters.taskDepth = 3;
+    parameters.taskBreadth = 4;
+    parameters.users = 3;
+    parameters.days = 28;
+    parameters.activeEvents = 2;
+    parameters.now = QDateTime( parameters.startDate.addDays( 16 ), QTime( 11, 30 ), Qt::UTC );
+    return parameters;
+}
+
+static int countEndingAt( const EventList& events, const QDateTime& end )
+{
+    int count = 0;
+    Q_FOREACH( const Event& event, events ) {
+        if ( event.endDateTime() == end )
+            ++count;
+    }
+    return count;
+}
+
+// the events in all XML files of @p paths:
+static EventList readXmlEvents( const QStringList& paths )
+{
+    EventList events;
+    Q_FOREACH( const QString& path, paths ) {
+        QFile file( path );
+        if ( !file.open( QIODevice::ReadOnly ) )
+            return EventList();
+        QDomDocument document;
+        if ( !document.setContent( &file ) )
+            return EventList();
+        const QDomNodeList elements = document.elementsByTagName( Event::tagName() );
+        for ( int i = 0; i < elements.count(); ++i )
+            events << Event::fromXml( elements.at( i ).toElement() );
+    }
+    return events;
+}
+
+void SyntheticDataTests::testDeterministic()
+{
+    const SyntheticData first( makeParameters() );
+    const SyntheticData second( makeParameters() );
+    QCOMPARE( first.tasks().size(), second.tasks().size() );
+    for ( int userId = 1; userId <= 3; ++userId ) {
+        const EventList events = first.events( userId );
+        QVERIFY( !events.isEmpty() );
+        QVERIFY( events == second.events( userId ) );
+    }
+}
+
+void SyntheticDataTests::testRunningEvents()
+{
+    const SyntheticData::Parameters parameters = makeParameters();
+    const SyntheticData data( parameters );
+    const EventIdList activeIds = data.activeEventIds();
+    QCOMPARE( activeIds.size(), 2 );
+
+    for ( int userId = 1; userId <= 2; ++userId ) {
+        const EventList events = data.events( userId );
+        const Event& running = events.last();
+        QCOMPARE( running.id(), activeIds.at( userId - 1 ) );
+        QCOMPARE( running.endDateTime(), parameters.now );
+        QVERIFY( running.startDateTime() < parameters.now );
+        QVERIFY( running.startDateTime().secsTo( parameters.now ) <= 3 * 3600 );
+        // nothing was recorded after the running event started:
+        for ( int i = 0; i < events.size() - 1; ++i ) {
+            QVERIFY( events[i].startDateTime() < running.startDateTime() );
+            QVERIFY( events[i].endDateTime() <= running.startDateTime() );
+            QVERIFY( events[i].id() != running.id() );
+        }
+    }
+
+    // the third user does not track time, its events cover the whole period:
+    const EventList events = data.events( 3 );
+    QVERIFY( !activeIds.contains( events.last().id() ) );
+    QCOMPARE( countEndingAt( events, parameters.now ), 0 );
+    QVERIFY( events.last().startDateTime() > parameters.now );
+}
+
+void SyntheticDataTests::testOutputsStoreRunningEvents()
+{
+    const SyntheticData::Parameters parameters = makeParameters();
+    const SyntheticData data( parameters );
+    int eventCount = 0;
+    for ( int userId = 1; userId <= parameters.users; ++userId )
+        eventCount += data.events( userId ).size();
+
+    const QString directoryName = QString::fromLatin1( "SyntheticDataTests-%1" ).arg( QCoreApplication::applicationPid() );
+    QVERIFY( QDir::temp().mkpath( directoryName ) );
+    QDir directory( QDir::temp().absoluteFilePath( directoryName ) );
+
+    // the database export:
+    const QString exportFile = directory.absoluteFilePath( "export.charmdatabase" );
+    writeDatabaseExport( data, exportFile );
+    const EventList exported = readXmlEvents( QStringList() << exportFile );
+    QCOMPARE( exported.size(), eventCount );
+    QCOMPARE( countEndingAt( exported, parameters.now ), 2 );
+
+    // the time sheets:
+    QVERIFY( directory.mkdir( "reports" ) );
+    QDir reports( directory.absoluteFilePath( "reports" ) );
+    QVERIFY( writeTimesheets( data, reports.path() ) > 0 );
+    QStringList reportFiles;
+    Q_FOREACH( const QString& file, reports.entryList( QDir::Files ) )
+        reportFiles << reports.absoluteFilePath( file );
+    const EventList reported = readXmlEvents( reportFiles );
+    QCOMPARE( reported.size(), eventCount );
+    QCOMPARE( countEndingAt( reported, parameters.now ), 2 );
+
+    // the SQLite database, which stores the events under new ids:
+    const QString databaseFile = directory.absoluteFilePath( "charm.db" );
+    writeDatabase( data, databaseFile );
+    Configuration& configuration = Configuration::instance();
+    configuration.newDatabase = false;
+    EventList stored;
+    {
+        SqLiteStorage storage;
+        QVERIFY( storage.connect( configuration ) );
+        stored = storage.getAllEvents();
+        storage.disconnect();
+    }
+    QCOMPARE( stored.size(), eventCount );
+    QCOMPARE( countEndingAt( stored, parameters.now ), 2 );
+
+    Q_FOREACH( const QString& file, reportFiles )
+        QFile::remove( file );
+    directory.rmdir( "reports" );
+    QFile::remove( exportFile );
+    QFile::remove( databaseFile );
+    QDir::temp().rmdir( directoryName );
+}
+
+QTEST_MAIN( SyntheticDataTests )
+
+#include "moc_SyntheticDataTests.cpp"
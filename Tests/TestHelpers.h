@@ -24,7 +24,9 @@
 #ifndef TESTHELPERS_H
 #define TESTHELPERS_H
 
+#include "Core/CharmDataSnapshot.h"
 #include "Core/CharmExceptions.h"
+#include "Core/Event.h"
 
 #include <QDebug>
 #include <QDir>
@@ -82,6 +84,99 @@ namespace TestHelpers {
         return ( text == "true" );
     }
 
+    /** An event of @p seconds on the task @p taskId, starting at @p start. */
+    inline Event makeEvent( EventId id, TaskId taskId, const QDateTime& start, int seconds = 3600 )
+    {
+        Event event;
+        event.setId( id );
+        event.setInstallationId( 1 );
+        event.setTaskId( taskId );
+        event.setStartDateTime( start );
+        event.setEndDateTime( start.addSecs( seconds ) );
+        return event;
+    }
+
+    /** @p count events with the ids 1 to @p count, on the tasks 1 to @p taskCount.
+     * They are spread over the @p days days from @p firstDay at irregular times,
+     * and last up to two hours. */
+    inline EventList makeSpreadEvents( int count, int taskCount, const QDate& firstDay, int days )
+    {
+        const QDateTime start( firstDay, QTime( 0, 0 ) );
+        EventList events;
+        events.reserve( count );
+        for ( int i = 1; i <= count; ++i ) {
+            const QDateTime eventStart = start.addSecs( qint64( i ) * 7919 % ( qint64( days ) * 86400 ) );
+            events << makeEvent( i, i * 7 % taskCount + 1, eventStart, i * 13 % 7200 );
+        }
+        return events;
+    }
+
+    /** A tree of @p count tasks named after their ids: ten top level tasks,
+     * and the other tasks spread evenly below them. */
+    inline TaskList makeTaskTree( int count )
+    {
+        TaskList tasks;
+        for ( int id = 1; id <= count; ++id ) {
+            Task task;
+            task.setId( id );
+            task.setName( QString::number( id ) );
+            task.setParent( id <= 10 ? 0 : ( id - 1 ) % 10 + 1 );
+            tasks << task;
+        }
+        return tasks;
+    }
+
+    /** Appends @p breadth subtasks of @p parent to @p tasks, and as many below each of them,
+     * down to @p depth levels. */
+    inline void addSubTasks( TaskList& tasks, TaskId parent, int breadth, int depth )
+    {
+        if ( depth == 0 )
+            return;
+        for ( int i = 0; i < breadth; ++i ) {
+            const TaskId id = tasks.size() + 1;
+            tasks << Task( id, QString::fromLatin1( "Task %1" ).arg( id ), parent );
+            addSubTasks( tasks, id, breadth, depth - 1 );
+        }
+    }
+
+    /** A tree with the same @p breadth at every level, down to @p depth levels. */
+    inline TaskList makeBalancedTaskTree( int breadth, int depth )
+    {
+        TaskList tasks;
+        addSubTasks( tasks, 0, breadth, depth );
+        return tasks;
+    }
+
+    /** Time booked on every third of @p tasks, with different values per bucket. */
+    inline TaskBucketSeconds makeBucketSeconds( const TaskList& tasks, int bucketCount )
+    {
+        TaskBucketSeconds seconds;
+        for ( int i = 0; i < tasks.size(); i += 3 ) {
+            QVector<int> values( bucketCount );
+            for ( int bucket = 0; bucket < bucketCount; ++bucket )
+                values[bucket] = ( i + bucket ) % 5 * 900;
+            seconds.insert( tasks[i].id(), values );
+        }
+        return seconds;
+    }
+
+    /** The seconds per task and bucket of the events that start from @p start to @p end,
+     * summed one event at a time, the way the reports did before the event columns. */
+    inline TaskBucketSeconds sumPerEvent( const CharmDataSnapshot& data, const QDate& start, const QDate& end,
+                                          int bucketDays, int bucketCount )
+    {
+        const QDate monday = start.addDays( 1 - start.dayOfWeek() );
+        TaskBucketSeconds seconds;
+        Q_FOREACH( EventId id, data.eventsThatStartInTimeFrame( start, end ) ) {
+            const Event& event = data.eventForId( id );
+            QVector<int>& values = seconds[event.taskId()];
+            if ( values.isEmpty() )
+                values.resize( bucketCount );
+            values[monday.daysTo( event.startDateTime().date() ) / bucketDays] += event.duration();
+        }
+        return seconds;
+    }
+
 }
 
 #endif
@@ -0,0 +1,72 @@
+/*
+  TimeSheetInfoTests.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "TimeSheetInfoTests.h"
+#include "TestHelpers.h"
+
+#include "Core/CharmDataModel.h"
+#include "Charm/Reports/TimesheetInfo.h"
+
+#include <QtTest/QtTest>
+
+void TimeSheetInfoTests::testAggregation_data()
+{
+    QTest::addColumn<int>( "root" );
+    QTest::addColumn<bool>( "activeTasksOnly" );
+    QTest::newRow( "all tasks" ) << 0 << false;
+    QTest::newRow( "all active tasks" ) << 0 << true;
+    QTest::newRow( "subtree" ) << 2 << false;
+    QTest::newRow( "active subtree" ) << 2 << true;
+    QTest::newRow( "leaf" ) << 4 << false;
+}
+
+void TimeSheetInfoTests::testAggregation()
+{
+    QFETCH( int, root );
+    QFETCH( bool, activeTasksOnly );
+
+    const int segments = 7;
+    CharmDataModel model;
+    const TaskList tasks = TestHelpers::makeBalancedTaskTree( 3, 4 );
+    model.setAllTasks( tasks );
+    // tasks added later are appended to their parents, the report still sorts them by id:
+    model.addTask( Task( 1000, "Late Task", 2 ) );
+    model.addTask( Task( 999, "Later Task", 2 ) );
+    SecondsMap secondsMap = TestHelpers::makeBucketSeconds( tasks, segments );
+    secondsMap.insert( 999, QVector<int>( segments, 60 ) );
+
+    const TimeSheetInfoList expected = TimeSheetInfo::filteredTaskWithSubTasks(
+        TimeSheetInfo::taskWithSubTasks( &model, segments, root, secondsMap ), activeTasksOnly );
+    const TimeSheetInfoList actual = TimeSheetInfo::filteredTaskWithSubTasks(
+        model.taskTree(), segments, root, secondsMap, activeTasksOnly );
+
+    QCOMPARE( actual.size(), expected.size() );
+    for ( int i = 0; i < actual.size(); ++i ) {
+        QCOMPARE( actual[i].taskId, expected[i].taskId );
+        QCOMPARE( actual[i].indentation, expected[i].indentation );
+        QCOMPARE( actual[i].seconds, expected[i].seconds );
+        QVERIFY( actual[i] == expected[i] );
+    }
+}
+
+QTEST_MAIN( TimeSheetInfoTests )
+
+#include "moc_TimeSheetInfoTests.cpp"
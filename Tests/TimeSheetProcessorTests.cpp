@@ -29,6 +29,7 @@
 
 #include "Tools/TimesheetProcessor/Operations.h"
 #include "Tools/TimesheetProcessor/CommandLine.h"
+#include "Tools/TimesheetProcessor/Daemon.h"
 #include "Core/MySqlStorage.h"
 #include <QDebug>
 
@@ -95,6 +96,189 @@ void TimeSheetProcessorTests::testAddRemoveTimeSheet()
     QVERIFY( !queryRemove.next() ); // not retrievable since it was deleted, must return false
 }
 
+void TimeSheetProcessorTests::testParseJob()
+{
+    const TimesheetDaemon::Job job = TimesheetDaemon::parseJob( "1", "43\t/tmp/report.charmreport\tweek 12 corrected" );
+    QCOMPARE( job.id, QString( "1" ) );
+    QCOMPARE( job.userid, 43 );
+    QCOMPARE( job.filename, QString( "/tmp/report.charmreport" ) );
+    QCOMPARE( job.userComment, QString( "week 12 corrected" ) );
+
+    const TimesheetDaemon::Job noComment = TimesheetDaemon::parseJob( "2", "43\treport.charmreport" );
+    QCOMPARE( noComment.filename, QString( "report.charmreport" ) );
+    QVERIFY( noComment.userComment.isEmpty() );
+
+    bool thrown = false;
+    try {
+        TimesheetDaemon::parseJob( "3", "report.charmreport" );
+    } catch ( const TimesheetProcessorException& ) {
+        thrown = true;
+    }
+    QVERIFY( thrown );
+
+    thrown = false;
+    try {
+        TimesheetDaemon::parseJob( "4", "0\treport.charmreport" );
+    } catch ( const TimesheetProcessorException& ) {
+        thrown = true;
+    }
+    QVERIFY( thrown );
+}
+
+void TimeSheetProcessorTests::testDaemonSpool()
+{
+    // GIVEN
+    const QString spoolName = QString( "TimeSheetProcessorTests-%1" ).arg( QCoreApplication::applicationPid() );
+    QVERIFY( QDir::temp().mkpath( spoolName ) );
+    QDir spoolDir( QDir::temp().absoluteFilePath( spoolName ) );
+    const QString reportFile = spoolDir.absoluteFilePath( "report.charmreport" );
+    QVERIFY( QFile::copy( m_reportPath, reportFile ) );
+    QFile jobFile( spoolDir.absoluteFilePath( "upload-1.job" ) );
+    QVERIFY( jobFile.open( QIODevice::WriteOnly ) );
+    jobFile.write( QString( "%1\treport.charmreport\tdaemon test\n" ).arg( m_adminId ).toLocal8Bit() );
+    jobFile.close();
+
+    // WHEN
+    TimesheetDaemon daemon( MySqlStorage::parseParameterEnvironmentVariable(), 2 );
+    QCOMPARE( daemon.processSpoolDirectory( spoolDir.path() ), 1 );
+
+    // THEN
+    QVERIFY( !spoolDir.exists( "upload-1.job" ) );
+    QVERIFY( spoolDir.entryList( QStringList() << "upload-1.job.processing*" ).isEmpty() );
+    QFile resultFile( spoolDir.absoluteFilePath( "upload-1.result" ) );
+    QVERIFY( resultFile.open( QIODevice::ReadOnly ) );
+    const QString result = QString::fromLocal8Bit( resultFile.readAll() );
+    QVERIFY2( result.contains( "Report added" ), qPrintable( result ) );
+    QRegExp indexLine( "index:(\\d+)" );
+    QVERIFY( indexLine.indexIn( result ) != -1 );
+    const int index = indexLine.cap( 1 ).toInt();
+    QVERIFY( index > 0 );
+
+    // nothing left to do in the spool directory
+    QCOMPARE( daemon.processSpoolDirectory( spoolDir.path() ), 0 );
+
+    CommandLine cmdRemove( m_adminId, index );
+    removeTimesheet( cmdRemove );
+
+    resultFile.remove();
+    QFile::remove( reportFile );
+    QDir::temp().rmdir( spoolName );
+}
+
+void TimeSheetProcessorTests::testRecoverClaimedJobs()
+{
+    // GIVEN
+    const QString spoolName = QString( "TimeSheetProcessorTests-recover-%1" ).arg( QCoreApplication::applicationPid() );
+    QVERIFY( QDir::temp().mkpath( spoolName ) );
+    QDir spoolDir( QDir::temp().absoluteFilePath( spoolName ) );
+    // claimed by an earlier process with the pid of this one, so that process is gone:
+    const QString staleSuffix = ".job.processing." + TimesheetDaemon::claimOwner();
+    const QStringList files = QStringList() << "upload-1" + staleSuffix
+                                            << "upload-2" + staleSuffix << "upload-2.result"
+                                            << "upload-3.job.processing.otherhost.example.com-1";
+    Q_FOREACH( const QString& file, files ) {
+        QFile claimedFile( spoolDir.absoluteFilePath( file ) );
+        QVERIFY( claimedFile.open( QIODevice::WriteOnly ) );
+    }
+
+    // WHEN
+    TimesheetDaemon daemon( MySqlStorage::parseParameterEnvironmentVariable() );
+    QCOMPARE( daemon.recoverClaimedJobs( spoolDir.path() ), 1 );
+
+    // THEN
+    // the unfinished job is pending again:
+    QVERIFY( spoolDir.exists( "upload-1.job" ) );
+    QVERIFY( !spoolDir.exists( "upload-1" + staleSuffix ) );
+    // the finished job keeps its result and is not run again:
+    QVERIFY( !spoolDir.exists( "upload-2.job" ) );
+    QVERIFY( !spoolDir.exists( "upload-2" + staleSuffix ) );
+    QVERIFY( spoolDir.exists( "upload-2.result" ) );
+    // the job of another host is left to its daemon:
+    QVERIFY( spoolDir.exists( "upload-3.job.processing.otherhost.example.com-1" ) );
+
+    Q_FOREACH( const QString& file, spoolDir.entryList( QDir::Files ) ) {
+        spoolDir.remove( file );
+    }
+    QDir::temp().rmdir( spoolName );
+}
+
+void TimeSheetProcessorTests::testExportTotals()
+{
+    // GIVEN
+    addTimesheet( CommandLine( m_reportPath, m_adminId ) );
+    MySqlStorage::Parameters parameters = MySqlStorage::parseParameterEnvironmentVariable();
+    MySqlStorage storage;
+    storage.configure( parameters );
+    QVERIFY( storage.database().open() );
+    QSqlQuery query( storage.database() );
+    query.prepare( "SELECT MAX(id) from timesheets where filename=:file AND userid=:user" );
+    query.bindValue( "file", m_reportPath );
+    query.bindValue( "user", m_adminId );
+    QVERIFY( storage.runQuery( query ) );
+    QVERIFY( query.next() );
+    const int index = query.value( 0 ).toInt();
+    QVERIFY( index > 0 );
+
+    // WHEN
+    const QString csvFilename = QDir::temp().absoluteFilePath(
+        QString( "TimeSheetProcessorTests-%1.csv" ).arg( QCoreApplication::applicationPid() ) );
+    exportTotals( CommandLine( csvFilename, QDate( 2014, 12, 29 ), QDate( 2015, 1, 4 ), CommandLine::Period_Week ) );
+
+    // THEN
+    QFile csv( csvFilename );
+    QVERIFY( csv.open( QIODevice::ReadOnly ) );
+    const QStringList lines = QString::fromUtf8( csv.readAll() ).split( '\n', QString::SkipEmptyParts );
+    QVERIFY( !lines.isEmpty() );
+    QCOMPARE( lines.first(), QString( "user_id,user,task,task_name,period,seconds" ) );
+    const QString prefix = QString( "%1," ).arg( m_adminId );
+    bool found = false;
+    Q_FOREACH( const QString& line, lines ) {
+        if ( line.startsWith( prefix ) && line.contains( ",9997," ) ) {
+            QVERIFY2( line.contains( ",2015-W01," ), qPrintable( line ) );
+            QVERIFY( line.section( ',', -1 ).toInt() >= 8 * 3600 );
+            found = true;
+        }
+    }
+    QVERIFY( found );
+
+    csv.remove();
+    removeTimesheet( CommandLine( m_adminId, index ) );
+}
+
+void TimeSheetProcessorTests::testReplaceTimeSheet()
+{
+    // GIVEN
+    MySqlStorage::Parameters parameters = MySqlStorage::parseParameterEnvironmentVariable();
+    MySqlStorage storage;
+    storage.configure( parameters );
+    QVERIFY( storage.database().open() );
+    CommandLine cmdReplace( m_reportPath, m_adminId, "replaced" );
+
+    // WHEN replacing twice
+    replaceTimesheet( cmdReplace );
+    replaceTimesheet( cmdReplace );
+
+    // THEN there is one time sheet for the week, with the events of one upload
+    QSqlQuery query( storage.database() );
+    query.prepare( "SELECT id, total from timesheets where userid=:user AND year=2015 AND week=1" );
+    query.bindValue( "user", m_adminId );
+    QVERIFY( storage.runQuery( query ) );
+    QVERIFY( query.next() );
+    const int index = query.value( 0 ).toInt();
+    QCOMPARE( query.value( 1 ).toInt(), 8 * 3600 );
+    QVERIFY( !query.next() );
+
+    QSqlQuery events( storage.database() );
+    events.prepare( "SELECT COUNT(*) from Events where report_id=:index AND user_id=:user" );
+    events.bindValue( "index", index );
+    events.bindValue( "user", m_adminId );
+    QVERIFY( storage.runQuery( events ) );
+    QVERIFY( events.next() );
+    QCOMPARE( events.value( 0 ).toInt(), 1 );
+
+    removeTimesheet( CommandLine( m_adminId, index ) );
+}
+
 QTEST_MAIN( TimeSheetProcessorTests)
 
 #include "moc_TimeSheetProcessorTests.cpp"
@@ -35,6 +35,11 @@ public:
 
 private slots:
     void testAddRemoveTimeSheet();
+    void testParseJob();
+    void testDaemonSpool();
+    void testRecoverClaimedJobs();
+    void testExportTotals();
+    void testReplaceTimeSheet();
 
 private:
     int m_idTimeSheet;
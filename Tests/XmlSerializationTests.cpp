@@ -30,7 +30,9 @@
 #include "Core/Event.h"
 #include "Core/XmlSerialization.h"
 
+#include <QBuffer>
 #include <QDateTime>
+#include <QRegExp>
 #include <QtDebug>
 #include <QtTest/QtTest>
 
@@ -188,6 +190,132 @@ void XmlSerializationTests::testTaskExportImport()
     QVERIFY( importer.exportTime().isValid() );
 }
 
+void XmlSerializationTests::testTaskExportWriter()
+{
+    TaskList tasks = tasksToTest();
+    tasks.pop_front();
+    const QDateTime changedSince( QDate( 2016, 2, 29 ), QTime( 12, 30 ), Qt::UTC );
+
+    QByteArray data;
+    QBuffer buffer( &data );
+    buffer.open( QIODevice::WriteOnly );
+    TaskExportWriter writer( &buffer, changedSince );
+    Q_FOREACH( const Task& task, tasks )
+        writer.writeTask( task );
+    writer.writeDeletedTask( 4711 );
+    writer.writeDeletedTask( 4712 );
+    writer.finish();
+    buffer.close();
+
+    // clients that only read complete catalogues do not accept the delta:
+    QVERIFY( data.contains( "type=\"" + TaskExport::deltaReportType().toLatin1() + '"' ) );
+
+    buffer.open( QIODevice::ReadOnly );
+    TaskExport importer;
+    importer.readFrom( &buffer );
+    QCOMPARE( importer.tasks(), tasks );
+    QVERIFY( importer.exportTime().isValid() );
+    QCOMPARE( importer.changedSince(), changedSince );
+    QVERIFY( importer.isDelta() );
+    QCOMPARE( importer.deletedTasks(), TaskIdList() << 4711 << 4712 );
+
+    // a complete export is not a delta:
+    QByteArray complete;
+    QBuffer completeBuffer( &complete );
+    completeBuffer.open( QIODevice::WriteOnly );
+    TaskExportWriter completeWriter( &completeBuffer );
+    completeWriter.finish();
+    completeBuffer.close();
+    completeBuffer.open( QIODevice::ReadOnly );
+    TaskExport completeImporter;
+    completeImporter.readFrom( &completeBuffer );
+    QVERIFY( completeImporter.tasks().isEmpty() );
+    QVERIFY( !completeImporter.changedSince().isValid() );
+    QVERIFY( !completeImporter.isDelta() );
+    QVERIFY( completeImporter.deletedTasks().isEmpty() );
+}
+
+// QDomDocument orders the attributes of an element by hash, so compare them
+// sorted; the creation times differ by the time between writing the reports:
+static QString normalizedReport( const QByteArray& xml )
+{
+    QString text = QString::fromUtf8( xml );
+    text.replace( QRegExp( "<creation-time>[^<]*</creation-time>" ), "<creation-time/>" );
+    QRegExp tag( "<([\\w-]+)((?: [\\w-]+=\"[^\"]*\")+)" );
+    QRegExp attribute( " [\\w-]+=\"[^\"]*\"" );
+    int pos = 0;
+    while ( ( pos = tag.indexIn( text, pos ) ) != -1 ) {
+        const QString attributes = tag.cap( 2 );
+        QStringList sorted;
+        int attributePos = 0;
+        while ( ( attributePos = attribute.indexIn( attributes, attributePos ) ) != -1 ) {
+            sorted << attribute.cap( 0 );
+            attributePos += attribute.matchedLength();
+        }
+        sorted.sort();
+        const QString normalizedTag = QLatin1Char( '<' ) + tag.cap( 1 ) + sorted.join( QString() );
+        text.replace( pos, tag.matchedLength(), normalizedTag );
+        pos += normalizedTag.length();
+    }
+    return text;
+}
+
+void XmlSerializationTests::testReportWriterMatchesDom()
+{
+    TaskList tasks = tasksToTest();
+    tasks[1].setName( "Markup <&> \"quoted\" ]]> and\r\nlines" );
+    EventList events;
+    Event event;
+    event.setId( 7 );
+    event.setTaskId( 42 );
+    event.setComment( "one > two & \"three\"\r\n" );
+    event.setStartDateTime( QDateTime( QDate( 2016, 3, 1 ), QTime( 0, 0 ), Qt::UTC ) );
+    event.setEndDateTime( QDateTime( QDate( 2016, 3, 1 ), QTime( 2, 30 ), Qt::UTC ) );
+    events << Event() << event;
+
+    // the DOM, like the timesheets used to build it:
+    QDomDocument document = XmlSerialization::createXmlTemplate( "weekly-timesheet" );
+    QDomElement metadata = XmlSerialization::metadataElement( document );
+    QDomElement serialNumber = document.createElement( "serial-number" );
+    serialNumber.setAttribute( "semantics", "week-number" );
+    serialNumber.appendChild( document.createTextNode( "9" ) );
+    metadata.appendChild( serialNumber );
+    QDomElement report = XmlSerialization::reportElement( document );
+    QDomElement tasksElement = document.createElement( "tasks" );
+    report.appendChild( tasksElement );
+    Q_FOREACH( const Task& task, tasks )
+        tasksElement.appendChild( task.toXml( document ) );
+    QDomElement effort = document.createElement( "effort" );
+    report.appendChild( effort );
+    Q_FOREACH( const Event& e, events )
+        effort.appendChild( e.toXml( document ) );
+    report.appendChild( document.createElement( "empty" ) );
+
+    // the same report, streamed:
+    QByteArray streamed;
+    QBuffer buffer( &streamed );
+    buffer.open( QIODevice::WriteOnly );
+    XmlReportWriter writer( &buffer, "weekly-timesheet" );
+    writer.startElement( "serial-number" );
+    writer.attribute( "semantics", "week-number" );
+    writer.text( "9" );
+    writer.endElement();
+    writer.startReport();
+    writer.startElement( "tasks" );
+    Q_FOREACH( const Task& task, tasks )
+        task.writeXml( &writer );
+    writer.endElement();
+    writer.startElement( "effort" );
+    Q_FOREACH( const Event& e, events )
+        e.writeXml( &writer );
+    writer.endElement();
+    writer.startElement( "empty" );
+    writer.endElement();
+    writer.finish();
+
+    QCOMPARE( normalizedReport( streamed ), normalizedReport( document.toByteArray( 4 ) ) );
+}
+
 QTEST_MAIN( XmlSerializationTests )
 
 #include "moc_XmlSerializationTests.cpp"
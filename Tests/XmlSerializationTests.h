@@ -41,6 +41,8 @@ private slots:
     void testTaskListSerialization();
     void testQDateTimeToFromString();
     void testTaskExportImport();
+    void testTaskExportWriter();
+    void testReportWriterMatchesDom();
 
 private:
     TaskList tasksToTest() const;
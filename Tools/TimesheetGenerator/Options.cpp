@@ -27,6 +27,7 @@
 
 #include <QObject>
 #include <QFile>
+#include <QStringList>
 
 extern "C" {
 #include <getopt.h>
@@ -37,11 +38,27 @@ extern "C" {
 
 using namespace TimesheetGenerator;
 
+namespace {
+    int intArgument( char option, int minimum )
+    {
+        const QString text = QString::fromLocal8Bit( optarg );
+        bool ok;
+        const int value = text.toInt( &ok );
+        if ( !ok || value < minimum ) {
+            throw UsageException( QObject::tr( "Option -%1 requires a number of at least %2, not \"%3\"" )
+                                  .arg( QLatin1Char( option ) ).arg( minimum ).arg( text ) );
+        }
+        return value;
+    }
+}
+
 Options::Options( int argc, char** argv )
+    : mMode( Mode_Template )
 {
+    bool dateSet = false;
     opterr = 0;
     int ch;
-    while ((ch = getopt(argc, argv, "vhf:d:")) != -1)
+    while ((ch = getopt(argc, argv, "vhf:d:g:o:s:t:u:n:e:c:l:a:")) != -1)
     {
         if (ch == '?')
         {
@@ -52,6 +69,14 @@ Options::Options( int argc, char** argv )
                 throw UsageException(QObject::tr( "Option -f requires a filename argument" ) );
             } else if ( option == 'd' ) {
                 throw UsageException(QObject::tr( "Option -d requires a date argument (e.g. 2009-01-01)" ) );
+            } else if ( option == 'g' ) {
+                throw UsageException(QObject::tr( "Option -g requires a format argument (sqlite, xml or reports)" ) );
+            } else if ( option == 'o' ) {
+                throw UsageException(QObject::tr( "Option -o requires a filename or directory argument" ) );
+            } else if ( option == 't' ) {
+                throw UsageException(QObject::tr( "Option -t requires a depth:breadth argument (e.g. 4:12)" ) );
+            } else if ( QByteArray( "sunecla" ).contains( option ) ) {
+                throw UsageException(QObject::tr( "Option -%1 requires a number argument" ).arg( QLatin1Char( option ) ) );
             } else {
                 int code = static_cast<int> ( option );
                 throw UsageException(QObject::tr("Unknown character %1").arg( code ) );
@@ -68,11 +93,69 @@ Options::Options( int argc, char** argv )
             QDate date = QDate::fromString( text, "yyyy-MM-dd" );
             if ( date.isValid() ) {
                 mDate = date;
+                dateSet = true;
             } else {
                 throw UsageException(QObject::tr("Cannot parse date \"%1\"").arg( text ) );
             }
             break;
         }
+        case 'g': {
+            const QString format = QString::fromLocal8Bit( optarg );
+            if ( format == QLatin1String( "sqlite" ) ) {
+                mMode = Mode_SqLite;
+            } else if ( format == QLatin1String( "xml" ) ) {
+                mMode = Mode_DatabaseExport;
+            } else if ( format == QLatin1String( "reports" ) ) {
+                mMode = Mode_Timesheets;
+            } else {
+                throw UsageException( QObject::tr( "Unknown output format \"%1\", use sqlite, xml or reports" ).arg( format ) );
+            }
+            break;
+        }
+        case 'o':
+            mOutput = QString::fromLocal8Bit( optarg );
+            break;
+        case 's': {
+            const QString text = QString::fromLocal8Bit( optarg );
+            bool ok;
+            mParameters.seed = text.toULongLong( &ok );
+            if ( !ok ) {
+                throw UsageException( QObject::tr( "Cannot parse seed \"%1\"" ).arg( text ) );
+            }
+            break;
+        }
+        case 't': {
+            const QString text = QString::fromLocal8Bit( optarg );
+            const QStringList parts = text.split( QLatin1Char( ':' ) );
+            bool depthOk = false;
+            bool breadthOk = false;
+            if ( parts.size() == 2 ) {
+                mParameters.taskDepth = parts[0].toInt( &depthOk );
+                mParameters.taskBreadth = parts[1].toInt( &breadthOk );
+            }
+            if ( !depthOk || !breadthOk || mParameters.taskDepth < 1 || mParameters.taskBreadth < 1 ) {
+                throw UsageException( QObject::tr( "Cannot parse task tree shape \"%1\", expected depth:breadth" ).arg( text ) );
+            }
+            break;
+        }
+        case 'u':
+            mParameters.users = intArgument( 'u', 1 );
+            break;
+        case 'n':
+            mParameters.days = intArgument( 'n', 1 );
+            break;
+        case 'e':
+            mParameters.eventsPerDay = intArgument( 'e', 1 );
+            break;
+        case 'c':
+            mParameters.commentLength = intArgument( 'c', 1 );
+            break;
+        case 'l':
+            mParameters.overlapPercent = intArgument( 'l', 0 );
+            break;
+        case 'a':
+            mParameters.activeEvents = intArgument( 'a', 0 );
+            break;
         case 'h':
             throw UsageException();
         case 'v':
@@ -84,6 +167,22 @@ Options::Options( int argc, char** argv )
         }
     }
 
+    if ( mMode != Mode_Template ) {
+        if ( mOutput.isEmpty() ) {
+            throw UsageException( QObject::tr( "No output specified (-o), aborting." ) );
+        }
+        if ( mParameters.overlapPercent > 100 ) {
+            throw UsageException( QObject::tr( "The overlap (-l) is a percentage, aborting." ) );
+        }
+        if ( mParameters.activeEvents > mParameters.users ) {
+            throw UsageException( QObject::tr( "There can be at most one active event per user (-a), aborting." ) );
+        }
+        if ( dateSet ) {
+            mParameters.startDate = mDate;
+        }
+        return;
+    }
+
     if ( mFile.isEmpty() ) {
         throw UsageException(QObject::tr( "No filename specified (-f), aborting." ) );
     }
@@ -98,6 +197,11 @@ Options::Options( int argc, char** argv )
     }
 }
 
+Options::Mode Options::mode() const
+{
+    return mMode;
+}
+
 QString Options::file() const
 {
     return mFile;
@@ -107,3 +211,13 @@ QDate Options::date() const
 {
     return mDate;
 }
+
+QString Options::output() const
+{
+    return mOutput;
+}
+
+SyntheticData::Parameters Options::parameters() const
+{
+    return mParameters;
+}
@@ -27,18 +27,33 @@
 #include <QString>
 #include <QDate>
 
+#include "SyntheticData.h"
+
 namespace TimesheetGenerator {
 
     class Options {
     public:
+        enum Mode {
+            Mode_Template, // time sheets from a template file (-f)
+            Mode_SqLite, // a synthetic SQLite database (-g sqlite)
+            Mode_DatabaseExport, // a synthetic database export (-g xml)
+            Mode_Timesheets // synthetic weekly time sheets (-g reports)
+        };
+
         explicit Options( int argc, char** argv );
 
+        Mode mode() const;
         QString file() const;
         QDate date() const;
+        QString output() const;
+        SyntheticData::Parameters parameters() const;
 
     private:
+        Mode mMode;
         QString mFile;
         QDate mDate;
+        QString mOutput;
+        SyntheticData::Parameters mParameters;
     };
 
 }
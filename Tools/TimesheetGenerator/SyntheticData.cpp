@@ -0,0 +1,273 @@
+/*
+  SyntheticData.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SyntheticData.h"
+
+#include <QDateTime>
+
+using namespace TimesheetGenerator;
+
+namespace {
+    static const TaskId FirstTaskId = 1000;
+    // chance that a leaf task expires during the generated period:
+    static const int ExpiredTaskPercent = 5;
+    static const int EmptyCommentPercent = 40;
+    static const int MaximumCommentLength = 255;
+    // every user works on a handful of tasks, one of them changes every few weeks:
+    static const int MinimumPortfolio = 5;
+    static const int MaximumPortfolio = 15;
+    static const int PortfolioRotationDays = 21;
+    static const int WorkMinutesPerDay = 8 * 60;
+    static const int EarliestStartMinute = 7 * 60;
+    static const int LatestEndMinute = 22 * 60;
+    static const int MaximumGapMinutes = 20;
+    // tries to find a task that has not expired before an event is skipped:
+    static const int TaskRetries = 10;
+    // a running event started this many minutes before its last checkpoint:
+    static const int MinimumRunningMinutes = 5;
+    static const int MaximumRunningMinutes = 3 * 60;
+
+    static const char* const Words[] = {
+        "review", "meeting", "fix", "build", "customer", "release", "planning", "design",
+        "test", "support", "refactoring", "documentation", "call", "travel", "workshop",
+        "training", "deployment", "bug", "feature", "analysis", "estimate", "merge"
+    };
+    static const int WordCount = sizeof Words / sizeof Words[0];
+}
+
+Random::Random( quint64 seed )
+    : mState( seed )
+{
+}
+
+quint32 Random::next()
+{
+    mState += Q_UINT64_C( 0x9E3779B97F4A7C15 );
+    quint64 z = mState;
+    z = ( z ^ ( z >> 30 ) ) * Q_UINT64_C( 0xBF58476D1CE4E5B9 );
+    z = ( z ^ ( z >> 27 ) ) * Q_UINT64_C( 0x94D049BB133111EB );
+    z = z ^ ( z >> 31 );
+    return static_cast<quint32>( z >> 32 );
+}
+
+int Random::bounded( int bound )
+{
+    Q_ASSERT( bound > 0 );
+    return static_cast<int>( ( quint64( next() ) * quint64( bound ) ) >> 32 );
+}
+
+int Random::between( int low, int high )
+{
+    Q_ASSERT( low <= high );
+    return low + bounded( high - low + 1 );
+}
+
+bool Random::percent( int chance )
+{
+    return bounded( 100 ) < chance;
+}
+
+SyntheticData::Parameters::Parameters()
+    : seed( 1 )
+    , taskDepth( 4 )
+    , taskBreadth( 12 )
+    , users( 10 )
+    , startDate( 2015, 1, 5 )
+    , days( 2 * 365 )
+    , eventsPerDay( 6 )
+    , commentLength( 30 )
+    , overlapPercent( 2 )
+    , activeEvents( 1 )
+    , now( QDateTime::currentDateTimeUtc() )
+{
+    now.setTime( QTime( now.time().hour(), now.time().minute(), now.time().second() ) );
+}
+
+SyntheticData::SyntheticData( const Parameters& parameters )
+    : mParameters( parameters )
+{
+    Q_ASSERT( mParameters.taskDepth > 0 && mParameters.taskBreadth > 0 );
+    Q_ASSERT( mParameters.users > 0 && mParameters.days > 0 && mParameters.eventsPerDay > 0 );
+    Q_ASSERT( mParameters.commentLength > 0 );
+
+    Random random( mParameters.seed );
+    TaskId nextId = FirstTaskId;
+    QVector<int> level( 1, -1 ); // the indexes of the parents of the next level, -1 is the root
+    for ( int depth = 1; depth <= mParameters.taskDepth; ++depth ) {
+        const bool leaves = depth == mParameters.taskDepth;
+        QVector<int> nextLevel;
+        Q_FOREACH( int parentIndex, level ) {
+            const int children = random.between( 1, 2 * mParameters.taskBreadth - 1 );
+            for ( int child = 1; child <= children; ++child ) {
+                Task task;
+                task.setId( nextId++ );
+                task.setParent( parentIndex < 0 ? 0 : mTasks.at( parentIndex ).id() );
+                const QString word = QString::fromLatin1( Words[random.bounded( WordCount )] );
+                task.setName( QString::fromLatin1( "%1%2 %3" ).arg( word.left( 1 ).toUpper(), word.mid( 1 ) ).arg( child ) );
+                task.setTrackable( leaves );
+                if ( leaves && random.percent( ExpiredTaskPercent ) ) {
+                    const QDate expiry = mParameters.startDate.addDays( random.bounded( mParameters.days ) );
+                    task.setValidUntil( QDateTime( expiry, QTime( 0, 0 ), Qt::UTC ) );
+                }
+                mTasks << task;
+                nextLevel << mTasks.size() - 1;
+                if ( leaves )
+                    mLeaves << mTasks.size() - 1;
+            }
+        }
+        level = nextLevel;
+    }
+}
+
+const SyntheticData::Parameters& SyntheticData::parameters() const
+{
+    return mParameters;
+}
+
+TaskList SyntheticData::tasks() const
+{
+    return mTasks;
+}
+
+EventList SyntheticData::events( int userId ) const
+{
+    Q_ASSERT( userId >= 1 && userId <= mParameters.users );
+    Random random( mParameters.seed ^ ( quint64( userId ) * Q_UINT64_C( 0xD6E8FEB86659FD93 ) ) );
+
+    QVector<int> portfolio( random.between( MinimumPortfolio, MaximumPortfolio ) );
+    for ( int i = 0; i < portfolio.size(); ++i )
+        portfolio[i] = mLeaves.at( random.bounded( mLeaves.size() ) );
+
+    const int maximumPerDay = 2 * mParameters.eventsPerDay - 1;
+    // leave room for the most events every user could have, to keep the ids unique:
+    EventId nextId = ( userId - 1 ) * ( mParameters.days * maximumPerDay + 1 ) + 1;
+    EventList events;
+
+    // the running event comes from its own numbers, the other events do not change with the time:
+    Event running;
+    if ( userId <= mParameters.activeEvents ) {
+        Random runningRandom( mParameters.seed ^ ( quint64( userId ) * Q_UINT64_C( 0x9FB21C651E98DF25 ) ) );
+        const QDateTime start = mParameters.now.addSecs(
+            -60 * runningRandom.between( MinimumRunningMinutes, MaximumRunningMinutes ) );
+        for ( int retry = 0; retry < TaskRetries && !running.isValid(); ++retry ) {
+            const Task& task = mTasks.at( portfolio[runningRandom.bounded( portfolio.size() )] );
+            if ( !isValidOn( task, start.date() ) )
+                continue;
+            running.setId( runningEventId( userId ) );
+            running.setInstallationId( 1 );
+            running.setUserId( userId );
+            running.setTaskId( task.id() );
+            running.setComment( comment( runningRandom ) );
+            running.setStartDateTime( start );
+            running.setEndDateTime( mParameters.now );
+        }
+    }
+
+    for ( int day = 0; day < mParameters.days; ++day ) {
+        const QDate date = mParameters.startDate.addDays( day );
+        if ( day % PortfolioRotationDays == PortfolioRotationDays - 1 )
+            portfolio[random.bounded( portfolio.size() )] = mLeaves.at( random.bounded( mLeaves.size() ) );
+        if ( date.dayOfWeek() > 5 )
+            continue;
+
+        const QDateTime midnight( date, QTime( 0, 0 ), Qt::UTC );
+        const int count = random.between( 1, maximumPerDay );
+        const int averageDuration = WorkMinutesPerDay / count;
+        int minute = EarliestStartMinute + random.bounded( 2 * 60 );
+        int previousDuration = 0;
+        for ( int i = 0; i < count && minute < LatestEndMinute; ++i ) {
+            const int duration = random.between( qMax( 5, averageDuration / 2 ), qMax( 5, averageDuration * 3 / 2 ) );
+            int start = minute;
+            if ( i > 0 && random.percent( mParameters.overlapPercent ) )
+                start -= random.between( 1, qMax( 1, previousDuration / 2 ) );
+
+            int slot = random.bounded( portfolio.size() );
+            for ( int retry = 0; retry < TaskRetries && !isValidOn( mTasks.at( portfolio[slot] ), date ); ++retry )
+                portfolio[slot] = mLeaves.at( random.bounded( mLeaves.size() ) );
+            const Task& task = mTasks.at( portfolio[slot] );
+
+            const QString text = comment( random );
+            const QDateTime startTime = midnight.addSecs( start * 60 + random.bounded( 60 ) );
+            minute = start + duration + random.bounded( MaximumGapMinutes );
+            previousDuration = duration;
+            if ( !isValidOn( task, date ) )
+                continue;
+            // nothing was recorded after the running event started:
+            if ( running.isValid() && startTime >= running.startDateTime() )
+                break;
+
+            Event event;
+            event.setId( nextId++ );
+            event.setInstallationId( 1 );
+            event.setUserId( userId );
+            event.setTaskId( task.id() );
+            event.setComment( text );
+            event.setStartDateTime( startTime );
+            event.setEndDateTime( startTime.addSecs( duration * 60 ) );
+            // starting the running event stopped the one before:
+            if ( running.isValid() && event.endDateTime() > running.startDateTime() )
+                event.setEndDateTime( running.startDateTime() );
+            events << event;
+        }
+    }
+    if ( running.isValid() )
+        events << running;
+    return events;
+}
+
+EventIdList SyntheticData::activeEventIds() const
+{
+    EventIdList ids;
+    const int users = qMin( mParameters.activeEvents, mParameters.users );
+    for ( int userId = 1; userId <= users; ++userId ) {
+        const EventList userEvents = events( userId );
+        if ( !userEvents.isEmpty() && userEvents.last().id() == runningEventId( userId ) )
+            ids << userEvents.last().id();
+    }
+    return ids;
+}
+
+EventId SyntheticData::runningEventId( int userId ) const
+{
+    const int maximumPerDay = 2 * mParameters.eventsPerDay - 1;
+    return userId * ( mParameters.days * maximumPerDay + 1 );
+}
+
+QString SyntheticData::comment( Random& random ) const
+{
+    if ( random.percent( EmptyCommentPercent ) )
+        return QString();
+    // the sum of two uniform numbers, most comments are close to the average length:
+    const int length = qMin( MaximumCommentLength,
+                             random.between( 1, mParameters.commentLength ) + random.between( 0, mParameters.commentLength ) );
+    QString text;
+    while ( text.length() < length ) {
+        if ( !text.isEmpty() )
+            text += QLatin1Char( ' ' );
+        text += QLatin1String( Words[random.bounded( WordCount )] );
+    }
+    return text.left( length );
+}
+
+bool SyntheticData::isValidOn( const Task& task, const QDate& date ) const
+{
+    return !task.validUntil().isValid() || date < task.validUntil().date();
+}
@@ -0,0 +1,113 @@
+/*
+  SyntheticData.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SYNTHETICDATA_H
+#define SYNTHETICDATA_H
+
+#include <QDate>
+#include <QDateTime>
+#include <QString>
+#include <QVector>
+
+#include "Core/Event.h"
+#include "Core/Task.h"
+
+namespace TimesheetGenerator {
+
+    /** A small pseudo random number generator (splitmix64) that produces
+        the same numbers for a seed on every platform, unlike qrand(). It
+        only uses integer arithmetic for the same reason. */
+    class Random {
+    public:
+        explicit Random( quint64 seed );
+
+        quint32 next();
+        /** A number in [0, bound). */
+        int bounded( int bound );
+        /** A number in [low, high]. */
+        int between( int low, int high );
+        bool percent( int chance );
+
+    private:
+        quint64 mState;
+    };
+
+    /** SyntheticData generates a task tree and the events of many users
+        for load tests and benchmarks. The same parameters always produce
+        the same data. The events of each user are generated from their
+        own seed, so users can be generated one at a time. */
+    class SyntheticData {
+    public:
+        struct Parameters {
+            Parameters();
+            quint64 seed;
+            /** Levels of the task tree, and the average number of children per task. */
+            int taskDepth;
+            int taskBreadth;
+            int users;
+            QDate startDate;
+            int days;
+            /** Average number of events per user and work day. */
+            int eventsPerDay;
+            /** Average length of the comments that are not empty. */
+            int commentLength;
+            /** Chance in percent that an event starts before the previous one ended. */
+            int overlapPercent;
+            /** Number of users whose last event is still running. */
+            int activeEvents;
+            /** The time of the last checkpoint of the running events, the
+                current time in whole seconds by default. */
+            QDateTime now;
+        };
+
+        explicit SyntheticData( const Parameters& parameters );
+
+        const Parameters& parameters() const;
+
+        /** The task tree, parents before their children. Only leaves are
+            trackable, some of them expire during the generated period. */
+        TaskList tasks() const;
+
+        /** The events of user @p userId, 1 to parameters().users, ordered by start.
+            Event ids are unique over all users. The last event of each of the
+            first activeEvents users is running: it started shortly before
+            parameters().now and ends there, as Charm stores a running event at
+            its last checkpoint. Their events that would start later are left out. */
+        EventList events( int userId ) const;
+
+        /** The ids of the running events, as returned by events(). writeDatabase
+            stores the events under new ids. */
+        EventIdList activeEventIds() const;
+
+    private:
+        QString comment( Random& random ) const;
+        bool isValidOn( const Task& task, const QDate& date ) const;
+        /** The id of the running event of @p userId, the last of its id range. */
+        EventId runningEventId( int userId ) const;
+
+        Parameters mParameters;
+        TaskList mTasks;
+        QVector<int> mLeaves; // indexes into mTasks
+    };
+
+}
+
+#endif
@@ -0,0 +1,169 @@
+/*
+  SyntheticOutput.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SyntheticOutput.h"
+#include "SyntheticData.h"
+#include "Exceptions.h"
+
+#include "Core/CharmConstants.h"
+#include "Core/CharmExceptions.h"
+#include "Core/Configuration.h"
+#include "Core/SqLiteStorage.h"
+#include "Core/SqlRaiiTransactor.h"
+#include "Core/XmlSerialization.h"
+
+#include <QDir>
+#include <QFile>
+#include <QObject>
+
+namespace {
+    void openNewFile( QFile* file )
+    {
+        if ( file->exists() ) {
+            throw TimesheetGenerator::Exception( QObject::tr( "File %1 exists, not overwriting it." ).arg( file->fileName() ) );
+        }
+        if ( !file->open( QIODevice::WriteOnly ) ) {
+            throw TimesheetGenerator::Exception( QObject::tr( "Error writing file %1: %2" ).arg( file->fileName(), file->errorString() ) );
+        }
+    }
+
+    void writeTimesheet( const QString& filename, int year, int week, const EventList& events )
+    {
+        QFile file( filename );
+        openNewFile( &file );
+        XmlReportWriter writer( &file, QLatin1String( "weekly-timesheet" ) );
+        writer.textElement( QLatin1String( "year" ), QString::number( year ) );
+        writer.startElement( QLatin1String( "serial-number" ) );
+        writer.attribute( QLatin1String( "semantics" ), QLatin1String( "week-number" ) );
+        writer.text( QString::number( week ) );
+        writer.endElement();
+        writer.startReport();
+        writer.startElement( QLatin1String( "effort" ) );
+        Q_FOREACH( const Event& event, events )
+            event.writeXml( &writer );
+        writer.finish();
+    }
+}
+
+void TimesheetGenerator::writeDatabase( const SyntheticData& data, const QString& filename )
+{
+    if ( QFile::exists( filename ) ) {
+        throw Exception( QObject::tr( "File %1 exists, not overwriting it." ).arg( filename ) );
+    }
+    Configuration& configuration = Configuration::instance();
+    configuration.installationId = 1;
+    configuration.user.setId( 1 );
+    configuration.user.setName( QLatin1String( "synthetic" ) );
+    configuration.localStorageType = CHARM_SQLITE_BACKEND_DESCRIPTOR;
+    configuration.localStorageDatabase = filename;
+    configuration.newDatabase = true;
+
+    SqLiteStorage storage;
+    if ( !storage.connect( configuration ) ) {
+        throw Exception( QObject::tr( "Cannot create database %1: %2" ).arg( filename, configuration.failureMessage ) );
+    }
+    const QString error = storage.setAllTasksAndEvents( configuration.user, data.tasks(), EventList() );
+    if ( !error.isEmpty() ) {
+        throw Exception( error );
+    }
+    // one transaction per user, the database assigns new event ids:
+    for ( int userId = 1; userId <= data.parameters().users; ++userId ) {
+        SqlRaiiTransactor transactor( storage.database() );
+        Q_FOREACH( const Event& event, data.events( userId ) ) {
+            Event stored = storage.makeEvent( transactor );
+            const EventId id = stored.id();
+            stored = event;
+            stored.setId( id );
+            if ( !storage.modifyEvent( stored, transactor ) ) {
+                throw Exception( QObject::tr( "Error adding event to database %1." ).arg( filename ) );
+            }
+        }
+        if ( !transactor.commit() ) {
+            throw Exception( QObject::tr( "Error committing the events of user %1." ).arg( userId ) );
+        }
+    }
+    storage.disconnect();
+}
+
+void TimesheetGenerator::writeDatabaseExport( const SyntheticData& data, const QString& filename )
+{
+    QFile file( filename );
+    openNewFile( &file );
+    try {
+        XmlReportWriter writer( &file );
+        writer.startDocument( QLatin1String( "charmdatabase" ) );
+        writer.attribute( QLatin1String( "version" ), QString::number( CHARM_DATABASE_VERSION ) );
+        writer.startElement( QLatin1String( "metadata" ) );
+        writer.endElement();
+        writer.startElement( QLatin1String( "tasks" ) );
+        Q_FOREACH( const Task& task, data.tasks() )
+            task.writeXml( &writer );
+        writer.endElement();
+        writer.startElement( QLatin1String( "events" ) );
+        for ( int userId = 1; userId <= data.parameters().users; ++userId ) {
+            Q_FOREACH( const Event& event, data.events( userId ) )
+                event.writeXml( &writer );
+        }
+        writer.finish();
+    } catch ( const XmlSerializationException& e ) {
+        throw Exception( QObject::tr( "Error writing file %1: %2" ).arg( filename, e.what() ) );
+    }
+}
+
+int TimesheetGenerator::writeTimesheets( const SyntheticData& data, const QString& directory )
+{
+    QDir dir( directory );
+    if ( !dir.exists() && !QDir().mkpath( directory ) ) {
+        throw Exception( QObject::tr( "Cannot create directory %1." ).arg( directory ) );
+    }
+    int files = 0;
+    try {
+        for ( int userId = 1; userId <= data.parameters().users; ++userId ) {
+            // the events of a user are ordered by start, so each week is a run of events:
+            EventList week;
+            int weekYear = 0;
+            int weekNumber = 0;
+            Q_FOREACH( const Event& event, data.events( userId ) ) {
+                int year;
+                const int number = event.startDateTime().date().weekNumber( &year );
+                if ( !week.isEmpty() && ( number != weekNumber || year != weekYear ) ) {
+                    writeTimesheet( dir.absoluteFilePath( QString::fromLatin1( "WeeklyTimesheet-generated-%1-%2-%3.charmreport" )
+                                                          .arg( userId ).arg( weekYear ).arg( weekNumber ) ),
+                                    weekYear, weekNumber, week );
+                    ++files;
+                    week.clear();
+                }
+                weekYear = year;
+                weekNumber = number;
+                week << event;
+            }
+            if ( !week.isEmpty() ) {
+                writeTimesheet( dir.absoluteFilePath( QString::fromLatin1( "WeeklyTimesheet-generated-%1-%2-%3.charmreport" )
+                                                      .arg( userId ).arg( weekYear ).arg( weekNumber ) ),
+                                weekYear, weekNumber, week );
+                ++files;
+            }
+        }
+    } catch ( const XmlSerializationException& e ) {
+        throw Exception( QObject::tr( "Error writing time sheets to %1: %2" ).arg( directory, e.what() ) );
+    }
+    return files;
+}
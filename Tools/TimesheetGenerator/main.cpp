@@ -25,6 +25,7 @@
 
 #include <QDomDocument>
 #include <QDomElement>
+#include <QCoreApplication>
 #include <QObject>
 #include <QFile>
 
@@ -34,15 +35,41 @@
 
 #include "Exceptions.h"
 #include "Options.h"
+#include "SyntheticData.h"
+#include "SyntheticOutput.h"
 
 int main( int argc, char** argv ) {
     using namespace std;
+    // the SQLite output needs the Qt SQL driver plugins:
+    QCoreApplication application( argc, argv );
 
     try {
         using namespace TimesheetGenerator;
         cout << "Timesheet Generator, (C) 2009 Mirko Boehm, KDAB" << endl;
         Options options( argc, argv );
 
+        if ( options.mode() != Options::Mode_Template ) {
+            const SyntheticData data( options.parameters() );
+            switch ( options.mode() ) {
+            case Options::Mode_SqLite:
+                writeDatabase( data, options.output() );
+                cout << "Generated Database: " << qPrintable( options.output() ) << endl;
+                break;
+            case Options::Mode_DatabaseExport:
+                writeDatabaseExport( data, options.output() );
+                cout << "Generated Database Export: " << qPrintable( options.output() ) << endl;
+                break;
+            case Options::Mode_Timesheets: {
+                const int count = writeTimesheets( data, options.output() );
+                cout << "Generated " << count << " Time Sheets in " << qPrintable( options.output() ) << endl;
+                break;
+            }
+            default:
+                Q_ASSERT( false ); // handled above
+            }
+            return 0;
+        }
+
         // create a QDomDocument from the file content:
         QDomDocument doc( QString::fromLatin1( "charm_template" ) );
         QFile file( options.file() );
@@ -147,7 +174,21 @@ int main( int argc, char** argv ) {
              << "   * TimesheetGenerator -h                              <-- get help"
              << endl
              << "   * TimesheetGenerator -f template-filename -d date    <-- generate timesheets from template for that date"
-             << endl;
+             << endl
+             << "   * TimesheetGenerator -g sqlite|xml|reports -o output [synthetic options]"
+             << endl
+             << "                                                        <-- generate a synthetic database, database export or time sheets"
+             << endl
+             << "Synthetic options (the same options always generate the same data, only the running events end now):" << endl
+             << "   -s seed            seed of the random numbers (default 1)" << endl
+             << "   -t depth:breadth   shape of the task tree (default 4:12)" << endl
+             << "   -u users           number of users (default 10)" << endl
+             << "   -d date            first day (default 2015-01-05)" << endl
+             << "   -n days            number of days (default 730)" << endl
+             << "   -e events          average events per user and work day (default 6)" << endl
+             << "   -c length          average comment length (default 30)" << endl
+             << "   -l percent         chance of overlapping events (default 2)" << endl
+             << "   -a count           number of users whose last event is running, at the current time (default 1)" << endl;
         return 1;
     } catch( TimesheetGenerator::Exception& e ) {
         cerr << e.what() << endl;
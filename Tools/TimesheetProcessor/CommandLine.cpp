@@ -34,11 +34,11 @@ extern "C" {
 #include <iostream>
 
 CommandLine::CommandLine(int argc, char** argv) :
-        m_mode(Mode_None), m_index(), m_userid()
+        m_mode(Mode_None), m_index(), m_userid(), m_threadCount(), m_period(Period_Week)
 {
         opterr = 0;
         int ch;
-        while ((ch = getopt(argc, argv, "vhza:x:c:ri:u:m:")) != -1)
+        while ((ch = getopt(argc, argv, "vhza:R:x:s:c:ri:u:m:d:j:t:b:e:p:")) != -1)
         {
                 if (ch == '?')
                 {
@@ -49,11 +49,19 @@ CommandLine::CommandLine(int argc, char** argv) :
                                 throw UsageException(QObject::tr(
                                                 "Option -a requires a filename argument"));
                         }
+                        if ( option == 'R' )
+                        {
+                                throw UsageException( QObject::tr( "Option -R requires a filename argument" ) );
+                        }
                         if (option == 'i')
                         {
                                 throw UsageException(QObject::tr(
                                                 "Option -i requires an index argument"));
                         }
+                        if ( option == 's' )
+                        {
+                                throw UsageException( QObject::tr( "Option -s requires a date and time argument" ) );
+                        }
                         if (option == 'x')
                         {
                                 throw UsageException(QObject::tr(
@@ -63,6 +71,26 @@ CommandLine::CommandLine(int argc, char** argv) :
                         {
                             throw UsageException( QObject::tr( "Option -m requires a user comment argument" ) );
                         }
+                        if ( option == 'd' )
+                        {
+                            throw UsageException( QObject::tr( "Option -d requires a spool directory argument" ) );
+                        }
+                        if ( option == 'j' )
+                        {
+                            throw UsageException( QObject::tr( "Option -j requires a thread count argument" ) );
+                        }
+                        if ( option == 't' )
+                        {
+                            throw UsageException( QObject::tr( "Option -t requires a filename argument" ) );
+                        }
+                        if ( option == 'b' || option == 'e' )
+                        {
+                            throw UsageException( QObject::tr( "Option -%1 requires a date argument" ).arg( QChar( option ) ) );
+                        }
+                        if ( option == 'p' )
+                        {
+                            throw UsageException( QObject::tr( "Option -p requires a period argument" ) );
+                        }
                         if (isprint(option))
                         {
                                 throw UsageException(
@@ -91,6 +119,18 @@ CommandLine::CommandLine(int argc, char** argv) :
                         m_mode = Mode_AddTimesheet;
                         break;
                 }
+                case 'R':
+                {
+                        if (m_mode != Mode_None)
+                        {
+                                QString msg = QObject::tr(
+                                                "Multiple mode selections, please use only one");
+                                throw UsageException(msg);
+                        }
+                        m_filename = QString::fromLocal8Bit(optarg);
+                        m_mode = Mode_ReplaceTimesheet;
+                        break;
+                }
                 case 'x':
                 {
                         if (m_mode != Mode_None)
@@ -104,6 +144,16 @@ CommandLine::CommandLine(int argc, char** argv) :
                         m_mode = Mode_ExportProjectcodes;
                         break;
                 }
+                case 's':
+                {
+                        QString arg = QString::fromLocal8Bit( optarg );
+                        m_changedSince = QDateTime::fromString( arg, Qt::ISODate );
+                        if ( !m_changedSince.isValid() )
+                        {
+                                throw UsageException( QObject::tr( "Argument to option -s must be a date and time of the format yyyy-mm-ddThh:mm:ssZ" ) );
+                        }
+                        break;
+                }
                 case 'c':
                 {
                         if (m_mode != Mode_None)
@@ -178,6 +228,71 @@ CommandLine::CommandLine(int argc, char** argv) :
                     m_userComment = arg;
                     break;
                 }
+                case 'd':
+                {
+                    if ( m_mode != Mode_None )
+                    {
+                        QString msg = QObject::tr( "Multiple mode selections, please use only one" );
+                        throw UsageException( msg );
+                    }
+                    m_spoolDirectory = QString::fromLocal8Bit( optarg );
+                    m_mode = Mode_Daemon;
+                    break;
+                }
+                case 'j':
+                {
+                    QString arg = QString::fromLocal8Bit( optarg );
+                    bool ok;
+                    m_threadCount = arg.toInt( &ok );
+                    if ( !ok || m_threadCount < 1 )
+                    {
+                        throw UsageException( QObject::tr( "Argument to option -j must be an integer thread count larger than zero" ) );
+                    }
+                    break;
+                }
+                case 't':
+                {
+                    if ( m_mode != Mode_None )
+                    {
+                        QString msg = QObject::tr( "Multiple mode selections, please use only one" );
+                        throw UsageException( msg );
+                    }
+                    m_exportFilename = QString::fromLocal8Bit( optarg );
+                    m_mode = Mode_ExportTotals;
+                    break;
+                }
+                case 'b':
+                case 'e':
+                {
+                    QString arg = QString::fromLocal8Bit( optarg );
+                    QDate date = QDate::fromString( arg, Qt::ISODate );
+                    if ( !date.isValid() )
+                    {
+                        throw UsageException( QObject::tr( "Argument to option -%1 must be a date of the format yyyy-mm-dd" ).arg( QChar( ch ) ) );
+                    }
+                    if ( ch == 'b' )
+                        m_startDate = date;
+                    else
+                        m_endDate = date;
+                    break;
+                }
+                case 'p':
+                {
+                    QString arg = QString::fromLocal8Bit( optarg );
+                    if ( arg == QLatin1String( "week" ) )
+                    {
+                        m_period = Period_Week;
+                    }
+                    else if ( arg == QLatin1String( "month" ) )
+                    {
+                        m_period = Period_Month;
+                    }
+                    else
+                    {
+                        throw UsageException( QObject::tr( "Argument to option -p must be week or month" ) );
+                    }
+                    break;
+                }
                 case 'z':
                         // initialize the database
                         m_mode = Mode_InitializeDatabase;
@@ -228,6 +343,19 @@ CommandLine::CommandLine(int argc, char** argv) :
             if ( m_index > 0 ) {
                 msg += QObject::tr( "Specifying an index when adding a time sheet is not supported anymore." );
             }
+        } else if ( m_mode == Mode_ReplaceTimesheet ) {
+            if ( m_userid < 1 ) {
+                msg += QObject::tr( "No userid specified. -R filename requires a user id specified with -u." );
+            }
+        } else if ( m_mode == Mode_ExportTotals ) {
+            if ( !m_startDate.isValid() || !m_endDate.isValid() ) {
+                msg += QObject::tr( "-t filename requires a date range specified with -b and -e." );
+            } else if ( m_endDate < m_startDate ) {
+                msg += QObject::tr( "The end date must not be before the start date." );
+            }
+        }
+        if ( m_changedSince.isValid() && m_mode != Mode_ExportProjectcodes ) {
+            msg += QObject::tr( "-s is only supported when exporting project codes with -x filename." );
         }
 
         if (!msg.isEmpty())
@@ -236,18 +364,29 @@ CommandLine::CommandLine(int argc, char** argv) :
         }
 }
 
-CommandLine::CommandLine(const QString file, const int userId)
+CommandLine::CommandLine(const QString file, const int userId, const QString& userComment)
+    : m_mode(Mode_AddTimesheet), m_index(), m_userid(), m_threadCount(), m_period(Period_Week)
 {
     m_filename = file;
     m_userid = userId;
+    m_userComment = userComment;
 }
 
 CommandLine::CommandLine(const int userId, const int index)
+    : m_mode(Mode_RemoveTimesheet), m_index(), m_userid(), m_threadCount(), m_period(Period_Week)
 {
     m_userid = userId;
     m_index = index;
 }
 
+CommandLine::CommandLine(const QString& exportFilename, const QDate& startDate, const QDate& endDate, Period period)
+    : m_mode(Mode_ExportTotals), m_index(), m_userid(), m_threadCount(), m_period(period)
+{
+    m_exportFilename = exportFilename;
+    m_startDate = startDate;
+    m_endDate = endDate;
+}
+
 CommandLine::Mode CommandLine::mode() const
 {
         return m_mode;
@@ -283,6 +422,36 @@ int CommandLine::index() const
         return m_index;
 }
 
+QString CommandLine::spoolDirectory() const
+{
+    return m_spoolDirectory;
+}
+
+int CommandLine::threadCount() const
+{
+    return m_threadCount;
+}
+
+QDateTime CommandLine::changedSince() const
+{
+    return m_changedSince;
+}
+
+QDate CommandLine::startDate() const
+{
+    return m_startDate;
+}
+
+QDate CommandLine::endDate() const
+{
+    return m_endDate;
+}
+
+CommandLine::Period CommandLine::period() const
+{
+    return m_period;
+}
+
 void CommandLine::usage()
 {
         using namespace std;
@@ -294,12 +463,28 @@ void CommandLine::usage()
                         << endl
                         << "   * TimesheetProzessor -a filename -u userid -m comment  <-- add timesheet from file"
                         << endl
+                        << "   * TimesheetProzessor -R filename -u userid -m comment  <-- replace the timesheet of that week"
+                        << endl
+                        << "     (concurrent replaces of the same week are serialized, a deadlock is retried up to 3 times)"
+                        << endl
                         << "   * TimesheetProzessor -r -i index -u userid                      <-- remove timesheet at index"
                         << endl
                         << "   * TimesheetProzessor -c username                                <-- create user if user does not exist"
                         << endl
                         << "   * TimesheetProzessor -x filename                                <-- export project codes to XML file"
                         << endl
+                        << "   * TimesheetProzessor -x filename -s yyyy-mm-ddThh:mm:ssZ        <-- export project codes changed since then"
+                        << endl
+                        << "   * TimesheetProzessor -t filename -b date -e date [-p week|month] <-- export totals per user, task and period"
+                        << endl
+                        << "     (CSV, or XML if filename ends in .xml, - writes CSV to stdout)"
+                        << endl
                         << "   * TimesheetProzessor -z                                         <-- initialize database (careful!)"
+                        << endl
+                        << "   * TimesheetProzessor -d directory [-j threads]                  <-- add timesheets from job files in directory"
+                        << endl
+                        << "   * TimesheetProzessor -d - [-j threads]                          <-- add timesheets from jobs read from stdin"
+                        << endl
+                        << "     (one job per line or .job file: userid<TAB>filename[<TAB>comment])"
                         << endl;
 }
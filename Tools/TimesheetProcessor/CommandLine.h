@@ -24,13 +24,15 @@
 #ifndef COMMANDLINE_H
 #define COMMANDLINE_H
 
+#include <QDate>
+#include <QDateTime>
 #include <QString>
 
 class CommandLine
 {
 public:
     CommandLine(int argc, char** argv);
-    CommandLine(const QString file, const int userId);
+    CommandLine(const QString file, const int userId, const QString& userComment = QString());
     CommandLine(const int userId, const int index);
 
 
@@ -42,10 +44,21 @@ public:
         Mode_PrintVersion,
         Mode_AddTimesheet,
         Mode_RemoveTimesheet,
+        Mode_ReplaceTimesheet,
         Mode_ExportProjectcodes,
+        Mode_Daemon,
+        Mode_ExportTotals,
         Mode_NumberOfModes
     };
 
+    /** The periods the totals are grouped by when exporting totals. */
+    enum Period {
+        Period_Week,
+        Period_Month
+    };
+
+    CommandLine(const QString& exportFilename, const QDate& startDate, const QDate& endDate, Period period);
+
     Mode mode() const;
 
     QString filename() const;
@@ -60,6 +73,23 @@ public:
 
     int index() const;
 
+    /** The directory watched for job files in daemon mode, "-" for jobs read from stdin. */
+    QString spoolDirectory() const;
+
+    /** The number of time sheets processed concurrently in daemon mode, 0 for the default. */
+    int threadCount() const;
+
+    /** The first day of the exported totals. */
+    QDate startDate() const;
+
+    /** The last day of the exported totals. */
+    QDate endDate() const;
+
+    Period period() const;
+
+    /** Export only the tasks changed since then, invalid to export all tasks. */
+    QDateTime changedSince() const;
+
     /** Dump command line option reference. */
     static void usage();
 
@@ -68,9 +98,15 @@ private:
     QString m_userComment;
     QString m_userName;
     QString m_exportFilename;
+    QString m_spoolDirectory;
     Mode m_mode;
     int m_index;
     int m_userid;
+    int m_threadCount;
+    QDate m_startDate;
+    QDate m_endDate;
+    Period m_period;
+    QDateTime m_changedSince;
 };
 
 #endif /*COMMANDLINE_H*/
@@ -0,0 +1,309 @@
+/*
+  Daemon.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Daemon.h"
+#include "CommandLine.h"
+#include "Operations.h"
+
+#include "Core/CharmExceptions.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QObject>
+#include <QRunnable>
+#include <QStringList>
+#include <QTextStream>
+
+#include <iostream>
+#include <sstream>
+
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+
+namespace {
+    static const int SpoolPollInterval = 2; // seconds
+    static const char JobSuffix[] = ".job";
+    static const char ProcessingSuffix[] = ".processing";
+    static const char ResultSuffix[] = ".result";
+
+    QString hostName()
+    {
+        char name[256];
+        if ( gethostname( name, sizeof name ) != 0 ) {
+            return QString();
+        }
+        name[sizeof name - 1] = '\0';
+        return QString::fromLocal8Bit( name );
+    }
+
+    class TimesheetJob : public QRunnable
+    {
+    public:
+        TimesheetJob( TimesheetDaemon* daemon, const TimesheetDaemon::Job& job )
+            : m_daemon( daemon )
+            , m_job( job )
+        {
+        }
+
+        void run() override
+        {
+            m_daemon->process( m_job );
+        }
+
+    private:
+        TimesheetDaemon* m_daemon;
+        TimesheetDaemon::Job m_job;
+    };
+}
+
+TimesheetDaemon::Job TimesheetDaemon::parseJob( const QString& id, const QString& line ) throw (TimesheetProcessorException )
+{
+    const QStringList fields = line.split( QLatin1Char( '\t' ) );
+    if ( fields.count() < 2 || fields.count() > 3 ) {
+        throw TimesheetProcessorException( QObject::tr( "Job %1 is not of the format userid<TAB>filename[<TAB>comment]" ).arg( id ) );
+    }
+    Job job;
+    job.id = id;
+    bool ok;
+    job.userid = fields.at( 0 ).trimmed().toInt( &ok );
+    if ( !ok || job.userid < 1 ) {
+        throw TimesheetProcessorException( QObject::tr( "Job %1 does not start with a user id larger than zero" ).arg( id ) );
+    }
+    job.filename = fields.at( 1 ).trimmed();
+    if ( job.filename.isEmpty() ) {
+        throw TimesheetProcessorException( QObject::tr( "Job %1 does not name a time sheet file" ).arg( id ) );
+    }
+    if ( fields.count() == 3 ) {
+        job.userComment = fields.at( 2 );
+    }
+    return job;
+}
+
+TimesheetDaemon::TimesheetDaemon( const MySqlStorage::Parameters& parameters, int threadCount )
+    : m_parameters( parameters )
+    , m_output( 0 )
+{
+    if ( threadCount > 0 ) {
+        m_pool.setMaxThreadCount( threadCount );
+    }
+    // keep the worker threads, and with them their database connections, alive between jobs
+    m_pool.setExpiryTimeout( -1 );
+}
+
+TimesheetDaemon::~TimesheetDaemon()
+{
+    m_pool.waitForDone();
+}
+
+int TimesheetDaemon::processSpoolDirectory( const QString& directory )
+{
+    QDir spool( directory );
+    const QStringList jobFiles = spool.entryList( QStringList() << QLatin1String( "*.job" ), QDir::Files, QDir::Name );
+    const QString owner = claimOwner();
+    int count = 0;
+    Q_FOREACH( const QString& jobFile, jobFiles ) {
+        const QString jobPath = spool.absoluteFilePath( jobFile );
+        const QString processingPath = jobPath + QLatin1String( ProcessingSuffix ) + QLatin1Char( '.' ) + owner;
+        // claim the job, renaming fails if another daemon was faster
+        if ( !QFile::rename( jobPath, processingPath ) ) {
+            continue;
+        }
+        ++count;
+        const QString baseName = jobFile.left( jobFile.length() - qstrlen( JobSuffix ) );
+        Job job;
+        try {
+            QFile file( processingPath );
+            if ( !file.open( QIODevice::ReadOnly ) ) {
+                throw TimesheetProcessorException( QObject::tr( "Cannot open file %1 for reading." ).arg( processingPath ) );
+            }
+            const QString line = QString::fromLocal8Bit( file.readLine() ).trimmed();
+            job = parseJob( baseName, line );
+            job.filename = spool.absoluteFilePath( job.filename );
+        } catch ( const TimesheetProcessorException& e ) {
+            job.id = baseName;
+            job.resultFilename = spool.absoluteFilePath( baseName + QLatin1String( ResultSuffix ) );
+            writeResult( job, QString::fromLatin1( "job:%1\nerror:%2\n" ).arg( job.id, QString::fromLocal8Bit( e.what() ) ).toLocal8Bit() );
+            QFile::remove( processingPath );
+            continue;
+        }
+        job.resultFilename = spool.absoluteFilePath( baseName + QLatin1String( ResultSuffix ) );
+        job.claimedFilename = processingPath;
+        m_pool.start( new TimesheetJob( this, job ) );
+    }
+    m_pool.waitForDone();
+    return count;
+}
+
+int TimesheetDaemon::recoverClaimedJobs( const QString& directory )
+{
+    QDir spool( directory );
+    const QString claimedSuffix = QLatin1String( JobSuffix ) + QLatin1String( ProcessingSuffix ) + QLatin1Char( '.' );
+    const QStringList claimedFiles = spool.entryList( QStringList() << QLatin1String( "*" ) + claimedSuffix + QLatin1String( "*" ),
+                                                      QDir::Files, QDir::Name );
+    const QString hostPrefix = hostName() + QLatin1Char( '-' );
+    int count = 0;
+    Q_FOREACH( const QString& claimedFile, claimedFiles ) {
+        const int suffixStart = claimedFile.lastIndexOf( claimedSuffix );
+        const QString owner = claimedFile.mid( suffixStart + claimedSuffix.length() );
+        if ( !owner.startsWith( hostPrefix ) ) {
+            continue;
+        }
+        bool ok;
+        const pid_t pid = owner.mid( hostPrefix.length() ).toInt( &ok );
+        // a process of another user answers EPERM, it still runs
+        if ( !ok || ( pid != getpid() && ( kill( pid, 0 ) == 0 || errno != ESRCH ) ) ) {
+            continue;
+        }
+        const QString claimedPath = spool.absoluteFilePath( claimedFile );
+        const QString baseName = claimedFile.left( suffixStart );
+        if ( spool.exists( baseName + QLatin1String( ResultSuffix ) ) ) {
+            // the daemon stopped after writing the result, do not add the time sheet twice
+            QFile::remove( claimedPath );
+        } else if ( QFile::rename( claimedPath, spool.absoluteFilePath( baseName + QLatin1String( JobSuffix ) ) ) ) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+QString TimesheetDaemon::claimOwner()
+{
+    return hostName() + QLatin1Char( '-' ) + QString::number( getpid() );
+}
+
+int TimesheetDaemon::processStream( QTextStream& input, std::ostream& output )
+{
+    m_output = &output;
+    int lineNumber = 0;
+    int count = 0;
+    QString line;
+    while ( !( line = input.readLine() ).isNull() ) {
+        ++lineNumber;
+        if ( line.trimmed().isEmpty() || line.startsWith( QLatin1Char( '#' ) ) ) {
+            continue;
+        }
+        ++count;
+        const QString id = QString::number( lineNumber );
+        try {
+            m_pool.start( new TimesheetJob( this, parseJob( id, line ) ) );
+        } catch ( const TimesheetProcessorException& e ) {
+            Job job;
+            job.id = id;
+            writeResult( job, QString::fromLatin1( "job:%1\nerror:%2\n" ).arg( id, QString::fromLocal8Bit( e.what() ) ).toLocal8Bit() );
+        }
+    }
+    m_pool.waitForDone();
+    m_output = 0;
+    return count;
+}
+
+void TimesheetDaemon::process( const Job& job )
+{
+    std::ostringstream out;
+    out << "job:" << qPrintable( job.id ) << std::endl;
+    try {
+        Database* database = connection();
+        CommandLine cmd( job.filename, job.userid, job.userComment );
+        addTimesheet( cmd, *database, out, &m_taskIds );
+    } catch ( const TimesheetProcessorException& e ) {
+        out << "error:" << e.what() << std::endl;
+    }
+    const std::string result = out.str();
+    writeResult( job, QByteArray( result.data(), static_cast<int>( result.size() ) ) );
+    if ( !job.claimedFilename.isEmpty() ) {
+        QFile::remove( job.claimedFilename );
+    }
+}
+
+Database* TimesheetDaemon::connection()
+{
+    Database* database = m_connections.localData();
+    if ( !database ) {
+        const int number = m_connectionCount.fetchAndAddRelaxed( 1 );
+        database = new Database( QString::fromLatin1( "TimesheetProcessor-%1" ).arg( number ) );
+        m_connections.setLocalData( database );
+    }
+    if ( !database->isConnected() ) {
+        // first use, or the server dropped the connection while the daemon was idle
+        database->database().close();
+        database->login( m_parameters );
+    }
+    return database;
+}
+
+void TimesheetDaemon::writeResult( const Job& job, const QByteArray& result )
+{
+    if ( job.resultFilename.isEmpty() ) {
+        QMutexLocker locker( &m_outputMutex );
+        Q_ASSERT( m_output );
+        m_output->write( result.constData(), result.size() );
+        *m_output << std::endl;
+        return;
+    }
+    // write to a temporary name first, readers only ever see complete result files
+    const QString temporaryFilename = job.resultFilename + QLatin1String( ".tmp" );
+    QFile file( temporaryFilename );
+    if ( !file.open( QIODevice::WriteOnly | QIODevice::Truncate ) || file.write( result ) != result.size() ) {
+        std::cerr << "Cannot write result file " << qPrintable( temporaryFilename ) << std::endl;
+        return;
+    }
+    file.close();
+    QFile::remove( job.resultFilename );
+    if ( !QFile::rename( temporaryFilename, job.resultFilename ) ) {
+        std::cerr << "Cannot write result file " << qPrintable( job.resultFilename ) << std::endl;
+    }
+}
+
+void runDaemon( const CommandLine& cmd )
+{
+    using namespace std;
+
+    MySqlStorage::Parameters parameters;
+    try {
+        parameters = MySqlStorage::parseParameterEnvironmentVariable();
+    } catch( ParseError& e ) {
+        throw TimesheetProcessorException( e.what() );
+    }
+    TimesheetDaemon daemon( parameters, cmd.threadCount() );
+
+    if ( cmd.spoolDirectory() == QLatin1String( "-" ) ) {
+        QTextStream input( stdin );
+        const int count = daemon.processStream( input, cout );
+        cout << "Done, " << count << " jobs processed." << endl;
+        return;
+    }
+
+    if ( !QFileInfo( cmd.spoolDirectory() ).isDir() ) {
+        throw TimesheetProcessorException( QObject::tr( "Spool directory %1 does not exist." ).arg( cmd.spoolDirectory() ) );
+    }
+    const int recovered = daemon.recoverClaimedJobs( cmd.spoolDirectory() );
+    if ( recovered > 0 ) {
+        cout << "Requeued " << recovered << " jobs of a daemon that stopped while processing them" << endl;
+    }
+    cout << "Processing jobs in " << qPrintable( cmd.spoolDirectory() ) << endl;
+    Q_FOREVER {
+        if ( daemon.processSpoolDirectory( cmd.spoolDirectory() ) == 0 ) {
+            sleep( SpoolPollInterval );
+        }
+    }
+}
@@ -0,0 +1,108 @@
+/*
+  Daemon.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2007-2016 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#include "Database.h"
+#include "Exceptions.h"
+
+#include "Core/MySqlStorage.h"
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QString>
+#include <QThreadPool>
+#include <QThreadStorage>
+
+#include <iosfwd>
+
+class QTextStream;
+
+/** Adds uploaded time sheets to the database until it is stopped.
+ *
+ * Jobs are either read line by line from a stream or picked up as .job files from a spool directory.
+ * A job line has the format userid<TAB>filename[<TAB>comment]. The jobs are processed concurrently,
+ * each worker thread keeps its own database connection open between jobs, and every time sheet is
+ * added in its own transaction. The result of a job is the output of addTimesheet, preceded by a
+ * job:id line and followed by an error:message line if the job failed.
+ */
+class TimesheetDaemon
+{
+public:
+    struct Job {
+        Job() : userid( 0 ) {}
+        QString id;
+        int userid;
+        QString filename;
+        QString userComment;
+        /** Where the result is written, the output stream if empty. */
+        QString resultFilename;
+        /** The claimed job file, removed when the job is done. */
+        QString claimedFilename;
+    };
+
+    static Job parseJob( const QString& id, const QString& line ) throw (TimesheetProcessorException );
+
+    explicit TimesheetDaemon( const MySqlStorage::Parameters& parameters, int threadCount = 0 );
+    ~TimesheetDaemon();
+
+    /** Claims the pending job files in @p directory, processes them and returns the number of jobs.
+     *
+     * A job file x.job is renamed to x.job.processing.owner while it is processed, so that several
+     * daemons can share a spool directory. The owner is claimOwner() of the daemon. The result of the
+     * job is written to x.result.
+     */
+    int processSpoolDirectory( const QString& directory );
+
+    /** Puts the jobs in @p directory that a daemon on this host claimed, but did not finish before
+     * it stopped, back as x.job, and returns their number. Called at startup.
+     *
+     * A claimed job is stale if its owner process no longer runs. If its result was written already,
+     * only the claimed file is removed. Jobs claimed on other hosts are left alone, because it cannot
+     * be told whether their daemon still runs.
+     */
+    int recoverClaimedJobs( const QString& directory );
+
+    /** The owner of the jobs claimed by this process, as hostname-pid. */
+    static QString claimOwner();
+
+    /** Processes the jobs read from @p input until end of file and returns the number of jobs. */
+    int processStream( QTextStream& input, std::ostream& output );
+
+    /** Processes a single job on the calling thread, called by the worker threads. */
+    void process( const Job& job );
+
+private:
+    Database* connection();
+    void writeResult( const Job& job, const QByteArray& result );
+
+    MySqlStorage::Parameters m_parameters;
+    TaskIdCache m_taskIds;
+    QThreadStorage<Database*> m_connections;
+    QAtomicInt m_connectionCount;
+    QMutex m_outputMutex;
+    std::ostream* m_output;
+    // destroyed first, so that the worker threads finish while their connections still exist
+    QThreadPool m_pool;
+};
+
+#endif /*DAEMON_H*/
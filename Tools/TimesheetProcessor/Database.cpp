@@ -25,7 +25,9 @@
 #include "Exceptions.h"
 
 #include "Core/CharmExceptions.h"
+#include "Core/XmlSerialization.h"
 
+#include <QHash>
 #include <QSqlDatabase>
 #include <QSqlDriver>
 #include <QSqlError>
@@ -36,11 +38,30 @@
 #include <QStringList>
 
 #include <cstdlib>
+#include <iostream>
+
+namespace {
+    struct Index {
+        const char* table;
+        const char* name;
+        const char* columns;
+    };
+
+    static const Index Indexes[] = {
+        { "Events", "events_report_user", "report_id, user_id" },
+        { "timesheets", "timesheets_user_year_week", "userid, year, week" }
+    };
+}
 
 Database::Database()
 {
 }
 
+Database::Database( const QString& connectionName )
+    : m_storage( connectionName )
+{
+}
+
 Database::~Database()
 {
 }
@@ -93,6 +114,95 @@ TaskList Database::getAllTasks() throw(TimesheetProcessorException )
         return m_storage.getAllTasks();
 }
 
+QSet<TaskId> Database::getTaskIds() throw (TimesheetProcessorException )
+{
+    QSqlQuery query( database() );
+    if ( !query.exec( "SELECT task_id FROM Tasks" ) ) {
+        throw TimesheetProcessorException( "Cannot execute query for task ids" );
+    }
+    QSet<TaskId> taskIds;
+    while ( query.next() ) {
+        taskIds.insert( query.value( 0 ).toInt() );
+    }
+    return taskIds;
+}
+
+int Database::exportTasks( TaskExportWriter* writer, const QDateTime& changedSince ) throw (TimesheetProcessorException )
+{
+    // for a delta, collect the changed tasks and their ancestors, without which the task list is not a tree
+    QSet<TaskId> exported;
+    if ( changedSince.isValid() ) {
+        QHash<TaskId, TaskId> parents;
+        QList<TaskId> changed;
+        QSqlQuery query( database() );
+        query.setForwardOnly( true );
+        query.prepare( "SELECT task_id, parent, UNIX_TIMESTAMP(changed) >= :since FROM Tasks" );
+        query.bindValue( ":since", changedSince.toTime_t() );
+        if ( !query.exec() ) {
+            throw TimesheetProcessorException( "Cannot execute query for changed tasks" );
+        }
+        while ( query.next() ) {
+            const TaskId id = query.value( 0 ).toInt();
+            parents.insert( id, query.value( 1 ).toInt() );
+            if ( query.value( 2 ).toInt() == 1 ) {
+                changed << id;
+            }
+        }
+        Q_FOREACH( TaskId id, changed ) {
+            while ( id != 0 && !exported.contains( id ) ) {
+                exported.insert( id );
+                id = parents.value( id );
+            }
+        }
+    }
+
+    QSqlQuery query( database() );
+    query.setForwardOnly( true );
+    if ( !query.exec( "SELECT * FROM Tasks LEFT JOIN Subscriptions ON Tasks.task_id = Subscriptions.task" ) ) {
+        throw TimesheetProcessorException( "Cannot execute query for tasks" );
+    }
+    int count = 0;
+    try {
+        while ( query.next() ) {
+            const Task task = SqlStorage::makeTaskFromRecord( query.record() );
+            if ( changedSince.isValid() && !exported.contains( task.id() ) ) {
+                continue;
+            }
+            writer->writeTask( task );
+            ++count;
+        }
+
+        // a delta also tells the clients which tasks are gone, unless the id was used again
+        if ( changedSince.isValid() ) {
+            QSqlQuery deleted( database() );
+            deleted.setForwardOnly( true );
+            deleted.prepare( "SELECT task_id FROM DeletedTasks WHERE UNIX_TIMESTAMP(deleted) >= :since "
+                             "AND task_id NOT IN ( SELECT task_id FROM Tasks )" );
+            deleted.bindValue( ":since", changedSince.toTime_t() );
+            if ( !deleted.exec() ) {
+                throw TimesheetProcessorException( "Cannot execute query for deleted tasks" );
+            }
+            while ( deleted.next() ) {
+                writer->writeDeletedTask( deleted.value( 0 ).toInt() );
+            }
+        }
+    } catch ( const XmlSerializationException& e ) {
+        throw TimesheetProcessorException( e.what() );
+    }
+    return count;
+}
+
+QString Database::taskTableChecksum() throw (TimesheetProcessorException )
+{
+    QSqlQuery query( database() );
+    if ( !query.exec( "SELECT COUNT(*), MAX(id), SUM(task_id) FROM Tasks" ) || !query.next() ) {
+        throw TimesheetProcessorException( "Cannot execute query for the task table checksum" );
+    }
+    return QString::fromLatin1( "%1/%2/%3" ).arg( query.value( 0 ).toString(),
+                                                  query.value( 1 ).toString(),
+                                                  query.value( 2 ).toString() );
+}
+
 QSqlDatabase& Database::database()
 {
         return m_storage.database();
@@ -106,6 +216,11 @@ void Database::login() throw (TimesheetProcessorException )
     } catch( ParseError& e ) {
         throw TimesheetProcessorException( e.what() );
     }
+    login( parameters );
+}
+
+void Database::login( const MySqlStorage::Parameters& parameters ) throw (TimesheetProcessorException )
+{
     m_storage.configure( parameters );
     bool ok = m_storage.database().open();
     if ( !ok ) {
@@ -125,6 +240,15 @@ void Database::login() throw (TimesheetProcessorException )
     }
 }
 
+bool Database::isConnected()
+{
+    if ( !m_storage.database().isOpen() ) {
+        return false;
+    }
+    QSqlQuery query( m_storage.database() );
+    return query.exec( "SELECT 1" );
+}
+
 void Database::initializeDatabase() throw (TimesheetProcessorException )
 {
         try {
@@ -136,11 +260,93 @@ void Database::initializeDatabase() throw (TimesheetProcessorException )
                 if ( !m_storage.createDatabaseTables() ) {
                         throw TimesheetProcessorException( "Cannot create database contents, please double-check permissions." );
                 }
+                ensureIndexes();
+                ensureTaskChangeTime();
+                ensureTaskDeletionLog();
         } catch ( UnsupportedDatabaseVersionException& e ) {
                 throw TimesheetProcessorException( e.what() );
         }
 }
 
+void Database::ensureIndexes()
+{
+    const QStringList tables = database().tables();
+    for ( unsigned int i = 0; i < sizeof Indexes / sizeof Indexes[0]; ++i ) {
+        const Index& index = Indexes[i];
+        if ( !tables.contains( QLatin1String( index.table ) ) ) {
+            continue;
+        }
+        QSqlQuery query( database() );
+        query.prepare( "SELECT COUNT(*) FROM information_schema.statistics "
+                       "WHERE table_schema = DATABASE() AND table_name = :table AND index_name = :index" );
+        query.bindValue( ":table", QLatin1String( index.table ) );
+        query.bindValue( ":index", QLatin1String( index.name ) );
+        if ( !query.exec() || !query.next() ) {
+            std::cerr << "Cannot check for index " << index.name << std::endl;
+            continue;
+        }
+        if ( query.value( 0 ).toInt() > 0 ) {
+            continue;
+        }
+        QSqlQuery create( database() );
+        const QString statement = QString::fromLatin1( "CREATE INDEX %1 ON %2 (%3)" )
+                .arg( QLatin1String( index.name ), QLatin1String( index.table ), QLatin1String( index.columns ) );
+        if ( !create.exec( statement ) ) {
+            std::cerr << "Cannot create index " << index.name << ": "
+                      << qPrintable( create.lastError().text() ) << std::endl;
+        }
+    }
+}
+
+void Database::ensureTaskChangeTime() throw (TimesheetProcessorException )
+{
+    QSqlQuery query( database() );
+    if ( !query.exec( "SELECT COUNT(*) FROM information_schema.columns "
+                      "WHERE table_schema = DATABASE() AND table_name = 'Tasks' AND column_name = 'changed'" )
+         || !query.next() ) {
+        throw TimesheetProcessorException( "Cannot check for the change time of tasks" );
+    }
+    if ( query.value( 0 ).toInt() > 0 ) {
+        return;
+    }
+    // MySQL maintains the column on every update, whoever modifies the tasks
+    QSqlQuery alter( database() );
+    if ( !alter.exec( "ALTER TABLE Tasks ADD COLUMN changed TIMESTAMP NOT NULL "
+                      "DEFAULT CURRENT_TIMESTAMP ON UPDATE CURRENT_TIMESTAMP" ) ) {
+        throw TimesheetProcessorException( QObject::tr( "Cannot add the change time of tasks: %1" )
+                                           .arg( alter.lastError().text() ) );
+    }
+}
+
+void Database::ensureTaskDeletionLog() throw (TimesheetProcessorException )
+{
+    if ( !database().tables().contains( QLatin1String( "DeletedTasks" ) ) ) {
+        QSqlQuery create( database() );
+        if ( !create.exec( "CREATE TABLE DeletedTasks ( task_id INTEGER NOT NULL PRIMARY KEY, "
+                           "deleted TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP )" ) ) {
+            throw TimesheetProcessorException( QObject::tr( "Cannot create the table of deleted tasks: %1" )
+                                               .arg( create.lastError().text() ) );
+        }
+    }
+
+    QSqlQuery query( database() );
+    if ( !query.exec( "SELECT COUNT(*) FROM information_schema.triggers "
+                      "WHERE trigger_schema = DATABASE() AND trigger_name = 'Tasks_deleted'" )
+         || !query.next() ) {
+        throw TimesheetProcessorException( "Cannot check for the trigger that records deleted tasks" );
+    }
+    if ( query.value( 0 ).toInt() > 0 ) {
+        return;
+    }
+    // like the change time, MySQL records the deletion whoever deletes the task
+    QSqlQuery trigger( database() );
+    if ( !trigger.exec( "CREATE TRIGGER Tasks_deleted AFTER DELETE ON Tasks FOR EACH ROW "
+                        "REPLACE INTO DeletedTasks ( task_id ) VALUES ( OLD.task_id )" ) ) {
+        throw TimesheetProcessorException( QObject::tr( "Cannot create the trigger that records deleted tasks: %1" )
+                                           .arg( trigger.lastError().text() ) );
+    }
+}
+
 void Database::addEvent( const Event& event, const SqlRaiiTransactor& t )
 {
     Event newEvent = m_storage.makeEvent( t );
@@ -165,3 +371,28 @@ void Database::deleteEventsForReport( int userid, int index )
                 throw TimesheetProcessorException( "Failed to delete report" );
         }
 }
+
+TaskIdCache::TaskIdCache()
+{
+}
+
+void TaskIdCache::refresh( Database& database ) throw (TimesheetProcessorException )
+{
+    const QString checksum = database.taskTableChecksum();
+    {
+        QReadLocker locker( &m_lock );
+        if ( checksum == m_checksum ) {
+            return;
+        }
+    }
+    const QSet<TaskId> taskIds = database.getTaskIds();
+    QWriteLocker locker( &m_lock );
+    m_taskIds = taskIds;
+    m_checksum = checksum;
+}
+
+bool TaskIdCache::contains( TaskId id ) const
+{
+    QReadLocker locker( &m_lock );
+    return m_taskIds.contains( id );
+}
@@ -30,24 +30,48 @@
 #include "Core/Task.h"
 #include "Core/MySqlStorage.h"
 
+#include <QDateTime>
+#include <QReadWriteLock>
+#include <QSet>
 #include <QString>
 
 class SqlRaiiTransactor;
+class TaskExportWriter;
 
 class Database
 {
 public:
     Database();
+    /** Uses a named connection, needed when several databases are open in different threads. */
+    explicit Database( const QString& connectionName );
     virtual ~Database();
 
     void login() throw ( TimesheetProcessorException );
+    void login( const MySqlStorage::Parameters& parameters ) throw ( TimesheetProcessorException );
+    /** Returns true if the connection is open and the server still answers. */
+    bool isConnected();
     void initializeDatabase() throw ( TimesheetProcessorException );
+    /** Creates the indexes used to find the events and time sheets of a report, if they are missing.
+     * Failing to create them is only reported, the queries work without them, just slower. */
+    void ensureIndexes();
+    /** Adds the column that records when a task was changed last, if it is missing. */
+    void ensureTaskChangeTime() throw ( TimesheetProcessorException );
+    /** Adds the table and trigger that record when a task was deleted, if they are missing.
+     * Deletions before that are not known, deltas since then do not list them. */
+    void ensureTaskDeletionLog() throw ( TimesheetProcessorException );
     void addEvent( const Event& event, const SqlRaiiTransactor& );
     void deleteEventsForReport ( int userid, int index );
     void checkUserid( int id ) throw (TimesheetProcessorException );
     User getOrCreateUserByName( QString name ) throw (TimesheetProcessorException );
     Task getTask( int taskid ) throw (TimesheetProcessorException );
     TaskList getAllTasks() throw (TimesheetProcessorException );
+    QSet<TaskId> getTaskIds() throw (TimesheetProcessorException );
+    /** Writes the tasks to @p writer while they are read from the database, and returns their number.
+     * With a valid @p changedSince, only the tasks changed since then and their parents are written,
+     * followed by the ids of the tasks deleted since then. */
+    int exportTasks( TaskExportWriter* writer, const QDateTime& changedSince = QDateTime() ) throw (TimesheetProcessorException );
+    /** Returns a summary of the Tasks table that changes whenever tasks are added, removed or renumbered. */
+    QString taskTableChecksum() throw (TimesheetProcessorException );
 
     QSqlDatabase& database();
 
@@ -55,4 +79,23 @@ private:
     MySqlStorage m_storage;
 };
 
+/** The ids of all tasks in the database, shared between threads.
+ *
+ * Validating a time sheet against the cache avoids one query per event. The ids are reloaded when the
+ * checksum of the Tasks table changed, which costs one query per refresh.
+ */
+class TaskIdCache
+{
+public:
+    TaskIdCache();
+
+    void refresh( Database& database ) throw (TimesheetProcessorException );
+    bool contains( TaskId id ) const;
+
+private:
+    mutable QReadWriteLock m_lock;
+    QString m_checksum;
+    QSet<TaskId> m_taskIds;
+};
+
 #endif /*DATABASE_H*/
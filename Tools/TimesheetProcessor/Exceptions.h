@@ -57,4 +57,15 @@ public:
     }
 };
 
+/* A statement was chosen as the victim of a deadlock, and the database rolled back
+ * the transaction. Running the transaction again is expected to succeed. */
+class DeadlockException : public TimesheetProcessorException
+{
+public:
+    explicit DeadlockException(const QString& text = QString::null) :
+        TimesheetProcessorException(text)
+    {
+    }
+};
+
 #endif
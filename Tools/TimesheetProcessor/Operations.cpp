@@ -37,12 +37,167 @@
 #include <QObject>
 #include <QDomDocument>
 #include <QSqlDatabase>
+#include <QSqlError>
 #include <QVariant>
 #include <QSqlQuery>
 #include <QSqlRecord>
+#include <QTextStream>
 
+#include <cstdio>
 #include <iostream>
 
+namespace {
+    // the period column of the totals, ISO weeks as 2016-W07 or months as 2016-02
+    static const char WeekExpression[] = "CONCAT(LEFT(YEARWEEK(e.start, 3), 4), '-W', RIGHT(YEARWEEK(e.start, 3), 2))";
+    static const char MonthExpression[] = "DATE_FORMAT(e.start, '%Y-%m')";
+    // the MySQL error of a transaction that was rolled back to resolve a deadlock (ER_LOCK_DEADLOCK)
+    static const int DeadlockError = 1213;
+    // how often a replace of a week is run, when it keeps losing deadlocks
+    static const int ReplaceAttempts = 3;
+
+    bool isDeadlock( const QSqlQuery& query )
+    {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 3, 0)
+        return query.lastError().nativeErrorCode() == QString::number( DeadlockError );
+#else
+        return query.lastError().number() == DeadlockError;
+#endif
+    }
+
+    QString csvField( const QString& field )
+    {
+        if ( !field.contains( QLatin1Char( ',' ) ) && !field.contains( QLatin1Char( '"' ) )
+             && !field.contains( QLatin1Char( '\n' ) ) ) {
+            return field;
+        }
+        QString quoted = field;
+        quoted.replace( QLatin1Char( '"' ), QLatin1String( "\"\"" ) );
+        return QLatin1Char( '"' ) + quoted + QLatin1Char( '"' );
+    }
+
+    int writeTotalsCsv( QSqlQuery& query, QIODevice* device )
+    {
+        QTextStream stream( device );
+        stream.setCodec( "UTF-8" );
+        stream << "user_id,user,task,task_name,period,seconds\n";
+        int rows = 0;
+        while ( query.next() ) {
+            stream << query.value( 0 ).toInt() << ','
+                   << csvField( query.value( 1 ).toString() ) << ','
+                   << query.value( 2 ).toInt() << ','
+                   << csvField( query.value( 3 ).toString() ) << ','
+                   << query.value( 4 ).toString() << ','
+                   << query.value( 5 ).toLongLong() << '\n';
+            ++rows;
+        }
+        stream.flush();
+        return rows;
+    }
+
+    int writeTotalsXml( QSqlQuery& query, QIODevice* device, const CommandLine& cmd )
+    {
+        XmlReportWriter writer( device, QLatin1String( "totals" ) );
+        writer.textElement( QLatin1String( "start" ), cmd.startDate().toString( Qt::ISODate ) );
+        writer.textElement( QLatin1String( "end" ), cmd.endDate().toString( Qt::ISODate ) );
+        writer.textElement( QLatin1String( "period" ),
+                            QLatin1String( cmd.period() == CommandLine::Period_Month ? "month" : "week" ) );
+        writer.startReport();
+        int rows = 0;
+        while ( query.next() ) {
+            writer.startElement( QLatin1String( "total" ) );
+            writer.attribute( QLatin1String( "user-id" ), query.value( 0 ).toString() );
+            writer.attribute( QLatin1String( "user" ), query.value( 1 ).toString() );
+            writer.attribute( QLatin1String( "task" ), query.value( 2 ).toString() );
+            writer.attribute( QLatin1String( "task-name" ), query.value( 3 ).toString() );
+            writer.attribute( QLatin1String( "period" ), query.value( 4 ).toString() );
+            writer.attribute( QLatin1String( "seconds" ), query.value( 5 ).toString() );
+            writer.endElement();
+            ++rows;
+        }
+        writer.finish();
+        return rows;
+    }
+
+    struct Timesheet {
+        Timesheet() : totalSeconds( 0 ) {}
+        QString year;
+        QString week;
+        int totalSeconds;
+        EventList events;
+    };
+
+    Timesheet loadTimesheet( const QString& filename )
+    {
+        // load the time sheet:
+        QFile file(filename );
+        if ( !file.exists() )
+        {
+            throw TimesheetProcessorException( QObject::tr("File %1 does not exist.").arg(filename ));
+        }
+        // load the XML into a DOM tree:
+        if (!file.open(QIODevice::ReadOnly))
+        {
+            QString msg = QObject::tr("Cannot open file %1 for reading.").arg(filename);
+            throw TimesheetProcessorException( msg);
+        }
+        QDomDocument doc("timesheet");
+        if (!doc.setContent(&file))
+        {
+            QString msg = QObject::tr("Cannot read file %1.").arg(filename);
+            throw TimesheetProcessorException( msg);
+        }
+        Timesheet timesheet;
+        QDomElement charmReportElement = doc.firstChildElement("charmreport");
+        QDomElement metadataElement = charmReportElement.firstChildElement("metadata");
+        QDomElement yearElement = metadataElement.firstChildElement("year");
+        timesheet.year = yearElement.text().simplified();
+        QDomElement weekElement = metadataElement.firstChildElement("serial-number");
+        timesheet.week = weekElement.text().simplified();
+        QDomElement reportElement = charmReportElement.firstChildElement("report");
+        QDomElement effortElement = reportElement.firstChildElement("effort");
+        if( effortElement.isNull() )
+        {
+            QString msg = QObject::tr("Invalid structure in file %1.").arg(filename);
+            throw TimesheetProcessorException( msg);
+        }
+
+        QDomElement element = effortElement.firstChildElement( Event::tagName() );
+        for (; !element.isNull(); element = element.nextSiblingElement( Event::tagName() ) )
+        {
+            try {
+                Event e = Event::fromXml(element);
+                timesheet.events << e;
+                timesheet.totalSeconds += e.duration();
+                // e.dump();
+            } catch ( const XmlSerializationException& e ) {
+                const QString msg = QObject::tr("Syntax error in file %1: %2.").arg( filename, e.what() );
+                throw TimesheetProcessorException( msg );
+            }
+        }
+        return timesheet;
+    }
+
+    void addEvents( Database& database, const SqlRaiiTransactor& transaction, const Timesheet& timesheet,
+                    int userid, int index, TaskIdCache* taskIds )
+    {
+        Q_FOREACH( Event e, timesheet.events )
+        {
+            // check for the project code, if this does not throw an exception, the task id exists
+            if ( taskIds ) {
+                if ( !taskIds->contains( e.taskId() ) ) {
+                    throw TimesheetProcessorException( QObject::tr( "Invalid task %1 in report" ).arg( e.taskId() ) );
+                }
+            } else {
+                database.getTask( e.taskId() );
+            }
+            // FIXME check for reporting period for the task, not implemented in the DB
+            e.setUserId( userid );
+            e.setReportId( index );
+            database.addEvent( e, transaction );
+        }
+    }
+}
+
 void initializeDatabase(const CommandLine& cmd)
 {
         using namespace std;
@@ -68,68 +223,30 @@ void checkOrCreateUser(const CommandLine& cmd)
 }
 
 void addTimesheet(const CommandLine& cmd)
+{
+    Database database;
+    database.login();
+    addTimesheet( cmd, database, std::cout );
+}
+
+void addTimesheet( const CommandLine& cmd, Database& database, std::ostream& out, TaskIdCache* taskIds )
 {
     using namespace std;
 
-    // load the time sheet:
-    QFile file(cmd.filename() );
-    if ( !file.exists() )
-    {
-        throw TimesheetProcessorException( QObject::tr("File %1 does not exist.").arg(cmd.filename() ));
-    }
-    // load the XML into a DOM tree:
-    if (!file.open(QIODevice::ReadOnly))
-    {
-        QString msg = QObject::tr("Cannot open file %1 for reading.").arg(cmd.filename());
-        throw TimesheetProcessorException( msg);
-    }
-    QDomDocument doc("timesheet");
-    if (!doc.setContent(&file))
-    {
-        QString msg = QObject::tr("Cannot read file %1.").arg(cmd.filename());
-        throw TimesheetProcessorException( msg);
-    }
-    // add it to the database:
     // 1) make a list of all the events:
-    EventList events;
-    QDomElement charmReportElement = doc.firstChildElement("charmreport");
-    QDomElement metadataElement = charmReportElement.firstChildElement("metadata");
-    QDomElement yearElement = metadataElement.firstChildElement("year");
-    QString year = yearElement.text().simplified();
-    QDomElement weekElement = metadataElement.firstChildElement("serial-number");
-    QString week = weekElement.text().simplified();
-    QDomElement reportElement = charmReportElement.firstChildElement("report");
-    QDomElement effortElement = reportElement.firstChildElement("effort");
-    if( effortElement.isNull() )
-    {
-        QString msg = QObject::tr("Invalid structure in file %1.").arg(cmd.filename());
-        throw TimesheetProcessorException( msg);
-    }
-
-    int totalSeconds = 0;
-    QDomElement element = effortElement.firstChildElement( Event::tagName() );
-    for (; !element.isNull(); element = element.nextSiblingElement( Event::tagName() ) )
-    {
-        try {
-            Event e = Event::fromXml(element);
-            events << e;
-            totalSeconds += e.duration();
-            // e.dump();
-        } catch ( const XmlSerializationException& e ) {
-            const QString msg = QObject::tr("Syntax error in file %1: %2.").arg( cmd.filename(), e.what() );
-            throw TimesheetProcessorException( msg );
-        }
-    }
+    const Timesheet timesheet = loadTimesheet( cmd.filename() );
+    const QString& year = timesheet.year;
+    const QString& week = timesheet.week;
+    const int totalSeconds = timesheet.totalSeconds;
 
     uint dateTimeUploaded = QDateTime::currentMSecsSinceEpoch()/1000;// seconds since 1970-01-01
 
-    // 2) log into database
-    Database database;
-    database.login();
+    // 2) check the user id and the task ids known to the database
     int index = -1;
-
-    // check for the user id
     database.checkUserid(cmd.userid());
+    if ( taskIds ) {
+        taskIds->refresh( database );
+    }
 
     try {
         SqlRaiiTransactor transaction( database.database() );
@@ -170,22 +287,14 @@ void addTimesheet(const CommandLine& cmd)
 
         Q_ASSERT( index > 0 );
 
-        cout << "Adding report " << index << " for user " << cmd.userid() << endl;
+        out << "Adding report " << index << " for user " << cmd.userid() << endl;
 
         // add the events to the database
-        Q_FOREACH( Event e, events )
-        {
-            // check for the project code, if this does not throw an exception, the task id exists
-            Task task = database.getTask( e.taskId());
-            // FIXME check for reporting period for the task, not implemented in the DB
-            e.setUserId( cmd.userid() );
-            e.setReportId( index );
-            database.addEvent( e, transaction );
-        }
+        addEvents( database, transaction, timesheet, cmd.userid(), index, taskIds );
 
         transaction.commit();
 
-        cout << "Report added" << endl
+        out << "Report added" << endl
                 << "total:" << totalSeconds << endl
                 << "year:" << year.toLocal8Bit().constData() << endl
                 << "week:" << week.toLocal8Bit().constData() << endl
@@ -214,6 +323,137 @@ void addTimesheet(const CommandLine& cmd)
     }
 }
 
+namespace {
+    // replaces the time sheets of the week in one transaction, and returns the index of the time sheet
+    int replaceWeek( Database& database, const CommandLine& cmd, const Timesheet& timesheet, uint dateTimeUploaded )
+    {
+        using namespace std;
+
+        SqlRaiiTransactor transaction( database.database() );
+
+        // lock the time sheets of that week, concurrent replaces of the same week wait for each other
+        QList<int> indexes;
+        {
+            QSqlQuery query( database.database() );
+            query.prepare( "SELECT id FROM timesheets WHERE userid = :userid AND year = :year AND week = :week ORDER BY id FOR UPDATE" );
+            query.bindValue( QString::fromLatin1( ":userid" ), cmd.userid() );
+            query.bindValue( QString::fromLatin1( ":year" ), timesheet.year );
+            query.bindValue( QString::fromLatin1( ":week" ), timesheet.week );
+            if ( ! query.exec() ) {
+                QString msg = QObject::tr( "Error retrieving the time sheets of week %1/%2." ).arg( timesheet.year, timesheet.week );
+                if ( isDeadlock( query ) ) {
+                    throw DeadlockException( msg );
+                }
+                throw TimesheetProcessorException( msg );
+            }
+            while ( query.next() ) {
+                indexes << query.value( 0 ).toInt();
+            }
+        }
+
+        int index = -1;
+        if ( indexes.isEmpty() ) {
+            // a week without time sheets only takes a gap lock above, which does not keep a concurrent replace
+            // of the same week out. Both then insert, and MySQL rolls one of them back as a deadlock.
+            QSqlQuery query( database.database() );
+            query.prepare( "INSERT into timesheets VALUES( 0, :filename, :original_filename, :year, :week, :total, :userid, 0, :date_time_uploaded)" );
+            query.bindValue( QString::fromLatin1( ":filename" ), cmd.filename() );
+            query.bindValue( QString::fromLatin1( ":original_filename" ), cmd.userComment() );
+            query.bindValue( QString::fromLatin1( ":year" ), timesheet.year );
+            query.bindValue( QString::fromLatin1( ":week" ), timesheet.week );
+            query.bindValue( QString::fromLatin1( ":total" ), timesheet.totalSeconds );
+            query.bindValue( QString::fromLatin1( ":userid" ), cmd.userid() );
+            query.bindValue( QString::fromLatin1( ":date_time_uploaded" ), dateTimeUploaded );
+            if ( ! query.exec() ) {
+                QString msg = QObject::tr( "Error adding time sheet %1." ).arg( cmd.filename() );
+                if ( isDeadlock( query ) ) {
+                    throw DeadlockException( msg );
+                }
+                throw TimesheetProcessorException( msg );
+            }
+            index = query.lastInsertId().toInt();
+            if ( index <= 0 ) {
+                QString msg = QObject::tr( "Error retrieving index for time sheet %1." ).arg( cmd.filename() );
+                throw TimesheetProcessorException( msg );
+            }
+            cout << "Adding report " << index << " for user " << cmd.userid() << endl;
+        } else {
+            // keep the oldest time sheet of the week, so that its index stays valid, and drop any duplicates
+            index = indexes.first();
+            cout << "Replacing report " << index << " for user " << cmd.userid() << endl;
+            Q_FOREACH( int oldIndex, indexes ) {
+                database.deleteEventsForReport( cmd.userid(), oldIndex );
+                if ( oldIndex == index ) {
+                    continue;
+                }
+                QSqlQuery query( database.database() );
+                query.prepare( "DELETE from timesheets WHERE id = :index" );
+                query.bindValue( QString::fromLatin1( ":index" ), oldIndex );
+                if ( ! query.exec() ) {
+                    QString msg = QObject::tr( "Error removing timesheet %1." ).arg( oldIndex );
+                    throw TimesheetProcessorException( msg );
+                }
+            }
+            QSqlQuery query( database.database() );
+            query.prepare( "UPDATE timesheets SET filename = :filename, original_filename = :original_filename, total = :total, "
+                           "date_time_uploaded = :date_time_uploaded WHERE id = :index" );
+            query.bindValue( QString::fromLatin1( ":filename" ), cmd.filename() );
+            query.bindValue( QString::fromLatin1( ":original_filename" ), cmd.userComment() );
+            query.bindValue( QString::fromLatin1( ":total" ), timesheet.totalSeconds );
+            query.bindValue( QString::fromLatin1( ":date_time_uploaded" ), dateTimeUploaded );
+            query.bindValue( QString::fromLatin1( ":index" ), index );
+            if ( ! query.exec() ) {
+                QString msg = QObject::tr( "Error replacing time sheet %1." ).arg( index );
+                throw TimesheetProcessorException( msg );
+            }
+        }
+
+        addEvents( database, transaction, timesheet, cmd.userid(), index, 0 );
+
+        if ( ! transaction.commit() ) {
+            QString msg = QObject::tr( "Error commit replace timesheet %1." ).arg( index );
+            throw TimesheetProcessorException( msg );
+        }
+        return index;
+    }
+}
+
+void replaceTimesheet( const CommandLine& cmd )
+{
+    using namespace std;
+
+    const Timesheet timesheet = loadTimesheet( cmd.filename() );
+    const uint dateTimeUploaded = QDateTime::currentMSecsSinceEpoch()/1000;// seconds since 1970-01-01
+
+    Database database;
+    database.login();
+    database.checkUserid( cmd.userid() );
+    // outside of the transaction, MySQL commits implicitly when creating an index
+    database.ensureIndexes();
+
+    // the loser of a deadlock between two replaces of a new week runs again, and then finds
+    // the time sheet of the winner to replace
+    int index = -1;
+    for ( int attempt = 1; ; ++attempt ) {
+        try {
+            index = replaceWeek( database, cmd, timesheet, dateTimeUploaded );
+            break;
+        } catch ( const DeadlockException& e ) {
+            if ( attempt == ReplaceAttempts ) {
+                throw;
+            }
+            cout << "Deadlock, retrying: " << e.what() << endl;
+        }
+    }
+
+    cout << "Report replaced" << endl
+            << "total:" << timesheet.totalSeconds << endl
+            << "year:" << timesheet.year.toLocal8Bit().constData() << endl
+            << "week:" << timesheet.week.toLocal8Bit().constData() << endl
+            << "uploadedTime:" << dateTimeUploaded << endl
+            << "index:" << index << endl;
+}
+
 void removeTimesheet(const CommandLine& cmd)
 {
         using namespace std;
@@ -221,6 +461,7 @@ void removeTimesheet(const CommandLine& cmd)
 
         Database database;
         database.login();
+        database.ensureIndexes();
         SqlRaiiTransactor transaction( database.database() );
         database.deleteEventsForReport( cmd.userid(), cmd.index() );
 
@@ -260,13 +501,80 @@ void exportProjectcodes( const CommandLine& cmd )
 
     Database database;
     database.login();
+    if ( cmd.changedSince().isValid() ) {
+        database.ensureTaskChangeTime();
+        database.ensureTaskDeletionLog();
+    }
 
-    TaskList tasks = database.getAllTasks();
+    QFile file( cmd.exportFilename() );
+    if ( !file.open( QIODevice::WriteOnly ) ) {
+        throw TimesheetProcessorException( QObject::tr( "Cannot write to file %1: %2" ).arg( cmd.exportFilename(), file.errorString() ) );
+    }
+    int count = 0;
     try {
-        TaskExport::writeTo( cmd.exportFilename(), tasks );
+        // the tasks are written while they are read, without collecting the catalogue first
+        TaskExportWriter writer( &file, cmd.changedSince() );
+        count = database.exportTasks( &writer, cmd.changedSince() );
+        writer.finish();
     } catch ( const XmlSerializationException& e ) {
         throw TimesheetProcessorException( QObject::tr( "Cannot write to file %1: %2" ).arg( cmd.exportFilename(), e.what() ) );
     }
 
-    cout << "Done, " << tasks.count() << " tasks definitions exported." << endl;
+    cout << "Done, " << count << " tasks definitions exported." << endl;
+}
+
+void exportTotals( const CommandLine& cmd )
+{
+    using namespace std;
+
+    const bool toStdout = cmd.exportFilename() == QLatin1String( "-" );
+    const bool asXml = cmd.exportFilename().endsWith( QLatin1String( ".xml" ), Qt::CaseInsensitive );
+    if ( !toStdout ) {
+        cout << "Exporting totals to " << qPrintable( cmd.exportFilename() ) << endl;
+    }
+
+    Database database;
+    database.login();
+
+    // aggregate in the database, only the totals are transferred to the client
+    const QString statement = QString::fromLatin1(
+        "SELECT e.user_id, u.name, e.task, t.name, %1 AS period, SUM(TIMESTAMPDIFF(SECOND, e.start, e.end)) "
+        "FROM Events e LEFT JOIN Users u ON u.user_id = e.user_id LEFT JOIN Tasks t ON t.task_id = e.task "
+        "WHERE e.start >= :start AND e.start < :end "
+        "GROUP BY e.user_id, u.name, e.task, t.name, period "
+        "ORDER BY e.user_id, e.task, period" )
+        .arg( QLatin1String( cmd.period() == CommandLine::Period_Month ? MonthExpression : WeekExpression ) );
+    QSqlQuery query( database.database() );
+    query.setForwardOnly( true );
+    query.prepare( statement );
+    query.bindValue( QString::fromLatin1( ":start" ), cmd.startDate() );
+    query.bindValue( QString::fromLatin1( ":end" ), cmd.endDate().addDays( 1 ) );
+    if ( !query.exec() ) {
+        QString msg = QObject::tr( "Error querying totals from %1 to %2." )
+                .arg( cmd.startDate().toString( Qt::ISODate ), cmd.endDate().toString( Qt::ISODate ) );
+        throw TimesheetProcessorException( msg );
+    }
+
+    QFile file( cmd.exportFilename() );
+    bool opened;
+    if ( toStdout ) {
+        opened = file.open( stdout, QIODevice::WriteOnly );
+    } else {
+        opened = file.open( QIODevice::WriteOnly | QIODevice::Truncate );
+    }
+    if ( !opened ) {
+        QString msg = QObject::tr( "Cannot open file %1 for writing." ).arg( cmd.exportFilename() );
+        throw TimesheetProcessorException( msg );
+    }
+
+    int rows = 0;
+    try {
+        rows = asXml && !toStdout ? writeTotalsXml( query, &file, cmd ) : writeTotalsCsv( query, &file );
+    } catch ( const XmlSerializationException& e ) {
+        throw TimesheetProcessorException( QObject::tr( "Cannot write to file %1: %2" ).arg( cmd.exportFilename(), e.what() ) );
+    }
+
+    if ( !toStdout ) {
+        cout << "Done, " << rows << " totals exported." << endl;
+    }
 }
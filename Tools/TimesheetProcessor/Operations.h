@@ -24,17 +24,32 @@
 #ifndef OPERATIONS_H
 #define OPERATIONS_H
 
+#include <iosfwd>
+
 /* Define functions that implement the operations of the time sheet processor. */
 class CommandLine;
+class Database;
+class TaskIdCache;
 
 void initializeDatabase(const CommandLine& cmd);
 
 void addTimesheet(const CommandLine& cmd);
 
+/* Add the time sheet using an open database connection and write the result to out. If taskIds is
+ * given, the events are validated against it instead of querying the database for every task. */
+void addTimesheet( const CommandLine& cmd, Database& database, std::ostream& out, TaskIdCache* taskIds = 0 );
+
 void removeTimesheet(const CommandLine& cmd);
 
+/* Add the time sheet, replacing the one the user uploaded for the same year and week, in one transaction. */
+void replaceTimesheet( const CommandLine& cmd );
+
 void checkOrCreateUser(const CommandLine& cmd);
 
 void exportProjectcodes( const CommandLine& cmd );
 
+void exportTotals( const CommandLine& cmd );
+
+void runDaemon( const CommandLine& cmd );
+
 #endif /*OPERATIONS_H*/
@@ -55,9 +55,18 @@ int main(int argc, char** argv)
         case CommandLine::Mode_RemoveTimesheet:
             removeTimesheet(cmd);
             break;
+        case CommandLine::Mode_ReplaceTimesheet:
+            replaceTimesheet( cmd );
+            break;
         case CommandLine::Mode_ExportProjectcodes:
             exportProjectcodes( cmd );
             break;
+        case CommandLine::Mode_ExportTotals:
+            exportTotals( cmd );
+            break;
+        case CommandLine::Mode_Daemon:
+            runDaemon( cmd );
+            break;
         case CommandLine::Mode_PrintVersion:
             cout << CHARM_VERSION << endl;
             break;